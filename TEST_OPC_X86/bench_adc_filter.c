@@ -0,0 +1,196 @@
+/*
+ * bench_adc_filter.c - Host-side benchmark for the analog input filters.
+ * See the project LICENSE file and main/opcua_esp32.c for licensing and attribution.
+ *
+ * Feeds a synthetic ADC signal (slow sine + Gaussian noise + occasional
+ * spikes, 12-bit codes) through every filter of components/adc_filter and
+ * reports the cost per sample together with the remaining error against
+ * the clean signal. The filter code is compiled unchanged from the
+ * firmware sources.
+ *
+ * Cycles are read from the x86 time stamp counter when available,
+ * otherwise only nanoseconds are shown. On the ESP32-S3 the same loop can
+ * be timed with esp_cpu_get_cycle_count().
+ *
+ * Build (from this directory):
+ *   gcc -O2 -std=c11 -Wall -I../components/adc_filter/include \
+ *       -o bench_adc_filter bench_adc_filter.c ../components/adc_filter/adc_filter.c -lm
+ *
+ * Run:
+ *   ./bench_adc_filter -n 1000000
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "adc_filter.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEFAULT_SAMPLES     1000000
+#define NOISE_RMS_CODES     12.0    /* Gaussian noise, ADC codes */
+#define SPIKE_PERIOD        997     /* One spike every N samples */
+#define SPIKE_CODES         800     /* Spike amplitude, ADC codes */
+
+typedef struct {
+    adc_filter_type_t type;
+    uint8_t param;
+} filter_case_t;
+
+static const filter_case_t cases[] = {
+    { ADC_FILTER_NONE,           0 },
+    { ADC_FILTER_MOVING_AVERAGE, 4 },
+    { ADC_FILTER_MOVING_AVERAGE, 8 },
+    { ADC_FILTER_MOVING_AVERAGE, 32 },
+    { ADC_FILTER_IIR,            2 },
+    { ADC_FILTER_IIR,            3 },
+    { ADC_FILTER_IIR,            5 },
+    { ADC_FILTER_MEDIAN,         3 },
+    { ADC_FILTER_MEDIAN,         5 },
+    { ADC_FILTER_MEDIAN,         15 },
+};
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t cycles(void) {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Box-Muller standard normal sample
+static double gaussian(void) {
+    double u1 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// Build the clean reference and the noisy input
+static void make_signal(uint16_t *noisy, float *clean, size_t n) {
+    srand(12345);
+    for (size_t i = 0; i < n; i++) {
+        double c = 2048.0 + 1500.0 * sin(2.0 * M_PI * (double)i / 5000.0);
+        double v = c + NOISE_RMS_CODES * gaussian();
+        if (i % SPIKE_PERIOD == SPIKE_PERIOD - 1) {
+            v += SPIKE_CODES;
+        }
+        if (v < 0) v = 0;
+        if (v > 4095) v = 4095;
+        clean[i] = (float)c;
+        noisy[i] = (uint16_t)lrint(v);
+    }
+}
+
+static void run_case(const filter_case_t *fc, const uint16_t *in, const float *clean,
+                     float *out, size_t n) {
+    adc_filter_t f;
+    adc_filter_init(&f, fc->type, fc->param);
+
+    uint64_t t0 = now_ns();
+    uint64_t c0 = cycles();
+    for (size_t i = 0; i < n; i++) {
+        out[i] = adc_filter_process(&f, in[i]);
+    }
+    uint64_t c1 = cycles();
+    uint64_t t1 = now_ns();
+
+    // Error after the warm-up window; filter delay is part of the error
+    double err2 = 0.0, max_err = 0.0;
+    size_t skip = 64;
+    for (size_t i = skip; i < n; i++) {
+        double e = fabs((double)out[i] - (double)clean[i]);
+        err2 += e * e;
+        if (e > max_err) max_err = e;
+    }
+
+    char name[32];
+    if (fc->type == ADC_FILTER_NONE) {
+        snprintf(name, sizeof(name), "%s", adc_filter_type_name(fc->type));
+    } else {
+        snprintf(name, sizeof(name), "%s(%u)", adc_filter_type_name(fc->type), fc->param);
+    }
+
+    printf("%-20s %10.2f %10.2f %12.2f %12.1f\n",
+           name,
+           HAVE_TSC ? (double)(c1 - c0) / n : 0.0,
+           (double)(t1 - t0) / n,
+           sqrt(err2 / (n - skip)),
+           max_err);
+}
+
+static void print_help(const char *program_name) {
+    printf("Analog input filter benchmark\n");
+    printf("Usage: %s [OPTIONS]\n\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help           Show this help message\n");
+    printf("  -n, --samples N      Samples per filter (default: %d)\n", DEFAULT_SAMPLES);
+}
+
+int main(int argc, char *argv[]) {
+    long n = DEFAULT_SAMPLES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_help(argv[0]);
+            return 0;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--samples") == 0) && i + 1 < argc) {
+            n = atol(argv[++i]);
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (n < 1000) {
+        printf("Error: at least 1000 samples required\n");
+        return 1;
+    }
+
+    uint16_t *in = malloc(n * sizeof(*in));
+    float *clean = malloc(n * sizeof(*clean));
+    float *out = malloc(n * sizeof(*out));
+    if (!in || !clean || !out) {
+        printf("Error: out of memory\n");
+        return 1;
+    }
+
+    make_signal(in, clean, n);
+
+    printf("Samples: %ld, noise: %.0f codes RMS, spike: +%d codes every %d samples\n\n",
+           n, NOISE_RMS_CODES, SPIKE_CODES, SPIKE_PERIOD);
+    printf("%-20s %10s %10s %12s %12s\n", "FILTER", "CYC/SMP", "NS/SMP", "RMS ERR", "MAX ERR");
+    printf("--------------------------------------------------------------------\n");
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        run_case(&cases[i], in, clean, out, n);
+    }
+
+    if (!HAVE_TSC) {
+        printf("\nNo cycle counter on this host: CYC/SMP not measured.\n");
+    }
+
+    free(in);
+    free(clean);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * bench_di_debounce.c - Host-side benchmark for the discrete input debouncer.
+ * See the project LICENSE file and main/opcua_esp32.c for licensing and attribution.
+ *
+ * Simulates 16 contacts that switch every few hundred milliseconds and
+ * bounce for a few milliseconds after each switch, sampled every 1 ms.
+ * The trace is fed through components/di_debounce (compiled unchanged
+ * from the firmware sources) and through a plain per-input loop doing the
+ * same filtering, for both modes and for 1 and 16 debounced inputs.
+ *
+ * For every case it prints the cost per update, the number of word
+ * changes before and after debouncing (what subscriptions would see) and
+ * whether the bit-parallel and per-input results agree.
+ *
+ * Build (from this directory):
+ *   gcc -O2 -std=c11 -Wall -I../components/di_debounce/include \
+ *       -o bench_di_debounce bench_di_debounce.c ../components/di_debounce/di_debounce.c
+ *
+ * Run:
+ *   ./bench_di_debounce -n 1000000
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "di_debounce.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#define DEFAULT_SAMPLES     1000000
+#define SWITCH_MIN_MS       100     /* Shortest time between two contact switches */
+#define SWITCH_SPREAD_MS    400     /* Random extra time between switches */
+#define BOUNCE_MS           4       /* Bounce duration after a switch */
+
+typedef struct {
+    const char *name;
+    di_debounce_mode_t mode;
+    uint32_t limit;
+    uint16_t inputs;
+} debounce_case_t;
+
+static const debounce_case_t cases[] = {
+    { "none",                DI_DEBOUNCE_NONE,       0,  0xFFFF },
+    { "integrator(3) x1",    DI_DEBOUNCE_INTEGRATOR, 3,  0x0001 },
+    { "integrator(3) x16",   DI_DEBOUNCE_INTEGRATOR, 3,  0xFFFF },
+    { "time(10 ms) x1",      DI_DEBOUNCE_TIME,       10, 0x0001 },
+    { "time(10 ms) x16",     DI_DEBOUNCE_TIME,       10, 0xFFFF },
+};
+
+/** Per-input reference state */
+typedef struct {
+    uint8_t state;
+    uint8_t armed;
+    uint32_t count;
+} ref_input_t;
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t cycles(void) {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// 1 ms samples of 16 bouncing contacts
+static void make_trace(uint16_t *raw, size_t n) {
+    uint16_t level = 0;
+    uint32_t next_switch[DI_DEBOUNCE_INPUTS];
+    uint32_t bounce_end[DI_DEBOUNCE_INPUTS];
+
+    srand(12345);
+    for (int b = 0; b < DI_DEBOUNCE_INPUTS; b++) {
+        next_switch[b] = SWITCH_MIN_MS + rand() % SWITCH_SPREAD_MS;
+        bounce_end[b] = 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint16_t word = level;
+        for (int b = 0; b < DI_DEBOUNCE_INPUTS; b++) {
+            if (i == next_switch[b]) {
+                level ^= 1u << b;
+                bounce_end[b] = (uint32_t)i + BOUNCE_MS;
+                next_switch[b] += SWITCH_MIN_MS + rand() % SWITCH_SPREAD_MS;
+            }
+            word = (word & ~(1u << b)) | (level & (1u << b));
+            if (i < bounce_end[b] && (rand() & 1)) {
+                word ^= 1u << b;
+            }
+        }
+        raw[i] = word;
+    }
+}
+
+// Same filtering as di_debounce_update(), one input at a time
+static uint16_t ref_update(ref_input_t *in, const debounce_case_t *dc, uint16_t raw, uint32_t elapsed) {
+    uint16_t out = 0;
+    if (elapsed > DI_DEBOUNCE_MAX_LIMIT) elapsed = DI_DEBOUNCE_MAX_LIMIT;
+
+    for (int b = 0; b < DI_DEBOUNCE_INPUTS; b++) {
+        ref_input_t *x = &in[b];
+        uint8_t bit = (raw >> b) & 1;
+        int mode = (dc->inputs & (1u << b)) ? dc->mode : DI_DEBOUNCE_NONE;
+
+        if (mode == DI_DEBOUNCE_NONE) {
+            x->state = bit;
+        } else if (bit == x->state) {
+            if (mode == DI_DEBOUNCE_INTEGRATOR) {
+                if (x->count) x->count--;
+            } else {
+                x->count = 0;
+                x->armed = 0;
+            }
+        } else {
+            if (mode == DI_DEBOUNCE_INTEGRATOR) {
+                x->count++;
+            } else {
+                if (x->armed) x->count += elapsed;
+                if (x->count > DI_DEBOUNCE_MAX_LIMIT) x->count = DI_DEBOUNCE_MAX_LIMIT;
+                x->armed = 1;
+            }
+            if (x->count >= dc->limit) {
+                x->state = bit;
+                x->count = 0;
+                x->armed = 0;
+            }
+        }
+        out |= (uint16_t)(x->state << b);
+    }
+    return out;
+}
+
+static void run_case(const debounce_case_t *dc, const uint16_t *raw, uint16_t *out, size_t n) {
+    di_debounce_t d;
+    di_debounce_init(&d, raw[0], DI_DEBOUNCE_NONE, 0, 0);
+    di_debounce_configure(&d, dc->inputs, dc->mode, dc->limit);
+
+    uint64_t t0 = now_ns();
+    uint64_t c0 = cycles();
+    for (size_t i = 0; i < n; i++) {
+        out[i] = di_debounce_update(&d, raw[i], (uint32_t)i);
+    }
+    uint64_t c1 = cycles();
+    uint64_t t1 = now_ns();
+
+    ref_input_t ref[DI_DEBOUNCE_INPUTS];
+    memset(ref, 0, sizeof(ref));
+    for (int b = 0; b < DI_DEBOUNCE_INPUTS; b++) {
+        ref[b].state = (raw[0] >> b) & 1;
+    }
+
+    size_t mismatches = 0;
+    uint64_t r0 = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        if (ref_update(ref, dc, raw[i], 1) != out[i]) mismatches++;
+    }
+    uint64_t r1 = now_ns();
+
+    size_t raw_changes = 0, out_changes = 0;
+    for (size_t i = 1; i < n; i++) {
+        if (raw[i] != raw[i - 1]) raw_changes++;
+        if (out[i] != out[i - 1]) out_changes++;
+    }
+
+    printf("%-20s %10.2f %10.2f %10.2f %10zu %10zu %8s\n",
+           dc->name,
+           HAVE_TSC ? (double)(c1 - c0) / n : 0.0,
+           (double)(t1 - t0) / n,
+           (double)(r1 - r0) / n,
+           raw_changes, out_changes,
+           mismatches ? "NO" : "yes");
+}
+
+static void print_help(const char *program_name) {
+    printf("Discrete input debounce benchmark\n");
+    printf("Usage: %s [OPTIONS]\n\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help           Show this help message\n");
+    printf("  -n, --samples N      Samples (1 ms each) per case (default: %d)\n", DEFAULT_SAMPLES);
+}
+
+int main(int argc, char *argv[]) {
+    long n = DEFAULT_SAMPLES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_help(argv[0]);
+            return 0;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--samples") == 0) && i + 1 < argc) {
+            n = atol(argv[++i]);
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (n < 1000) {
+        printf("Error: at least 1000 samples required\n");
+        return 1;
+    }
+
+    uint16_t *raw = malloc(n * sizeof(*raw));
+    uint16_t *out = malloc(n * sizeof(*out));
+    if (!raw || !out) {
+        printf("Error: out of memory\n");
+        return 1;
+    }
+
+    make_trace(raw, n);
+
+    printf("Samples: %ld (1 ms), 16 contacts switching every %d-%d ms, bouncing %d ms\n\n",
+           n, SWITCH_MIN_MS, SWITCH_MIN_MS + SWITCH_SPREAD_MS, BOUNCE_MS);
+    printf("%-20s %10s %10s %10s %10s %10s %8s\n",
+           "MODE", "CYC/UPD", "NS/UPD", "REF NS", "RAW CHG", "OUT CHG", "MATCH");
+    printf("------------------------------------------------------------------------------------\n");
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        run_case(&cases[i], raw, out, n);
+    }
+
+    if (!HAVE_TSC) {
+        printf("\nNo cycle counter on this host: CYC/UPD not measured.\n");
+    }
+
+    free(raw);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * bench_io_cache.c - Host-side contention benchmark for the io_cache sequence lock.
+ * See the project LICENSE file and main/opcua_esp32.c for licensing and attribution.
+ *
+ * One writer thread plays the role of the polling task and updates a
+ * cache record (discrete word, ADC channels, timestamps) as fast as
+ * possible or at a fixed period. Reader threads play the role of the
+ * OPC UA task and read the record concurrently, measuring per-read
+ * latency, retry counts and torn reads. The same record is also read
+ * through a mutex for comparison with the previous implementation.
+ *
+ * Build (from this directory):
+ *   gcc -O2 -std=c11 -Wall -pthread -I../components/io_cache \
+ *       -o bench_io_cache bench_io_cache.c
+ *
+ * Run:
+ *   ./bench_io_cache -d 5 -r 2 -p 0
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "io_seqlock.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ADC_CHANNELS    4
+#define MAX_READERS         8
+#define LATENCY_BUCKETS     4096    /* 1 bucket = 10 ns, last bucket = overflow */
+#define BUCKET_NS           10
+
+// Cache record mirroring io_cache_t / io_cache_adc_t
+typedef struct {
+    uint16_t discrete_inputs;
+    uint64_t inputs_timestamp;
+    float adc[NUM_ADC_CHANNELS];
+    uint64_t adc_timestamp[NUM_ADC_CHANNELS];
+} record_t;
+
+typedef enum { MODE_SEQLOCK, MODE_MUTEX } bench_mode_t;
+
+// Per-reader statistics
+typedef struct {
+    uint64_t reads;
+    uint64_t retries;
+    uint64_t torn;
+    uint64_t max_ns;
+    uint64_t total_ns;
+    uint64_t hist[LATENCY_BUCKETS];
+} reader_stats_t;
+
+static record_t record;
+static io_seqlock_t seqlock;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int running = 1;
+static bench_mode_t mode;
+static long writer_period_us = 0;
+static uint64_t writer_updates = 0;
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Fill every field from one counter so readers can detect torn copies
+static inline void fill_record(record_t *r, uint64_t n) {
+    r->discrete_inputs = (uint16_t)n;
+    r->inputs_timestamp = n;
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        r->adc[i] = (float)(n & 0xFFF);
+        r->adc_timestamp[i] = n;
+    }
+}
+
+static inline int record_is_consistent(const record_t *r) {
+    uint64_t n = r->inputs_timestamp;
+    if (r->discrete_inputs != (uint16_t)n) return 0;
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        if (r->adc_timestamp[i] != n || r->adc[i] != (float)(n & 0xFFF)) return 0;
+    }
+    return 1;
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    uint64_t n = 0;
+    while (running) {
+        n++;
+        if (mode == MODE_SEQLOCK) {
+            io_seqlock_write_begin(&seqlock);
+            fill_record(&record, n);
+            io_seqlock_write_end(&seqlock);
+        } else {
+            pthread_mutex_lock(&mutex);
+            fill_record(&record, n);
+            pthread_mutex_unlock(&mutex);
+        }
+        if (writer_period_us > 0) {
+            struct timespec ts = { 0, writer_period_us * 1000L };
+            nanosleep(&ts, NULL);
+        }
+    }
+    writer_updates = n;
+    return NULL;
+}
+
+static void *reader_thread(void *arg) {
+    reader_stats_t *st = (reader_stats_t *)arg;
+    record_t copy;
+
+    while (running) {
+        uint64_t t0 = now_ns();
+        if (mode == MODE_SEQLOCK) {
+            for (;;) {
+                unsigned seq = io_seqlock_read_begin(&seqlock);
+                memcpy(&copy, &record, sizeof(copy));
+                if (!io_seqlock_read_retry(&seqlock, seq)) break;
+                st->retries++;
+            }
+        } else {
+            pthread_mutex_lock(&mutex);
+            memcpy(&copy, &record, sizeof(copy));
+            pthread_mutex_unlock(&mutex);
+        }
+        uint64_t dt = now_ns() - t0;
+
+        if (!record_is_consistent(&copy)) st->torn++;
+        st->reads++;
+        st->total_ns += dt;
+        if (dt > st->max_ns) st->max_ns = dt;
+        uint64_t b = dt / BUCKET_NS;
+        st->hist[b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1]++;
+    }
+    return NULL;
+}
+
+static uint64_t percentile_ns(const uint64_t *hist, uint64_t total, double p) {
+    uint64_t target = (uint64_t)(total * p);
+    uint64_t acc = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        acc += hist[i];
+        if (acc > target) return (uint64_t)i * BUCKET_NS;
+    }
+    return (uint64_t)LATENCY_BUCKETS * BUCKET_NS;
+}
+
+static void run(bench_mode_t m, int readers, int duration_s) {
+    static reader_stats_t stats[MAX_READERS];
+    static uint64_t hist[LATENCY_BUCKETS];
+    pthread_t wt, rt[MAX_READERS];
+
+    memset(stats, 0, sizeof(stats));
+    memset(hist, 0, sizeof(hist));
+    memset(&record, 0, sizeof(record));
+    io_seqlock_init(&seqlock);
+    mode = m;
+    running = 1;
+
+    pthread_create(&wt, NULL, writer_thread, NULL);
+    for (int i = 0; i < readers; i++) {
+        pthread_create(&rt[i], NULL, reader_thread, &stats[i]);
+    }
+
+    struct timespec ts = { duration_s, 0 };
+    nanosleep(&ts, NULL);
+    running = 0;
+
+    pthread_join(wt, NULL);
+    for (int i = 0; i < readers; i++) {
+        pthread_join(rt[i], NULL);
+    }
+
+    uint64_t reads = 0, retries = 0, torn = 0, total_ns = 0, max_ns = 0;
+    for (int i = 0; i < readers; i++) {
+        reads += stats[i].reads;
+        retries += stats[i].retries;
+        torn += stats[i].torn;
+        total_ns += stats[i].total_ns;
+        if (stats[i].max_ns > max_ns) max_ns = stats[i].max_ns;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) hist[b] += stats[i].hist[b];
+    }
+
+    printf("%-8s %12llu %12llu %10llu %6llu %8.1f %8llu %8llu %8llu %10llu\n",
+           m == MODE_SEQLOCK ? "seqlock" : "mutex",
+           (unsigned long long)writer_updates,
+           (unsigned long long)reads,
+           (unsigned long long)retries,
+           (unsigned long long)torn,
+           reads ? (double)total_ns / reads : 0.0,
+           (unsigned long long)percentile_ns(hist, reads, 0.50),
+           (unsigned long long)percentile_ns(hist, reads, 0.99),
+           (unsigned long long)percentile_ns(hist, reads, 0.999),
+           (unsigned long long)max_ns);
+}
+
+static void print_help(const char *program_name) {
+    printf("io_cache sequence lock contention benchmark\n");
+    printf("Usage: %s [OPTIONS]\n\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help           Show this help message\n");
+    printf("  -d, --duration N     Seconds per mode (default: 3)\n");
+    printf("  -r, --readers N      Reader threads, 1-%d (default: 1)\n", MAX_READERS);
+    printf("  -p, --period N       Writer update period in us, 0 = hammer (default: 0)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int duration_s = 3;
+    int readers = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_help(argv[0]);
+            return 0;
+        } else if ((strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--duration") == 0) && i + 1 < argc) {
+            duration_s = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--readers") == 0) && i + 1 < argc) {
+            readers = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--period") == 0) && i + 1 < argc) {
+            writer_period_us = atol(argv[++i]);
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (duration_s <= 0 || readers < 1 || readers > MAX_READERS || writer_period_us < 0) {
+        printf("Error: invalid arguments\n");
+        return 1;
+    }
+
+    printf("Writer period: %ld us, readers: %d, duration: %d s per mode\n\n",
+           writer_period_us, readers, duration_s);
+    printf("%-8s %12s %12s %10s %6s %8s %8s %8s %8s %10s\n",
+           "MODE", "UPDATES", "READS", "RETRIES", "TORN",
+           "AVG(ns)", "P50", "P99", "P99.9", "MAX(ns)");
+    printf("----------------------------------------------------------------------------------------------\n");
+
+    run(MODE_SEQLOCK, readers, duration_s);
+    run(MODE_MUTEX, readers, duration_s);
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+/*
+ * bench_io_expander.c - Host-side benchmark of the discrete acquisition cycle on the expander HAL.
+ * See the project LICENSE file and main/opcua_esp32.c for licensing and attribution.
+ *
+ * Drives the drivers and the generic HAL, compiled unchanged from the
+ * firmware sources, against the simulated expander bus
+ * (components/io_expander/io_expander_sim.c). model.c itself is not linked:
+ * cycle() below repeats the HAL calls of its read_discrete_inputs_slow()
+ * and write_discrete_outputs_masked_slow() on a board modelled as in the
+ * firmware, two input and two output expanders at the KC868-A16
+ * addresses. Every cycle reads both input banks in one chained transaction
+ * and mirrors them to the outputs through the shadow registers (a write
+ * only when an input changed); about one cycle in eight an input toggles.
+ *
+ * For every chip (PCF8574, PCF8575, MCP23017) and fault rate it prints:
+ *
+ *   - CPU time per cycle on the host (driver and HAL overhead)
+ *   - average and maximum bus time per cycle on the virtual clock
+ *   - the worst-case bound: the cycle time when every transaction takes
+ *     the maximum jitter, fails at its last byte and so falls back to
+ *     per-device transfers, with all outputs pending
+ *   - cycles with a failed bank and cycles whose outputs did not follow
+ *     the inputs although every transfer succeeded
+ *   - whether a second run with the same seed gives identical results
+ *
+ * The virtual clock only advances with bus transactions, so the bus times
+ * and the bound do not depend on the host and are exactly reproducible.
+ *
+ * Build (part of the host build):
+ *   cmake -S ../host -B ../build-host && cmake --build ../build-host --target bench_io_expander
+ *
+ * Run:
+ *   ../build-host/bench_io_expander -n 100000
+ */
+
+#include "io_expander.h"
+#include "io_expander_sim.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_CYCLES      100000
+#define DEFAULT_OVERHEAD_US 40      /* i2c_master driver time per transaction */
+#define DEFAULT_JITTER_US   20
+#define DEFAULT_SEED        1
+
+/* Board addresses, as in components/model/include/model.h */
+#define DIO_IN1_ADDR        0x22
+#define DIO_IN2_ADDR        0x21
+#define DIO_OUT1_ADDR       0x24
+#define DIO_OUT2_ADDR       0x25
+#define BANKS               2
+
+typedef struct {
+    const char *name;
+    const io_expander_ops_t *ops;
+    io_expander_sim_chip_t chip;
+} chip_case_t;
+
+typedef struct {
+    double cpu_ns;              /* Host time per cycle */
+    double bus_avg_us;          /* Virtual bus time per cycle */
+    uint64_t bus_max_us;
+    uint32_t failed_cycles;     /* Cycles with a failed bank read or write */
+    uint32_t stale_cycles;      /* Successful cycles whose outputs do not match the inputs */
+    uint64_t checksum;          /* Values, results and times of all cycles */
+} result_t;
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t fnv1a(uint64_t h, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        h ^= (v >> (8 * i)) & 0xFF;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+static inline uint32_t xorshift32(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+/**
+ * @brief Put the board on a simulated bus and initialize the descriptors.
+ */
+static void board_init(io_expander_sim_t *sim, const io_expander_sim_config_t *cfg, const chip_case_t *cc,
+                       io_expander_t in[BANKS], io_expander_t out[BANKS]) {
+    const uint8_t in_addr[BANKS] = { DIO_IN1_ADDR, DIO_IN2_ADDR };
+    const uint8_t out_addr[BANKS] = { DIO_OUT1_ADDR, DIO_OUT2_ADDR };
+
+    io_expander_sim_init(sim, cfg);
+    for (int b = 0; b < BANKS; b++) {
+        io_expander_sim_add(sim, cc->chip, in_addr[b], -1);
+        io_expander_sim_add(sim, cc->chip, out_addr[b], -1);
+    }
+    for (int b = 0; b < BANKS; b++) {
+        io_expander_init(&in[b], cc->ops, io_expander_sim_bus(sim), in_addr[b], IO_EXPANDER_ALL_HIGH);
+        io_expander_init(&out[b], cc->ops, io_expander_sim_bus(sim), out_addr[b], 0xFF00);
+    }
+}
+
+/**
+ * @brief One acquisition cycle as in model.c: chained input read, masked output update.
+ *
+ * @param invert Output bits to invert after mirroring the inputs (forces writes)
+ * @return true if every transfer succeeded
+ */
+static bool cycle(io_expander_t *const in_devs[], io_expander_t *const out_devs[], uint16_t inputs[BANKS],
+                  uint16_t invert) {
+    static const uint16_t mask[BANKS] = { 0x00FF, 0x00FF };
+    uint16_t raw[BANKS];
+    bool ok_in[BANKS], ok_out[BANKS];
+
+    bool ok = io_expander_read_multi(in_devs, BANKS, raw, ok_in);
+    for (int b = 0; b < BANKS; b++) {
+        // Pin low = input active; the output pin low = relay on
+        inputs[b] = ok_in[b] ? (uint16_t)(~raw[b] & 0xFF) : 0;
+    }
+    const uint16_t value[BANKS] = { (uint16_t)(~inputs[0] ^ invert), (uint16_t)(~inputs[1] ^ invert) };
+    ok = io_expander_update_mask_multi(out_devs, BANKS, mask, value, ok_out) && ok;
+    return ok;
+}
+
+static result_t run(const chip_case_t *cc, const io_expander_sim_config_t *cfg, long cycles) {
+    static io_expander_sim_t sim;
+    io_expander_t in[BANKS], out[BANKS];
+    io_expander_t *const in_devs[BANKS] = { &in[0], &in[1] };
+    io_expander_t *const out_devs[BANKS] = { &out[0], &out[1] };
+    result_t r = { 0 };
+    uint32_t rng = 0x12345678u ^ cfg->seed;
+    uint16_t word = 0;
+    uint64_t bus_total = 0;
+    uint64_t cpu_total = 0;
+
+    r.checksum = 0xCBF29CE484222325ull;
+    board_init(&sim, cfg, cc, in, out);
+
+    for (long i = 0; i < cycles; i++) {
+        if (xorshift32(&rng) % 8 == 0) {
+            word ^= (uint16_t)(1u << (xorshift32(&rng) % 16));
+            io_expander_sim_set_inputs(&sim, DIO_IN1_ADDR, word & 0xFF);
+            io_expander_sim_set_inputs(&sim, DIO_IN2_ADDR, word >> 8);
+        }
+
+        uint16_t inputs[BANKS];
+        uint64_t t0 = io_expander_sim_now_us(&sim);
+        uint64_t c0 = now_ns();
+        bool ok = cycle(in_devs, out_devs, inputs, 0);
+        cpu_total += now_ns() - c0;
+        uint64_t dt = io_expander_sim_now_us(&sim) - t0;
+
+        bus_total += dt;
+        if (dt > r.bus_max_us) r.bus_max_us = dt;
+        if (!ok) {
+            r.failed_cycles++;
+        } else if ((io_expander_sim_get_pins(&sim, DIO_OUT1_ADDR) & 0xFF) != (uint16_t)(~word & 0xFF) ||
+                   (io_expander_sim_get_pins(&sim, DIO_OUT2_ADDR) & 0xFF) != (uint16_t)(~word >> 8 & 0xFF)) {
+            r.stale_cycles++;
+        }
+        r.checksum = fnv1a(r.checksum, ((uint64_t)inputs[0] << 48) | ((uint64_t)inputs[1] << 32) |
+                                       ((uint64_t)ok << 31) | (dt & 0x7FFFFFFF));
+    }
+
+    r.cpu_ns = (double)cpu_total / cycles;
+    r.bus_avg_us = (double)bus_total / cycles;
+    return r;
+}
+
+/**
+ * @brief Cycle time with every transaction failing at its last byte after the maximum jitter.
+ *
+ * The outputs are toggled every cycle, so every cycle also pays the
+ * chained write and both per-device retries: the longest cycle possible.
+ */
+static uint64_t worst_case_bound(const chip_case_t *cc, const io_expander_sim_config_t *cfg) {
+    static io_expander_sim_t sim;
+    io_expander_t in[BANKS], out[BANKS];
+    io_expander_t *const in_devs[BANKS] = { &in[0], &in[1] };
+    io_expander_t *const out_devs[BANKS] = { &out[0], &out[1] };
+    uint64_t bound = 0;
+
+    board_init(&sim, cfg, cc, in, out);
+    sim.config.worst_case = true;
+    for (int i = 0; i < 16; i++) {
+        uint16_t inputs[BANKS];
+        uint64_t t0 = io_expander_sim_now_us(&sim);
+        cycle(in_devs, out_devs, inputs, (i & 1) ? 0xFF : 0x00);
+        uint64_t dt = io_expander_sim_now_us(&sim) - t0;
+        if (dt > bound) bound = dt;
+    }
+    return bound;
+}
+
+static void print_help(const char *program_name) {
+    printf("I/O expander HAL acquisition cycle benchmark\n");
+    printf("Usage: %s [OPTIONS]\n\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help           Show this help message\n");
+    printf("  -n, --cycles N       Cycles per case (default: %d)\n", DEFAULT_CYCLES);
+    printf("  -o, --overhead US    Driver time per transaction (default: %d)\n", DEFAULT_OVERHEAD_US);
+    printf("  -j, --jitter US      Maximum extra time per transaction (default: %d)\n", DEFAULT_JITTER_US);
+    printf("  -s, --seed N         Seed of the bus and input PRNGs (default: %d)\n", DEFAULT_SEED);
+}
+
+int main(int argc, char *argv[]) {
+    long cycles = DEFAULT_CYCLES;
+    io_expander_sim_config_t cfg = {
+        .scl_hz = 400000,
+        .overhead_us = DEFAULT_OVERHEAD_US,
+        .jitter_us = DEFAULT_JITTER_US,
+        .seed = DEFAULT_SEED,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_help(argv[0]);
+            return 0;
+        } else if ((strcmp(arg, "-n") == 0 || strcmp(arg, "--cycles") == 0) && i + 1 < argc) {
+            cycles = atol(argv[++i]);
+        } else if ((strcmp(arg, "-o") == 0 || strcmp(arg, "--overhead") == 0) && i + 1 < argc) {
+            cfg.overhead_us = (uint32_t)atol(argv[++i]);
+        } else if ((strcmp(arg, "-j") == 0 || strcmp(arg, "--jitter") == 0) && i + 1 < argc) {
+            cfg.jitter_us = (uint32_t)atol(argv[++i]);
+        } else if ((strcmp(arg, "-s") == 0 || strcmp(arg, "--seed") == 0) && i + 1 < argc) {
+            cfg.seed = (uint32_t)atol(argv[++i]);
+        } else {
+            printf("Unknown option: %s\n", arg);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (cycles < 1000) {
+        printf("Error: at least 1000 cycles required\n");
+        return 1;
+    }
+
+    // Failed transfers are counted below, not logged
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    static const chip_case_t chips[] = {
+        { "PCF8574", &io_expander_pcf8574_ops, IO_EXPANDER_SIM_PCF8574 },
+        { "PCF8575", &io_expander_pcf8575_ops, IO_EXPANDER_SIM_PCF8575 },
+        { "MCP23017", &io_expander_mcp23017_ops, IO_EXPANDER_SIM_MCP23017 },
+    };
+    static const uint32_t fault_ppm[] = { 0, 1000, 10000, 100000 };
+
+    printf("Cycles: %ld, SCL %u Hz, overhead %u us, jitter 0-%u us, seed %u\n\n",
+           cycles, cfg.scl_hz, cfg.overhead_us, cfg.jitter_us, cfg.seed);
+    printf("%-9s %8s %9s %9s %8s %9s %8s %7s %6s\n",
+           "CHIP", "FAULTPPM", "CPU NS", "BUS AVG", "BUS MAX", "BOUND", "FAILED", "STALE", "REPRO");
+    printf("%-9s %8s %9s %9s %8s %9s %8s %7s %6s\n",
+           "", "", "/cycle", "[us]", "[us]", "[us]", "cycles", "cycles", "");
+    printf("-----------------------------------------------------------------------------\n");
+
+    for (size_t c = 0; c < sizeof(chips) / sizeof(chips[0]); c++) {
+        uint64_t bound = worst_case_bound(&chips[c], &cfg);
+        for (size_t f = 0; f < sizeof(fault_ppm) / sizeof(fault_ppm[0]); f++) {
+            cfg.fault_rate_ppm = fault_ppm[f];
+            result_t a = run(&chips[c], &cfg, cycles);
+            result_t b = run(&chips[c], &cfg, cycles);
+            printf("%-9s %8u %9.1f %9.1f %8llu %8llu%s %8u %7u %6s\n",
+                   chips[c].name, fault_ppm[f], a.cpu_ns, a.bus_avg_us,
+                   (unsigned long long)a.bus_max_us, (unsigned long long)bound,
+                   a.bus_max_us <= bound ? " " : "!", a.failed_cycles, a.stale_cycles,
+                   a.checksum == b.checksum ? "yes" : "NO");
+        }
+    }
+    printf("\n! = a cycle exceeded the worst-case bound\n");
+    return 0;
+}
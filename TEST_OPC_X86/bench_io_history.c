@@ -0,0 +1,166 @@
+/*
+ * bench_io_history.c - Host-side benchmark for the I/O history ring buffers.
+ * See the project LICENSE file and main/opcua_esp32.c for licensing and attribution.
+ *
+ * Appends synthetic traces to components/io_cache/io_history.c (compiled
+ * unchanged from the firmware sources) with the firmware default ring
+ * size:
+ *
+ *   - discrete: 16 inputs, one input toggling at a random time every
+ *     1-20 ms, occasionally several at once, plus rare quality drops
+ *   - ADC: a slow sine with noise, one sample every 100 ms, 1/16 code
+ *     resolution
+ *
+ * For each trace it prints the cost per append, the average encoded size
+ * per stored sample, how many samples and how much time the ring holds,
+ * and whether decoding returns exactly the newest samples appended.
+ *
+ * Build (from this directory):
+ *   gcc -O2 -std=c11 -Wall -I../components/io_cache \
+ *       -o bench_io_history bench_io_history.c ../components/io_cache/io_history.c -lm
+ *
+ * Run:
+ *   ./bench_io_history -n 1000000
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "io_history.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEFAULT_SAMPLES     1000000
+#define ADC_PERIOD_US       100000  /* ADC sample period */
+#define ADC_NOISE_CODES     2.0     /* Noise amplitude, ADC codes */
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void make_discrete(io_history_sample_t *s, size_t n) {
+    uint64_t t = 1000000;
+    uint16_t word = 0x00F0;
+    srand(4321);
+    for (size_t i = 0; i < n; i++) {
+        t += 1000 + (uint64_t)(rand() % 19000);
+        word ^= (uint16_t)(1u << (rand() % 16));
+        if (rand() % 50 == 0) {
+            word ^= (uint16_t)rand();
+        }
+        s[i].time_us = t;
+        s[i].value = word;
+        s[i].quality = (rand() % 500 == 0) ? 2 : 1;  /* LAST_USABLE now and then, else GOOD */
+    }
+}
+
+static void make_adc(io_history_sample_t *s, size_t n) {
+    uint64_t t = 1000000;
+    srand(8765);
+    for (size_t i = 0; i < n; i++) {
+        t += ADC_PERIOD_US;
+        double code = 2048.0 + 1500.0 * sin(2.0 * M_PI * (double)i / 600.0) +
+                      ADC_NOISE_CODES * ((double)rand() / RAND_MAX - 0.5);
+        s[i].time_us = t;
+        s[i].value = io_history_adc_value((float)code);
+        s[i].quality = 1;
+    }
+}
+
+static void run_case(const char *name, io_history_kind_t kind, const io_history_sample_t *in, size_t n) {
+    static io_history_t h;
+    size_t *accepted = malloc(n * sizeof(*accepted));
+    size_t n_acc = 0;
+    if (!accepted) {
+        printf("Error: out of memory\n");
+        exit(1);
+    }
+
+    io_history_init(&h, kind);
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        if (io_history_append(&h, in[i].time_us, in[i].value, in[i].quality)) {
+            accepted[n_acc++] = i;
+        }
+    }
+    uint64_t t1 = now_ns();
+
+    // The ring must hold exactly the newest h.count accepted samples
+    io_history_iter_t it;
+    io_history_sample_t s;
+    size_t first = n_acc - h.count;
+    size_t k = 0;
+    int ok = 1;
+    io_history_iter_init(&it, &h);
+    while (io_history_next(&it, &s)) {
+        const io_history_sample_t *ref = &in[accepted[first + k]];
+        if (s.time_us != ref->time_us || s.value != ref->value || s.quality != ref->quality) {
+            ok = 0;
+        }
+        k++;
+    }
+    if (k != h.count) ok = 0;
+
+    double span_s = h.count ? (double)(h.last_time_us - in[accepted[first]].time_us) / 1e6 : 0.0;
+    printf("%-10s %10.1f %10zu %10.2f %10u %10.1f %8s\n",
+           name, (double)(t1 - t0) / n, n_acc, (double)h.used / (h.count ? h.count : 1),
+           (unsigned)h.count, span_s, ok ? "yes" : "NO");
+    free(accepted);
+}
+
+static void print_help(const char *program_name) {
+    printf("I/O history ring buffer benchmark\n");
+    printf("Usage: %s [OPTIONS]\n\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help           Show this help message\n");
+    printf("  -n, --samples N      Samples per trace (default: %d)\n", DEFAULT_SAMPLES);
+}
+
+int main(int argc, char *argv[]) {
+    long n = DEFAULT_SAMPLES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_help(argv[0]);
+            return 0;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--samples") == 0) && i + 1 < argc) {
+            n = atol(argv[++i]);
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (n < 1000) {
+        printf("Error: at least 1000 samples required\n");
+        return 1;
+    }
+
+    io_history_sample_t *in = malloc(n * sizeof(*in));
+    if (!in) {
+        printf("Error: out of memory\n");
+        return 1;
+    }
+
+    printf("Samples: %ld, ring size: %d bytes\n\n", n, IO_HISTORY_BYTES);
+    printf("%-10s %10s %10s %10s %10s %10s %8s\n",
+           "TRACE", "NS/APPEND", "STORED", "BYTES/SMP", "IN RING", "SPAN [s]", "EXACT");
+    printf("------------------------------------------------------------------------\n");
+
+    make_discrete(in, n);
+    run_case("discrete", IO_HISTORY_DISCRETE, in, n);
+    make_adc(in, n);
+    run_case("adc", IO_HISTORY_ADC, in, n);
+
+    free(in);
+    return 0;
+}
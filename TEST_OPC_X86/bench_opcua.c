@@ -0,0 +1,777 @@
+/*
+ * bench_opcua.c - OPC UA client benchmark with percentile latency reporting.
+ * See the project LICENSE file and main/opcua_esp32.c for licensing and attribution.
+ *
+ * Measures the server with prebuilt Read/Write requests sent through the
+ * low-level service calls, so the client does as little work per request
+ * as possible. Scenarios:
+ *
+ *   read       one Read request for one node
+ *   multiread  one Read request for the nine test_counter8 tags
+ *   loopback   Write loopback_input, then Read loopback_output and check it
+ *   subscribe  Write loopback_input and wait for the data change
+ *              notification of loopback_output (write to notification)
+ *   pipeline   asynchronous Read requests for one node with a fixed number
+ *              in flight (UA_Client_sendAsyncReadRequest and
+ *              UA_Client_run_iterate); the rate is the peak request rate of
+ *              the server, the latency that of each request in the queue
+ *
+ * Every scenario runs a number of warm-up iterations that are not
+ * recorded, then runs for a fixed duration and/or number of iterations.
+ * Latencies go into a log-linear histogram (components/io_cache/io_hist.h,
+ * 12.5 % bucket width) from which p50/p90/p99/p99.9 are taken. Results are
+ * printed as a table, JSON or CSV; CSV appended to a file gets its header
+ * only once, so one file can collect a series of runs.
+ *
+ * Build against an installed open62541 (from this directory):
+ *   gcc -O2 -std=c11 -Wall -I../components/io_cache \
+ *       -o bench_opcua bench_opcua.c ../components/io_cache/io_hist.c \
+ *       -lopen62541 -lpthread -lm
+ *
+ * or with the host build's copy of the stack:
+ *   cmake -S ../host -B ../build-host && cmake --build ../build-host --target bench_opcua
+ *
+ * Run:
+ *   ./bench_opcua -d 10 -w 200 opc.tcp://10.0.0.128:4840
+ *   ./bench_opcua -s read,loopback -n 10000 -f csv -o results.csv -l "$(git rev-parse --short HEAD)"
+ *   ./bench_opcua -s pipeline -q 1,2,4,8,16,32 -d 5 opc.tcp://10.0.0.128:4840
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#ifdef BENCH_OPCUA_AMALGAMATION
+#include "open62541.h"
+#else
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#endif
+#include "io_hist.h"
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_SERVER_URL      "opc.tcp://10.0.0.128:4840"
+#define DEFAULT_DURATION_S      10
+#define DEFAULT_WARMUP          100
+#define DEFAULT_TIMEOUT_MS      1000
+#define DEFAULT_READ_NODE       "discrete_inputs"
+#define MAX_CONSECUTIVE_ERRORS  10      /* Abort a scenario after this many failures in a row */
+#define DEFAULT_INFLIGHT        8
+#define MAX_INFLIGHT            256     /* Requests in flight in the pipeline scenario */
+#define MAX_DEPTHS              8       /* Pipeline depths per run (-q 1,2,4,...) */
+
+/* Tags read by the multiread scenario, as in test_counter8.c */
+static const char *const multiread_nodes[] = {
+    "diagnostic_counter", "loopback_input", "loopback_output",
+    "discrete_inputs", "discrete_outputs",
+    "adc_channel_1", "adc_channel_2", "adc_channel_3", "adc_channel_4",
+};
+#define MULTIREAD_COUNT     (sizeof(multiread_nodes) / sizeof(multiread_nodes[0]))
+
+typedef enum { FORMAT_TEXT, FORMAT_JSON, FORMAT_CSV } output_format_t;
+
+// Benchmark state shared by the scenarios
+typedef struct {
+    UA_Client *client;
+    UA_UInt32 timeout_ms;
+    const char *read_node;
+    double publishing_ms;
+    double sampling_ms;
+
+    UA_ReadValueId read_ids[MULTIREAD_COUNT];
+    UA_ReadRequest read_request;
+    UA_WriteValue write_value;
+    UA_WriteRequest write_request;
+    UA_UInt16 sequence;             /* Last value written to loopback_input */
+    uint64_t mismatches;            /* Loopback values that did not match */
+
+    UA_UInt32 subscription_id;
+    UA_UInt16 notified;             /* Last value notified for loopback_output */
+    bool notified_valid;
+    double revised_publishing_ms;
+    double revised_sampling_ms;
+
+    unsigned inflight_max;          /* Pipeline depth */
+    unsigned inflight;              /* Requests sent and not answered */
+    bool slot_used[MAX_INFLIGHT];
+    uint64_t sent_at[MAX_INFLIGHT]; /* Send time per slot (request userdata) */
+    uint64_t done_latency[MAX_INFLIGHT];
+    UA_StatusCode done_status[MAX_INFLIGHT];
+    unsigned done_head;             /* Completed requests not yet taken by pipeline_op() */
+    unsigned done_count;
+    uint64_t op_latency_ns;         /* Set by an op that measures its own latency */
+} bench_t;
+
+// One scenario: setup/teardown around a repeated operation
+typedef struct {
+    const char *name;
+    bool (*setup)(bench_t *b);
+    UA_StatusCode (*op)(bench_t *b);
+    void (*teardown)(bench_t *b);
+} scenario_t;
+
+// Result of one scenario
+typedef struct {
+    const char *name;
+    unsigned inflight;              /* Requests in flight (1 for the synchronous scenarios) */
+    uint64_t ops;                   /* Successful operations (recorded) */
+    uint64_t errors;                /* Failed operations */
+    uint64_t mismatches;            /* Successful loopbacks with a wrong value */
+    UA_StatusCode last_error;
+    bool aborted;
+    double seconds;
+    io_hist_t hist;                 /* Latency in ns */
+} result_t;
+
+static volatile sig_atomic_t running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+/* Stack log lines go to stderr so they never mix with results on stdout */
+static void log_stderr(void *context, UA_LogLevel level, UA_LogCategory category,
+                       const char *msg, va_list args) {
+    (void)context; (void)category;
+    if (level >= UA_LOGLEVEL_WARNING) {
+        vfprintf(stderr, msg, args);
+        fputc('\n', stderr);
+    }
+}
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ========== REQUESTS ==========
+
+static void prepare_read(bench_t *b, const char *const *nodes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        UA_ReadValueId_init(&b->read_ids[i]);
+        b->read_ids[i].nodeId = UA_NODEID_STRING(1, (char *)nodes[i]);
+        b->read_ids[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest_init(&b->read_request);
+    b->read_request.nodesToRead = b->read_ids;
+    b->read_request.nodesToReadSize = count;
+    b->read_request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+}
+
+static void prepare_write(bench_t *b) {
+    UA_WriteValue_init(&b->write_value);
+    b->write_value.nodeId = UA_NODEID_STRING(1, "loopback_input");
+    b->write_value.attributeId = UA_ATTRIBUTEID_VALUE;
+    b->write_value.value.hasValue = true;
+    UA_WriteRequest_init(&b->write_request);
+    b->write_request.nodesToWrite = &b->write_value;
+    b->write_request.nodesToWriteSize = 1;
+}
+
+/* Overall status of a Read response: service result, then the first bad value */
+static UA_StatusCode read_status(const UA_ReadResponse *resp, size_t expected) {
+    UA_StatusCode status = resp->responseHeader.serviceResult;
+
+    if (status == UA_STATUSCODE_GOOD && resp->resultsSize != expected) {
+        status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    for (size_t i = 0; status == UA_STATUSCODE_GOOD && i < resp->resultsSize; i++) {
+        if (resp->results[i].hasStatus && resp->results[i].status != UA_STATUSCODE_GOOD) {
+            status = resp->results[i].status;
+        } else if (!resp->results[i].hasValue) {
+            status = UA_STATUSCODE_BADNODATA;
+        }
+    }
+    return status;
+}
+
+/* Send the prepared Read request; the first value is returned if asked for */
+static UA_StatusCode send_read(bench_t *b, UA_Variant *first) {
+    UA_ReadResponse resp = UA_Client_Service_read(b->client, b->read_request);
+    UA_StatusCode status = read_status(&resp, b->read_request.nodesToReadSize);
+
+    if (status == UA_STATUSCODE_GOOD && first != NULL) {
+        UA_Variant_copy(&resp.results[0].value, first);
+    }
+    UA_ReadResponse_clear(&resp);
+    return status;
+}
+
+static UA_StatusCode write_loopback(bench_t *b, UA_UInt16 value) {
+    UA_Variant_setScalar(&b->write_value.value.value, &value, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_WriteResponse resp = UA_Client_Service_write(b->client, b->write_request);
+    UA_StatusCode status = resp.responseHeader.serviceResult;
+
+    if (status == UA_STATUSCODE_GOOD) {
+        status = resp.resultsSize == 1 ? resp.results[0] : UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    UA_WriteResponse_clear(&resp);
+    return status;
+}
+
+// ========== SCENARIOS ==========
+
+static bool read_setup(bench_t *b) {
+    const char *node = b->read_node;
+    prepare_read(b, &node, 1);
+    return true;
+}
+
+static UA_StatusCode read_op(bench_t *b) {
+    return send_read(b, NULL);
+}
+
+static bool multiread_setup(bench_t *b) {
+    prepare_read(b, multiread_nodes, MULTIREAD_COUNT);
+    return true;
+}
+
+static bool loopback_setup(bench_t *b) {
+    static const char *const node = "loopback_output";
+    prepare_read(b, &node, 1);
+    prepare_write(b);
+    return true;
+}
+
+static UA_StatusCode loopback_op(bench_t *b) {
+    UA_Variant value;
+    UA_StatusCode status = write_loopback(b, ++b->sequence);
+
+    if (status != UA_STATUSCODE_GOOD) {
+        return status;
+    }
+    UA_Variant_init(&value);
+    status = send_read(b, &value);
+    if (status == UA_STATUSCODE_GOOD &&
+        (!UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_UINT16]) ||
+         *(UA_UInt16 *)value.data != b->sequence)) {
+        b->mismatches++;
+    }
+    UA_Variant_clear(&value);
+    return status;
+}
+
+static void on_data_change(UA_Client *client, UA_UInt32 subId, void *subContext,
+                           UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    bench_t *b = (bench_t *)monContext;
+    (void)client; (void)subId; (void)subContext; (void)monId;
+
+    if (value->hasValue && UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_UINT16])) {
+        b->notified = *(UA_UInt16 *)value->value.data;
+        b->notified_valid = true;
+    }
+}
+
+static bool subscribe_setup(bench_t *b) {
+    UA_CreateSubscriptionRequest req = UA_CreateSubscriptionRequest_default();
+    req.requestedPublishingInterval = b->publishing_ms;
+    UA_CreateSubscriptionResponse resp = UA_Client_Subscriptions_create(b->client, req, NULL, NULL, NULL);
+
+    if (resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Error: CreateSubscription failed: %s\n", UA_StatusCode_name(resp.responseHeader.serviceResult));
+        UA_CreateSubscriptionResponse_clear(&resp);
+        return false;
+    }
+    b->subscription_id = resp.subscriptionId;
+    b->revised_publishing_ms = resp.revisedPublishingInterval;
+    UA_CreateSubscriptionResponse_clear(&resp);
+
+    UA_MonitoredItemCreateRequest item =
+        UA_MonitoredItemCreateRequest_default(UA_NODEID_STRING(1, "loopback_output"));
+    item.requestedParameters.samplingInterval = b->sampling_ms;
+    UA_MonitoredItemCreateResult res = UA_Client_MonitoredItems_createDataChange(
+        b->client, b->subscription_id, UA_TIMESTAMPSTORETURN_NEITHER, item, b, on_data_change, NULL);
+    UA_StatusCode status = res.statusCode;
+    b->revised_sampling_ms = res.revisedSamplingInterval;
+    UA_MonitoredItemCreateResult_clear(&res);
+
+    if (status != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Error: CreateMonitoredItems failed: %s\n", UA_StatusCode_name(status));
+        UA_Client_Subscriptions_deleteSingle(b->client, b->subscription_id);
+        return false;
+    }
+    prepare_write(b);
+    b->notified_valid = false;
+    return true;
+}
+
+static UA_StatusCode subscribe_op(bench_t *b) {
+    UA_UInt16 expected = ++b->sequence;
+    uint64_t deadline = now_ns() + (uint64_t)b->timeout_ms * 1000000ull;
+    UA_StatusCode status = write_loopback(b, expected);
+
+    // The notification may already have arrived while waiting for the write response
+    while (status == UA_STATUSCODE_GOOD && !(b->notified_valid && b->notified == expected)) {
+        if (now_ns() > deadline) {
+            return UA_STATUSCODE_BADTIMEOUT;
+        }
+        status = UA_Client_run_iterate(b->client, 1);
+    }
+    return status;
+}
+
+static void subscribe_teardown(bench_t *b) {
+    UA_Client_Subscriptions_deleteSingle(b->client, b->subscription_id);
+}
+
+static void on_read_response(UA_Client *client, void *userdata, UA_UInt32 requestId, UA_ReadResponse *rr) {
+    bench_t *b = (bench_t *)UA_Client_getContext(client);
+    unsigned slot = (unsigned)(uintptr_t)userdata;
+    unsigned tail = (b->done_head + b->done_count) % MAX_INFLIGHT;
+    (void)requestId;
+
+    b->done_latency[tail] = now_ns() - b->sent_at[slot];
+    b->done_status[tail] = read_status(rr, b->read_request.nodesToReadSize);
+    b->done_count++;
+    b->slot_used[slot] = false;
+    b->inflight--;
+}
+
+static bool pipeline_setup(bench_t *b) {
+    const char *node = b->read_node;
+    prepare_read(b, &node, 1);
+    memset(b->slot_used, 0, sizeof(b->slot_used));
+    b->inflight = 0;
+    b->done_head = 0;
+    b->done_count = 0;
+    return true;
+}
+
+/*
+ * Refill the window to inflight_max requests, then take one answered
+ * request; its latency is from its own send to its response.
+ */
+static UA_StatusCode pipeline_op(bench_t *b) {
+    unsigned slot = 0;
+
+    while (b->inflight < b->inflight_max) {
+        while (b->slot_used[slot]) {
+            slot++;
+        }
+        b->sent_at[slot] = now_ns();
+        UA_StatusCode status = UA_Client_sendAsyncReadRequest(b->client, &b->read_request, on_read_response,
+                                                              (void *)(uintptr_t)slot, NULL);
+        if (status != UA_STATUSCODE_GOOD) {
+            return status;
+        }
+        b->slot_used[slot] = true;
+        b->inflight++;
+    }
+
+    uint64_t deadline = now_ns() + (uint64_t)b->timeout_ms * 1000000ull;
+    while (b->done_count == 0) {
+        if (now_ns() > deadline) {
+            return UA_STATUSCODE_BADTIMEOUT;
+        }
+        UA_StatusCode status = UA_Client_run_iterate(b->client, 1);
+        if (status != UA_STATUSCODE_GOOD) {
+            return status;
+        }
+    }
+    b->op_latency_ns = b->done_latency[b->done_head];
+    UA_StatusCode status = b->done_status[b->done_head];
+    b->done_head = (b->done_head + 1) % MAX_INFLIGHT;
+    b->done_count--;
+    return status;
+}
+
+/* Collect the requests still in flight so the next scenario starts idle */
+static void pipeline_teardown(bench_t *b) {
+    uint64_t deadline = now_ns() + (uint64_t)b->timeout_ms * 1000000ull;
+
+    while (b->inflight > 0 && now_ns() < deadline) {
+        if (UA_Client_run_iterate(b->client, 10) != UA_STATUSCODE_GOOD) {
+            break;
+        }
+    }
+    b->done_count = 0;
+}
+
+static const scenario_t scenarios[] = {
+    { "read",      read_setup,      read_op,      NULL },
+    { "multiread", multiread_setup, read_op,      NULL },
+    { "loopback",  loopback_setup,  loopback_op,  NULL },
+    { "subscribe", subscribe_setup, subscribe_op, subscribe_teardown },
+    { "pipeline",  pipeline_setup,  pipeline_op,  pipeline_teardown },
+};
+#define SCENARIO_COUNT      (sizeof(scenarios) / sizeof(scenarios[0]))
+
+// ========== RUNNER ==========
+
+static void run_scenario(bench_t *b, const scenario_t *sc, int warmup, uint64_t iterations,
+                         int duration_s, result_t *r) {
+    memset(r, 0, sizeof(*r));
+    r->name = sc->name;
+    r->inflight = sc->op == pipeline_op ? b->inflight_max : 1;
+    io_hist_reset(&r->hist);
+
+    if (!sc->setup(b)) {
+        r->aborted = true;
+        return;
+    }
+
+    // Warm-up: connection buffers, server-side caches and branch predictors
+    for (int i = 0; i < warmup && running; i++) {
+        sc->op(b);
+    }
+    b->mismatches = 0;
+
+    uint64_t start = now_ns();
+    uint64_t end = duration_s > 0 ? start + (uint64_t)duration_s * 1000000000ull : UINT64_MAX;
+    unsigned consecutive = 0;
+
+    while (running && (iterations == 0 || r->ops + r->errors < iterations)) {
+        uint64_t t0 = now_ns();
+        if (t0 >= end) {
+            break;
+        }
+        b->op_latency_ns = 0;
+        UA_StatusCode status = sc->op(b);
+        uint64_t dt = b->op_latency_ns ? b->op_latency_ns : now_ns() - t0;
+
+        if (status == UA_STATUSCODE_GOOD) {
+            io_hist_record(&r->hist, dt < UINT32_MAX ? (uint32_t)dt : UINT32_MAX);
+            r->ops++;
+            consecutive = 0;
+        } else {
+            r->errors++;
+            r->last_error = status;
+            if (++consecutive >= MAX_CONSECUTIVE_ERRORS) {
+                r->aborted = true;
+                break;
+            }
+        }
+    }
+    r->seconds = (double)(now_ns() - start) / 1e9;
+    r->mismatches = b->mismatches;
+
+    if (sc->teardown != NULL) {
+        sc->teardown(b);
+    }
+}
+
+// ========== OUTPUT ==========
+
+static double pct_us(const result_t *r, double p) {
+    return (double)io_hist_percentile(&r->hist, p) / 1000.0;
+}
+
+static double mean_us(const result_t *r) {
+    return r->hist.count ? (double)r->hist.sum / (double)r->hist.count / 1000.0 : 0.0;
+}
+
+static double min_us(const result_t *r) {
+    return r->hist.count ? (double)r->hist.min / 1000.0 : 0.0;
+}
+
+static double rate(const result_t *r) {
+    return r->seconds > 0.0 ? (double)r->ops / r->seconds : 0.0;
+}
+
+static void print_text(FILE *out, const result_t *res, size_t count) {
+    fprintf(out, "\n%-10s %5s %9s %7s %6s %9s %8s %8s %8s %8s %8s %8s %8s\n",
+            "SCENARIO", "INFL", "OPS", "ERRORS", "MISM", "RATE/s",
+            "MIN", "MEAN", "P50", "P90", "P99", "P99.9", "MAX");
+    fprintf(out, "%-10s %5s %9s %7s %6s %9s %8s %8s %8s %8s %8s %8s %8s\n",
+            "", "", "", "", "", "", "[us]", "[us]", "[us]", "[us]", "[us]", "[us]", "[us]");
+    fprintf(out, "---------------------------------------------------------------------------------------------------------------\n");
+    for (size_t i = 0; i < count; i++) {
+        const result_t *r = &res[i];
+        fprintf(out, "%-10s %5u %9llu %7llu %6llu %9.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f%s\n",
+                r->name, r->inflight, (unsigned long long)r->ops, (unsigned long long)r->errors,
+                (unsigned long long)r->mismatches, rate(r),
+                min_us(r), mean_us(r), pct_us(r, 0.50), pct_us(r, 0.90), pct_us(r, 0.99),
+                pct_us(r, 0.999), (double)r->hist.max / 1000.0, r->aborted ? "  ABORTED" : "");
+        if (r->errors > 0) {
+            fprintf(out, "%-10s last error: %s\n", "", UA_StatusCode_name(r->last_error));
+        }
+    }
+    fprintf(out, "\nPercentiles are histogram estimates (+/- 6 %%). INFL = requests in flight,\n"
+            "MISM = loopback values that did not match.\n");
+}
+
+static void print_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fprintf(out, "\\%c", *s);
+        } else if ((unsigned char)*s < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*s);
+        } else {
+            fputc(*s, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void print_json(FILE *out, const char *timestamp, const char *url, const char *label,
+                       const result_t *res, size_t count) {
+    fprintf(out, "{\n  \"timestamp\": \"%s\",\n  \"server\": ", timestamp);
+    print_json_string(out, url);
+    fprintf(out, ",\n  \"label\": ");
+    print_json_string(out, label);
+    fprintf(out, ",\n  \"scenarios\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        const result_t *r = &res[i];
+        fprintf(out, "    { \"name\": \"%s\", \"inflight\": %u, \"ops\": %llu, \"errors\": %llu, \"mismatches\": %llu, "
+                "\"aborted\": %s, \"seconds\": %.3f, \"rate\": %.1f,\n"
+                "      \"latency_us\": { \"min\": %.1f, \"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, "
+                "\"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f } }%s\n",
+                r->name, r->inflight, (unsigned long long)r->ops, (unsigned long long)r->errors,
+                (unsigned long long)r->mismatches, r->aborted ? "true" : "false", r->seconds, rate(r),
+                min_us(r), mean_us(r), pct_us(r, 0.50), pct_us(r, 0.90), pct_us(r, 0.99),
+                pct_us(r, 0.999), (double)r->hist.max / 1000.0, i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static void print_csv(FILE *out, bool header, const char *timestamp, const char *url, const char *label,
+                      const result_t *res, size_t count) {
+    if (header) {
+        fprintf(out, "timestamp,server,label,scenario,inflight,ops,errors,mismatches,aborted,seconds,rate,"
+                "min_us,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n");
+    }
+    for (size_t i = 0; i < count; i++) {
+        const result_t *r = &res[i];
+        // URL and label are written as given: they must not contain commas
+        fprintf(out, "%s,%s,%s,%s,%u,%llu,%llu,%llu,%d,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+                timestamp, url, label, r->name, r->inflight, (unsigned long long)r->ops,
+                (unsigned long long)r->errors, (unsigned long long)r->mismatches, r->aborted ? 1 : 0,
+                r->seconds, rate(r), min_us(r), mean_us(r), pct_us(r, 0.50), pct_us(r, 0.90),
+                pct_us(r, 0.99), pct_us(r, 0.999), (double)r->hist.max / 1000.0);
+    }
+}
+
+// ========== MAIN ==========
+
+static void print_help(const char *program_name) {
+    printf("OPC UA server benchmark\n");
+    printf("Usage: %s [OPTIONS] [SERVER_URL]\n\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help             Show this help message\n");
+    printf("  -s, --scenarios LIST   Comma separated: read, multiread, loopback, subscribe,\n");
+    printf("                         pipeline, all (default: all)\n");
+    printf("  -d, --duration N       Seconds per scenario, 0 = no limit (default: %d)\n", DEFAULT_DURATION_S);
+    printf("  -n, --iterations N     Operations per scenario, 0 = no limit (default: 0)\n");
+    printf("  -w, --warmup N         Unrecorded operations before each scenario (default: %d)\n", DEFAULT_WARMUP);
+    printf("  -t, --timeout N        Request timeout in ms (default: %d)\n", DEFAULT_TIMEOUT_MS);
+    printf("  -N, --node ID          Node of the read scenario, ns=1 string id (default: %s)\n", DEFAULT_READ_NODE);
+    printf("  -P, --publishing N     Requested publishing interval in ms (default: 0 = server minimum)\n");
+    printf("  -S, --sampling N       Requested sampling interval in ms (default: 0 = server minimum)\n");
+    printf("  -q, --inflight LIST    Pipeline depths, comma separated, 1-%d (default: %d)\n", MAX_INFLIGHT, DEFAULT_INFLIGHT);
+    printf("  -f, --format F         text, json or csv (default: text)\n");
+    printf("  -o, --output FILE      Write results to FILE (csv is appended)\n");
+    printf("  -l, --label TEXT       Label stored with json/csv results, e.g. a git revision\n");
+    printf("\n");
+    printf("Default server URL: %s\n", DEFAULT_SERVER_URL);
+    printf("Ctrl+C ends the current scenario early and skips the rest\n");
+}
+
+static bool parse_depths(const char *list, unsigned depths[MAX_DEPTHS], size_t *count) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", list);
+    *count = 0;
+
+    for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        int depth = atoi(tok);
+        if (depth < 1 || depth > MAX_INFLIGHT || *count == MAX_DEPTHS) {
+            printf("Error: pipeline depths must be 1-%d, at most %d of them\n", MAX_INFLIGHT, MAX_DEPTHS);
+            return false;
+        }
+        depths[(*count)++] = (unsigned)depth;
+    }
+    return *count > 0;
+}
+
+static bool parse_scenarios(const char *list, bool selected[SCENARIO_COUNT]) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", list);
+    memset(selected, 0, SCENARIO_COUNT * sizeof(bool));
+
+    for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        bool found = false;
+        for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+            if (strcmp(tok, "all") == 0 || strcmp(tok, scenarios[i].name) == 0) {
+                selected[i] = found = true;
+            }
+        }
+        if (!found) {
+            printf("Error: unknown scenario '%s'\n", tok);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char *server_url = DEFAULT_SERVER_URL;
+    const char *output_path = NULL;
+    const char *label = "";
+    output_format_t format = FORMAT_TEXT;
+    bool selected[SCENARIO_COUNT];
+    int duration_s = DEFAULT_DURATION_S;
+    long long iterations = 0;
+    int warmup = DEFAULT_WARMUP;
+    int timeout_ms = DEFAULT_TIMEOUT_MS;
+    unsigned depths[MAX_DEPTHS] = { DEFAULT_INFLIGHT };
+    size_t depth_count = 1;
+    bench_t bench;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.read_node = DEFAULT_READ_NODE;
+    parse_scenarios("all", selected);
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_help(argv[0]);
+            return 0;
+        } else if ((strcmp(arg, "-s") == 0 || strcmp(arg, "--scenarios") == 0) && has_value) {
+            if (!parse_scenarios(argv[++i], selected)) return 1;
+        } else if ((strcmp(arg, "-d") == 0 || strcmp(arg, "--duration") == 0) && has_value) {
+            duration_s = atoi(argv[++i]);
+        } else if ((strcmp(arg, "-n") == 0 || strcmp(arg, "--iterations") == 0) && has_value) {
+            iterations = atoll(argv[++i]);
+        } else if ((strcmp(arg, "-w") == 0 || strcmp(arg, "--warmup") == 0) && has_value) {
+            warmup = atoi(argv[++i]);
+        } else if ((strcmp(arg, "-t") == 0 || strcmp(arg, "--timeout") == 0) && has_value) {
+            timeout_ms = atoi(argv[++i]);
+        } else if ((strcmp(arg, "-N") == 0 || strcmp(arg, "--node") == 0) && has_value) {
+            bench.read_node = argv[++i];
+        } else if ((strcmp(arg, "-P") == 0 || strcmp(arg, "--publishing") == 0) && has_value) {
+            bench.publishing_ms = atof(argv[++i]);
+        } else if ((strcmp(arg, "-S") == 0 || strcmp(arg, "--sampling") == 0) && has_value) {
+            bench.sampling_ms = atof(argv[++i]);
+        } else if ((strcmp(arg, "-q") == 0 || strcmp(arg, "--inflight") == 0) && has_value) {
+            if (!parse_depths(argv[++i], depths, &depth_count)) return 1;
+        } else if ((strcmp(arg, "-f") == 0 || strcmp(arg, "--format") == 0) && has_value) {
+            const char *f = argv[++i];
+            if (strcmp(f, "text") == 0) format = FORMAT_TEXT;
+            else if (strcmp(f, "json") == 0) format = FORMAT_JSON;
+            else if (strcmp(f, "csv") == 0) format = FORMAT_CSV;
+            else {
+                printf("Error: unknown format '%s'\n", f);
+                return 1;
+            }
+        } else if ((strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) && has_value) {
+            output_path = argv[++i];
+        } else if ((strcmp(arg, "-l") == 0 || strcmp(arg, "--label") == 0) && has_value) {
+            label = argv[++i];
+        } else if (arg[0] == '-') {
+            printf("Unknown option: %s\n", arg);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        } else {
+            server_url = arg;
+        }
+    }
+
+    if (duration_s < 0 || iterations < 0 || warmup < 0 || timeout_ms <= 0 ||
+        (duration_s == 0 && iterations == 0)) {
+        printf("Error: invalid arguments\n");
+        return 1;
+    }
+
+    // Progress goes to stderr when the results go to stdout in a machine format
+    FILE *log = (format == FORMAT_TEXT || output_path != NULL) ? stdout : stderr;
+
+    signal(SIGINT, on_signal);
+
+    bench.client = UA_Client_new();
+    UA_ClientConfig *config = UA_Client_getConfig(bench.client);
+    config->logger.log = log_stderr;
+    config->logger.clear = NULL;
+    UA_ClientConfig_setDefault(config);
+    config->timeout = (UA_UInt32)timeout_ms;
+    config->clientContext = &bench;
+    bench.timeout_ms = (UA_UInt32)timeout_ms;
+
+    fprintf(log, "Connecting to %s...\n", server_url);
+    UA_StatusCode status = UA_Client_connect(bench.client, server_url);
+    if (status != UA_STATUSCODE_GOOD) {
+        fprintf(log, "Connection failed: %s\n", UA_StatusCode_name(status));
+        UA_Client_delete(bench.client);
+        return 1;
+    }
+    fprintf(log, "Warm-up %d, duration %d s, iterations %lld per scenario\n", warmup, duration_s, iterations);
+
+    result_t results[SCENARIO_COUNT + MAX_DEPTHS];
+    size_t count = 0;
+    for (size_t i = 0; i < SCENARIO_COUNT && running; i++) {
+        if (!selected[i]) {
+            continue;
+        }
+        // The pipeline scenario runs once per depth, the others once
+        bool pipeline = scenarios[i].op == pipeline_op;
+        for (size_t d = 0; d < (pipeline ? depth_count : 1) && running; d++) {
+            bench.inflight_max = depths[d];
+            if (pipeline) {
+                fprintf(log, "Running %s with %u in flight...\n", scenarios[i].name, depths[d]);
+            } else {
+                fprintf(log, "Running %s...\n", scenarios[i].name);
+            }
+            fflush(log);
+            run_scenario(&bench, &scenarios[i], warmup, (uint64_t)iterations, duration_s, &results[count]);
+            if (strcmp(scenarios[i].name, "subscribe") == 0 && !results[count].aborted) {
+                fprintf(log, "  revised publishing interval %.1f ms, sampling interval %.1f ms\n",
+                        bench.revised_publishing_ms, bench.revised_sampling_ms);
+            }
+            count++;
+        }
+    }
+
+    UA_Client_disconnect(bench.client);
+    UA_Client_delete(bench.client);
+
+    char timestamp[32];
+    time_t t = time(NULL);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    FILE *out = stdout;
+    bool csv_header = true;
+    if (output_path != NULL) {
+        out = fopen(output_path, format == FORMAT_CSV ? "a" : "w");
+        if (out == NULL) {
+            perror(output_path);
+            return 1;
+        }
+        if (format == FORMAT_CSV) {
+            fseek(out, 0, SEEK_END);
+            csv_header = ftell(out) == 0;
+        }
+    }
+
+    switch (format) {
+    case FORMAT_TEXT:
+        print_text(out, results, count);
+        break;
+    case FORMAT_JSON:
+        print_json(out, timestamp, server_url, label, results, count);
+        break;
+    case FORMAT_CSV:
+        print_csv(out, csv_header, timestamp, server_url, label, results, count);
+        break;
+    }
+    if (out != stdout) {
+        fclose(out);
+        fprintf(log, "Results written to %s\n", output_path);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].errors > 0 || results[i].mismatches > 0 || results[i].aborted) {
+            return 2;
+        }
+    }
+    return 0;
+}
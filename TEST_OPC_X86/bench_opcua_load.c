@@ -0,0 +1,833 @@
+/*
+ * bench_opcua_load.c - Multi-session OPC UA load generator for server scaling tests.
+ * See the project LICENSE file and main/opcua_esp32.c for licensing and attribution.
+ *
+ * Opens N client sessions, one thread per session, the way several SCADA,
+ * HMI and historian clients load one gateway. Every session follows a
+ * profile: a weighted mix of single-node reads, multi-node reads and
+ * loopback writes at a target rate (or back to back), plus optionally a
+ * subscription with a number of monitored items. The open62541 client has
+ * one session per secure channel, so every session is its own secure
+ * channel and TCP connection, as with separate client applications.
+ *
+ * Requests are sent on a fixed schedule and latency is measured from the
+ * scheduled send time, so a server that falls behind shows up in the
+ * percentiles instead of only lowering the request rate (no coordinated
+ * omission). Statistics start after a warm-up period. The report has the
+ * aggregate throughput and latency percentiles, per-session percentiles
+ * and errors, and connect failures with their status codes.
+ *
+ * With --sweep the run is repeated for 1, 1 + step, ... up to N sessions
+ * and one aggregate line is printed per session count, which shows where
+ * throughput stops scaling or sessions start to fail (e.g. at the
+ * CONFIG_LWIP_MAX_SOCKETS limit of the firmware).
+ *
+ * Build against an installed open62541 (from this directory):
+ *   gcc -O2 -std=c11 -Wall -pthread -I../components/io_cache \
+ *       -o bench_opcua_load bench_opcua_load.c ../components/io_cache/io_hist.c \
+ *       -lopen62541 -lm
+ *
+ * or with the host build's copy of the stack:
+ *   cmake -S ../host -B ../build-host && cmake --build ../build-host --target bench_opcua_load
+ *
+ * Run:
+ *   ./bench_opcua_load -c 6 -p scada -p hmi -p historian -d 30 opc.tcp://10.0.0.128:4840
+ *   ./bench_opcua_load -c 12 --sweep 1 -p stress -d 10 -f csv -o sweep.csv opc.tcp://10.0.0.128:4840
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#ifdef BENCH_OPCUA_AMALGAMATION
+#include "open62541.h"
+#else
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#endif
+#include "io_hist.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_SERVER_URL  "opc.tcp://10.0.0.128:4840"
+#define DEFAULT_SESSIONS    4
+#define DEFAULT_DURATION_S  10
+#define DEFAULT_WARMUP_S    2
+#define DEFAULT_TIMEOUT_MS  1000
+#define MAX_SESSIONS        64
+#define MAX_PROFILES        8
+#define CONNECT_WAIT_S      30      /* Longest wait for all sessions to connect */
+
+/* Tags of the server, as in test_counter8.c; reads and monitored items cycle through them */
+static const char *const tag_nodes[] = {
+    "diagnostic_counter", "loopback_input", "loopback_output",
+    "discrete_inputs", "discrete_outputs",
+    "adc_channel_1", "adc_channel_2", "adc_channel_3", "adc_channel_4",
+};
+#define TAG_COUNT   (sizeof(tag_nodes) / sizeof(tag_nodes[0]))
+
+typedef enum { OP_READ, OP_MULTIREAD, OP_WRITE, OP_COUNT } op_kind_t;
+
+typedef enum { FORMAT_TEXT, FORMAT_JSON, FORMAT_CSV } output_format_t;
+
+// Client behaviour of one session
+typedef struct {
+    char name[16];
+    unsigned weight[OP_COUNT];      /* Relative share of each request type */
+    double rate_hz;                 /* Requests per second, 0 = back to back */
+    unsigned items;                 /* Monitored items, 0 = no subscription */
+    double interval_ms;             /* Publishing and sampling interval */
+} profile_t;
+
+static const profile_t presets[] = {
+    /* Polling SCADA: the whole tag set ten times a second */
+    { "scada",     { 0, 1, 0 }, 10.0,  0, 0.0 },
+    /* Operator panel: single reads, occasional writes, subscribed tags */
+    { "hmi",       { 4, 0, 1 }, 20.0,  5, 100.0 },
+    /* Historian: subscription only */
+    { "historian", { 0, 0, 0 },  0.0,  9, 1000.0 },
+    /* Single reads back to back */
+    { "stress",    { 1, 0, 0 },  0.0,  0, 0.0 },
+};
+#define PRESET_COUNT    (sizeof(presets) / sizeof(presets[0]))
+
+// State and statistics of one session thread
+typedef struct {
+    int index;
+    const profile_t *profile;
+    pthread_t thread;
+    UA_Client *client;
+    uint64_t rng;
+
+    UA_ReadValueId read_ids[TAG_COUNT];
+    UA_WriteValue write_value;
+    UA_UInt16 sequence;
+    unsigned next_tag;
+
+    UA_StatusCode connect_status;   /* Connect or subscription failure */
+    bool disconnected;              /* Connection lost during the run */
+    uint64_t ops[OP_COUNT];
+    uint64_t errors;
+    UA_StatusCode last_error;
+    uint64_t late;                  /* Requests sent more than one period late */
+    uint64_t notifications;
+    io_hist_t hist;                 /* Latency in ns */
+} session_t;
+
+// Aggregate of one run
+typedef struct {
+    int sessions;
+    int connected;
+    int lost;
+    double target_rate;             /* Sum of the rate-limited targets */
+    double seconds;
+    uint64_t ops;
+    uint64_t errors;
+    uint64_t late;
+    uint64_t notifications;
+    io_hist_t hist;
+} run_result_t;
+
+static const char *server_url = DEFAULT_SERVER_URL;
+static UA_UInt32 timeout_ms = DEFAULT_TIMEOUT_MS;
+static volatile sig_atomic_t interrupted = 0;
+static volatile int running;        /* Session threads keep going */
+static volatile int started;        /* Session threads may send requests */
+static volatile int recording;      /* Session threads record statistics */
+static int connect_done;            /* Sessions that finished connecting */
+static pthread_mutex_t connect_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void on_signal(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+/* Stack errors go to stderr so they never mix with results on stdout; warnings
+ * (certificate policy, publish responses after disconnect) would repeat per session */
+static void log_stderr(void *context, UA_LogLevel level, UA_LogCategory category,
+                       const char *msg, va_list args) {
+    (void)context; (void)category;
+    if (level >= UA_LOGLEVEL_ERROR) {
+        vfprintf(stderr, msg, args);
+        fputc('\n', stderr);
+    }
+}
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    nanosleep(&ts, NULL);
+}
+
+// xorshift64*, seeded per session so a run picks the same request sequence
+static uint32_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+// ========== PROFILES ==========
+
+static bool profile_has_requests(const profile_t *p) {
+    return p->weight[OP_READ] + p->weight[OP_MULTIREAD] + p->weight[OP_WRITE] > 0;
+}
+
+/* Parse "preset", "preset:key=value,..." or "key=value,..." (based on "stress") */
+static bool parse_profile(const char *spec, profile_t *p) {
+    char buf[128];
+    char *settings = buf;
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    *p = presets[PRESET_COUNT - 1];
+    char *colon = strchr(buf, ':');
+    if (colon != NULL || strchr(buf, '=') == NULL) {
+        if (colon != NULL) {
+            *colon = '\0';
+            settings = colon + 1;
+        } else {
+            settings = buf + strlen(buf);
+        }
+        size_t i;
+        for (i = 0; i < PRESET_COUNT && strcmp(buf, presets[i].name) != 0; i++) {
+        }
+        if (i == PRESET_COUNT) {
+            fprintf(stderr, "Error: unknown profile '%s'\n", buf);
+            return false;
+        }
+        *p = presets[i];
+    } else {
+        snprintf(p->name, sizeof(p->name), "custom");
+    }
+
+    for (char *tok = strtok(settings, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        char *eq = strchr(tok, '=');
+        if (eq == NULL) {
+            fprintf(stderr, "Error: expected key=value in profile, got '%s'\n", tok);
+            return false;
+        }
+        *eq = '\0';
+        double v = atof(eq + 1);
+        if (v < 0) {
+            fprintf(stderr, "Error: negative value for '%s'\n", tok);
+            return false;
+        }
+        if (strcmp(tok, "read") == 0) p->weight[OP_READ] = (unsigned)v;
+        else if (strcmp(tok, "multiread") == 0) p->weight[OP_MULTIREAD] = (unsigned)v;
+        else if (strcmp(tok, "write") == 0) p->weight[OP_WRITE] = (unsigned)v;
+        else if (strcmp(tok, "rate") == 0) p->rate_hz = v;
+        else if (strcmp(tok, "sub") == 0) p->items = (unsigned)v;
+        else if (strcmp(tok, "interval") == 0) p->interval_ms = v;
+        else if (strcmp(tok, "name") == 0) snprintf(p->name, sizeof(p->name), "%s", eq + 1);
+        else {
+            fprintf(stderr, "Error: unknown profile key '%s'\n", tok);
+            return false;
+        }
+    }
+    if (p->items > TAG_COUNT) {
+        p->items = TAG_COUNT;
+    }
+    if (!profile_has_requests(p) && p->items == 0) {
+        fprintf(stderr, "Error: profile '%s' neither sends requests nor subscribes\n", p->name);
+        return false;
+    }
+    return true;
+}
+
+// ========== SESSION ==========
+
+static void on_data_change(UA_Client *client, UA_UInt32 subId, void *subContext,
+                           UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    session_t *s = (session_t *)monContext;
+    (void)client; (void)subId; (void)subContext; (void)monId; (void)value;
+
+    if (recording) {
+        s->notifications++;
+    }
+}
+
+static UA_StatusCode subscribe(session_t *s) {
+    const profile_t *p = s->profile;
+    UA_CreateSubscriptionRequest req = UA_CreateSubscriptionRequest_default();
+    req.requestedPublishingInterval = p->interval_ms;
+    UA_CreateSubscriptionResponse resp = UA_Client_Subscriptions_create(s->client, req, s, NULL, NULL);
+    UA_StatusCode status = resp.responseHeader.serviceResult;
+    UA_UInt32 sub_id = resp.subscriptionId;
+    UA_CreateSubscriptionResponse_clear(&resp);
+    if (status != UA_STATUSCODE_GOOD) {
+        return status;
+    }
+
+    UA_MonitoredItemCreateRequest items[TAG_COUNT];
+    UA_Client_DataChangeNotificationCallback callbacks[TAG_COUNT];
+    UA_Client_DeleteMonitoredItemCallback delete_callbacks[TAG_COUNT];
+    void *contexts[TAG_COUNT];
+    for (unsigned i = 0; i < p->items; i++) {
+        items[i] = UA_MonitoredItemCreateRequest_default(UA_NODEID_STRING(1, (char *)tag_nodes[i]));
+        items[i].requestedParameters.samplingInterval = p->interval_ms;
+        callbacks[i] = on_data_change;
+        delete_callbacks[i] = NULL;
+        contexts[i] = s;
+    }
+    UA_CreateMonitoredItemsRequest mreq;
+    UA_CreateMonitoredItemsRequest_init(&mreq);
+    mreq.subscriptionId = sub_id;
+    mreq.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    mreq.itemsToCreate = items;
+    mreq.itemsToCreateSize = p->items;
+    UA_CreateMonitoredItemsResponse mresp =
+        UA_Client_MonitoredItems_createDataChanges(s->client, mreq, contexts, callbacks, delete_callbacks);
+    status = mresp.responseHeader.serviceResult;
+    for (size_t i = 0; status == UA_STATUSCODE_GOOD && i < mresp.resultsSize; i++) {
+        status = mresp.results[i].statusCode;
+    }
+    UA_CreateMonitoredItemsResponse_clear(&mresp);
+    return status;
+}
+
+static UA_StatusCode send_request(session_t *s, op_kind_t op) {
+    UA_StatusCode status;
+
+    if (op == OP_WRITE) {
+        UA_UInt16 value = ++s->sequence;
+        UA_WriteRequest req;
+        UA_WriteRequest_init(&req);
+        UA_Variant_setScalar(&s->write_value.value.value, &value, &UA_TYPES[UA_TYPES_UINT16]);
+        req.nodesToWrite = &s->write_value;
+        req.nodesToWriteSize = 1;
+        UA_WriteResponse resp = UA_Client_Service_write(s->client, req);
+        status = resp.responseHeader.serviceResult;
+        if (status == UA_STATUSCODE_GOOD) {
+            status = resp.resultsSize == 1 ? resp.results[0] : UA_STATUSCODE_BADUNEXPECTEDERROR;
+        }
+        UA_WriteResponse_clear(&resp);
+        return status;
+    }
+
+    UA_ReadRequest req;
+    UA_ReadRequest_init(&req);
+    req.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    if (op == OP_MULTIREAD) {
+        req.nodesToRead = s->read_ids;
+        req.nodesToReadSize = TAG_COUNT;
+    } else {
+        req.nodesToRead = &s->read_ids[s->next_tag];
+        req.nodesToReadSize = 1;
+        s->next_tag = (s->next_tag + 1) % TAG_COUNT;
+    }
+    UA_ReadResponse resp = UA_Client_Service_read(s->client, req);
+    status = resp.responseHeader.serviceResult;
+    if (status == UA_STATUSCODE_GOOD && resp.resultsSize != req.nodesToReadSize) {
+        status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    for (size_t i = 0; status == UA_STATUSCODE_GOOD && i < resp.resultsSize; i++) {
+        if (resp.results[i].hasStatus && resp.results[i].status != UA_STATUSCODE_GOOD) {
+            status = resp.results[i].status;
+        }
+    }
+    UA_ReadResponse_clear(&resp);
+    return status;
+}
+
+static op_kind_t pick_op(session_t *s) {
+    const unsigned *w = s->profile->weight;
+    uint32_t r = next_random(&s->rng) % (w[OP_READ] + w[OP_MULTIREAD] + w[OP_WRITE]);
+
+    if (r < w[OP_READ]) return OP_READ;
+    if (r < w[OP_READ] + w[OP_MULTIREAD]) return OP_MULTIREAD;
+    return OP_WRITE;
+}
+
+static bool session_alive(session_t *s) {
+    UA_SessionState state;
+    UA_Client_getState(s->client, NULL, &state, NULL);
+    return state == UA_SESSIONSTATE_ACTIVATED;
+}
+
+/* Wait until a deadline, serving publish responses if the session subscribes */
+static void wait_until(session_t *s, uint64_t deadline) {
+    uint64_t now;
+    while (running && (now = now_ns()) < deadline) {
+        uint64_t remaining = deadline - now;
+        if (s->profile->items > 0 && remaining >= 1000000ull) {
+            UA_UInt32 ms = (UA_UInt32)(remaining / 1000000ull);
+            UA_Client_run_iterate(s->client, ms < 10 ? ms : 10);
+        } else {
+            sleep_ns(remaining < 10000000ull ? remaining : 10000000ull);
+        }
+    }
+}
+
+static void *session_thread(void *arg) {
+    session_t *s = (session_t *)arg;
+    const profile_t *p = s->profile;
+
+    s->client = UA_Client_new();
+    UA_ClientConfig *config = UA_Client_getConfig(s->client);
+    config->logger.log = log_stderr;
+    config->logger.clear = NULL;
+    UA_ClientConfig_setDefault(config);
+    config->timeout = timeout_ms;
+
+    s->connect_status = UA_Client_connect(s->client, server_url);
+    if (s->connect_status == UA_STATUSCODE_GOOD && p->items > 0) {
+        s->connect_status = subscribe(s);
+    }
+    pthread_mutex_lock(&connect_lock);
+    connect_done++;
+    pthread_mutex_unlock(&connect_lock);
+
+    if (s->connect_status != UA_STATUSCODE_GOOD) {
+        UA_Client_delete(s->client);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < TAG_COUNT; i++) {
+        UA_ReadValueId_init(&s->read_ids[i]);
+        s->read_ids[i].nodeId = UA_NODEID_STRING(1, (char *)tag_nodes[i]);
+        s->read_ids[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_WriteValue_init(&s->write_value);
+    s->write_value.nodeId = UA_NODEID_STRING(1, "loopback_input");
+    s->write_value.attributeId = UA_ATTRIBUTEID_VALUE;
+    s->write_value.value.hasValue = true;
+
+    while (running && !started) {
+        wait_until(s, now_ns() + 1000000ull);
+    }
+
+    uint64_t period = p->rate_hz > 0.0 ? (uint64_t)(1e9 / p->rate_hz) : 0;
+    // Spread the first requests of rate-limited sessions over one period
+    uint64_t next = now_ns() + (period ? next_random(&s->rng) % period : 0);
+
+    while (running) {
+        if (!profile_has_requests(p)) {
+            if (UA_Client_run_iterate(s->client, 10) != UA_STATUSCODE_GOOD && !session_alive(s)) {
+                s->disconnected = true;
+                break;
+            }
+            continue;
+        }
+
+        uint64_t scheduled;
+        if (period) {
+            wait_until(s, next);
+            if (!running) {
+                break;
+            }
+            scheduled = next;
+            next += period;
+        } else {
+            scheduled = now_ns();
+        }
+
+        bool record = recording;
+        uint64_t sent = now_ns();
+        op_kind_t op = pick_op(s);
+        UA_StatusCode status = send_request(s, op);
+        uint64_t dt = now_ns() - scheduled;
+
+        if (record) {
+            if (period && sent - scheduled > period) {
+                s->late++;
+            }
+            if (status == UA_STATUSCODE_GOOD) {
+                io_hist_record(&s->hist, dt < UINT32_MAX ? (uint32_t)dt : UINT32_MAX);
+                s->ops[op]++;
+            } else {
+                s->errors++;
+                s->last_error = status;
+            }
+        }
+        if (status != UA_STATUSCODE_GOOD && !session_alive(s)) {
+            s->disconnected = true;
+            break;
+        }
+    }
+
+    UA_Client_disconnect(s->client);
+    UA_Client_delete(s->client);
+    return NULL;
+}
+
+// ========== RUN ==========
+
+static uint64_t session_ops(const session_t *s) {
+    return s->ops[OP_READ] + s->ops[OP_MULTIREAD] + s->ops[OP_WRITE];
+}
+
+static void run(session_t *sessions, int count, const profile_t *profiles, int profile_count,
+                int warmup_s, int duration_s, run_result_t *r) {
+    memset(sessions, 0, (size_t)count * sizeof(session_t));
+    memset(r, 0, sizeof(*r));
+    io_hist_reset(&r->hist);
+    r->sessions = count;
+    connect_done = 0;
+    running = 1;
+    started = 0;
+    recording = 0;
+
+    for (int i = 0; i < count; i++) {
+        session_t *s = &sessions[i];
+        s->index = i;
+        s->profile = &profiles[i % profile_count];
+        s->rng = 0x9E3779B97F4A7C15ull * (uint64_t)(i + 1);
+        io_hist_reset(&s->hist);
+        pthread_create(&s->thread, NULL, session_thread, s);
+    }
+
+    // All sessions connect before any of them sends requests
+    uint64_t deadline = now_ns() + CONNECT_WAIT_S * 1000000000ull;
+    for (;;) {
+        pthread_mutex_lock(&connect_lock);
+        int done = connect_done;
+        pthread_mutex_unlock(&connect_lock);
+        if (done == count || now_ns() > deadline || interrupted) {
+            break;
+        }
+        sleep_ns(10000000ull);
+    }
+    started = 1;
+
+    uint64_t start = now_ns();
+    while (!interrupted && now_ns() < start + (uint64_t)warmup_s * 1000000000ull) {
+        sleep_ns(10000000ull);
+    }
+    recording = 1;
+    uint64_t record_start = now_ns();
+    while (!interrupted && now_ns() < record_start + (uint64_t)duration_s * 1000000000ull) {
+        sleep_ns(10000000ull);
+    }
+    recording = 0;
+    r->seconds = (double)(now_ns() - record_start) / 1e9;
+    running = 0;
+
+    for (int i = 0; i < count; i++) {
+        session_t *s = &sessions[i];
+        pthread_join(s->thread, NULL);
+        if (s->connect_status != UA_STATUSCODE_GOOD) {
+            continue;
+        }
+        r->connected++;
+        r->lost += s->disconnected;
+        r->target_rate += profile_has_requests(s->profile) ? s->profile->rate_hz : 0.0;
+        r->ops += session_ops(s);
+        r->errors += s->errors;
+        r->late += s->late;
+        r->notifications += s->notifications;
+        for (unsigned b = 0; b < IO_HIST_BUCKETS; b++) {
+            r->hist.buckets[b] += s->hist.buckets[b];
+        }
+        r->hist.count += s->hist.count;
+        r->hist.sum += s->hist.sum;
+        if (s->hist.count && s->hist.min < r->hist.min) r->hist.min = s->hist.min;
+        if (s->hist.max > r->hist.max) r->hist.max = s->hist.max;
+    }
+}
+
+// ========== OUTPUT ==========
+
+static double pct_us(const io_hist_t *h, double p) {
+    return (double)io_hist_percentile(h, p) / 1000.0;
+}
+
+static double per_s(uint64_t n, double seconds) {
+    return seconds > 0.0 ? (double)n / seconds : 0.0;
+}
+
+static void print_aggregate_header(FILE *out) {
+    fprintf(out, "%8s %6s %5s %10s %10s %8s %8s %8s %8s %9s %7s %9s\n",
+            "SESSIONS", "CONN", "LOST", "TARGET/s", "RATE/s", "P50", "P99", "P99.9", "MAX",
+            "ERRORS", "LATE", "NOTIF/s");
+    fprintf(out, "%8s %6s %5s %10s %10s %8s %8s %8s %8s %9s %7s %9s\n",
+            "", "", "", "", "", "[us]", "[us]", "[us]", "[us]", "", "", "");
+    fprintf(out, "-------------------------------------------------------------------------------------------------------------\n");
+}
+
+static void print_aggregate(FILE *out, const run_result_t *r) {
+    fprintf(out, "%8d %6d %5d %10.1f %10.1f %8.1f %8.1f %8.1f %8.1f %9llu %7llu %9.1f\n",
+            r->sessions, r->connected, r->lost, r->target_rate, per_s(r->ops, r->seconds),
+            pct_us(&r->hist, 0.50), pct_us(&r->hist, 0.99), pct_us(&r->hist, 0.999),
+            (double)r->hist.max / 1000.0, (unsigned long long)r->errors,
+            (unsigned long long)r->late, per_s(r->notifications, r->seconds));
+}
+
+static void print_sessions_text(FILE *out, const session_t *sessions, int count, double seconds) {
+    fprintf(out, "\n%4s %-10s %8s %8s %8s %8s %8s %8s %7s %9s  %s\n",
+            "#", "PROFILE", "RATE/s", "P50", "P99", "P99.9", "MAX", "ERRORS", "LATE", "NOTIF/s", "STATUS");
+    fprintf(out, "%4s %-10s %8s %8s %8s %8s %8s %8s %7s %9s\n",
+            "", "", "", "[us]", "[us]", "[us]", "[us]", "", "", "");
+    fprintf(out, "-------------------------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < count; i++) {
+        const session_t *s = &sessions[i];
+        if (s->connect_status != UA_STATUSCODE_GOOD) {
+            fprintf(out, "%4d %-10s %8s %8s %8s %8s %8s %8s %7s %9s  connect: %s\n", i, s->profile->name,
+                    "-", "-", "-", "-", "-", "-", "-", "-", UA_StatusCode_name(s->connect_status));
+            continue;
+        }
+        fprintf(out, "%4d %-10s %8.1f %8.1f %8.1f %8.1f %8.1f %8llu %7llu %9.1f  %s%s%s\n",
+                i, s->profile->name, per_s(session_ops(s), seconds),
+                pct_us(&s->hist, 0.50), pct_us(&s->hist, 0.99), pct_us(&s->hist, 0.999),
+                (double)s->hist.max / 1000.0, (unsigned long long)s->errors,
+                (unsigned long long)s->late, per_s(s->notifications, seconds),
+                s->disconnected ? "lost" : "ok",
+                s->errors ? ", last error: " : "", s->errors ? UA_StatusCode_name(s->last_error) : "");
+    }
+}
+
+static void print_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fprintf(out, "\\%c", *s);
+        } else if ((unsigned char)*s < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*s);
+        } else {
+            fputc(*s, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void print_json_run(FILE *out, const run_result_t *r, const session_t *sessions, bool first) {
+    fprintf(out, "%s    { \"sessions\": %d, \"connected\": %d, \"lost\": %d, \"seconds\": %.3f, "
+            "\"target_rate\": %.1f, \"rate\": %.1f, \"errors\": %llu, \"late\": %llu, \"notification_rate\": %.1f,\n"
+            "      \"latency_us\": { \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f },\n"
+            "      \"per_session\": [\n",
+            first ? "" : ",\n", r->sessions, r->connected, r->lost, r->seconds, r->target_rate, per_s(r->ops, r->seconds),
+            (unsigned long long)r->errors, (unsigned long long)r->late, per_s(r->notifications, r->seconds),
+            pct_us(&r->hist, 0.50), pct_us(&r->hist, 0.99), pct_us(&r->hist, 0.999),
+            (double)r->hist.max / 1000.0);
+    for (int i = 0; i < r->sessions; i++) {
+        const session_t *s = &sessions[i];
+        fprintf(out, "        { \"index\": %d, \"profile\": ", i);
+        print_json_string(out, s->profile->name);
+        fprintf(out, ", \"connect_status\": \"%s\", \"lost\": %s, \"ops\": %llu, \"errors\": %llu, "
+                "\"last_error\": \"%s\", \"late\": %llu, \"notifications\": %llu, "
+                "\"latency_us\": { \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f } }%s\n",
+                UA_StatusCode_name(s->connect_status), s->disconnected ? "true" : "false",
+                (unsigned long long)session_ops(s), (unsigned long long)s->errors,
+                UA_StatusCode_name(s->last_error), (unsigned long long)s->late,
+                (unsigned long long)s->notifications, pct_us(&s->hist, 0.50), pct_us(&s->hist, 0.99),
+                pct_us(&s->hist, 0.999), (double)s->hist.max / 1000.0, i + 1 < r->sessions ? "," : "");
+    }
+    fprintf(out, "      ] }");
+}
+
+static void print_csv_run(FILE *out, const char *timestamp, const char *label,
+                          const run_result_t *r, const session_t *sessions) {
+    // One aggregate row ("all") followed by one row per session
+    fprintf(out, "%s,%s,%s,%d,all,,%d,%d,%.3f,%.1f,%.1f,%llu,%llu,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+            timestamp, server_url, label, r->sessions, r->connected, r->lost, r->seconds,
+            r->target_rate, per_s(r->ops, r->seconds), (unsigned long long)r->errors,
+            (unsigned long long)r->late, per_s(r->notifications, r->seconds),
+            pct_us(&r->hist, 0.50), pct_us(&r->hist, 0.99), pct_us(&r->hist, 0.999),
+            (double)r->hist.max / 1000.0);
+    for (int i = 0; i < r->sessions; i++) {
+        const session_t *s = &sessions[i];
+        bool ok = s->connect_status == UA_STATUSCODE_GOOD;
+        fprintf(out, "%s,%s,%s,%d,%d,%s,%d,%d,%.3f,%.1f,%.1f,%llu,%llu,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+                timestamp, server_url, label, r->sessions, i, s->profile->name, ok, s->disconnected,
+                r->seconds, ok && profile_has_requests(s->profile) ? s->profile->rate_hz : 0.0,
+                per_s(session_ops(s), r->seconds), (unsigned long long)s->errors,
+                (unsigned long long)s->late, per_s(s->notifications, r->seconds),
+                pct_us(&s->hist, 0.50), pct_us(&s->hist, 0.99), pct_us(&s->hist, 0.999),
+                (double)s->hist.max / 1000.0);
+    }
+}
+
+// ========== MAIN ==========
+
+static void print_help(const char *program_name) {
+    printf("OPC UA multi-session load generator\n");
+    printf("Usage: %s [OPTIONS] [SERVER_URL]\n\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help             Show this help message\n");
+    printf("  -c, --sessions N       Number of sessions, 1-%d (default: %d)\n", MAX_SESSIONS, DEFAULT_SESSIONS);
+    printf("  -p, --profile SPEC     Session profile, repeatable; session i uses profile i %% count\n");
+    printf("                         (default: hmi)\n");
+    printf("  -d, --duration N       Recorded seconds per run (default: %d)\n", DEFAULT_DURATION_S);
+    printf("  -w, --warmup N         Unrecorded seconds before each run (default: %d)\n", DEFAULT_WARMUP_S);
+    printf("  -t, --timeout N        Request timeout in ms (default: %d)\n", DEFAULT_TIMEOUT_MS);
+    printf("      --sweep STEP       Run 1, 1+STEP, ... up to N sessions, one line per run\n");
+    printf("  -f, --format F         text, json or csv (default: text)\n");
+    printf("  -o, --output FILE      Write results to FILE (csv is appended)\n");
+    printf("  -l, --label TEXT       Label stored with json/csv results\n");
+    printf("\n");
+    printf("Profile SPEC: PRESET, PRESET:KEY=VALUE,... or KEY=VALUE,...\n");
+    printf("  Presets:   scada     multiread=1,rate=10\n");
+    printf("             hmi       read=4,write=1,rate=20,sub=5,interval=100\n");
+    printf("             historian sub=9,interval=1000\n");
+    printf("             stress    read=1,rate=0\n");
+    printf("  Keys:      read, multiread, write   request mix weights\n");
+    printf("             rate                     requests/s per session, 0 = back to back\n");
+    printf("             sub, interval            monitored items and their interval in ms\n");
+    printf("             name                     label in the report\n");
+    printf("\n");
+    printf("Default server URL: %s\n", DEFAULT_SERVER_URL);
+    printf("Ctrl+C ends the current run early and skips the rest\n");
+}
+
+int main(int argc, char *argv[]) {
+    static session_t sessions[MAX_SESSIONS];
+    profile_t profiles[MAX_PROFILES];
+    int profile_count = 0;
+    int session_count = DEFAULT_SESSIONS;
+    int duration_s = DEFAULT_DURATION_S;
+    int warmup_s = DEFAULT_WARMUP_S;
+    int sweep_step = 0;
+    int timeout = DEFAULT_TIMEOUT_MS;
+    output_format_t format = FORMAT_TEXT;
+    const char *output_path = NULL;
+    const char *label = "";
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_help(argv[0]);
+            return 0;
+        } else if ((strcmp(arg, "-c") == 0 || strcmp(arg, "--sessions") == 0) && has_value) {
+            session_count = atoi(argv[++i]);
+        } else if ((strcmp(arg, "-p") == 0 || strcmp(arg, "--profile") == 0) && has_value) {
+            if (profile_count == MAX_PROFILES) {
+                fprintf(stderr, "Error: at most %d profiles\n", MAX_PROFILES);
+                return 1;
+            }
+            if (!parse_profile(argv[++i], &profiles[profile_count++])) return 1;
+        } else if ((strcmp(arg, "-d") == 0 || strcmp(arg, "--duration") == 0) && has_value) {
+            duration_s = atoi(argv[++i]);
+        } else if ((strcmp(arg, "-w") == 0 || strcmp(arg, "--warmup") == 0) && has_value) {
+            warmup_s = atoi(argv[++i]);
+        } else if ((strcmp(arg, "-t") == 0 || strcmp(arg, "--timeout") == 0) && has_value) {
+            timeout = atoi(argv[++i]);
+        } else if (strcmp(arg, "--sweep") == 0 && has_value) {
+            sweep_step = atoi(argv[++i]);
+        } else if ((strcmp(arg, "-f") == 0 || strcmp(arg, "--format") == 0) && has_value) {
+            const char *f = argv[++i];
+            if (strcmp(f, "text") == 0) format = FORMAT_TEXT;
+            else if (strcmp(f, "json") == 0) format = FORMAT_JSON;
+            else if (strcmp(f, "csv") == 0) format = FORMAT_CSV;
+            else {
+                fprintf(stderr, "Error: unknown format '%s'\n", f);
+                return 1;
+            }
+        } else if ((strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) && has_value) {
+            output_path = argv[++i];
+        } else if ((strcmp(arg, "-l") == 0 || strcmp(arg, "--label") == 0) && has_value) {
+            label = argv[++i];
+        } else if (arg[0] == '-') {
+            printf("Unknown option: %s\n", arg);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        } else {
+            server_url = arg;
+        }
+    }
+
+    if (session_count < 1 || session_count > MAX_SESSIONS || duration_s <= 0 || warmup_s < 0 ||
+        timeout <= 0 || sweep_step < 0) {
+        fprintf(stderr, "Error: invalid arguments\n");
+        return 1;
+    }
+    if (profile_count == 0) {
+        parse_profile("hmi", &profiles[profile_count++]);
+    }
+    timeout_ms = (UA_UInt32)timeout;
+
+    // Progress goes to stderr when the results go to stdout in a machine format
+    FILE *log = (format == FORMAT_TEXT || output_path != NULL) ? stdout : stderr;
+    FILE *out = stdout;
+    if (output_path != NULL) {
+        out = fopen(output_path, format == FORMAT_CSV ? "a" : "w");
+        if (out == NULL) {
+            perror(output_path);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    char timestamp[32];
+    time_t t = time(NULL);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    fprintf(log, "Server %s, %d session(s), warm-up %d s, %d s per run\n",
+            server_url, session_count, warmup_s, duration_s);
+    for (int i = 0; i < profile_count; i++) {
+        const profile_t *p = &profiles[i];
+        fprintf(log, "  profile %-10s read=%u multiread=%u write=%u rate=%.1f sub=%u interval=%.0f\n",
+                p->name, p->weight[OP_READ], p->weight[OP_MULTIREAD], p->weight[OP_WRITE],
+                p->rate_hz, p->items, p->interval_ms);
+    }
+
+    if (format == FORMAT_JSON) {
+        fprintf(out, "{\n  \"timestamp\": \"%s\",\n  \"server\": ", timestamp);
+        print_json_string(out, server_url);
+        fprintf(out, ",\n  \"label\": ");
+        print_json_string(out, label);
+        fprintf(out, ",\n  \"runs\": [\n");
+    } else if (format == FORMAT_CSV) {
+        fseek(out, 0, SEEK_END);
+        if (ftell(out) == 0) {
+            fprintf(out, "timestamp,server,label,sessions,session,profile,connected,lost,seconds,"
+                    "target_rate,rate,errors,late,notification_rate,p50_us,p99_us,p999_us,max_us\n");
+        }
+    }
+    if (format == FORMAT_TEXT) {
+        fprintf(out, "\n");
+        print_aggregate_header(out);
+    }
+
+    int first = sweep_step > 0 ? 1 : session_count;
+    int failed = 0;
+    for (int n = first; n <= session_count && !interrupted; n += sweep_step > 0 ? sweep_step : session_count) {
+        run_result_t r;
+        run(sessions, n, profiles, profile_count, warmup_s, duration_s, &r);
+        failed |= r.connected < r.sessions || r.lost > 0 || r.errors > 0;
+
+        switch (format) {
+        case FORMAT_TEXT:
+            print_aggregate(out, &r);
+            if (sweep_step == 0) {
+                print_sessions_text(out, sessions, n, r.seconds);
+            }
+            break;
+        case FORMAT_JSON:
+            print_json_run(out, &r, sessions, n == first);
+            break;
+        case FORMAT_CSV:
+            print_csv_run(out, timestamp, label, &r, sessions);
+            break;
+        }
+        fflush(out);
+    }
+
+    if (format == FORMAT_JSON) {
+        fprintf(out, "\n  ]\n}\n");
+    } else if (format == FORMAT_TEXT) {
+        fprintf(out, "\nLatency from the scheduled send time; percentiles are histogram estimates (+/- 6 %%).\n"
+                "LATE = requests sent more than one period after their schedule.\n");
+    }
+    if (out != stdout) {
+        fclose(out);
+        fprintf(log, "Results written to %s\n", output_path);
+    }
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,149 @@
+/* adc_filter.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "adc_filter.h"
+#include <string.h>
+
+#define IIR_ONE     ((float)(1 << ADC_FILTER_IIR_FRAC_BITS))
+
+/**
+ * @brief Initialize a filter
+ *
+ * @param f Filter state
+ * @param type Filter type
+ * @param param Window length or IIR shift (clamped to the valid range)
+ */
+void adc_filter_init(adc_filter_t *f, adc_filter_type_t type, uint8_t param) {
+    memset(f, 0, sizeof(*f));
+    f->type = type;
+    f->window = 1;
+    f->shift = 1;
+
+    switch (type) {
+        case ADC_FILTER_MOVING_AVERAGE:
+            f->window = param < 1 ? 1 : (param > ADC_FILTER_MAX_WINDOW ? ADC_FILTER_MAX_WINDOW : param);
+            break;
+        case ADC_FILTER_MEDIAN:
+            f->window = param < 1 ? 1 : (param > ADC_FILTER_MAX_MEDIAN ? ADC_FILTER_MAX_MEDIAN : param);
+            f->window |= 1;  // Odd length: the median is a sample, not an average
+            break;
+        case ADC_FILTER_IIR:
+            f->shift = param < 1 ? 1 : (param > 15 ? 15 : param);
+            break;
+        default:
+            f->type = ADC_FILTER_NONE;
+            break;
+    }
+}
+
+/**
+ * @brief Clear the filter history, keeping type and parameter
+ *
+ * @param f Filter state
+ */
+void adc_filter_reset(adc_filter_t *f) {
+    f->count = 0;
+    f->pos = 0;
+    f->sum = 0;
+    f->state = 0;
+}
+
+/**
+ * @brief Moving average: running sum over a ring buffer, O(1) per sample
+ */
+static float process_moving_average(adc_filter_t *f, uint16_t sample) {
+    if (f->count == f->window) {
+        f->sum -= f->ring[f->pos];
+    } else {
+        f->count++;
+    }
+    f->ring[f->pos] = sample;
+    f->sum += sample;
+    if (++f->pos == f->window) {
+        f->pos = 0;
+    }
+    return (float)f->sum / (float)f->count;
+}
+
+/**
+ * @brief First-order IIR: y += (x - y) >> shift in fixed point
+ */
+static float process_iir(adc_filter_t *f, uint16_t sample) {
+    int32_t x = (int32_t)sample << ADC_FILTER_IIR_FRAC_BITS;
+    if (f->count == 0) {
+        f->state = x;  // No ramp from zero at start-up
+        f->count = 1;
+    } else {
+        f->state += (x - f->state) >> f->shift;
+    }
+    return (float)f->state / IIR_ONE;
+}
+
+/**
+ * @brief Median: the window is kept sorted, so each sample costs one
+ *        removal and one insertion (O(N)) instead of a full sort
+ */
+static float process_median(adc_filter_t *f, uint16_t sample) {
+    uint8_t n = f->count;
+
+    if (n == f->window) {
+        // Drop the oldest sample from the sorted window
+        uint16_t oldest = f->ring[f->pos];
+        uint8_t i = 0;
+        while (f->sorted[i] != oldest) {
+            i++;
+        }
+        memmove(&f->sorted[i], &f->sorted[i + 1], (size_t)(n - 1 - i) * sizeof(uint16_t));
+        n--;
+    } else {
+        f->count++;
+    }
+
+    // Insert the new sample in order
+    uint8_t j = n;
+    while (j > 0 && f->sorted[j - 1] > sample) {
+        f->sorted[j] = f->sorted[j - 1];
+        j--;
+    }
+    f->sorted[j] = sample;
+
+    f->ring[f->pos] = sample;
+    if (++f->pos == f->window) {
+        f->pos = 0;
+    }
+    return (float)f->sorted[(f->count - 1) / 2];
+}
+
+/**
+ * @brief Feed one sample and get the filtered value
+ *
+ * @param f Filter state
+ * @param sample ADC code (or scaled code)
+ * @return float Filtered value in the units of sample
+ */
+float adc_filter_process(adc_filter_t *f, uint16_t sample) {
+    switch (f->type) {
+        case ADC_FILTER_MOVING_AVERAGE:
+            return process_moving_average(f, sample);
+        case ADC_FILTER_IIR:
+            return process_iir(f, sample);
+        case ADC_FILTER_MEDIAN:
+            return process_median(f, sample);
+        default:
+            return (float)sample;
+    }
+}
+
+/**
+ * @brief Get a printable name of a filter type
+ *
+ * @param type Filter type
+ * @return const char* Filter name
+ */
+const char *adc_filter_type_name(adc_filter_type_t type) {
+    switch (type) {
+        case ADC_FILTER_MOVING_AVERAGE: return "moving_average";
+        case ADC_FILTER_IIR:            return "iir";
+        case ADC_FILTER_MEDIAN:         return "median";
+        default:                        return "none";
+    }
+}
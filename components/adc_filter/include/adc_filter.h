@@ -0,0 +1,94 @@
+/* adc_filter.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef ADC_FILTER_H
+#define ADC_FILTER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Longest moving average window (samples) */
+#define ADC_FILTER_MAX_WINDOW   32
+
+/** @brief Longest median window (samples, odd) */
+#define ADC_FILTER_MAX_MEDIAN   15
+
+/** @brief Fraction bits of the IIR state (65535 << 12 fits in int32) */
+#define ADC_FILTER_IIR_FRAC_BITS  12
+
+/**
+ * @brief Filter applied to one analog channel
+ */
+typedef enum {
+    ADC_FILTER_NONE = 0,          /**< Pass samples through unchanged */
+    ADC_FILTER_MOVING_AVERAGE,    /**< Mean of the last N samples */
+    ADC_FILTER_IIR,               /**< First-order low pass, alpha = 2^-shift */
+    ADC_FILTER_MEDIAN,            /**< Median of the last N samples (spike rejection) */
+} adc_filter_type_t;
+
+/**
+ * @brief Per-channel filter state
+ *
+ * All arithmetic is integer: sums are exact, the IIR state is kept with
+ * 12 fractional bits, and only the final output is converted to float.
+ * Samples may use the full 16-bit range, so callers with sub-code
+ * resolution (e.g. averaged DMA samples) can pass scaled codes. The same
+ * code runs on the target and in the host benchmark (TEST_OPC_X86).
+ */
+typedef struct {
+    adc_filter_type_t type;       /**< Filter type */
+    uint8_t window;               /**< Window length (moving average, median) */
+    uint8_t shift;                /**< IIR smoothing shift (alpha = 2^-shift) */
+    uint8_t count;                /**< Samples in the window (warm-up) */
+    uint8_t pos;                  /**< Next ring buffer slot */
+    uint32_t sum;                 /**< Moving average running sum */
+    int32_t state;                /**< IIR output with ADC_FILTER_IIR_FRAC_BITS fraction bits */
+    uint16_t ring[ADC_FILTER_MAX_WINDOW];     /**< Last samples in arrival order */
+    uint16_t sorted[ADC_FILTER_MAX_MEDIAN];   /**< Median window kept sorted */
+} adc_filter_t;
+
+/**
+ * @brief Initialize a filter
+ *
+ * @param f Filter state
+ * @param type Filter type
+ * @param param Window length for moving average (1-32) and median (odd,
+ *        1-15), smoothing shift for IIR (1-15); out-of-range values are
+ *        clamped, even median windows are rounded up
+ */
+void adc_filter_init(adc_filter_t *f, adc_filter_type_t type, uint8_t param);
+
+/**
+ * @brief Clear the filter history, keeping type and parameter
+ *
+ * @param f Filter state
+ */
+void adc_filter_reset(adc_filter_t *f);
+
+/**
+ * @brief Feed one sample and get the filtered value
+ *
+ * Until the window is full the moving average and median use the samples
+ * seen so far; the IIR starts from the first sample instead of zero.
+ *
+ * @param f Filter state
+ * @param sample ADC code (or scaled code, any 16-bit value)
+ * @return float Filtered value in the units of sample
+ */
+float adc_filter_process(adc_filter_t *f, uint16_t sample);
+
+/**
+ * @brief Get a printable name of a filter type
+ *
+ * @param type Filter type
+ * @return const char* Name ("none", "moving_average", "iir", "median")
+ */
+const char *adc_filter_type_name(adc_filter_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADC_FILTER_H */
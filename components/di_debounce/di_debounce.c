@@ -0,0 +1,143 @@
+/* di_debounce.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "di_debounce.h"
+#include <string.h>
+
+/**
+ * @brief Add one to the counters of the selected inputs
+ *
+ * Callers guarantee the counters are below DI_DEBOUNCE_MAX_LIMIT.
+ */
+static inline void planes_increment(uint16_t *c, uint16_t lanes) {
+    uint16_t carry = lanes;
+    for (int p = 0; p < DI_DEBOUNCE_PLANES && carry; p++) {
+        uint16_t sum = c[p] ^ carry;
+        carry = c[p] & carry;
+        c[p] = sum;
+    }
+}
+
+/**
+ * @brief Subtract one from the counters of the selected inputs
+ *
+ * Callers guarantee the counters are not zero.
+ */
+static inline void planes_decrement(uint16_t *c, uint16_t lanes) {
+    uint16_t borrow = lanes;
+    for (int p = 0; p < DI_DEBOUNCE_PLANES && borrow; p++) {
+        uint16_t diff = c[p] ^ borrow;
+        borrow = ~c[p] & borrow;
+        c[p] = diff;
+    }
+}
+
+/**
+ * @brief Add the same value to the counters of the selected inputs, saturating
+ */
+static inline void planes_add_saturate(uint16_t *c, uint16_t lanes, uint32_t value) {
+    uint16_t carry = 0;
+    for (int p = 0; p < DI_DEBOUNCE_PLANES; p++) {
+        uint16_t v = (value & (1u << p)) ? lanes : 0;
+        uint16_t sum = c[p] ^ v ^ carry;
+        carry = (c[p] & v) | (carry & (c[p] ^ v));
+        c[p] = sum;
+    }
+    // Lanes that overflowed stay at the maximum
+    for (int p = 0; p < DI_DEBOUNCE_PLANES; p++) {
+        c[p] |= carry;
+    }
+}
+
+/**
+ * @brief Inputs whose counter is greater than or equal to their limit
+ */
+static inline uint16_t planes_greater_equal(const uint16_t *c, const uint16_t *limit) {
+    uint16_t greater = 0;
+    uint16_t equal = 0xFFFF;
+    for (int p = DI_DEBOUNCE_PLANES - 1; p >= 0; p--) {
+        greater |= equal & c[p] & ~limit[p];
+        equal &= ~(c[p] ^ limit[p]);
+    }
+    return greater | equal;
+}
+
+/**
+ * @brief Clear the counters of the selected inputs
+ */
+static inline void planes_clear(uint16_t *c, uint16_t lanes) {
+    for (int p = 0; p < DI_DEBOUNCE_PLANES; p++) {
+        c[p] &= ~lanes;
+    }
+}
+
+void di_debounce_init(di_debounce_t *d, uint16_t initial, di_debounce_mode_t mode,
+                      uint32_t limit, uint32_t now_ms) {
+    memset(d, 0, sizeof(*d));
+    d->state = initial;
+    d->last_ms = now_ms;
+    di_debounce_configure(d, 0xFFFF, mode, limit);
+}
+
+void di_debounce_configure(di_debounce_t *d, uint16_t inputs, di_debounce_mode_t mode,
+                           uint32_t limit) {
+    if (limit > DI_DEBOUNCE_MAX_LIMIT) {
+        limit = DI_DEBOUNCE_MAX_LIMIT;
+    }
+
+    d->integrator &= ~inputs;
+    d->timed &= ~inputs;
+    if (mode == DI_DEBOUNCE_INTEGRATOR) {
+        d->integrator |= inputs;
+    } else if (mode == DI_DEBOUNCE_TIME) {
+        d->timed |= inputs;
+    }
+
+    for (int p = 0; p < DI_DEBOUNCE_PLANES; p++) {
+        d->limit[p] = (d->limit[p] & ~inputs) | ((limit & (1u << p)) ? inputs : 0);
+    }
+    planes_clear(d->count, inputs);
+    d->armed &= ~inputs;
+}
+
+uint16_t di_debounce_update(di_debounce_t *d, uint16_t raw, uint32_t now_ms) {
+    uint16_t diff = raw ^ d->state;
+
+    // Integrator: count towards the raw value, back off on agreeing samples
+    uint16_t nonzero = 0;
+    for (int p = 0; p < DI_DEBOUNCE_PLANES; p++) {
+        nonzero |= d->count[p];
+    }
+    uint16_t up = d->integrator & diff;
+    planes_increment(d->count, up);
+    planes_decrement(d->count, d->integrator & ~diff & nonzero);
+
+    // Time: accumulate while the difference lasts, restart when it ends
+    uint16_t timed_diff = d->timed & diff;
+    uint32_t elapsed = now_ms - d->last_ms;
+    if (elapsed > DI_DEBOUNCE_MAX_LIMIT) {
+        elapsed = DI_DEBOUNCE_MAX_LIMIT;
+    }
+    planes_clear(d->count, d->timed & ~diff);
+    planes_add_saturate(d->count, timed_diff & d->armed, elapsed);
+    d->armed = timed_diff;
+    d->last_ms = now_ms;
+
+    // Inputs that reached their limit take the raw value
+    uint16_t flip = (up | timed_diff) & planes_greater_equal(d->count, d->limit);
+    d->state ^= flip;
+    planes_clear(d->count, flip);
+    d->armed &= ~flip;
+
+    // Inputs without debouncing follow the raw value
+    uint16_t direct = ~(d->integrator | d->timed);
+    d->state = (d->state & ~direct) | (raw & direct);
+    return d->state;
+}
+
+const char *di_debounce_mode_name(di_debounce_mode_t mode) {
+    switch (mode) {
+        case DI_DEBOUNCE_INTEGRATOR: return "integrator";
+        case DI_DEBOUNCE_TIME:       return "time";
+        default:                     return "none";
+    }
+}
@@ -0,0 +1,130 @@
+/* di_debounce.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef DI_DEBOUNCE_H
+#define DI_DEBOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Number of inputs handled by one debouncer (one bit each) */
+#define DI_DEBOUNCE_INPUTS      16
+
+/** @brief Bits per input counter (bit planes) */
+#define DI_DEBOUNCE_PLANES      8
+
+/** @brief Largest limit (samples or milliseconds) */
+#define DI_DEBOUNCE_MAX_LIMIT   ((1u << DI_DEBOUNCE_PLANES) - 1)
+
+/**
+ * @brief Debounce mode of one input
+ */
+typedef enum {
+    DI_DEBOUNCE_NONE = 0,         /**< Pass the raw value through */
+    DI_DEBOUNCE_INTEGRATOR,       /**< Count up on disagreeing samples, down on agreeing ones */
+    DI_DEBOUNCE_TIME,             /**< Raw value must differ continuously for a time */
+} di_debounce_mode_t;
+
+/**
+ * @brief Debouncer for a 16-bit discrete input word
+ *
+ * Every input has its own 8-bit counter and limit, stored as bit planes:
+ * count[p] holds bit p of all 16 counters. Counting, comparing and
+ * resetting are then a fixed sequence of word-wide logic operations per
+ * plane (SWAR), so one update costs the same whether one input or all 16
+ * are debounced, and no input is ever looked at on its own.
+ *
+ * - Integrator: the counter goes up by one for every sample that differs
+ *   from the debounced state and down by one for every sample that agrees
+ *   (not below zero). The state follows the raw value when the counter
+ *   reaches the limit, so a glitch of k samples needs k agreeing samples
+ *   to be forgotten. The limit is in samples.
+ * - Time: the counter adds the milliseconds elapsed while the raw value
+ *   keeps differing from the state and restarts on any agreeing sample.
+ *   The state follows once the difference has lasted the limit, which
+ *   keeps the filter delay independent of the poll period. The limit is
+ *   in milliseconds.
+ *
+ * Single writer. Like adc_filter this module only depends on C, so the
+ * same code runs in the firmware and in host tools.
+ */
+typedef struct {
+    uint16_t state;                       /**< Debounced input word */
+    uint16_t integrator;                  /**< Inputs in DI_DEBOUNCE_INTEGRATOR mode */
+    uint16_t timed;                       /**< Inputs in DI_DEBOUNCE_TIME mode */
+    uint16_t armed;                       /**< Timed inputs that differed in the last sample */
+    uint16_t count[DI_DEBOUNCE_PLANES];   /**< Counters, bit plane p = bit p of every counter */
+    uint16_t limit[DI_DEBOUNCE_PLANES];   /**< Limits, same layout */
+    uint32_t last_ms;                     /**< Time of the last sample */
+} di_debounce_t;
+
+/**
+ * @brief Initialize a debouncer with every input in one mode
+ *
+ * @param d Debouncer
+ * @param initial Initial debounced state (normally the first raw read)
+ * @param mode Mode of all inputs
+ * @param limit Limit of all inputs (samples or milliseconds, clamped to
+ *        DI_DEBOUNCE_MAX_LIMIT)
+ * @param now_ms Current time in milliseconds
+ */
+void di_debounce_init(di_debounce_t *d, uint16_t initial, di_debounce_mode_t mode,
+                      uint32_t limit, uint32_t now_ms);
+
+/**
+ * @brief Change the mode and limit of some inputs
+ *
+ * The counters of the selected inputs restart from zero; their debounced
+ * state is kept.
+ *
+ * @param d Debouncer
+ * @param inputs Bit mask of the inputs to change
+ * @param mode New mode
+ * @param limit New limit (samples or milliseconds, clamped to DI_DEBOUNCE_MAX_LIMIT)
+ */
+void di_debounce_configure(di_debounce_t *d, uint16_t inputs, di_debounce_mode_t mode,
+                           uint32_t limit);
+
+/**
+ * @brief Feed one raw sample and get the debounced word
+ *
+ * @param d Debouncer
+ * @param raw Raw input word
+ * @param now_ms Time of the sample in milliseconds (wraps)
+ * @return uint16_t Debounced input word
+ */
+uint16_t di_debounce_update(di_debounce_t *d, uint16_t raw, uint32_t now_ms);
+
+/**
+ * @brief Inputs whose raw value currently differs from the debounced state
+ *
+ * A non-zero result means the state may still change without a new edge,
+ * so the caller should keep sampling.
+ *
+ * @param d Debouncer
+ * @return uint16_t Bit mask of unsettled inputs
+ */
+static inline uint16_t di_debounce_pending(const di_debounce_t *d) {
+    uint16_t nonzero = d->armed;
+    for (int p = 0; p < DI_DEBOUNCE_PLANES; p++) {
+        nonzero |= d->count[p];
+    }
+    return nonzero;
+}
+
+/**
+ * @brief Get the name of a debounce mode
+ *
+ * @param mode Debounce mode
+ * @return const char* Mode name for logs
+ */
+const char *di_debounce_mode_name(di_debounce_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DI_DEBOUNCE_H */
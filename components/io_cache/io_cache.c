@@ -1,8 +1,10 @@
 /* io_cache.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
 
 #include "io_cache.h"
+#include "io_seqlock.h"
 #include "esp_log.h"
 #include <string.h>
+#include <stdatomic.h>
 
 static const char *TAG = "io_cache";
 
@@ -22,13 +24,17 @@ typedef struct {
     uint16_t discrete_outputs_cache;        /**< Cached discrete output values (16 bits) */
     // REMOVED: float temperature_cache[NUM_TEMP_SENSORS];
     // REMOVED: bool temp_valid[NUM_TEMP_SENSORS];
-    uint64_t inputs_timestamp_ms;           /**< Source timestamp for inputs (hardware read time) */
-    uint64_t outputs_timestamp_ms;          /**< Source timestamp for outputs (hardware read time) */
-    // REMOVED: uint64_t temp_timestamp_ms[NUM_TEMP_SENSORS];
-    uint64_t inputs_server_timestamp_ms;    /**< Server timestamp for inputs (cache update time) */
-    uint64_t outputs_server_timestamp_ms;   /**< Server timestamp for outputs (cache update time) */
-    // REMOVED: uint64_t temp_server_timestamp_ms[NUM_TEMP_SENSORS];
-    SemaphoreHandle_t mutex;                /**< Mutex for thread-safe access to cache */
+    uint64_t inputs_timestamp_us;           /**< Source timestamp for inputs (hardware read time, timebase_now_us()) */
+    uint64_t outputs_timestamp_us;          /**< Source timestamp for outputs (hardware write time) */
+    // REMOVED: uint64_t temp_timestamp_us[NUM_TEMP_SENSORS];
+    uint64_t inputs_server_timestamp_us;    /**< Server timestamp for inputs (cache update time) */
+    uint64_t outputs_server_timestamp_us;   /**< Server timestamp for outputs (cache update time) */
+    uint8_t inputs_quality;                 /**< io_quality_t of the inputs */
+    uint8_t outputs_quality;                /**< io_quality_t of the outputs (last hardware write) */
+    uint32_t inputs_stale_ms;               /**< Inputs staleness limit (0 = none) */
+    bool inputs_valid;                      /**< Inputs were read at least once (edges can be counted) */
+    io_counter_t counters[IO_NUM_COUNTERS]; /**< Edge counters per discrete input */
+    // REMOVED: uint64_t temp_server_timestamp_us[NUM_TEMP_SENSORS];
 } io_cache_t;
 
 /**
@@ -39,41 +45,106 @@ typedef struct {
  */
 typedef struct {
     float adc_cache[NUM_ADC_CHANNELS];              /**< Cached ADC channel values */
-    uint64_t adc_timestamps_ms[NUM_ADC_CHANNELS];   /**< Source timestamps for ADC values */
-    uint64_t adc_server_timestamps_ms[NUM_ADC_CHANNELS]; /**< Server timestamps for ADC values */
+    uint64_t adc_timestamps_us[NUM_ADC_CHANNELS];   /**< Source timestamps for ADC values */
+    uint64_t adc_server_timestamps_us[NUM_ADC_CHANNELS]; /**< Server timestamps for ADC values */
     bool adc_valid[NUM_ADC_CHANNELS];               /**< Validity flags for ADC channels */
+    uint8_t adc_quality[NUM_ADC_CHANNELS];          /**< io_quality_t per channel */
+    uint32_t adc_stale_ms;                          /**< ADC staleness limit (0 = none) */
 } io_cache_adc_t;
 
 static io_cache_t io_cache;               /**< Main I/O cache instance */
 static io_cache_adc_t adc_cache;          /**< ADC cache instance */
+static io_history_t histories[IO_HISTORY_TAG_COUNT]; /**< Per-tag history, updated with the cache */
 
 /**
- * @brief Get current system time in milliseconds
- * 
- * @return uint64_t Current time in milliseconds since system start
+ * Both cache instances are protected by one sequence lock. Readers (OPC UA
+ * task) never block and never see a torn value; writers (polling task and
+ * OPC UA write callbacks) are serialised by a spinlock held only for the
+ * few stores of an update, so a reader on the other core spins for at most
+ * that long and a reader on the same core can never preempt a writer.
+ */
+static io_seqlock_t cache_seqlock;
+static portMUX_TYPE cache_write_lock = portMUX_INITIALIZER_UNLOCKED;
+static atomic_uint cache_read_retries;    /**< Total reader retries (diagnostics) */
+
+/**
+ * Change events for the OPC UA task. Writers push inside their update
+ * section, so the cache write lock already makes the queue single-producer
+ * and head/tail need no further locking. The consumer only moves the tail.
+ */
+static io_event_t event_queue[IO_EVENT_QUEUE_LEN];
+static atomic_uint event_head;            /**< Next slot to fill (producer) */
+static atomic_uint event_tail;            /**< Next slot to take (consumer) */
+static atomic_bool events_enabled;
+static atomic_bool events_overflow;
+
+/**
+ * @brief Enter a cache update section (serialises writers, makes readers retry)
  */
-static uint64_t get_current_time_ms(void) {
-    return (uint64_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+static inline void cache_write_begin(void) {
+    portENTER_CRITICAL(&cache_write_lock);
+    io_seqlock_write_begin(&cache_seqlock);
+}
+
+/**
+ * @brief Leave a cache update section and publish the new values
+ */
+static inline void cache_write_end(void) {
+    io_seqlock_write_end(&cache_seqlock);
+    portEXIT_CRITICAL(&cache_write_lock);
+}
+
+/**
+ * @brief Queue a change event (call between cache_write_begin/end)
+ *
+ * @param event Event to queue
+ */
+static inline void event_push(const io_event_t *event) {
+    if (!atomic_load_explicit(&events_enabled, memory_order_relaxed)) return;
+    
+    unsigned head = atomic_load_explicit(&event_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&event_tail, memory_order_acquire);
+    if (head - tail >= IO_EVENT_QUEUE_LEN) {
+        atomic_store_explicit(&events_overflow, true, memory_order_release);
+        return;
+    }
+    event_queue[head & (IO_EVENT_QUEUE_LEN - 1)] = *event;
+    atomic_store_explicit(&event_head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief Record a sample in the history of a tag (call between cache_write_begin/end)
+ */
+static inline void history_append(io_history_tag_t tag, uint64_t time_us, int32_t value, uint8_t quality) {
+    io_history_append(&histories[tag], time_us, value, quality);
 }
 
 /**
  * @brief Initialize I/O cache system
  * 
- * This function initializes the cache structures and creates the mutex
- * for thread-safe operations. Must be called before using any cache functions.
+ * This function initializes the cache structures and the sequence lock
+ * protecting them. Must be called before using any cache functions.
  */
 void io_cache_init(void) {
     // Initialize main I/O cache
     memset(&io_cache, 0, sizeof(io_cache_t));
-    io_cache.mutex = xSemaphoreCreateMutex();
-    if (io_cache.mutex == NULL) {
-        ESP_LOGE(TAG, "Failed to create mutex");
-        return;
-    }
     
     // Initialize ADC cache
     memset(&adc_cache, 0, sizeof(io_cache_adc_t));
     
+    io_history_init(&histories[IO_HISTORY_TAG_INPUTS], IO_HISTORY_DISCRETE);
+    io_history_init(&histories[IO_HISTORY_TAG_OUTPUTS], IO_HISTORY_DISCRETE);
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        io_history_init(&histories[IO_HISTORY_TAG_ADC + i], IO_HISTORY_ADC);
+    }
+    
+    io_seqlock_init(&cache_seqlock);
+    atomic_init(&cache_read_retries, 0);
+    atomic_init(&event_head, 0);
+    atomic_init(&event_tail, 0);
+    atomic_init(&events_enabled, false);
+    atomic_init(&events_overflow, false);
+    
     ESP_LOGI(TAG, "I/O cache initialized");
 }
 
@@ -87,13 +158,21 @@ void io_cache_init(void) {
  * @return uint16_t Cached discrete input value (0-65535)
  */
 uint16_t io_cache_get_discrete_inputs(uint64_t *source_timestamp, uint64_t *server_timestamp) {
-    uint16_t val = 0;
-    if (xSemaphoreTake(io_cache.mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+    uint16_t val;
+    uint64_t src_ts, srv_ts;
+    unsigned seq;
+    
+    for (;;) {
+        seq = io_seqlock_read_begin(&cache_seqlock);
         val = io_cache.discrete_inputs_cache;
-        if (source_timestamp) *source_timestamp = io_cache.inputs_timestamp_ms;
-        if (server_timestamp) *server_timestamp = io_cache.inputs_server_timestamp_ms;
-        xSemaphoreGive(io_cache.mutex);
+        src_ts = io_cache.inputs_timestamp_us;
+        srv_ts = io_cache.inputs_server_timestamp_us;
+        if (!io_seqlock_read_retry(&cache_seqlock, seq)) break;
+        atomic_fetch_add_explicit(&cache_read_retries, 1, memory_order_relaxed);
     }
+    
+    if (source_timestamp) *source_timestamp = src_ts;
+    if (server_timestamp) *server_timestamp = srv_ts;
     return val;
 }
 
@@ -107,13 +186,21 @@ uint16_t io_cache_get_discrete_inputs(uint64_t *source_timestamp, uint64_t *serv
  * @return uint16_t Cached discrete output value (0-65535)
  */
 uint16_t io_cache_get_discrete_outputs(uint64_t *source_timestamp, uint64_t *server_timestamp) {
-    uint16_t val = 0;
-    if (xSemaphoreTake(io_cache.mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+    uint16_t val;
+    uint64_t src_ts, srv_ts;
+    unsigned seq;
+    
+    for (;;) {
+        seq = io_seqlock_read_begin(&cache_seqlock);
         val = io_cache.discrete_outputs_cache;
-        if (source_timestamp) *source_timestamp = io_cache.outputs_timestamp_ms;
-        if (server_timestamp) *server_timestamp = io_cache.outputs_server_timestamp_ms;
-        xSemaphoreGive(io_cache.mutex);
+        src_ts = io_cache.outputs_timestamp_us;
+        srv_ts = io_cache.outputs_server_timestamp_us;
+        if (!io_seqlock_read_retry(&cache_seqlock, seq)) break;
+        atomic_fetch_add_explicit(&cache_read_retries, 1, memory_order_relaxed);
     }
+    
+    if (source_timestamp) *source_timestamp = src_ts;
+    if (server_timestamp) *server_timestamp = srv_ts;
     return val;
 }
 
@@ -123,15 +210,50 @@ uint16_t io_cache_get_discrete_outputs(uint64_t *source_timestamp, uint64_t *ser
  * Updates the cached value of discrete inputs with new hardware readings.
  * 
  * @param new_val New discrete input value (16 bits)
- * @param source_timestamp_ms Source timestamp from hardware reading
+ * @param ok true if every expander was read successfully
+ * @param source_timestamp_us INT edge or read time, also used for the edge counters
  */
-void io_cache_update_discrete_inputs(uint16_t new_val, uint64_t source_timestamp_ms) {
-    if (xSemaphoreTake(io_cache.mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
-        io_cache.discrete_inputs_cache = new_val;
-        io_cache.inputs_timestamp_ms = source_timestamp_ms;
-        io_cache.inputs_server_timestamp_ms = get_current_time_ms();
-        xSemaphoreGive(io_cache.mutex);
+void io_cache_update_discrete_inputs(uint16_t new_val, bool ok, uint64_t source_timestamp_us) {
+    uint64_t server_ts = timebase_now_us();
+    
+    cache_write_begin();
+    uint16_t changed = new_val ^ io_cache.discrete_inputs_cache;
+    uint8_t quality = ok ? IO_QUALITY_GOOD
+                         : io_quality_after_failure((io_quality_t)io_cache.inputs_quality);
+    if (changed || quality != io_cache.inputs_quality) {
+        io_event_t ev = { .kind = IO_EVENT_DISCRETE_INPUTS, .discrete = new_val,
+                          .quality = quality, .source_timestamp_us = source_timestamp_us };
+        event_push(&ev);
+    }
+    io_cache.inputs_quality = quality;
+    history_append(IO_HISTORY_TAG_INPUTS, source_timestamp_us, new_val, quality);
+    // The first read is a state, not a change
+    if (!io_cache.inputs_valid) {
+        changed = 0;
+        io_cache.inputs_valid = true;
+    }
+    // Only the changed bits are visited
+    while (changed) {
+        int bit = __builtin_ctz(changed);
+        io_counter_t *c = &io_cache.counters[bit];
+        changed &= changed - 1;
+        
+        if (new_val & (1u << bit)) {
+            c->rising++;
+            if (c->last_rise_us != 0 && source_timestamp_us > c->last_rise_us) {
+                uint64_t period = source_timestamp_us - c->last_rise_us;
+                c->period_us = period > UINT32_MAX ? UINT32_MAX : (uint32_t)period;
+            }
+            c->last_rise_us = source_timestamp_us;
+        } else {
+            c->falling++;
+        }
+        c->last_edge_us = source_timestamp_us;
     }
+    io_cache.discrete_inputs_cache = new_val;
+    io_cache.inputs_timestamp_us = source_timestamp_us;
+    io_cache.inputs_server_timestamp_us = server_ts;
+    cache_write_end();
 }
 
 /**
@@ -140,15 +262,189 @@ void io_cache_update_discrete_inputs(uint16_t new_val, uint64_t source_timestamp
  * Updates the cached value of discrete outputs with new hardware readings.
  * 
  * @param new_val New discrete output value (16 bits)
- * @param source_timestamp_ms Source timestamp from hardware reading
+ * @param source_timestamp_us Source timestamp from hardware reading
+ */
+void io_cache_update_discrete_outputs(uint16_t new_val, uint64_t source_timestamp_us) {
+    uint64_t server_ts = timebase_now_us();
+    
+    cache_write_begin();
+    if (new_val != io_cache.discrete_outputs_cache || io_cache.outputs_quality != IO_QUALITY_GOOD) {
+        io_event_t ev = { .kind = IO_EVENT_DISCRETE_OUTPUTS, .discrete = new_val,
+                          .quality = IO_QUALITY_GOOD,
+                          .source_timestamp_us = source_timestamp_us };
+        event_push(&ev);
+    }
+    io_cache.outputs_quality = IO_QUALITY_GOOD;
+    io_cache.discrete_outputs_cache = new_val;
+    history_append(IO_HISTORY_TAG_OUTPUTS, source_timestamp_us, new_val, IO_QUALITY_GOOD);
+    io_cache.outputs_timestamp_us = source_timestamp_us;
+    io_cache.outputs_server_timestamp_us = server_ts;
+    cache_write_end();
+}
+
+/**
+ * @brief Copy the whole cache in one consistent operation
+ * 
+ * Copies discrete inputs/outputs, all ADC channels and their timestamps
+ * in a single read section, so all values belong to the same cache state.
+ * 
+ * @param snapshot Pointer to structure receiving the copy
+ */
+void io_cache_get_snapshot(io_cache_snapshot_t *snapshot) {
+    if (!snapshot) return;
+    
+    unsigned seq;
+    
+    for (;;) {
+        seq = io_seqlock_read_begin(&cache_seqlock);
+        snapshot->discrete_inputs = io_cache.discrete_inputs_cache;
+        snapshot->discrete_outputs = io_cache.discrete_outputs_cache;
+        snapshot->inputs_timestamp_us = io_cache.inputs_timestamp_us;
+        snapshot->inputs_server_timestamp_us = io_cache.inputs_server_timestamp_us;
+        snapshot->outputs_timestamp_us = io_cache.outputs_timestamp_us;
+        snapshot->outputs_server_timestamp_us = io_cache.outputs_server_timestamp_us;
+        memcpy(snapshot->adc, adc_cache.adc_cache, sizeof(snapshot->adc));
+        memcpy(snapshot->adc_timestamps_us, adc_cache.adc_timestamps_us,
+               sizeof(snapshot->adc_timestamps_us));
+        memcpy(snapshot->adc_server_timestamps_us, adc_cache.adc_server_timestamps_us,
+               sizeof(snapshot->adc_server_timestamps_us));
+        memcpy(snapshot->adc_valid, adc_cache.adc_valid, sizeof(snapshot->adc_valid));
+        snapshot->inputs_quality = io_cache.inputs_quality;
+        snapshot->outputs_quality = io_cache.outputs_quality;
+        memcpy(snapshot->adc_quality, adc_cache.adc_quality, sizeof(snapshot->adc_quality));
+        snapshot->inputs_stale_ms = io_cache.inputs_stale_ms;
+        snapshot->adc_stale_ms = adc_cache.adc_stale_ms;
+        if (!io_seqlock_read_retry(&cache_seqlock, seq)) break;
+        atomic_fetch_add_explicit(&cache_read_retries, 1, memory_order_relaxed);
+    }
+    
+    // Every update advances the sequence lock by two
+    snapshot->sequence = seq >> 1;
+}
+
+/**
+ * @brief Copy the edge counters of all discrete inputs
+ * 
+ * @param counters Array of IO_NUM_COUNTERS receiving the copy
+ */
+void io_cache_get_counters(io_counter_t counters[IO_NUM_COUNTERS]) {
+    unsigned seq;
+    
+    for (;;) {
+        seq = io_seqlock_read_begin(&cache_seqlock);
+        memcpy(counters, io_cache.counters, sizeof(io_cache.counters));
+        if (!io_seqlock_read_retry(&cache_seqlock, seq)) break;
+        atomic_fetch_add_explicit(&cache_read_retries, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Copy the history of one tag
+ * 
+ * @param tag Tag to copy
+ * @param copy Pointer to structure receiving the copy
+ * @return true if the tag exists
+ */
+bool io_cache_copy_history(io_history_tag_t tag, io_history_t *copy) {
+    if (tag < 0 || tag >= IO_HISTORY_TAG_COUNT || !copy) {
+        return false;
+    }
+    
+    unsigned seq;
+    
+    for (;;) {
+        seq = io_seqlock_read_begin(&cache_seqlock);
+        memcpy(copy, &histories[tag], sizeof(*copy));
+        if (!io_seqlock_read_retry(&cache_seqlock, seq)) break;
+        atomic_fetch_add_explicit(&cache_read_retries, 1, memory_order_relaxed);
+    }
+    return true;
+}
+
+/**
+ * @brief Set the staleness limits used by io_quality_effective()
+ * 
+ * @param inputs_ms Inputs staleness limit (0 = never stale)
+ * @param adc_ms ADC staleness limit (0 = never stale)
+ */
+void io_cache_set_stale_limits(uint32_t inputs_ms, uint32_t adc_ms) {
+    cache_write_begin();
+    io_cache.inputs_stale_ms = inputs_ms;
+    adc_cache.adc_stale_ms = adc_ms;
+    cache_write_end();
+}
+
+/**
+ * @brief Start or stop queueing change events
+ * 
+ * @param enable true to queue events from now on
+ */
+void io_cache_enable_events(bool enable) {
+    atomic_store_explicit(&events_enabled, enable, memory_order_relaxed);
+}
+
+/**
+ * @brief Take the oldest queued change event (single consumer)
+ * 
+ * @param event Pointer to structure receiving the event
+ * @return true if an event was returned
+ * @return false if the queue is empty
+ */
+bool io_cache_pop_event(io_event_t *event) {
+    unsigned tail = atomic_load_explicit(&event_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&event_head, memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+    *event = event_queue[tail & (IO_EVENT_QUEUE_LEN - 1)];
+    atomic_store_explicit(&event_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Check and clear the event queue overflow flag
+ * 
+ * @return true if events were lost since the last call
+ */
+bool io_cache_take_event_overflow(void) {
+    return atomic_exchange_explicit(&events_overflow, false, memory_order_acquire);
+}
+
+/**
+ * @brief Report the result of an output write to hardware
+ * 
+ * On success publishes the applied value with Good quality. On failure
+ * keeps the last applied value and lowers its quality.
+ * 
+ * @param applied_val Value written to the outputs (16 bits)
+ * @param ok true if the hardware write succeeded
+ * @param source_timestamp_us Time of the hardware write
  */
-void io_cache_update_discrete_outputs(uint16_t new_val, uint64_t source_timestamp_ms) {
-    if (xSemaphoreTake(io_cache.mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
-        io_cache.discrete_outputs_cache = new_val;
-        io_cache.outputs_timestamp_ms = source_timestamp_ms;
-        io_cache.outputs_server_timestamp_ms = get_current_time_ms();
-        xSemaphoreGive(io_cache.mutex);
+void io_cache_complete_outputs_write(uint16_t applied_val, bool ok, uint64_t source_timestamp_us) {
+    uint64_t server_ts = timebase_now_us();
+    
+    cache_write_begin();
+    // A failed write is always reported: the node may hold the rejected value
+    bool changed = !ok || io_cache.outputs_quality != IO_QUALITY_GOOD ||
+                   applied_val != io_cache.discrete_outputs_cache;
+    if (ok) {
+        io_cache.discrete_outputs_cache = applied_val;
+        io_cache.outputs_timestamp_us = source_timestamp_us;
+        io_cache.outputs_server_timestamp_us = server_ts;
+        io_cache.outputs_quality = IO_QUALITY_GOOD;
+    } else {
+        io_cache.outputs_quality = io_quality_after_failure((io_quality_t)io_cache.outputs_quality);
+    }
+    history_append(IO_HISTORY_TAG_OUTPUTS, source_timestamp_us, io_cache.discrete_outputs_cache,
+                   io_cache.outputs_quality);
+    if (changed) {
+        io_event_t ev = { .kind = IO_EVENT_DISCRETE_OUTPUTS,
+                          .discrete = io_cache.discrete_outputs_cache,
+                          .quality = io_cache.outputs_quality,
+                          .source_timestamp_us = source_timestamp_us };
+        event_push(&ev);
     }
+    cache_write_end();
 }
 
 /**
@@ -164,18 +460,33 @@ void io_cache_update_discrete_outputs(uint16_t new_val, uint64_t source_timestam
  * @return false if channel is invalid or value is not valid
  */
 bool io_cache_get_adc_channel(int channel, float *value, uint64_t *source_timestamp, uint64_t *server_timestamp) {
-    if (channel < 0 || channel >= NUM_ADC_CHANNELS || !adc_cache.adc_valid[channel]) {
+    if (channel < 0 || channel >= NUM_ADC_CHANNELS) {
         return false;
     }
     
-    if (xSemaphoreTake(io_cache.mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        *value = adc_cache.adc_cache[channel];
-        if (source_timestamp) *source_timestamp = adc_cache.adc_timestamps_ms[channel];
-        if (server_timestamp) *server_timestamp = adc_cache.adc_server_timestamps_ms[channel];
-        xSemaphoreGive(io_cache.mutex);
-        return true;
+    float val;
+    uint64_t src_ts, srv_ts;
+    bool valid;
+    unsigned seq;
+    
+    for (;;) {
+        seq = io_seqlock_read_begin(&cache_seqlock);
+        val = adc_cache.adc_cache[channel];
+        src_ts = adc_cache.adc_timestamps_us[channel];
+        srv_ts = adc_cache.adc_server_timestamps_us[channel];
+        valid = adc_cache.adc_valid[channel];
+        if (!io_seqlock_read_retry(&cache_seqlock, seq)) break;
+        atomic_fetch_add_explicit(&cache_read_retries, 1, memory_order_relaxed);
     }
-    return false;
+    
+    if (!valid) {
+        return false;
+    }
+    
+    *value = val;
+    if (source_timestamp) *source_timestamp = src_ts;
+    if (server_timestamp) *server_timestamp = srv_ts;
+    return true;
 }
 
 /**
@@ -197,38 +508,80 @@ float* io_cache_get_all_adc_channels(void) {
  * 
  * @param channel ADC channel number (0 to NUM_ADC_CHANNELS-1)
  * @param new_value New ADC value
- * @param source_timestamp_ms Source timestamp from hardware reading
+ * @param source_timestamp_us Source timestamp from hardware reading
  */
-void io_cache_update_adc_channel(int channel, float new_value, uint64_t source_timestamp_ms) {
+void io_cache_update_adc_channel(int channel, float new_value, uint64_t source_timestamp_us) {
     if (channel < 0 || channel >= NUM_ADC_CHANNELS) return;
     
-    if (xSemaphoreTake(io_cache.mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
-        adc_cache.adc_cache[channel] = new_value;
-        adc_cache.adc_timestamps_ms[channel] = source_timestamp_ms;
-        adc_cache.adc_server_timestamps_ms[channel] = get_current_time_ms();
-        adc_cache.adc_valid[channel] = true;
-        xSemaphoreGive(io_cache.mutex);
+    uint64_t server_ts = timebase_now_us();
+    
+    cache_write_begin();
+    if (adc_cache.adc_quality[channel] != IO_QUALITY_GOOD || new_value != adc_cache.adc_cache[channel]) {
+        io_event_t ev = { .kind = IO_EVENT_ADC, .channel = (uint8_t)channel, .adc = new_value,
+                          .quality = IO_QUALITY_GOOD, .source_timestamp_us = source_timestamp_us };
+        event_push(&ev);
     }
+    adc_cache.adc_quality[channel] = IO_QUALITY_GOOD;
+    adc_cache.adc_cache[channel] = new_value;
+    history_append(IO_HISTORY_TAG_ADC + channel, source_timestamp_us,
+                   io_history_adc_value(new_value), IO_QUALITY_GOOD);
+    adc_cache.adc_timestamps_us[channel] = source_timestamp_us;
+    adc_cache.adc_server_timestamps_us[channel] = server_ts;
+    adc_cache.adc_valid[channel] = true;
+    cache_write_end();
 }
 
 /**
  * @brief Update all ADC channel values in cache
  * 
  * Updates all ADC channel values with new readings in a single operation.
+ * Failed channels keep their value and timestamps; only the quality and
+ * the server timestamp change.
  * 
  * @param values Array of new ADC values (must contain NUM_ADC_CHANNELS elements)
- * @param source_timestamp_ms Source timestamp from hardware reading
+ * @param ok Per-channel acquisition result (NULL = all succeeded)
+ * @param source_timestamp_us Source timestamp from hardware reading
  */
-void io_cache_update_all_adc_channels(float* values, uint64_t source_timestamp_ms) {
+void io_cache_update_all_adc_channels(float* values, const bool *ok, uint64_t source_timestamp_us) {
     if (!values) return;
     
-    if (xSemaphoreTake(io_cache.mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
-        for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
-            adc_cache.adc_cache[i] = values[i];
-            adc_cache.adc_timestamps_ms[i] = source_timestamp_ms;
-            adc_cache.adc_server_timestamps_ms[i] = get_current_time_ms();
+    uint64_t server_ts = timebase_now_us();
+    
+    cache_write_begin();
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        bool channel_ok = !ok || ok[i];
+        uint8_t quality = channel_ok ? IO_QUALITY_GOOD
+                                     : io_quality_after_failure((io_quality_t)adc_cache.adc_quality[i]);
+        float value = channel_ok ? values[i] : adc_cache.adc_cache[i];
+        
+        if (quality != adc_cache.adc_quality[i] || value != adc_cache.adc_cache[i]) {
+            io_event_t ev = { .kind = IO_EVENT_ADC, .channel = (uint8_t)i, .adc = value,
+                              .quality = quality,
+                              .source_timestamp_us = channel_ok ? source_timestamp_us
+                                                                : adc_cache.adc_timestamps_us[i] };
+            event_push(&ev);
+        }
+        adc_cache.adc_quality[i] = quality;
+        adc_cache.adc_server_timestamps_us[i] = server_ts;
+        history_append(IO_HISTORY_TAG_ADC + i, source_timestamp_us, io_history_adc_value(value), quality);
+        if (channel_ok) {
+            adc_cache.adc_cache[i] = value;
+            adc_cache.adc_timestamps_us[i] = source_timestamp_us;
             adc_cache.adc_valid[i] = true;
         }
-        xSemaphoreGive(io_cache.mutex);
     }
+    cache_write_end();
+}
+
+/**
+ * @brief Get total number of cache reader retries
+ * 
+ * Counts how often a reader had to repeat its copy because the polling
+ * task was updating the cache at the same time. Useful as a contention
+ * indicator; a retry costs a few hundred nanoseconds, never a block.
+ * 
+ * @return uint32_t Number of retries since io_cache_init()
+ */
+uint32_t io_cache_get_read_retries(void) {
+    return atomic_load_explicit(&cache_read_retries, memory_order_relaxed);
 }
\ No newline at end of file
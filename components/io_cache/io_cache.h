@@ -7,16 +7,183 @@
 #include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "timebase.h"
+#include "io_sched.h"
+#include "io_hist.h"
+#include "di_debounce.h"
+#include "io_history.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#ifndef NUM_ADC_CHANNELS
+/** @brief Number of ADC channels held in the cache (matches model.h) */
+#define NUM_ADC_CHANNELS  4
+#endif
+
+/**
+ * @brief Quality of a cached value
+ * 
+ * Set by the acquisition path from the driver result of every read or
+ * write. Readers map it to an OPC UA StatusCode.
+ */
+typedef enum {
+    IO_QUALITY_WAITING = 0,     /**< Not acquired yet (Bad_WaitingForInitialData) */
+    IO_QUALITY_GOOD,            /**< Last acquisition succeeded (Good) */
+    IO_QUALITY_LAST_USABLE,     /**< Last acquisition failed or is overdue, older value kept (Uncertain_LastUsableValue) */
+    IO_QUALITY_COMM_FAILURE,    /**< Acquisition failed and there is no older value (Bad_NoCommunication) */
+} io_quality_t;
+
+/**
+ * @brief Quality of a value after a failed acquisition
+ * 
+ * @param current Quality before the failure
+ * @return io_quality_t IO_QUALITY_LAST_USABLE if a value was ever acquired,
+ *         IO_QUALITY_COMM_FAILURE otherwise
+ */
+static inline io_quality_t io_quality_after_failure(io_quality_t current) {
+    return (current == IO_QUALITY_GOOD || current == IO_QUALITY_LAST_USABLE)
+           ? IO_QUALITY_LAST_USABLE : IO_QUALITY_COMM_FAILURE;
+}
+
+/**
+ * @brief Quality of a value as seen by a reader now
+ * 
+ * A Good value that has not been updated within @p stale_ms (a few poll
+ * periods, see io_cache_set_stale_limits()) is downgraded to last usable:
+ * the acquisition is overdue even though no read has failed.
+ * 
+ * @param quality Stored quality
+ * @param updated_us Time of the last update (server timestamp, timebase_now_us())
+ * @param now_us Current time from timebase_now_us()
+ * @param stale_ms Staleness limit (0 = never stale)
+ * @return io_quality_t Effective quality
+ */
+static inline io_quality_t io_quality_effective(io_quality_t quality, uint64_t updated_us,
+                                                uint64_t now_us, uint32_t stale_ms) {
+    if (quality == IO_QUALITY_GOOD && stale_ms != 0 &&
+        now_us > updated_us && now_us - updated_us > (uint64_t)stale_ms * 1000) {
+        return IO_QUALITY_LAST_USABLE;
+    }
+    return quality;
+}
+
+/**
+ * @brief Consistent copy of the whole I/O cache
+ * 
+ * Filled by io_cache_get_snapshot() in one lock-free read section, so all
+ * values belong to the same cache state (no mix of poll cycles).
+ * 
+ * All timestamps are monotonic microseconds from timebase_now_us(); map
+ * them with timebase_to_utc_us() before handing them to clients.
+ */
+typedef struct {
+    uint16_t discrete_inputs;                            /**< Discrete input values (16 bits) */
+    uint16_t discrete_outputs;                           /**< Discrete output values (16 bits) */
+    uint64_t inputs_timestamp_us;                        /**< Source timestamp for inputs */
+    uint64_t inputs_server_timestamp_us;                 /**< Server timestamp for inputs */
+    uint64_t outputs_timestamp_us;                       /**< Source timestamp for outputs */
+    uint64_t outputs_server_timestamp_us;                /**< Server timestamp for outputs */
+    float adc[NUM_ADC_CHANNELS];                         /**< ADC channel values */
+    uint64_t adc_timestamps_us[NUM_ADC_CHANNELS];        /**< Source timestamps for ADC values */
+    uint64_t adc_server_timestamps_us[NUM_ADC_CHANNELS]; /**< Server timestamps for ADC values */
+    bool adc_valid[NUM_ADC_CHANNELS];                    /**< Validity flags for ADC channels */
+    uint8_t inputs_quality;                              /**< io_quality_t of the inputs */
+    uint8_t outputs_quality;                             /**< io_quality_t of the outputs (last write) */
+    uint8_t adc_quality[NUM_ADC_CHANNELS];               /**< io_quality_t per ADC channel */
+    uint32_t inputs_stale_ms;                            /**< Staleness limit of the inputs (0 = none) */
+    uint32_t adc_stale_ms;                               /**< Staleness limit of the ADC channels (0 = none) */
+    uint32_t sequence;                                   /**< Number of cache updates so far */
+} io_cache_snapshot_t;
+
+/** @brief Number of discrete inputs with edge counters */
+#define IO_NUM_COUNTERS  16
+
+/**
+ * @brief Edge counter of one discrete input
+ * 
+ * Counted by the cache on every change of the (debounced) input word, so
+ * the resolution is one acquisition: an INT-triggered read when expander
+ * interrupts are used, otherwise the input poll. Counters are 64-bit and
+ * never reset, so a client computes the pulses between two reads as the
+ * unsigned difference of the counts, which stays correct across
+ * wrap-around; the count and its edge time are copied together.
+ */
+typedef struct {
+    uint64_t rising;            /**< Rising edges since start */
+    uint64_t falling;           /**< Falling edges since start */
+    uint64_t last_edge_us;      /**< Time of the last edge (0 = none yet) */
+    uint64_t last_rise_us;      /**< Time of the last rising edge (0 = none yet) */
+    uint32_t period_us;         /**< Time between the last two rising edges (0 = unknown) */
+} io_counter_t;
+
+/**
+ * @brief Pulses between two counter reads (wrap-around safe)
+ * 
+ * @param now Current count
+ * @param prev Earlier count
+ * @return uint64_t Edges in between
+ */
+static inline uint64_t io_counter_delta(uint64_t now, uint64_t prev) {
+    return now - prev;
+}
+
+/**
+ * @brief Estimated pulse frequency of an input
+ * 
+ * The inverse of the last rising edge period. When no edge has arrived
+ * for longer than that period, the time since the last edge is used
+ * instead, so the estimate falls towards zero when the pulses stop.
+ * 
+ * @param c Counter
+ * @param now_us Current time in microseconds
+ * @return double Frequency in Hz (0 before two rising edges)
+ */
+static inline double io_counter_frequency_hz(const io_counter_t *c, uint64_t now_us) {
+    if (c->period_us == 0) {
+        return 0.0;
+    }
+    uint64_t period = c->period_us;
+    if (now_us > c->last_rise_us && now_us - c->last_rise_us > period) {
+        period = now_us - c->last_rise_us;
+    }
+    return 1e6 / (double)period;
+}
+
+/** @brief Capacity of the change event queue (power of two) */
+#define IO_EVENT_QUEUE_LEN  64
+
+/**
+ * @brief Value carried by a cache change event
+ */
+typedef enum {
+    IO_EVENT_DISCRETE_INPUTS = 0,   /**< Discrete input word changed */
+    IO_EVENT_DISCRETE_OUTPUTS,      /**< Discrete output word or its write status changed */
+    IO_EVENT_ADC,                   /**< One ADC channel changed */
+} io_event_kind_t;
+
+/**
+ * @brief Cache change event, see io_cache_enable_events()
+ */
+typedef struct {
+    uint8_t kind;                   /**< io_event_kind_t */
+    uint8_t channel;                /**< ADC channel (IO_EVENT_ADC only) */
+    uint8_t quality;                /**< io_quality_t of the new value */
+    uint16_t discrete;              /**< New discrete word (discrete events) */
+    float adc;                      /**< New ADC value (IO_EVENT_ADC only) */
+    uint64_t source_timestamp_us;   /**< Hardware timestamp of the new value */
+} io_event_t;
+
 /**
  * @brief Initialize I/O cache system
  * 
- * This function initializes the cache structures and creates the mutex
- * for thread-safe operations. Must be called before using any cache functions.
+ * This function initializes the cache structures and the sequence lock
+ * protecting them. Must be called before using any cache functions.
+ *
+ * @note Cache readers are lock-free and never block: a reader that overlaps
+ *       an update simply repeats its copy. Getters therefore always return
+ *       a consistent value, never a fabricated default.
  */
 void io_cache_init(void);
 
@@ -47,10 +214,17 @@ uint16_t io_cache_get_discrete_outputs(uint64_t *source_timestamp, uint64_t *ser
  * 
  * Updates the cached value of discrete inputs with new hardware readings.
  * 
+ * Every changed bit also advances the edge counter of its input. When
+ * the read failed, the caller passes the last good bits of the failed
+ * expanders and the quality drops to last usable (or communication
+ * failure if the inputs were never read).
+ * 
  * @param new_val New discrete input value (16 bits)
- * @param source_timestamp_ms Source timestamp from hardware reading
+ * @param ok true if every expander was read successfully
+ * @param source_timestamp_us INT edge or read time (timebase_now_us()), also
+ *        the edge time of the counters
  */
-void io_cache_update_discrete_inputs(uint16_t new_val, uint64_t source_timestamp_ms);
+void io_cache_update_discrete_inputs(uint16_t new_val, bool ok, uint64_t source_timestamp_us);
 
 /**
  * @brief Update discrete output values in cache
@@ -58,9 +232,230 @@ void io_cache_update_discrete_inputs(uint16_t new_val, uint64_t source_timestamp
  * Updates the cached value of discrete outputs with new hardware readings.
  * 
  * @param new_val New discrete output value (16 bits)
- * @param source_timestamp_ms Source timestamp from hardware reading
+ * @param source_timestamp_us Source timestamp from hardware reading
+ */
+void io_cache_update_discrete_outputs(uint16_t new_val, uint64_t source_timestamp_us);
+
+/**
+ * @brief Copy the whole cache in one consistent operation
+ * 
+ * Copies discrete inputs/outputs, all ADC channels and their timestamps
+ * at once. Cheaper than calling the individual getters for every value
+ * and guarantees that all values come from the same cache state.
+ * 
+ * @param snapshot Pointer to structure receiving the copy
+ */
+void io_cache_get_snapshot(io_cache_snapshot_t *snapshot);
+
+/**
+ * @brief Copy the edge counters of all discrete inputs
+ * 
+ * Kept out of io_cache_get_snapshot() so that readers of the plain I/O
+ * values do not copy them on every iteration.
+ * 
+ * @param counters Array of IO_NUM_COUNTERS receiving the copy
+ */
+void io_cache_get_counters(io_counter_t counters[IO_NUM_COUNTERS]);
+
+/**
+ * @brief Tags with a history ring buffer
+ */
+typedef enum {
+    IO_HISTORY_TAG_INPUTS = 0,      /**< Discrete inputs (debounced word) */
+    IO_HISTORY_TAG_OUTPUTS,         /**< Discrete outputs (applied word) */
+    IO_HISTORY_TAG_ADC,             /**< First ADC channel, followed by the others */
+    IO_HISTORY_TAG_COUNT = IO_HISTORY_TAG_ADC + NUM_ADC_CHANNELS
+} io_history_tag_t;
+
+/**
+ * @brief Copy the history of one tag
+ * 
+ * Every cache update that changes a value or its quality is also
+ * recorded in the ring buffer of its tag, so clients can backfill the
+ * samples they missed while disconnected. The copy is consistent and can
+ * be decoded with io_history_iter_init() without holding any lock.
+ * 
+ * @param tag Tag to copy
+ * @param copy Pointer to structure receiving the copy (IO_HISTORY_BYTES + header)
+ * @return true if the tag exists
+ */
+bool io_cache_copy_history(io_history_tag_t tag, io_history_t *copy);
+
+/**
+ * @brief Set the staleness limits used by io_quality_effective()
+ * 
+ * Called by the polling task whenever a poll period changes.
+ * 
+ * @param inputs_ms Inputs older than this are reported as last usable (0 = never)
+ * @param adc_ms ADC values older than this are reported as last usable (0 = never)
+ */
+void io_cache_set_stale_limits(uint32_t inputs_ms, uint32_t adc_ms);
+
+/**
+ * @brief Start or stop queueing change events
+ * 
+ * While enabled, every cache update whose value differs from the cached
+ * one queues an io_event_t. The queue has a single consumer (the OPC UA
+ * task); producers are already serialised by the cache write lock, so
+ * neither side ever blocks. Disabled by default.
+ * 
+ * @param enable true to queue events from now on
+ */
+void io_cache_enable_events(bool enable);
+
+/**
+ * @brief Take the oldest queued change event
+ * 
+ * Must only be called from one task.
+ * 
+ * @param event Pointer to structure receiving the event
+ * @return true if an event was returned
+ * @return false if the queue is empty
+ */
+bool io_cache_pop_event(io_event_t *event);
+
+/**
+ * @brief Check and clear the event queue overflow flag
+ * 
+ * When the queue is full, new events are dropped and the flag is set.
+ * The consumer must then resynchronise from io_cache_get_snapshot().
+ * 
+ * @return true if events were lost since the last call
+ */
+bool io_cache_take_event_overflow(void);
+
+/**
+ * @brief Report the result of an output write to hardware
+ * 
+ * Called by the polling task after executing a queued output command.
+ * On success the applied value is published like
+ * io_cache_update_discrete_outputs(); on failure the cached value keeps the
+ * last applied state and its quality drops to last usable (communication
+ * failure if no write has succeeded yet).
+ * 
+ * @param applied_val Value written to the outputs (16 bits)
+ * @param ok true if the hardware write succeeded
+ * @param source_timestamp_us Time of the hardware write
+ */
+void io_cache_complete_outputs_write(uint16_t applied_val, bool ok, uint64_t source_timestamp_us);
+
+/**
+ * @brief Queue a discrete output change for the polling task
+ * 
+ * Lock-free and non-blocking, safe to call from the OPC UA task. Bits set
+ * in @p mask take their value from @p values; other outputs are unchanged.
+ * Requests not yet executed are coalesced per bit (last writer wins) and
+ * the merged command is written at the next I/O slot.
+ * 
+ * @param mask Outputs to change (bit n = output n+1)
+ * @param values New values for the outputs selected by @p mask
+ */
+void io_polling_request_outputs(uint16_t mask, uint16_t values);
+
+/** @brief io_polling_refresh() group: all discrete inputs */
+#define IO_REFRESH_INPUTS   (1u << 0)
+/** @brief io_polling_refresh() group: all ADC channels (oneshot backend only) */
+#define IO_REFRESH_ADC      (1u << 1)
+
+/**
+ * @brief Read I/O groups from hardware now, through the polling task
+ * 
+ * Blocks the caller until the polling task has read the requested groups
+ * and updated the cache, or until the timeout expires. The bus stays owned
+ * by the polling task, so on-demand reads never overlap a poll. Used for
+ * OPC UA reads whose maxAge is shorter than the age of the cached value.
+ * Only one task may call this at a time.
+ * 
+ * @param groups IO_REFRESH_INPUTS and/or IO_REFRESH_ADC
+ * @param timeout_ms Maximum time to wait
+ * @return true if the cache was refreshed
+ * @return false on timeout or if no requested group can be read on demand
+ */
+bool io_polling_refresh(uint32_t groups, uint32_t timeout_ms);
+
+/**
+ * @brief Set the input and ADC poll periods
+ * 
+ * Called by the OPC UA side when the monitored sampling intervals or the
+ * number of sessions change. Inputs read through expander interrupts keep
+ * their integrity poll period.
+ * 
+ * @param inputs_ms Discrete input poll period in milliseconds
+ * @param adc_ms ADC poll period in milliseconds (oneshot backend)
  */
-void io_cache_update_discrete_outputs(uint16_t new_val, uint64_t source_timestamp_ms);
+void io_polling_set_intervals(uint32_t inputs_ms, uint32_t adc_ms);
+
+/**
+ * @brief Get the number of acquisition groups of the polling task
+ * 
+ * @return int Number of groups (0 before the polling task has started)
+ */
+int io_polling_get_group_count(void);
+
+/**
+ * @brief Get the timing statistics of an acquisition group
+ * 
+ * Reports the configured and actual period, release lateness (jitter),
+ * longest run time and skipped deadlines of one periodic group (inputs,
+ * ADC, statistics). Lock-free; safe to call from any task.
+ * 
+ * @param id Group index (0 to io_polling_get_group_count()-1)
+ * @param name Optional pointer receiving the group name
+ * @param stats Pointer to structure receiving the statistics
+ * @return true if the group exists
+ */
+bool io_polling_get_group_stats(int id, const char **name, io_sched_stats_t *stats);
+
+/**
+ * @brief Acquisition histograms kept by the polling task
+ */
+typedef enum {
+    IO_DIAG_INPUTS_READ = 0,    /**< Discrete input acquisition time (CPU cycles) */
+    IO_DIAG_ADC_READ,           /**< ADC acquisition time incl. cache update (CPU cycles) */
+    IO_DIAG_CACHE_UPDATE,       /**< Discrete input cache update time (CPU cycles) */
+    IO_DIAG_LATENESS,           /**< Start lateness of the input and ADC polls (microseconds) */
+    IO_DIAG_COUNT
+} io_diag_id_t;
+
+/**
+ * @brief Copy an acquisition histogram
+ * 
+ * Always-on instrumentation of the polling task: each acquisition is timed
+ * with the CPU cycle counter and recorded in a fixed-size log-linear
+ * histogram (io_hist.h). Lock-free; safe to call from any task.
+ * 
+ * @param id Histogram
+ * @param out Pointer to histogram receiving the copy
+ */
+void io_polling_get_diag_histogram(io_diag_id_t id, io_hist_t *out);
+
+/**
+ * @brief Get the number of failed I/O expander transactions since the last reset
+ * 
+ * @return uint32_t Failed I2C transactions
+ */
+uint32_t io_polling_get_bus_errors(void);
+
+/**
+ * @brief Request a reset of all acquisition diagnostics
+ * 
+ * Clears the histograms, the bus error count and the group timing
+ * statistics. Carried out asynchronously by the polling task.
+ */
+void io_polling_reset_diagnostics(void);
+
+/**
+ * @brief Set the debounce mode of one discrete input
+ * 
+ * Debouncing runs in the polling task between the expander read and the
+ * cache update, see di_debounce.h. Takes effect at the next input read.
+ * 
+ * @param input Input index (0-15)
+ * @param mode Debounce mode
+ * @param limit Samples (integrator) or milliseconds (time), 0-255
+ * @return true on success, false if the input index is invalid
+ */
+bool io_polling_set_debounce(uint8_t input, di_debounce_mode_t mode, uint32_t limit);
 
 /**
  * @brief Start I/O polling task
@@ -111,16 +506,28 @@ float* io_cache_get_all_adc_channels(void);
  * 
  * @param channel ADC channel number (0 to NUM_ADC_CHANNELS-1)
  * @param new_value New ADC value
- * @param source_timestamp_ms Source timestamp from hardware reading
+ * @param source_timestamp_us Source timestamp from hardware reading
  */
-void io_cache_update_adc_channel(int channel, float new_value, uint64_t source_timestamp_ms);
+void io_cache_update_adc_channel(int channel, float new_value, uint64_t source_timestamp_us);
 
 /**
  * @brief Update all ADC channel values in cache
  * 
  * Updates all ADC channel values with new readings in a single operation.
+ * Channels whose acquisition failed keep their value and lose quality.
  * 
  * @param values Array of new ADC values (must contain NUM_ADC_CHANNELS elements)
- * @param source_timestamp_ms Source timestamp from hardware reading
+ * @param ok Per-channel acquisition result (NULL = all succeeded)
+ * @param source_timestamp_us Source timestamp from hardware reading
+ */
+void io_cache_update_all_adc_channels(float* values, const bool *ok, uint64_t source_timestamp_us);
+
+/**
+ * @brief Get total number of cache reader retries
+ * 
+ * Counts how often a reader had to repeat its copy because the cache
+ * was being updated at the same time (contention indicator).
+ * 
+ * @return uint32_t Number of retries since io_cache_init()
  */
-void io_cache_update_all_adc_channels(float* values, uint64_t source_timestamp_ms);
\ No newline at end of file
+uint32_t io_cache_get_read_retries(void);
\ No newline at end of file
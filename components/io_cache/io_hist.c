@@ -0,0 +1,43 @@
+/* io_hist.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "io_hist.h"
+#include <string.h>
+
+void io_hist_reset(io_hist_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = UINT32_MAX;
+}
+
+uint32_t io_hist_bucket_low(unsigned idx) {
+    if (idx < IO_HIST_SUB_BUCKETS) {
+        return idx;
+    }
+    unsigned e = idx / IO_HIST_SUB_BUCKETS + IO_HIST_SUB_BITS - 1;
+    unsigned m = idx % IO_HIST_SUB_BUCKETS;
+    return (uint32_t)(IO_HIST_SUB_BUCKETS + m) << (e - IO_HIST_SUB_BITS);
+}
+
+uint32_t io_hist_percentile(const io_hist_t *h, double p) {
+    if (h->count == 0) {
+        return 0;
+    }
+    if (p < 0.0) p = 0.0;
+    if (p > 1.0) p = 1.0;
+
+    uint64_t rank = (uint64_t)(p * (double)(h->count - 1));
+    uint64_t acc = 0;
+
+    for (unsigned i = 0; i < IO_HIST_BUCKETS; i++) {
+        acc += h->buckets[i];
+        if (acc > rank) {
+            uint32_t low = io_hist_bucket_low(i);
+            uint32_t width = (i + 1 < IO_HIST_BUCKETS) ? io_hist_bucket_low(i + 1) - low
+                                                       : UINT32_MAX - low;
+            uint32_t mid = low + width / 2;
+            if (mid < h->min) mid = h->min;
+            if (mid > h->max) mid = h->max;
+            return mid;
+        }
+    }
+    return h->max;
+}
@@ -0,0 +1,99 @@
+/* io_hist.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef IO_HIST_H
+#define IO_HIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Linear sub-buckets per power of two, as bits (8 sub-buckets = 12.5 % resolution) */
+#define IO_HIST_SUB_BITS     3
+/** @brief Linear sub-buckets per power of two */
+#define IO_HIST_SUB_BUCKETS  (1u << IO_HIST_SUB_BITS)
+/** @brief Number of buckets covering the whole uint32_t range */
+#define IO_HIST_BUCKETS      ((32 - IO_HIST_SUB_BITS + 1) * IO_HIST_SUB_BUCKETS)
+
+/**
+ * @brief Log-linear histogram of 32-bit values in fixed memory
+ *
+ * Values below IO_HIST_SUB_BUCKETS get one bucket each; above that every
+ * power of two is split into IO_HIST_SUB_BUCKETS equal buckets, so the
+ * relative bucket width is at most 1/IO_HIST_SUB_BUCKETS over the whole
+ * range. Recording is a count-leading-zeros, a shift and an increment.
+ *
+ * Single writer. Like io_seqlock.h this header only depends on C, so the
+ * same code runs in the firmware and in host tools.
+ */
+typedef struct {
+    uint32_t buckets[IO_HIST_BUCKETS];  /**< Counts per bucket */
+    uint32_t count;                     /**< Number of recorded values */
+    uint32_t min;                       /**< Smallest value (UINT32_MAX if empty) */
+    uint32_t max;                       /**< Largest value */
+    uint64_t sum;                       /**< Sum of all values */
+} io_hist_t;
+
+/**
+ * @brief Bucket index of a value
+ *
+ * @param v Value
+ * @return unsigned Bucket index (0 to IO_HIST_BUCKETS-1)
+ */
+static inline unsigned io_hist_bucket(uint32_t v) {
+    if (v < IO_HIST_SUB_BUCKETS) {
+        return v;
+    }
+    unsigned e = 31u - (unsigned)__builtin_clz(v);
+    return (e - IO_HIST_SUB_BITS + 1) * IO_HIST_SUB_BUCKETS +
+           ((v >> (e - IO_HIST_SUB_BITS)) & (IO_HIST_SUB_BUCKETS - 1));
+}
+
+/**
+ * @brief Record one value
+ *
+ * @param h Pointer to histogram
+ * @param v Value
+ */
+static inline void io_hist_record(io_hist_t *h, uint32_t v) {
+    h->buckets[io_hist_bucket(v)]++;
+    h->count++;
+    h->sum += v;
+    if (v < h->min) h->min = v;
+    if (v > h->max) h->max = v;
+}
+
+/**
+ * @brief Clear a histogram
+ *
+ * @param h Pointer to histogram
+ */
+void io_hist_reset(io_hist_t *h);
+
+/**
+ * @brief Smallest value falling into a bucket
+ *
+ * @param idx Bucket index
+ * @return uint32_t Lower bound of the bucket
+ */
+uint32_t io_hist_bucket_low(unsigned idx);
+
+/**
+ * @brief Estimate a percentile
+ *
+ * Returns the middle of the bucket holding the requested rank, limited to
+ * the recorded minimum and maximum.
+ *
+ * @param h Pointer to histogram
+ * @param p Fraction between 0 and 1 (e.g. 0.99)
+ * @return uint32_t Estimated value (0 if the histogram is empty)
+ */
+uint32_t io_hist_percentile(const io_hist_t *h, double p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_HIST_H */
@@ -0,0 +1,198 @@
+/* io_history.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "io_history.h"
+#include <string.h>
+
+#define HDR_QUALITY_MASK    0x03u
+#define HDR_VALUE_SHIFT     2
+#define HDR_VALUE_MASK      0x03u
+
+/** Value encodings (header bits 2-3) */
+enum {
+    VALUE_SAME = 0,     /**< Value unchanged */
+    VALUE_BIT,          /**< Discrete: one toggled bit, index in one byte */
+    VALUE_XOR,          /**< Discrete: 16-bit XOR mask */
+};
+#define VALUE_DELTA  VALUE_BIT  /**< ADC: zigzag varint difference */
+
+/**
+ * @brief One record as stored, after decoding
+ */
+typedef struct {
+    uint64_t dt_us;     /**< Time since the previous sample */
+    int32_t value;      /**< Value after applying the record */
+    uint8_t quality;    /**< Quality of the sample */
+    uint32_t len;       /**< Encoded length in bytes */
+} record_t;
+
+static inline uint32_t ring_wrap(uint32_t pos) {
+    return pos >= IO_HISTORY_BYTES ? pos - IO_HISTORY_BYTES : pos;
+}
+
+static inline uint8_t ring_get(const io_history_t *h, uint32_t pos) {
+    return h->buf[ring_wrap(pos)];
+}
+
+static inline uint32_t put_varint(uint8_t *p, uint64_t v) {
+    uint32_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline uint64_t get_varint(const io_history_t *h, uint32_t pos, uint32_t *len) {
+    uint64_t v = 0;
+    unsigned shift = 0;
+    uint8_t b;
+    do {
+        b = ring_get(h, pos + *len);
+        (*len)++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while ((b & 0x80) && shift < 64);
+    return v;
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ * @brief Decode the record at a ring offset
+ *
+ * @param h History
+ * @param pos Offset of the record
+ * @param prev_value Value before the record
+ * @param r Decoded record
+ */
+static void decode_record(const io_history_t *h, uint32_t pos, int32_t prev_value, record_t *r) {
+    uint8_t hdr = ring_get(h, pos);
+    uint32_t len = 1;
+    unsigned enc = (hdr >> HDR_VALUE_SHIFT) & HDR_VALUE_MASK;
+
+    r->quality = hdr & HDR_QUALITY_MASK;
+    r->dt_us = get_varint(h, pos, &len);
+    r->value = prev_value;
+
+    if (h->kind == IO_HISTORY_DISCRETE) {
+        if (enc == VALUE_BIT) {
+            r->value ^= (int32_t)(1u << (ring_get(h, pos + len) & 0x0F));
+            len += 1;
+        } else if (enc == VALUE_XOR) {
+            uint16_t mask = (uint16_t)(ring_get(h, pos + len) | (ring_get(h, pos + len + 1) << 8));
+            r->value ^= mask;
+            len += 2;
+        }
+    } else if (enc == VALUE_DELTA) {
+        r->value += unzigzag((uint32_t)get_varint(h, pos, &len));
+    }
+    r->len = len;
+}
+
+/**
+ * @brief Drop the oldest record, keeping its state as the new base
+ */
+static void drop_oldest(io_history_t *h) {
+    record_t r;
+    decode_record(h, h->tail, h->base_value, &r);
+    h->base_time_us += r.dt_us;
+    h->base_value = r.value;
+    h->tail = ring_wrap(h->tail + r.len);
+    h->used -= r.len;
+    h->count--;
+    h->dropped++;
+}
+
+void io_history_init(io_history_t *h, io_history_kind_t kind) {
+    memset(h, 0, sizeof(*h));
+    h->kind = (uint8_t)kind;
+}
+
+bool io_history_append(io_history_t *h, uint64_t time_us, int32_t value, uint8_t quality) {
+    if (h->count == 0 && h->dropped == 0) {
+        // First sample: the base is the sample itself, the record holds no change
+        h->base_time_us = time_us;
+        h->base_value = value;
+        h->last_time_us = time_us;
+        h->last_value = value;
+    } else if (value == h->last_value && quality == h->last_quality) {
+        return false;
+    }
+    if (time_us < h->last_time_us) {
+        time_us = h->last_time_us;
+    }
+
+    uint8_t rec[IO_HISTORY_MAX_RECORD];
+    uint32_t len = 1;
+    unsigned enc = VALUE_SAME;
+    len += put_varint(&rec[len], time_us - h->last_time_us);
+
+    if (h->kind == IO_HISTORY_DISCRETE) {
+        uint16_t mask = (uint16_t)(value ^ h->last_value);
+        if (mask != 0 && (mask & (mask - 1)) == 0) {
+            enc = VALUE_BIT;
+            rec[len++] = (uint8_t)__builtin_ctz(mask);
+        } else if (mask != 0) {
+            enc = VALUE_XOR;
+            rec[len++] = (uint8_t)mask;
+            rec[len++] = (uint8_t)(mask >> 8);
+        }
+    } else if (value != h->last_value) {
+        enc = VALUE_DELTA;
+        len += put_varint(&rec[len], zigzag(value - h->last_value));
+    }
+    rec[0] = (uint8_t)((quality & HDR_QUALITY_MASK) | (enc << HDR_VALUE_SHIFT));
+
+    while (IO_HISTORY_BYTES - h->used < len) {
+        drop_oldest(h);
+    }
+
+    uint32_t head = ring_wrap(h->tail + h->used);
+    uint32_t first = IO_HISTORY_BYTES - head;
+    if (first >= len) {
+        memcpy(&h->buf[head], rec, len);
+    } else {
+        memcpy(&h->buf[head], rec, first);
+        memcpy(h->buf, &rec[first], len - first);
+    }
+    h->used += len;
+    h->count++;
+    h->last_time_us = time_us;
+    h->last_value = value;
+    h->last_quality = quality;
+    return true;
+}
+
+void io_history_iter_init(io_history_iter_t *it, const io_history_t *h) {
+    it->h = h;
+    it->pos = h->tail;
+    it->left = h->count;
+    it->time_us = h->base_time_us;
+    it->value = h->base_value;
+}
+
+bool io_history_next(io_history_iter_t *it, io_history_sample_t *sample) {
+    if (it->left == 0) {
+        return false;
+    }
+
+    record_t r;
+    decode_record(it->h, it->pos, it->value, &r);
+    it->pos = ring_wrap(it->pos + r.len);
+    it->left--;
+    it->time_us += r.dt_us;
+    it->value = r.value;
+
+    sample->time_us = it->time_us;
+    sample->value = r.value;
+    sample->quality = r.quality;
+    sample->seq = it->h->dropped + (it->h->count - it->left - 1);
+    return true;
+}
@@ -0,0 +1,165 @@
+/* io_history.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef IO_HISTORY_H
+#define IO_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Ring buffer size per tag in bytes */
+#ifdef CONFIG_A16_HISTORY_BYTES
+#define IO_HISTORY_BYTES        CONFIG_A16_HISTORY_BYTES
+#else
+#define IO_HISTORY_BYTES        4096
+#endif
+
+/** @brief ADC values are stored in fixed point with this many fractional bits (1/16 code) */
+#define IO_HISTORY_ADC_FRAC_BITS  4
+
+/** @brief Longest encoded record: header, 64-bit varint time delta, 32-bit varint value */
+#define IO_HISTORY_MAX_RECORD   (1 + 10 + 5)
+
+/**
+ * @brief Kind of values stored in a history
+ */
+typedef enum {
+    IO_HISTORY_DISCRETE = 0,    /**< 16-bit discrete word */
+    IO_HISTORY_ADC,             /**< ADC code in fixed point (IO_HISTORY_ADC_FRAC_BITS) */
+} io_history_kind_t;
+
+/**
+ * @brief One decoded sample
+ */
+typedef struct {
+    uint64_t time_us;           /**< Source timestamp (timebase_now_us() clock) */
+    int32_t value;              /**< Discrete word or fixed-point ADC code */
+    uint8_t quality;            /**< io_quality_t */
+    uint32_t seq;               /**< Number of records appended before this one (wraps) */
+} io_history_sample_t;
+
+/**
+ * @brief Time series of one tag in a fixed-size byte ring
+ *
+ * Samples are stored as variable-length delta records, oldest first:
+ *
+ * - header byte: quality (bits 0-1) and value encoding (bits 2-3)
+ * - time since the previous sample, unsigned LEB128 varint (microseconds)
+ * - value change:
+ *   - discrete: nothing (unchanged), the index of the one toggled bit
+ *     (one byte, the usual case for a single input edge) or the 16-bit
+ *     XOR mask of all toggled bits
+ *   - ADC: nothing (unchanged) or the zigzag varint difference of the
+ *     fixed-point code
+ *
+ * A typical input edge 10 ms after the previous one takes 5 bytes and an
+ * ADC sample every 100 ms about 6, instead of 10-12 bytes for a raw
+ * timestamp and value. When the ring is full the oldest records are
+ * dropped; the state before the oldest record is kept in base_*, so the
+ * first remaining delta can still be decoded.
+ *
+ * Only samples that change the value or the quality are recorded (a
+ * discrete word or an ADC code that stays the same within 1/16 code adds
+ * nothing), so stable signals cover a long time span.
+ *
+ * Not thread-safe: the owner serialises appends and copies. Like
+ * io_hist.h this module only depends on C, so the same code runs in the
+ * firmware and in host tools.
+ */
+typedef struct {
+    uint8_t buf[IO_HISTORY_BYTES];  /**< Record storage */
+    uint32_t tail;                  /**< Offset of the oldest record */
+    uint32_t used;                  /**< Bytes in use */
+    uint32_t count;                 /**< Number of records */
+    uint32_t dropped;               /**< Records dropped because the ring was full (= seq of the oldest) */
+    uint64_t base_time_us;          /**< Time before the oldest record */
+    int32_t base_value;             /**< Value before the oldest record */
+    uint64_t last_time_us;          /**< Time of the newest record */
+    int32_t last_value;             /**< Value of the newest record */
+    uint8_t last_quality;           /**< Quality of the newest record */
+    uint8_t kind;                   /**< io_history_kind_t */
+} io_history_t;
+
+/**
+ * @brief Sequential decoder over a history, oldest sample first
+ */
+typedef struct {
+    const io_history_t *h;      /**< History being decoded */
+    uint32_t pos;               /**< Offset of the next record */
+    uint32_t left;              /**< Records not decoded yet */
+    uint64_t time_us;           /**< Time of the last decoded sample */
+    int32_t value;              /**< Value of the last decoded sample */
+} io_history_iter_t;
+
+/**
+ * @brief Initialize an empty history
+ *
+ * @param h Pointer to history
+ * @param kind IO_HISTORY_DISCRETE or IO_HISTORY_ADC
+ */
+void io_history_init(io_history_t *h, io_history_kind_t kind);
+
+/**
+ * @brief Append a sample
+ *
+ * Does nothing if value and quality equal the newest sample. A time
+ * before the newest sample is stored as the same time, so the series
+ * stays ordered.
+ *
+ * @param h Pointer to history
+ * @param time_us Source timestamp in microseconds
+ * @param value Discrete word or fixed-point ADC code (see io_history_adc_value())
+ * @param quality io_quality_t of the sample
+ * @return true if a record was added
+ */
+bool io_history_append(io_history_t *h, uint64_t time_us, int32_t value, uint8_t quality);
+
+/**
+ * @brief Fixed-point history value of an ADC code
+ *
+ * @param code ADC value as cached (float code)
+ * @return int32_t Code in 1/2^IO_HISTORY_ADC_FRAC_BITS units, rounded
+ */
+static inline int32_t io_history_adc_value(float code) {
+    float v = code * (float)(1 << IO_HISTORY_ADC_FRAC_BITS);
+    return (int32_t)(v >= 0.0f ? v + 0.5f : v - 0.5f);
+}
+
+/**
+ * @brief ADC code of a fixed-point history value
+ *
+ * @param value Value from io_history_sample_t
+ * @return float ADC code
+ */
+static inline float io_history_adc_code(int32_t value) {
+    return (float)value / (float)(1 << IO_HISTORY_ADC_FRAC_BITS);
+}
+
+/**
+ * @brief Start decoding at the oldest sample
+ *
+ * @param it Pointer to iterator
+ * @param h History to decode (must not change while the iterator is used)
+ */
+void io_history_iter_init(io_history_iter_t *it, const io_history_t *h);
+
+/**
+ * @brief Decode the next sample
+ *
+ * @param it Pointer to iterator
+ * @param sample Pointer to structure receiving the sample
+ * @return true if a sample was returned, false at the end
+ */
+bool io_history_next(io_history_iter_t *it, io_history_sample_t *sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_HISTORY_H */
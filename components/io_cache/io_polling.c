@@ -2,59 +2,795 @@
 
 #include "io_cache.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "model.h"
+#include "io_sched.h"
+#include "io_seqlock.h"
+#include "io_hist.h"
+#include "di_debounce.h"
 #include <stdint.h>
+#include <stdatomic.h>
 
 static const char *TAG = "io_polling";
 
-#define POLL_INPUTS_INTERVAL_MS     20    /**< Polling interval for discrete inputs in milliseconds */
-#define POLL_ADC_INTERVAL_MS        100   /**< Polling interval for ADC channels in milliseconds */
+#define POLL_INPUTS_INTEGRITY_MS    CONFIG_A16_DI_INTEGRITY_POLL_MS  /**< Full input read interval when interrupts are used */
+#define BUS_STATS_LOG_INTERVAL_MS   60000 /**< Interval for logging I2C transaction timing */
+
+/** Notification bit for a queued output command (bits 0..n are input banks) */
+#define IO_NOTIFY_OUTPUTS           (1u << 31)
+/** Notification bit for an on-demand input read (io_polling_refresh()) */
+#define IO_NOTIFY_REFRESH_INPUTS    (1u << 30)
+/** Notification bit for an on-demand ADC read (io_polling_refresh()) */
+#define IO_NOTIFY_REFRESH_ADC       (1u << 29)
+
+static TaskHandle_t io_polling_task_handle = NULL;  /**< Notified by the expander INT handler and output requests */
+static SemaphoreHandle_t refresh_done = NULL;       /**< Given after an on-demand read */
+
+/** On-demand read groups, indexed by the bit number of IO_REFRESH_INPUTS / IO_REFRESH_ADC */
+#define IO_REFRESH_GROUPS           2
+
+/**
+ * On-demand read generations per group. io_polling_refresh() increments
+ * refresh_requested before notifying; the polling task copies the value it
+ * saw before reading to refresh_completed after reading, so a caller can
+ * tell its own request from a completion left over from an earlier one.
+ */
+static atomic_uint refresh_requested[IO_REFRESH_GROUPS];
+static atomic_uint refresh_completed[IO_REFRESH_GROUPS];
+
+/** Notification bit sent by the deadline timer */
+#define IO_NOTIFY_DEADLINE          (1u << 28)
+
+#define POLL_ADC_PHASE_MS           5     /**< ADC release offset against the input poll */
+#define POLL_STATS_PHASE_MS         7     /**< Statistics release offset */
+
+static io_sched_t io_sched;                         /**< Acquisition groups, owned by the polling task */
+static int sched_inputs = -1;                       /**< Group ID of the input poll */
+static int sched_adc = -1;                          /**< Group ID of the ADC poll (-1 with the continuous backend) */
+static int sched_debounce = -1;                     /**< Group ID of the debounce resample (parked while settled) */
+static esp_timer_handle_t deadline_timer;           /**< Wakes the polling task at the next deadline */
+static uint16_t polled_inputs;                      /**< Last raw input word read by the polling task */
+static uint8_t inputs_failed_banks;                 /**< Input banks whose last read failed (bits kept from before) */
+static di_debounce_t debounce;                      /**< Input debouncer, owned by the polling task */
+
+/**
+ * Debounce settings requested by io_polling_set_debounce(), applied by the
+ * polling task before its next input read.
+ */
+static struct {
+    uint8_t mode;
+    uint8_t limit;
+} debounce_config[DI_DEBOUNCE_INPUTS];
+static uint16_t debounce_config_changed = 0;       /**< Inputs with new settings */
+static portMUX_TYPE debounce_config_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** Group statistics published for other tasks after every scheduler run */
+static io_sched_stats_t sched_stats_copy[IO_SCHED_MAX_GROUPS];
+static io_seqlock_t sched_stats_lock;
+static atomic_int sched_group_count = 0;
+
+/**
+ * Acquisition diagnostics. Histograms are written by the polling task only,
+ * inside a sequence lock so readers get consistent copies; a reset is only
+ * requested by other tasks and carried out by the polling task.
+ */
+static io_hist_t diag_hist[IO_DIAG_COUNT];
+static io_seqlock_t diag_lock;
+static atomic_bool diag_reset_requested = false;
+static atomic_uint diag_bus_errors_base = 0;    /**< Bus error count at the last reset */
+
+/**
+ * Poll periods in milliseconds. Set by the OPC UA task from the monitored
+ * sampling intervals (io_polling_set_intervals()), read by the polling task.
+ */
+static atomic_uint inputs_poll_ms = CONFIG_A16_POLL_INPUTS_MAX_MS;
+static atomic_uint adc_poll_ms = CONFIG_A16_POLL_ADC_MAX_MS;
+
+/**
+ * Pending output command: bit mask in the upper 16 bits, values in the
+ * lower 16 bits. Producers merge into it with CAS (last writer wins per
+ * bit); the polling task takes the whole command with one exchange, so
+ * any number of requests between two I/O slots costs one hardware write.
+ */
+static atomic_uint_least32_t pending_outputs = 0;
+
+/**
+ * Time of the first INT edge per input bank since its last read, in
+ * microseconds (0 = no edge pending). Written by the ISR, consumed by the
+ * polling task; guarded by irq_lock because 64-bit stores are not atomic.
+ */
+static uint64_t input_irq_time_us[DISCRETE_INPUT_BANKS];
+static portMUX_TYPE irq_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Input expander INT handler
+ * 
+ * Records the edge time as source timestamp and wakes the polling task
+ * with the changed banks as notification bits.
+ * 
+ * @param arg Bit mask of banks wired to this INT line
+ */
+static void IRAM_ATTR discrete_input_isr(void *arg) {
+    uint32_t banks = (uint32_t)(uintptr_t)arg;
+    // Same clock as timebase_now_us(), called directly because it is in IRAM
+    uint64_t now_us = (uint64_t)esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+    
+    portENTER_CRITICAL_ISR(&irq_lock);
+    for (int bank = 0; bank < DISCRETE_INPUT_BANKS; bank++) {
+        if ((banks & (1u << bank)) && input_irq_time_us[bank] == 0) {
+            input_irq_time_us[bank] = now_us;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&irq_lock);
+    
+    xTaskNotifyFromISR(io_polling_task_handle, banks, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief Take the pending INT timestamp of an input bank
+ * 
+ * @param bank Input bank
+ * @return uint64_t Edge time in microseconds (0 if none pending)
+ */
+static uint64_t take_input_irq_time_us(int bank) {
+    portENTER_CRITICAL(&irq_lock);
+    uint64_t t = input_irq_time_us[bank];
+    input_irq_time_us[bank] = 0;
+    portEXIT_CRITICAL(&irq_lock);
+    return t;
+}
+
+/**
+ * @brief Queue a discrete output change for the polling task
+ * 
+ * Merges the request into the pending command and wakes the polling task.
+ * Never blocks and never touches the I2C bus.
+ * 
+ * @param mask Outputs to change
+ * @param values New values for the outputs selected by mask
+ */
+void io_polling_request_outputs(uint16_t mask, uint16_t values) {
+    uint_least32_t old_cmd = atomic_load_explicit(&pending_outputs, memory_order_relaxed);
+    uint_least32_t new_cmd;
+    
+    do {
+        uint16_t old_mask = (uint16_t)(old_cmd >> 16);
+        uint16_t old_vals = (uint16_t)old_cmd;
+        uint16_t new_vals = (uint16_t)((old_vals & ~mask) | (values & mask));
+        new_cmd = ((uint_least32_t)(old_mask | mask) << 16) | new_vals;
+    } while (!atomic_compare_exchange_weak_explicit(&pending_outputs, &old_cmd, new_cmd,
+                                                    memory_order_release, memory_order_relaxed));
+    
+    if (io_polling_task_handle != NULL) {
+        xTaskNotify(io_polling_task_handle, IO_NOTIFY_OUTPUTS, eSetBits);
+    }
+}
+
+/**
+ * @brief Read I/O groups from hardware now, through the polling task
+ * 
+ * Wakes the polling task, which reads the requested groups in its next
+ * slot and updates the cache, and waits until it is done. The bus is only
+ * ever used by the polling task, so this never collides with a poll.
+ * Only one task (the OPC UA task) may call this at a time.
+ * 
+ * @param groups IO_REFRESH_INPUTS and/or IO_REFRESH_ADC
+ * @param timeout_ms Maximum time to wait
+ * @return true if the cache was refreshed
+ * @return false on timeout or if no requested group can be read on demand
+ */
+bool io_polling_refresh(uint32_t groups, uint32_t timeout_ms) {
+    uint32_t bits = 0;
+    
+    if (groups & IO_REFRESH_INPUTS) {
+        bits |= IO_NOTIFY_REFRESH_INPUTS;
+    }
+#ifndef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+    // The continuous backend publishes averages; there is nothing to read on demand
+    if (groups & IO_REFRESH_ADC) {
+        bits |= IO_NOTIFY_REFRESH_ADC;
+    }
+#endif
+    if (bits == 0 || io_polling_task_handle == NULL || refresh_done == NULL) {
+        return false;
+    }
+    
+    unsigned int wanted[IO_REFRESH_GROUPS] = {0};
+    for (int g = 0; g < IO_REFRESH_GROUPS; g++) {
+        if (bits & (IO_NOTIFY_REFRESH_INPUTS >> g)) {
+            wanted[g] = atomic_fetch_add_explicit(&refresh_requested[g], 1, memory_order_relaxed) + 1;
+        }
+    }
+    xTaskNotify(io_polling_task_handle, bits, eSetBits);
+    
+    // A completion of an earlier request that timed out may still arrive: wait for ours
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    while (1) {
+        bool done = true;
+        for (int g = 0; g < IO_REFRESH_GROUPS; g++) {
+            // Generations wrap, so compare their distance
+            if ((bits & (IO_NOTIFY_REFRESH_INPUTS >> g)) &&
+                (int)(atomic_load_explicit(&refresh_completed[g], memory_order_acquire) - wanted[g]) < 0) {
+                done = false;
+            }
+        }
+        if (done) {
+            return true;
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout || xSemaphoreTake(refresh_done, timeout - elapsed) != pdTRUE) {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Set the input and ADC poll periods
+ * 
+ * Takes effect at the next poll of each group. Without expander interrupts
+ * the inputs are polled at @p inputs_ms; with interrupts the input poll
+ * stays at the integrity interval.
+ * 
+ * @param inputs_ms Discrete input poll period in milliseconds
+ * @param adc_ms ADC poll period in milliseconds (oneshot backend)
+ */
+void io_polling_set_intervals(uint32_t inputs_ms, uint32_t adc_ms) {
+    uint32_t old_inputs = atomic_exchange_explicit(&inputs_poll_ms, inputs_ms, memory_order_relaxed);
+    uint32_t old_adc = atomic_exchange_explicit(&adc_poll_ms, adc_ms, memory_order_relaxed);
+    
+    if (old_inputs != inputs_ms || old_adc != adc_ms) {
+        ESP_LOGI(TAG, "Poll periods: inputs %lu ms, ADC %lu ms",
+                 (unsigned long)inputs_ms, (unsigned long)adc_ms);
+    }
+}
+
+/**
+ * @brief Set the debounce mode of one discrete input
+ * 
+ * @param input Input index (0-15)
+ * @param mode Debounce mode
+ * @param limit Samples (integrator) or milliseconds (time), 0-255
+ * @return true on success, false if the input index is invalid
+ */
+bool io_polling_set_debounce(uint8_t input, di_debounce_mode_t mode, uint32_t limit) {
+    if (input >= DI_DEBOUNCE_INPUTS) {
+        return false;
+    }
+    if (limit > DI_DEBOUNCE_MAX_LIMIT) {
+        limit = DI_DEBOUNCE_MAX_LIMIT;
+    }
+    
+    portENTER_CRITICAL(&debounce_config_lock);
+    debounce_config[input].mode = (uint8_t)mode;
+    debounce_config[input].limit = (uint8_t)limit;
+    debounce_config_changed |= 1u << input;
+    portEXIT_CRITICAL(&debounce_config_lock);
+    
+    ESP_LOGI(TAG, "DI%d debounce: %s (%lu)", input + 1, di_debounce_mode_name(mode), (unsigned long)limit);
+    return true;
+}
+
+/**
+ * @brief Apply settings from io_polling_set_debounce() (polling task only)
+ */
+static void apply_debounce_config(void) {
+    if (debounce_config_changed == 0) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&debounce_config_lock);
+    for (int i = 0; i < DI_DEBOUNCE_INPUTS; i++) {
+        if (debounce_config_changed & (1u << i)) {
+            di_debounce_configure(&debounce, 1u << i, (di_debounce_mode_t)debounce_config[i].mode,
+                                  debounce_config[i].limit);
+        }
+    }
+    debounce_config_changed = 0;
+    portEXIT_CRITICAL(&debounce_config_lock);
+}
+
+/**
+ * @brief Bits of the input word belonging to a set of banks
+ */
+static inline uint16_t bank_bits(uint32_t banks) {
+    uint16_t bits = 0;
+    for (int bank = 0; bank < DISCRETE_INPUT_BANKS; bank++) {
+        if (banks & (1u << bank)) bits |= (uint16_t)(0xFFu << (8 * bank));
+    }
+    return bits;
+}
+
+/**
+ * @brief Merge a hardware read of some banks into polled_inputs
+ * 
+ * Banks that failed keep their last good bits instead of the 0 returned
+ * by the driver, so a bus error never shows up as input changes.
+ * 
+ * @param value Value read (bits of other banks are ignored)
+ * @param read_banks Banks that were read
+ * @param failed_banks Banks among them that failed
+ */
+static void merge_inputs(uint16_t value, uint32_t read_banks, uint32_t failed_banks) {
+    uint16_t take = bank_bits(read_banks & ~failed_banks);
+    polled_inputs = (polled_inputs & ~take) | (value & take);
+    inputs_failed_banks = (uint8_t)((inputs_failed_banks & ~read_banks) | failed_banks);
+}
+
+/**
+ * @brief Debounce the raw input word and store the result in the cache
+ * 
+ * The quality is Good only if the last read of every bank succeeded.
+ * 
+ * @param source_timestamp_us INT edge or read time (timebase_now_us())
+ */
+static void publish_inputs(uint64_t source_timestamp_us) {
+    uint64_t now_ms = timebase_now_ms();
+    uint16_t inputs = di_debounce_update(&debounce, polled_inputs, (uint32_t)now_ms);
+    io_cache_update_discrete_inputs(inputs, inputs_failed_banks == 0, source_timestamp_us);
+}
+
+/**
+ * @brief Sample time of a read: middle of the bus transaction
+ * 
+ * @param start_us timebase_now_us() taken just before the read
+ * @return uint64_t Source timestamp in microseconds
+ */
+static inline uint64_t read_midpoint_us(uint64_t start_us) {
+    return start_us + (timebase_now_us() - start_us) / 2;
+}
+
+/**
+ * @brief Execute the pending output command, if any
+ * 
+ * Applies the coalesced per-bit changes through the expander shadow
+ * registers (only changed expanders are written) and reports the
+ * resulting state to the cache.
+ */
+static void execute_pending_outputs(void) {
+    uint_least32_t cmd = atomic_exchange_explicit(&pending_outputs, 0, memory_order_acquire);
+    uint16_t mask = (uint16_t)(cmd >> 16);
+    if (mask == 0) {
+        return;
+    }
+    
+    uint16_t outputs = 0;
+    bool ok = write_discrete_outputs_masked_slow(mask, (uint16_t)cmd, &outputs);
+    io_cache_complete_outputs_write(outputs, ok, timebase_now_us());
+    ESP_LOGD(TAG, "Outputs applied: 0x%04X (mask 0x%04X, %s)", outputs, mask, ok ? "ok" : "failed");
+}
 
 /**
- * @brief Get current system time in milliseconds
+ * @brief Record one value in an acquisition histogram (polling task only)
  * 
- * @return uint64_t Current time in milliseconds since system start
+ * @param id Histogram
+ * @param value Value (CPU cycles or microseconds, see io_diag_id_t)
  */
-static uint64_t get_current_time_ms(void) {
-    return (uint64_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+static inline void diag_record(io_diag_id_t id, uint32_t value) {
+    io_seqlock_write_begin(&diag_lock);
+    io_hist_record(&diag_hist[id], value);
+    io_seqlock_write_end(&diag_lock);
+}
+
+/**
+ * @brief Clear all histograms (polling task only)
+ */
+static void diag_clear(void) {
+    io_seqlock_write_begin(&diag_lock);
+    for (int i = 0; i < IO_DIAG_COUNT; i++) {
+        io_hist_reset(&diag_hist[i]);
+    }
+    io_seqlock_write_end(&diag_lock);
+    atomic_store_explicit(&diag_bus_errors_base, discrete_io_get_bus_errors(), memory_order_relaxed);
+}
+
+/**
+ * @brief Copy an acquisition histogram
+ * 
+ * @param id Histogram
+ * @param out Pointer to histogram receiving the copy
+ */
+void io_polling_get_diag_histogram(io_diag_id_t id, io_hist_t *out) {
+    if (id < 0 || id >= IO_DIAG_COUNT || !out) {
+        return;
+    }
+    
+    unsigned seq;
+    do {
+        seq = io_seqlock_read_begin(&diag_lock);
+        *out = diag_hist[id];
+    } while (io_seqlock_read_retry(&diag_lock, seq));
+}
+
+/**
+ * @brief Get the number of failed I/O expander transactions since the last reset
+ * 
+ * @return uint32_t Failed I2C transactions
+ */
+uint32_t io_polling_get_bus_errors(void) {
+    return discrete_io_get_bus_errors() -
+           atomic_load_explicit(&diag_bus_errors_base, memory_order_relaxed);
+}
+
+/**
+ * @brief Request a reset of all acquisition diagnostics
+ * 
+ * Clears histograms, the bus error count and the group timing statistics
+ * at the next wake-up of the polling task.
+ */
+void io_polling_reset_diagnostics(void) {
+    atomic_store_explicit(&diag_reset_requested, true, memory_order_relaxed);
+    if (io_polling_task_handle != NULL) {
+        xTaskNotify(io_polling_task_handle, IO_NOTIFY_DEADLINE, eSetBits);
+    }
+}
+
+/**
+ * @brief Follow the poll periods with the cache staleness limits
+ * 
+ * A value not updated for CONFIG_A16_STALE_POLL_PERIODS of its poll
+ * periods is reported as last usable by readers.
+ * 
+ * @param irq_banks Input banks with interrupts (inputs then use the integrity poll)
+ */
+static void update_stale_limits(uint32_t irq_banks) {
+    static uint32_t inputs_limit_ms = 0;
+    static uint32_t adc_limit_ms = 0;
+    
+    uint32_t inputs_ms = irq_banks ? POLL_INPUTS_INTEGRITY_MS
+                                   : atomic_load_explicit(&inputs_poll_ms, memory_order_relaxed);
+#ifdef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+    uint32_t adc_ms = CONFIG_A16_ADC_PUBLISH_INTERVAL_MS;
+#else
+    uint32_t adc_ms = atomic_load_explicit(&adc_poll_ms, memory_order_relaxed);
+#endif
+    inputs_ms *= CONFIG_A16_STALE_POLL_PERIODS;
+    adc_ms *= CONFIG_A16_STALE_POLL_PERIODS;
+    
+    if (inputs_ms != inputs_limit_ms || adc_ms != adc_limit_ms) {
+        io_cache_set_stale_limits(inputs_ms, adc_ms);
+        inputs_limit_ms = inputs_ms;
+        adc_limit_ms = adc_ms;
+    }
+}
+
+/**
+ * @brief Deadline timer callback: wake the polling task
+ * 
+ * @param arg Not used
+ */
+static void deadline_timer_cb(void *arg) {
+    xTaskNotify(io_polling_task_handle, IO_NOTIFY_DEADLINE, eSetBits);
+}
+
+/**
+ * @brief Scheduler clock: the monotonic timebase
+ */
+static uint64_t sched_now_us(void) {
+    return timebase_now_us();
+}
+
+/**
+ * @brief Read all input expanders, debounce and update the cache
+ */
+static void acquire_inputs(void) {
+    uint8_t failed = 0;
+    uint64_t start_us = timebase_now_us();
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    uint16_t value = read_discrete_inputs_slow(&failed);
+    uint64_t sample_us = read_midpoint_us(start_us);
+    merge_inputs(value, (1u << DISCRETE_INPUT_BANKS) - 1, failed);
+    uint32_t c1 = esp_cpu_get_cycle_count();
+    publish_inputs(sample_us);
+    uint32_t c2 = esp_cpu_get_cycle_count();
+    
+    diag_record(IO_DIAG_INPUTS_READ, c1 - c0);
+    diag_record(IO_DIAG_CACHE_UPDATE, c2 - c1);
+}
+
+/**
+ * @brief Input group: full read of all input expanders
+ */
+static void poll_inputs_group(void *arg, uint64_t now_us) {
+    diag_record(IO_DIAG_LATENESS, io_sched.groups[sched_inputs].stats.last_lateness_us);
+    acquire_inputs();
+}
+
+/**
+ * @brief Debounce group: resample the inputs while a debounced input is unsettled
+ * 
+ * Lets the debounced state settle without waiting for the next input poll
+ * or edge. The task loop releases the group when an input becomes
+ * unsettled and parks it again once all inputs have settled.
+ */
+static void debounce_group(void *arg, uint64_t now_us) {
+    if (di_debounce_pending(&debounce)) {
+        acquire_inputs();
+    }
+}
+
+#ifndef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+/**
+ * @brief ADC group: one conversion per channel (the continuous backend publishes on its own)
+ */
+static void poll_adc_group(void *arg, uint64_t now_us) {
+    diag_record(IO_DIAG_LATENESS, io_sched.groups[sched_adc].stats.last_lateness_us);
+    
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    update_all_adc_channels_slow();
+    diag_record(IO_DIAG_ADC_READ, esp_cpu_get_cycle_count() - c0);
+}
+#endif
+
+/**
+ * @brief Statistics group: log I2C transaction timing and scheduler timing
+ */
+static void stats_group(void *arg, uint64_t now_us) {
+    discrete_io_log_bus_stats();
+    
+    for (int id = 0; id < io_sched.count; id++) {
+        const io_sched_group_t *g = &io_sched.groups[id];
+        const io_sched_stats_t *st = &g->stats;
+        if (st->periods == 0) continue;
+        ESP_LOGI(TAG, "Group %s: period %lu us (actual min/avg/max %lu/%llu/%lu), "
+                 "lateness avg/max %llu/%lu us, run max %lu us, overruns %lu",
+                 g->name, (unsigned long)st->period_us,
+                 (unsigned long)st->min_period_us, (unsigned long long)(st->sum_period_us / st->periods),
+                 (unsigned long)st->max_period_us,
+                 (unsigned long long)(st->sum_lateness_us / st->runs), (unsigned long)st->max_lateness_us,
+                 (unsigned long)st->max_duration_us, (unsigned long)st->overruns);
+    }
+}
+
+/**
+ * @brief Copy the scheduler statistics for other tasks
+ */
+static void publish_sched_stats(void) {
+    io_seqlock_write_begin(&sched_stats_lock);
+    for (int id = 0; id < io_sched.count; id++) {
+        sched_stats_copy[id] = io_sched.groups[id].stats;
+    }
+    io_seqlock_write_end(&sched_stats_lock);
+}
+
+/**
+ * @brief Get the timing statistics of an acquisition group
+ * 
+ * Lock-free; safe to call from any task.
+ * 
+ * @param id Group index (0 to io_polling_get_group_count()-1)
+ * @param name Optional pointer receiving the group name
+ * @param stats Pointer to structure receiving the statistics
+ * @return true if the group exists
+ */
+bool io_polling_get_group_stats(int id, const char **name, io_sched_stats_t *stats) {
+    if (id < 0 || id >= io_polling_get_group_count() || !stats) {
+        return false;
+    }
+    
+    unsigned seq;
+    do {
+        seq = io_seqlock_read_begin(&sched_stats_lock);
+        *stats = sched_stats_copy[id];
+    } while (io_seqlock_read_retry(&sched_stats_lock, seq));
+    
+    if (name) *name = io_sched.groups[id].name;
+    return true;
+}
+
+/**
+ * @brief Get the number of acquisition groups
+ * 
+ * @return int Number of groups (0 before the polling task has started)
+ */
+int io_polling_get_group_count(void) {
+    return atomic_load_explicit(&sched_group_count, memory_order_acquire);
+}
+
+/**
+ * @brief Handle input expander interrupts and on-demand input reads
+ * 
+ * @param notified Task notification bits of this wake-up
+ */
+static void handle_input_events(uint32_t notified) {
+    const uint32_t all_banks = (1u << DISCRETE_INPUT_BANKS) - 1;
+    uint32_t changed_banks = notified & all_banks;
+    if (notified & IO_NOTIFY_REFRESH_INPUTS) {
+        // On-demand read: all banks
+        changed_banks = all_banks;
+    }
+    if (!changed_banks) {
+        return;
+    }
+    
+    uint64_t start_us = timebase_now_us();
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    if (changed_banks == all_banks) {
+        // Every expander signalled: one chained transaction for all banks
+        uint8_t failed = 0;
+        uint16_t value = read_discrete_inputs_slow(&failed);
+        merge_inputs(value, all_banks, failed);
+    } else {
+        // Read only the expanders that signalled a change
+        for (int bank = 0; bank < DISCRETE_INPUT_BANKS; bank++) {
+            if (!(changed_banks & (1u << bank))) continue;
+            
+            bool ok = false;
+            uint8_t value = read_discrete_input_bank_slow(bank, &ok);
+            merge_inputs((uint16_t)value << (8 * bank), 1u << bank, ok ? 0 : 1u << bank);
+        }
+    }
+    
+    // Source timestamp is the earliest edge among the banks just read
+    uint64_t edge_us = 0;
+    for (int bank = 0; bank < DISCRETE_INPUT_BANKS; bank++) {
+        if (!(changed_banks & (1u << bank))) continue;
+        uint64_t t = take_input_irq_time_us(bank);
+        if (t != 0 && (edge_us == 0 || t < edge_us)) edge_us = t;
+    }
+    uint32_t c1 = esp_cpu_get_cycle_count();
+    publish_inputs(edge_us ? edge_us : read_midpoint_us(start_us));
+    
+    diag_record(IO_DIAG_INPUTS_READ, c1 - c0);
+    diag_record(IO_DIAG_CACHE_UPDATE, esp_cpu_get_cycle_count() - c1);
 }
 
 /**
  * @brief I/O polling task function
  * 
- * This background task periodically polls hardware I/O (discrete inputs and ADC channels)
+ * This background task polls hardware I/O (discrete inputs and ADC channels)
  * and updates the cache with current values. The task runs on Core 1 at high priority.
  * 
+ * Periodic acquisition groups are released by a deadline scheduler
+ * (io_sched): the task sleeps until the earliest group deadline, woken
+ * by a one-shot esp_timer, so groups start within the timer latency of
+ * their deadline instead of on a fixed 5 ms wake-up grid. Group phases
+ * are offset so the input and ADC polls do not fall into the same slot.
+ * 
+ * When input expander INT lines are configured, a change wakes the task
+ * immediately and only the expander that reported it is read, stamped with
+ * the ISR time. The periodic full input read then only serves as a slow
+ * integrity check for missed edges.
+ * 
+ * Input words pass through a per-input debouncer before they reach the
+ * cache. While any input is unsettled a debounce group resamples the
+ * inputs every CONFIG_A16_DI_DEBOUNCE_SAMPLE_MS, so bounces are filtered
+ * in milliseconds even when the input poll or the interrupts are slow.
+ * 
+ * Output writes queued by io_polling_request_outputs() also wake the task
+ * and are executed before any input acquisition of that slot.
+ * 
  * @param pvParameters Task parameters (not used)
  */
 static void io_polling_task(void *pvParameters) {
-    TickType_t xLastInputsTime = xTaskGetTickCount();
-    static TickType_t xLastAdcTime;  // Declared as static for persistence
+    uint32_t irq_banks = discrete_inputs_attach_interrupt(discrete_input_isr);
+    uint8_t failed = 0;
+    uint64_t start_us = timebase_now_us();
+    polled_inputs = read_discrete_inputs_slow(&failed);
+    uint64_t sample_us = read_midpoint_us(start_us);
+    inputs_failed_banks = failed;
+    di_debounce_init(&debounce, polled_inputs, DI_DEBOUNCE_NONE, 0, (uint32_t)timebase_now_ms());
+    di_debounce_configure(&debounce, CONFIG_A16_DI_DEBOUNCE_INTEGRATOR_MASK & ~CONFIG_A16_DI_DEBOUNCE_TIME_MASK,
+                          DI_DEBOUNCE_INTEGRATOR, CONFIG_A16_DI_DEBOUNCE_SAMPLES);
+    di_debounce_configure(&debounce, CONFIG_A16_DI_DEBOUNCE_TIME_MASK,
+                          DI_DEBOUNCE_TIME, CONFIG_A16_DI_DEBOUNCE_TIME_MS);
+    apply_debounce_config();
+    io_cache_update_discrete_inputs(polled_inputs, failed == 0, sample_us);
+    
+    // Confirm the safe state written by discrete_io_init(): gives the outputs their first quality
+    bool outputs_ok = write_discrete_outputs_slow(0);
+    io_cache_complete_outputs_write(0, outputs_ok, timebase_now_us());
     
-    // Initialize after declaration
-    xLastAdcTime = xTaskGetTickCount();
+    const esp_timer_create_args_t timer_args = {
+        .callback = deadline_timer_cb,
+        .name = "io_sched",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &deadline_timer));
+    
+    uint32_t inputs_interval_ms = irq_banks ? POLL_INPUTS_INTEGRITY_MS
+                                            : atomic_load_explicit(&inputs_poll_ms, memory_order_relaxed);
+    uint64_t now = sched_now_us();
+    io_sched_init(&io_sched);
+    sched_inputs = io_sched_add(&io_sched, "inputs", inputs_interval_ms * 1000, 0,
+                                poll_inputs_group, NULL, now);
+#ifndef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+    sched_adc = io_sched_add(&io_sched, "adc",
+                             atomic_load_explicit(&adc_poll_ms, memory_order_relaxed) * 1000,
+                             POLL_ADC_PHASE_MS * 1000, poll_adc_group, NULL, now);
+#endif
+    sched_debounce = io_sched_add(&io_sched, "debounce", CONFIG_A16_DI_DEBOUNCE_SAMPLE_MS * 1000, 0,
+                                  debounce_group, NULL, now);
+    io_sched_set_deadline(&io_sched, sched_debounce, UINT64_MAX);
+    io_sched_add(&io_sched, "stats", BUS_STATS_LOG_INTERVAL_MS * 1000, POLL_STATS_PHASE_MS * 1000,
+                 stats_group, NULL, now);
+    publish_sched_stats();
+    update_stale_limits(irq_banks);
+    atomic_store_explicit(&sched_group_count, io_sched.count, memory_order_release);
+    
+    if (irq_banks) {
+        ESP_LOGI(TAG, "IO polling task started (240 MHz), input INT banks: 0x%02lX, integrity poll: %d ms",
+                 (unsigned long)irq_banks, POLL_INPUTS_INTEGRITY_MS);
+    } else {
+        ESP_LOGI(TAG, "IO polling task started (240 MHz), input poll follows the monitored sampling intervals");
+    }
     
-    ESP_LOGI(TAG, "IO polling task started (240 MHz)");
+    bool debounce_active = false;
     
     while (1) {
-        TickType_t xNow = xTaskGetTickCount();
+        uint32_t notified = 0;
+        now = sched_now_us();
         
-        // Poll discrete inputs
-        if ((xNow - xLastInputsTime) * portTICK_PERIOD_MS >= POLL_INPUTS_INTERVAL_MS) {
-            uint16_t inputs = read_discrete_inputs_slow();
-            uint64_t timestamp = get_current_time_ms();
-            io_cache_update_discrete_inputs(inputs, timestamp);
-            xLastInputsTime = xNow;
+        // Release the debounce group while an input is unsettled, park it otherwise
+        bool unsettled = di_debounce_pending(&debounce) != 0;
+        if (unsettled != debounce_active) {
+            io_sched_set_deadline(&io_sched, sched_debounce,
+                                  unsettled ? now + CONFIG_A16_DI_DEBOUNCE_SAMPLE_MS * 1000 : UINT64_MAX);
+            debounce_active = unsettled;
         }
         
-        // Poll ADC channels
-        if ((xNow - xLastAdcTime) * portTICK_PERIOD_MS >= POLL_ADC_INTERVAL_MS) {
+        uint64_t deadline = io_sched_next_deadline(&io_sched);
+        
+        if (deadline > now) {
+            // Sleep until the next deadline or an event (INT, output request, refresh)
+            esp_timer_start_once(deadline_timer, deadline - now);
+            xTaskNotifyWait(0, UINT32_MAX, &notified, portMAX_DELAY);
+            esp_timer_stop(deadline_timer);
+        } else {
+            // Already due: only collect pending events
+            xTaskNotifyWait(0, UINT32_MAX, &notified, 0);
+        }
+        
+        if (atomic_exchange_explicit(&diag_reset_requested, false, memory_order_relaxed)) {
+            diag_clear();
+            io_sched_reset_stats(&io_sched);
+            publish_sched_stats();
+        }
+        
+        // Queued output commands first, so a write never waits for an input cycle
+        execute_pending_outputs();
+        
+        apply_debounce_config();
+        
+        // Requests up to here are served by the reads below
+        unsigned int refresh_gen[IO_REFRESH_GROUPS];
+        for (int g = 0; g < IO_REFRESH_GROUPS; g++) {
+            refresh_gen[g] = atomic_load_explicit(&refresh_requested[g], memory_order_relaxed);
+        }
+        
+        handle_input_events(notified);
+        
+#ifndef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+        if (notified & IO_NOTIFY_REFRESH_ADC) {
             update_all_adc_channels_slow();
-            xLastAdcTime = xNow;
+        }
+#endif
+        
+        if (notified & (IO_NOTIFY_REFRESH_INPUTS | IO_NOTIFY_REFRESH_ADC)) {
+            for (int g = 0; g < IO_REFRESH_GROUPS; g++) {
+                if (notified & (IO_NOTIFY_REFRESH_INPUTS >> g)) {
+                    atomic_store_explicit(&refresh_completed[g], refresh_gen[g], memory_order_release);
+                }
+            }
+            xSemaphoreGive(refresh_done);
         }
         
-        vTaskDelay(pdMS_TO_TICKS(5));
+        // Follow period changes from io_polling_set_intervals()
+        if (!irq_banks) {
+            io_sched_set_period(&io_sched, sched_inputs,
+                                atomic_load_explicit(&inputs_poll_ms, memory_order_relaxed) * 1000);
+        }
+        io_sched_set_period(&io_sched, sched_adc,
+                            atomic_load_explicit(&adc_poll_ms, memory_order_relaxed) * 1000);
+        update_stale_limits(irq_banks);
+        
+        if (io_sched_run_due(&io_sched, sched_now_us(), sched_now_us) > 0) {
+            publish_sched_stats();
+        }
     }
 }
 
@@ -65,7 +801,11 @@ static void io_polling_task(void *pvParameters) {
  * The task is pinned to Core 1 with priority 8 for reliable real-time operation.
  */
 void io_polling_task_start(void) {
+    refresh_done = xSemaphoreCreateBinary();
+    io_seqlock_init(&sched_stats_lock);
+    io_seqlock_init(&diag_lock);
+    diag_clear();
     xTaskCreatePinnedToCore(io_polling_task, "io_poll", 4096, NULL, 
-                           8, NULL, 1);
+                           8, &io_polling_task_handle, 1);
     ESP_LOGI(TAG, "IO polling task created");
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+/* io_sched.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "io_sched.h"
+#include <string.h>
+
+/**
+ * @brief Deadline of the group at a heap position
+ */
+static inline uint64_t heap_key(const io_sched_t *s, int pos) {
+    return s->groups[s->heap[pos]].deadline_us;
+}
+
+static inline void heap_swap(io_sched_t *s, int a, int b) {
+    uint8_t t = s->heap[a];
+    s->heap[a] = s->heap[b];
+    s->heap[b] = t;
+}
+
+static void heap_sift_up(io_sched_t *s, int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (heap_key(s, parent) <= heap_key(s, pos)) break;
+        heap_swap(s, parent, pos);
+        pos = parent;
+    }
+}
+
+static void heap_sift_down(io_sched_t *s, int pos) {
+    for (;;) {
+        int left = 2 * pos + 1;
+        int right = left + 1;
+        int smallest = pos;
+        if (left < s->count && heap_key(s, left) < heap_key(s, smallest)) smallest = left;
+        if (right < s->count && heap_key(s, right) < heap_key(s, smallest)) smallest = right;
+        if (smallest == pos) break;
+        heap_swap(s, pos, smallest);
+        pos = smallest;
+    }
+}
+
+/**
+ * @brief Restore the heap order after a deadline change of any group
+ */
+static void heap_rebuild(io_sched_t *s) {
+    for (int pos = s->count / 2 - 1; pos >= 0; pos--) {
+        heap_sift_down(s, pos);
+    }
+}
+
+void io_sched_init(io_sched_t *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+int io_sched_add(io_sched_t *s, const char *name, uint32_t period_us, uint32_t phase_us,
+                 io_sched_fn_t fn, void *arg, uint64_t now_us) {
+    if (s->count >= IO_SCHED_MAX_GROUPS || period_us == 0 || fn == NULL) {
+        return -1;
+    }
+
+    int id = s->count;
+    io_sched_group_t *g = &s->groups[id];
+    memset(g, 0, sizeof(*g));
+    g->name = name;
+    g->fn = fn;
+    g->arg = arg;
+    g->deadline_us = now_us + phase_us;
+    g->stats.period_us = period_us;
+    g->stats.min_period_us = UINT32_MAX;
+
+    s->heap[s->count++] = (uint8_t)id;
+    heap_sift_up(s, s->count - 1);
+    return id;
+}
+
+void io_sched_set_period(io_sched_t *s, int id, uint32_t period_us) {
+    if (id < 0 || id >= s->count || period_us == 0) {
+        return;
+    }
+
+    io_sched_group_t *g = &s->groups[id];
+    if (g->stats.period_us == period_us) {
+        return;
+    }
+
+    // Re-base the pending deadline on the last release
+    if (g->deadline_us >= g->stats.period_us) {
+        g->deadline_us = g->deadline_us - g->stats.period_us + period_us;
+    }
+    g->stats.period_us = period_us;
+    heap_rebuild(s);
+}
+
+void io_sched_set_deadline(io_sched_t *s, int id, uint64_t deadline_us) {
+    if (id < 0 || id >= s->count) {
+        return;
+    }
+
+    s->groups[id].deadline_us = deadline_us;
+    s->groups[id].last_start_us = 0;
+    heap_rebuild(s);
+}
+
+uint64_t io_sched_next_deadline(const io_sched_t *s) {
+    return s->count ? heap_key(s, 0) : UINT64_MAX;
+}
+
+/**
+ * @brief Run one group and move it to its next deadline
+ */
+static void run_group(io_sched_group_t *g, uint64_t start_us, uint64_t (*clock)(void)) {
+    io_sched_stats_t *st = &g->stats;
+    uint32_t lateness = (uint32_t)(start_us - g->deadline_us);
+
+    if (g->last_start_us != 0) {
+        uint32_t period = (uint32_t)(start_us - g->last_start_us);
+        st->last_period_us = period;
+        st->periods++;
+        st->sum_period_us += period;
+        if (period < st->min_period_us) st->min_period_us = period;
+        if (period > st->max_period_us) st->max_period_us = period;
+    }
+    st->last_lateness_us = lateness;
+    if (lateness > st->max_lateness_us) st->max_lateness_us = lateness;
+    st->sum_lateness_us += lateness;
+    st->runs++;
+    g->last_start_us = start_us;
+
+    g->fn(g->arg, start_us);
+
+    if (clock) {
+        uint32_t duration = (uint32_t)(clock() - start_us);
+        if (duration > st->max_duration_us) st->max_duration_us = duration;
+    }
+
+    // Next release on the phase grid; releases already in the past are skipped
+    uint64_t next = g->deadline_us + st->period_us;
+    if (next <= start_us) {
+        uint64_t missed = (start_us - g->deadline_us) / st->period_us;
+        st->overruns += (uint32_t)missed;
+        next = g->deadline_us + (missed + 1) * st->period_us;
+    }
+    g->deadline_us = next;
+}
+
+int io_sched_run_due(io_sched_t *s, uint64_t now_us, uint64_t (*clock)(void)) {
+    int ran = 0;
+
+    while (s->count && heap_key(s, 0) <= now_us) {
+        io_sched_group_t *g = &s->groups[s->heap[0]];
+        uint64_t start_us = clock ? clock() : now_us;
+
+        run_group(g, start_us, clock);
+        heap_sift_down(s, 0);
+        ran++;
+    }
+    return ran;
+}
+
+bool io_sched_get_stats(const io_sched_t *s, int id, io_sched_stats_t *stats) {
+    if (id < 0 || id >= s->count || !stats) {
+        return false;
+    }
+    *stats = s->groups[id].stats;
+    return true;
+}
+
+void io_sched_reset_stats(io_sched_t *s) {
+    for (int i = 0; i < s->count; i++) {
+        io_sched_stats_t *st = &s->groups[i].stats;
+        uint32_t period = st->period_us;
+        memset(st, 0, sizeof(*st));
+        st->period_us = period;
+        st->min_period_us = UINT32_MAX;
+        s->groups[i].last_start_us = 0;
+    }
+}
@@ -0,0 +1,170 @@
+/* io_sched.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef IO_SCHED_H
+#define IO_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Maximum number of acquisition groups per scheduler */
+#define IO_SCHED_MAX_GROUPS  8
+
+/**
+ * @brief Group callback
+ *
+ * @param arg User argument given to io_sched_add()
+ * @param now_us Start time of the run in microseconds
+ */
+typedef void (*io_sched_fn_t)(void *arg, uint64_t now_us);
+
+/**
+ * @brief Timing statistics of one group
+ *
+ * Lateness is the start time minus the deadline (release jitter); the
+ * period is measured between the starts of two consecutive runs.
+ */
+typedef struct {
+    uint32_t runs;              /**< Number of runs */
+    uint32_t periods;           /**< Number of measured periods */
+    uint32_t overruns;          /**< Deadlines skipped because a run started too late */
+    uint32_t period_us;         /**< Configured period */
+    uint32_t last_period_us;    /**< Last actual period */
+    uint32_t min_period_us;     /**< Shortest actual period */
+    uint32_t max_period_us;     /**< Longest actual period */
+    uint64_t sum_period_us;     /**< Sum of actual periods (periods values) */
+    uint32_t last_lateness_us;  /**< Lateness of the current or last run */
+    uint32_t max_lateness_us;   /**< Largest lateness */
+    uint64_t sum_lateness_us;   /**< Sum of lateness (runs values) */
+    uint32_t max_duration_us;   /**< Longest run time of the callback */
+} io_sched_stats_t;
+
+/**
+ * @brief One periodic acquisition group
+ */
+typedef struct {
+    const char *name;           /**< Name for logs */
+    io_sched_fn_t fn;           /**< Callback */
+    void *arg;                  /**< Callback argument */
+    uint64_t deadline_us;       /**< Next release time */
+    uint64_t last_start_us;     /**< Start of the last run (0 = never ran) */
+    io_sched_stats_t stats;     /**< Timing statistics */
+} io_sched_group_t;
+
+/**
+ * @brief Deadline scheduler for periodic acquisition groups
+ *
+ * Groups are kept in a binary min-heap ordered by their next deadline, so
+ * the caller only sleeps until io_sched_next_deadline() and then calls
+ * io_sched_run_due(). Deadlines advance on a fixed grid (deadline +
+ * period), so the phase offset given to io_sched_add() is kept and late
+ * starts do not accumulate drift. A run that starts after its following
+ * deadline skips the missed periods and counts them as overruns.
+ *
+ * The scheduler has no OS dependency: time is passed in by the caller in
+ * microseconds. It is not thread-safe; one task owns it.
+ */
+typedef struct {
+    io_sched_group_t groups[IO_SCHED_MAX_GROUPS];
+    uint8_t heap[IO_SCHED_MAX_GROUPS];  /**< Group indices, heap[0] = earliest deadline */
+    uint8_t count;                      /**< Number of groups */
+} io_sched_t;
+
+/**
+ * @brief Initialize an empty scheduler
+ *
+ * @param s Pointer to scheduler
+ */
+void io_sched_init(io_sched_t *s);
+
+/**
+ * @brief Add a periodic group
+ *
+ * The first run is released at now_us + phase_us.
+ *
+ * @param s Pointer to scheduler
+ * @param name Name for logs (not copied)
+ * @param period_us Period in microseconds (> 0)
+ * @param phase_us Offset of the first release, used to keep groups apart
+ * @param fn Callback
+ * @param arg Callback argument
+ * @param now_us Current time in microseconds
+ * @return int Group ID, or -1 if the scheduler is full or arguments are invalid
+ */
+int io_sched_add(io_sched_t *s, const char *name, uint32_t period_us, uint32_t phase_us,
+                 io_sched_fn_t fn, void *arg, uint64_t now_us);
+
+/**
+ * @brief Change the period of a group
+ *
+ * The next deadline becomes the last release plus the new period, so a
+ * shorter period takes effect immediately and a longer one does not cut
+ * the current period short.
+ *
+ * @param s Pointer to scheduler
+ * @param id Group ID
+ * @param period_us New period in microseconds (> 0)
+ */
+void io_sched_set_period(io_sched_t *s, int id, uint32_t period_us);
+
+/**
+ * @brief Move the next release of a group
+ *
+ * Used for groups that only run on demand: park the group with
+ * UINT64_MAX and release it with the current time when there is work.
+ * The deadline grid restarts from the new deadline, and the period
+ * measurement restarts with the next run.
+ *
+ * @param s Pointer to scheduler
+ * @param id Group ID
+ * @param deadline_us Next release in microseconds (UINT64_MAX = never)
+ */
+void io_sched_set_deadline(io_sched_t *s, int id, uint64_t deadline_us);
+
+/**
+ * @brief Get the earliest deadline of all groups
+ *
+ * @param s Pointer to scheduler
+ * @return uint64_t Deadline in microseconds (UINT64_MAX if there are no groups)
+ */
+uint64_t io_sched_next_deadline(const io_sched_t *s);
+
+/**
+ * @brief Run every group whose deadline has passed
+ *
+ * Groups run in deadline order. Each group runs at most once per call.
+ *
+ * @param s Pointer to scheduler
+ * @param now_us Current time in microseconds
+ * @param clock Function returning the current time in microseconds, used
+ *        to measure run times and lateness of later groups (may be NULL,
+ *        then now_us is used for all of them)
+ * @return int Number of groups run
+ */
+int io_sched_run_due(io_sched_t *s, uint64_t now_us, uint64_t (*clock)(void));
+
+/**
+ * @brief Copy the statistics of a group
+ *
+ * @param s Pointer to scheduler
+ * @param id Group ID
+ * @param stats Pointer to structure receiving the copy
+ * @return true if the group exists
+ */
+bool io_sched_get_stats(const io_sched_t *s, int id, io_sched_stats_t *stats);
+
+/**
+ * @brief Clear the statistics of all groups (periods are kept)
+ *
+ * @param s Pointer to scheduler
+ */
+void io_sched_reset_stats(io_sched_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_SCHED_H */
@@ -0,0 +1,93 @@
+/* io_seqlock.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef IO_SEQLOCK_H
+#define IO_SEQLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sequence lock for single-writer / multi-reader data
+ *
+ * The sequence counter is odd while an update is in progress and even
+ * when the protected data is stable. Readers never take a lock: they
+ * copy the data and retry if the counter changed or was odd while
+ * copying. Writers must be serialised by the caller (one writer at a
+ * time), e.g. with a spinlock held only around the update.
+ *
+ * This header depends on C11 atomics only, so the same code is used by
+ * the firmware and by the host-side benchmark in TEST_OPC_X86/.
+ */
+typedef struct {
+    atomic_uint seq;          /**< Sequence counter (odd = write in progress) */
+} io_seqlock_t;
+
+/**
+ * @brief Initialize a sequence lock
+ *
+ * @param sl Pointer to sequence lock
+ */
+static inline void io_seqlock_init(io_seqlock_t *sl) {
+    atomic_init(&sl->seq, 0);
+}
+
+/**
+ * @brief Begin an update of the protected data
+ *
+ * Makes the counter odd so concurrent readers discard their copy.
+ *
+ * @param sl Pointer to sequence lock
+ */
+static inline void io_seqlock_write_begin(io_seqlock_t *sl) {
+    unsigned s = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief Finish an update of the protected data
+ *
+ * Makes the counter even again and publishes the new data.
+ *
+ * @param sl Pointer to sequence lock
+ */
+static inline void io_seqlock_write_end(io_seqlock_t *sl) {
+    unsigned s = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, s + 1, memory_order_release);
+}
+
+/**
+ * @brief Start a read section
+ *
+ * @param sl Pointer to sequence lock
+ * @return unsigned Counter value to pass to io_seqlock_read_retry()
+ *         (odd if a write is in progress; the read will then be retried)
+ */
+static inline unsigned io_seqlock_read_begin(const io_seqlock_t *sl) {
+    return atomic_load_explicit((atomic_uint *)&sl->seq, memory_order_acquire);
+}
+
+/**
+ * @brief Check whether a read section must be retried
+ *
+ * @param sl Pointer to sequence lock
+ * @param start Value returned by io_seqlock_read_begin()
+ * @return true if the copied data may be torn and must be read again
+ * @return false if the copy is consistent
+ */
+static inline bool io_seqlock_read_retry(const io_seqlock_t *sl, unsigned start) {
+    atomic_thread_fence(memory_order_acquire);
+    return (start & 1u) ||
+           atomic_load_explicit((atomic_uint *)&sl->seq, memory_order_relaxed) != start;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_SEQLOCK_H */
@@ -0,0 +1,332 @@
+/* io_expander.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef IO_EXPANDER_H
+#define IO_EXPANDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Maximum number of devices in one io_expander_*_multi() call */
+#define IO_EXPANDER_MULTI_MAX_DEVICES   8
+
+/** @brief Maximum number of segments in one bus transaction */
+#define IO_EXPANDER_MAX_SEGMENTS        (IO_EXPANDER_MULTI_MAX_DEVICES * 2)
+
+/** @brief Port value of all pins high (power-on latch of quasi-bidirectional ports) */
+#define IO_EXPANDER_ALL_HIGH            0xFFFF
+
+/* ============================================================================
+ * BUS INTERFACE
+ * ============================================================================ */
+
+/**
+ * @brief One addressed part of a bus transaction
+ *
+ * Consecutive segments are joined by repeated STARTs, the transaction
+ * ends with one STOP.
+ */
+typedef struct {
+    uint8_t address;            /**< 7-bit device address */
+    bool read;                  /**< true = read data, false = write data */
+    uint8_t len;                /**< Number of data bytes */
+    uint8_t *data;              /**< Data to write or buffer to read into */
+} io_expander_segment_t;
+
+/**
+ * @brief Interrupt handler type for an expander INT line
+ *
+ * Runs in ISR context on the target and must be placed in IRAM (IRAM_ATTR).
+ *
+ * @param arg User argument passed to io_expander_irq_attach()
+ */
+typedef void (*io_expander_irq_handler_t)(void *arg);
+
+typedef struct io_expander_bus io_expander_bus_t;
+
+/**
+ * @brief Operations of a bus backend
+ */
+typedef struct {
+    /** Prepare the bus for a device address (NULL = nothing to do) */
+    bool (*add_device)(io_expander_bus_t *bus, uint8_t address);
+    /** Run the segments as one transaction; ESP_OK if every byte was acknowledged */
+    esp_err_t (*transfer)(io_expander_bus_t *bus, const io_expander_segment_t *segments, size_t count);
+    /** Clock of the bus, used for the transaction statistics */
+    int64_t (*now_us)(io_expander_bus_t *bus);
+    /** Install a falling-edge handler on an INT line (NULL = no interrupts) */
+    bool (*irq_attach)(io_expander_bus_t *bus, int gpio_num, io_expander_irq_handler_t handler, void *arg);
+} io_expander_bus_ops_t;
+
+/**
+ * @brief Transaction timing statistics of a bus
+ *
+ * Accumulated since start or the last io_expander_bus_reset_stats() call.
+ * Times are taken from the bus clock: driver overhead included on the
+ * target, simulated time on the simulated bus.
+ */
+typedef struct {
+    uint32_t transactions;      /**< Number of completed transactions */
+    uint32_t errors;            /**< Number of failed transactions */
+    uint64_t total_us;          /**< Sum of transaction times in microseconds */
+    uint32_t min_us;            /**< Shortest transaction time in microseconds */
+    uint32_t max_us;            /**< Longest transaction time in microseconds */
+} io_expander_bus_stats_t;
+
+/**
+ * @brief A bus with expanders on it
+ *
+ * Created by a backend: io_expander_i2c_bus_init() for the ESP-IDF I2C
+ * driver or io_expander_sim_init() for the simulated bus.
+ */
+struct io_expander_bus {
+    const io_expander_bus_ops_t *ops;   /**< Backend operations */
+    void *ctx;                          /**< Backend state */
+    io_expander_bus_stats_t stats;      /**< Timing statistics */
+    uint32_t error_count;               /**< Failed transactions since start (not reset) */
+    portMUX_TYPE lock;                  /**< Guards stats and error_count */
+};
+
+/* ============================================================================
+ * DEVICE INTERFACE
+ * ============================================================================ */
+
+typedef struct io_expander io_expander_t;
+
+/**
+ * @brief Operations of an expander driver
+ *
+ * Port values are pin levels, bit 0 = first pin, 16 bits for every chip
+ * (pins a chip does not have read as 1 and are ignored when written).
+ * The single-device and chained operations do not retry or fall back;
+ * the generic io_expander_* functions do.
+ */
+typedef struct {
+    const char *name;           /**< Chip name for logs */
+    uint8_t pins;               /**< Number of I/O pins (8 or 16) */
+    /** Bring the chip into the state described by the descriptor (NULL = nothing to do) */
+    bool (*init)(io_expander_t *dev);
+    /** Read the pin levels */
+    bool (*read)(io_expander_t *dev, uint16_t *value);
+    /** Write the output latch */
+    bool (*write)(io_expander_t *dev, uint16_t value);
+    /** Read several devices of this type in one bus transaction (NULL = not supported) */
+    bool (*read_multi)(io_expander_t *const devs[], size_t count, uint16_t values[]);
+    /** Write several devices of this type in one bus transaction (NULL = not supported) */
+    bool (*write_multi)(io_expander_t *const devs[], size_t count, const uint16_t values[]);
+    /** Enable the INT output and attach a handler to its GPIO */
+    bool (*irq_attach)(io_expander_t *dev, int gpio_num, io_expander_irq_handler_t handler, void *arg);
+} io_expander_ops_t;
+
+/** @brief PCF8574/PCF8574A: 8 quasi-bidirectional pins, one byte per access */
+extern const io_expander_ops_t io_expander_pcf8574_ops;
+/** @brief PCF8575: 16 quasi-bidirectional pins, two bytes per access */
+extern const io_expander_ops_t io_expander_pcf8575_ops;
+/** @brief MCP23017: 16 pins with direction, pull-up and interrupt-on-change registers */
+extern const io_expander_ops_t io_expander_mcp23017_ops;
+
+/**
+ * @brief Expander device descriptor
+ *
+ * Outputs go through a shadow register: the value last requested for the
+ * port. A port is written only when the shadow differs from what the
+ * device is known to hold, so masked updates cost no bus read and at most
+ * one write.
+ */
+struct io_expander {
+    const io_expander_ops_t *ops;   /**< Driver */
+    io_expander_bus_t *bus;         /**< Bus the device is on */
+    uint8_t address;                /**< 7-bit device address */
+    uint16_t input_mask;            /**< Pins used as inputs (kept high, interrupt on change) */
+    uint16_t shadow;                /**< Shadow output register */
+    uint16_t written;               /**< Last value written to the device */
+    bool written_valid;             /**< true if the device is known to hold 'written' */
+};
+
+/* ============================================================================
+ * PUBLIC FUNCTION PROTOTYPES
+ * ============================================================================ */
+
+/**
+ * @brief Initialize a device descriptor and configure the chip
+ *
+ * The shadow starts with all pins high. Chips with direction registers
+ * are configured with input_mask as inputs (pull-ups and interrupt on
+ * change enabled) and the other pins as outputs.
+ *
+ * @param dev Descriptor to initialize
+ * @param ops Driver of the chip
+ * @param bus Bus the chip is on
+ * @param address 7-bit device address
+ * @param input_mask Pins used as inputs
+ * @return true if the chip acknowledged its configuration (always true for
+ *         chips without configuration)
+ */
+bool io_expander_init(io_expander_t *dev, const io_expander_ops_t *ops, io_expander_bus_t *bus,
+                      uint8_t address, uint16_t input_mask);
+
+/**
+ * @brief Read the pin levels of a device
+ *
+ * @param dev Initialized descriptor
+ * @param value Receives the pin levels (left untouched on failure)
+ * @return true if the read succeeded
+ */
+bool io_expander_read(io_expander_t *dev, uint16_t *value);
+
+/**
+ * @brief Write the output port of a device
+ *
+ * Replaces the shadow register and always writes. Input pins are kept high.
+ *
+ * @param dev Initialized descriptor
+ * @param value New port value
+ * @return true if the device holds the value
+ */
+bool io_expander_write(io_expander_t *dev, uint16_t value);
+
+/**
+ * @brief Update masked output pins through the shadow register
+ *
+ * Pins selected by mask take the bits of value, all other pins keep their
+ * shadow state. The port is written only if the result differs from what
+ * the device holds (or the previous write failed). Safe to call from
+ * several tasks: the device converges on the latest shadow value.
+ *
+ * @param dev Initialized descriptor
+ * @param mask Pins to change
+ * @param value New values for the pins selected by mask
+ * @return true if the device holds the updated shadow value
+ */
+bool io_expander_update_mask(io_expander_t *dev, uint16_t mask, uint16_t value);
+
+/**
+ * @brief Get the shadow output register
+ *
+ * @param dev Initialized descriptor
+ * @return uint16_t Last value requested for the port (no bus access)
+ */
+uint16_t io_expander_get_shadow(const io_expander_t *dev);
+
+/**
+ * @brief Read several devices, in one transaction when possible
+ *
+ * Devices with the same driver and bus are chained into one transaction
+ * (repeated STARTs), so the driver is entered once and the ports are
+ * sampled with minimal skew. If the chained transaction fails, or the
+ * driver cannot chain, each device is read on its own to get per-device
+ * status.
+ *
+ * @param devs Array of descriptors
+ * @param count Number of devices (1 to IO_EXPANDER_MULTI_MAX_DEVICES)
+ * @param values Receives one port value per device (0xFFFF on failure)
+ * @param ok Optional array receiving per-device success (may be NULL)
+ * @return true if every device was read
+ */
+bool io_expander_read_multi(io_expander_t *const devs[], size_t count, uint16_t values[], bool ok[]);
+
+/**
+ * @brief Write several devices, in one transaction when possible
+ *
+ * The values replace the shadow registers and are always written, so all
+ * ports change state almost simultaneously.
+ *
+ * @param devs Array of descriptors
+ * @param count Number of devices (1 to IO_EXPANDER_MULTI_MAX_DEVICES)
+ * @param values One port value per device
+ * @param ok Optional array receiving per-device success (may be NULL)
+ * @return true if every device holds its value
+ */
+bool io_expander_write_multi(io_expander_t *const devs[], size_t count, const uint16_t values[], bool ok[]);
+
+/**
+ * @brief Update masked output pins of several devices
+ *
+ * Applies io_expander_update_mask() to each device, then writes only the
+ * devices whose port value changed, chained into one transaction.
+ *
+ * @param devs Array of descriptors
+ * @param count Number of devices (1 to IO_EXPANDER_MULTI_MAX_DEVICES)
+ * @param mask Pins to change, one mask per device
+ * @param value New values for the masked pins, one per device
+ * @param ok Optional array receiving per-device success (may be NULL)
+ * @return true if every device holds its updated shadow value
+ */
+bool io_expander_update_mask_multi(io_expander_t *const devs[], size_t count,
+                                   const uint16_t mask[], const uint16_t value[], bool ok[]);
+
+/**
+ * @brief Attach an interrupt handler to the INT line of a device
+ *
+ * The handler runs on the falling edge of INT, which the chip asserts when
+ * an input pin changes and releases when the port is read. Several devices
+ * may share one line; all of them must then be read to release it.
+ *
+ * @param dev Initialized descriptor
+ * @param gpio_num GPIO wired to INT
+ * @param handler ISR handler
+ * @param arg User argument passed to the handler
+ * @return true if the handler was attached
+ */
+bool io_expander_irq_attach(io_expander_t *dev, int gpio_num, io_expander_irq_handler_t handler, void *arg);
+
+/* ============================================================================
+ * BUS FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize the generic part of a bus (called by backends)
+ *
+ * @param bus Bus to initialize
+ * @param ops Backend operations
+ * @param ctx Backend state
+ */
+void io_expander_bus_init(io_expander_bus_t *bus, const io_expander_bus_ops_t *ops, void *ctx);
+
+/**
+ * @brief Run one transaction and account it in the statistics (used by drivers)
+ *
+ * @param bus Bus
+ * @param segments Segments joined by repeated STARTs
+ * @param count Number of segments (1 to IO_EXPANDER_MAX_SEGMENTS)
+ * @return esp_err_t ESP_OK if every byte was acknowledged
+ */
+esp_err_t io_expander_bus_transfer(io_expander_bus_t *bus, const io_expander_segment_t *segments, size_t count);
+
+/**
+ * @brief Get the transaction timing statistics of a bus
+ *
+ * @param bus Bus
+ * @param stats Receives a copy of the statistics
+ */
+void io_expander_bus_get_stats(io_expander_bus_t *bus, io_expander_bus_stats_t *stats);
+
+/**
+ * @brief Reset the transaction timing statistics of a bus
+ *
+ * @param bus Bus
+ */
+void io_expander_bus_reset_stats(io_expander_bus_t *bus);
+
+/**
+ * @brief Get the number of failed transactions since start
+ *
+ * Unlike io_expander_bus_stats_t::errors this counter is not cleared by
+ * io_expander_bus_reset_stats(); use differences for rates.
+ *
+ * @param bus Bus
+ * @return uint32_t Failed transactions (wraps at 2^32)
+ */
+uint32_t io_expander_bus_get_error_count(io_expander_bus_t *bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_EXPANDER_H */
@@ -0,0 +1,54 @@
+/* io_expander_i2c.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef IO_EXPANDER_I2C_H
+#define IO_EXPANDER_I2C_H
+
+#include "io_expander.h"
+#include "hal/i2c_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Number of I2C buses that can be opened (one per controller) */
+#define IO_EXPANDER_I2C_MAX_BUSES       2
+
+/** @brief Number of device addresses per bus */
+#define IO_EXPANDER_I2C_MAX_DEVICES     8
+
+/**
+ * @brief I2C bus configuration
+ */
+typedef struct {
+    i2c_port_t port;            /**< I2C controller */
+    int sda_pin;                /**< SDA GPIO */
+    int scl_pin;                /**< SCL GPIO */
+    uint32_t clk_speed;         /**< SCL frequency in Hz */
+} io_expander_i2c_config_t;
+
+/**
+ * @brief Open an I2C controller as expander bus
+ *
+ * Uses the i2c_master driver (one device handle per address, chained
+ * transactions through an addressless handle) or, with
+ * CONFIG_IO_EXPANDER_USE_LEGACY_I2C, the legacy command link driver.
+ * Interrupts are attached through the shared GPIO ISR service.
+ *
+ * @param bus Bus to initialize
+ * @param config I2C pins and clock
+ * @return true if the controller was configured
+ */
+bool io_expander_i2c_bus_init(io_expander_bus_t *bus, const io_expander_i2c_config_t *config);
+
+/**
+ * @brief Name of the I2C driver in use, for logs
+ *
+ * @return const char* "legacy" or "i2c_master"
+ */
+const char *io_expander_i2c_driver_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_EXPANDER_I2C_H */
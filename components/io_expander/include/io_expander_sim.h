@@ -0,0 +1,179 @@
+/* io_expander_sim.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef IO_EXPANDER_SIM_H
+#define IO_EXPANDER_SIM_H
+
+#include "io_expander.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Number of chips on one simulated bus */
+#define IO_EXPANDER_SIM_MAX_CHIPS       8
+
+/** @brief Number of INT lines with a handler on one simulated bus */
+#define IO_EXPANDER_SIM_MAX_IRQS        8
+
+/** @brief MCP23017 register file size (IOCON.BANK = 0 layout) */
+#define IO_EXPANDER_SIM_MCP_REGS        0x16
+
+/**
+ * @brief Chip models
+ */
+typedef enum {
+    IO_EXPANDER_SIM_PCF8574 = 0,    /**< 8 quasi-bidirectional pins */
+    IO_EXPANDER_SIM_PCF8575,        /**< 16 quasi-bidirectional pins */
+    IO_EXPANDER_SIM_MCP23017,       /**< 16 pins, register file */
+} io_expander_sim_chip_t;
+
+/**
+ * @brief Timing and fault model of the simulated bus
+ *
+ * A transaction takes overhead_us plus a uniform random 0..jitter_us plus
+ * the bits on the wire at scl_hz (START, 9 bits per address or data byte,
+ * STOP). A failed transaction ends at the byte that was not acknowledged.
+ * All randomness comes from one PRNG seeded with seed, and time is a
+ * virtual clock advanced only by transactions and io_expander_sim_advance(),
+ * so a run is exactly reproducible.
+ */
+typedef struct {
+    uint32_t scl_hz;            /**< SCL frequency (0 = 400 kHz) */
+    uint32_t overhead_us;       /**< Fixed driver overhead per transaction */
+    uint32_t jitter_us;         /**< Maximum random extra time per transaction */
+    uint32_t fault_rate_ppm;    /**< Probability of a NACK per transaction, parts per million */
+    uint32_t fault_every;       /**< Fail every Nth transaction in addition (0 = off) */
+    uint32_t seed;              /**< PRNG seed */
+    bool worst_case;            /**< Every transaction takes the maximum jitter and fails at its last byte */
+} io_expander_sim_config_t;
+
+/**
+ * @brief Bus activity counters
+ */
+typedef struct {
+    uint32_t transactions;      /**< Transactions started */
+    uint32_t bytes;             /**< Address and data bytes clocked */
+    uint32_t faults;            /**< Transactions failed by fault injection */
+    uint32_t nacks;             /**< Addresses no chip answered */
+    uint32_t interrupts;        /**< Falling INT edges delivered to handlers */
+} io_expander_sim_stats_t;
+
+/**
+ * @brief One simulated chip
+ */
+typedef struct {
+    io_expander_sim_chip_t chip;    /**< Model */
+    uint8_t address;                /**< 7-bit address */
+    int int_gpio;                   /**< INT line (-1 = not connected) */
+    uint16_t ext_low;               /**< Pins pulled low from outside */
+    uint16_t latch;                 /**< PCF857x output latch */
+    uint16_t last_read;             /**< PCF857x pin levels at the last read (INT reference) */
+    uint8_t regs[IO_EXPANDER_SIM_MCP_REGS];  /**< MCP23017 registers */
+    uint8_t ptr;                    /**< MCP23017 register pointer */
+    bool int_active;                /**< INT output asserted */
+} io_expander_sim_dev_t;
+
+/**
+ * @brief Simulated bus with expander chips
+ *
+ * Implements the bus interface of io_expander.h in memory, so acquisition
+ * code can run off-target against the same drivers, with configurable
+ * timing and injected faults. Interrupt handlers are called synchronously
+ * by the operation that asserts an INT line. Intended for host benchmarks
+ * and tests.
+ */
+typedef struct {
+    io_expander_bus_t bus;                          /**< Bus handed to io_expander_init() */
+    io_expander_sim_config_t config;                /**< Timing and fault model */
+    uint64_t clock_ns;                              /**< Virtual time */
+    uint64_t rng;                                   /**< PRNG state */
+    uint32_t sequence;                              /**< Transactions for fault_every */
+    io_expander_sim_dev_t chips[IO_EXPANDER_SIM_MAX_CHIPS];
+    size_t chip_count;
+    struct {
+        int gpio;
+        io_expander_irq_handler_t handler;
+        void *arg;
+    } irqs[IO_EXPANDER_SIM_MAX_IRQS];               /**< Attached INT handlers */
+    size_t irq_count;
+    io_expander_sim_stats_t stats;                  /**< Activity counters */
+    portMUX_TYPE lock;                              /**< Guards everything above */
+} io_expander_sim_t;
+
+/**
+ * @brief Initialize an empty simulated bus
+ *
+ * @param sim Simulator to initialize
+ * @param config Timing and fault model (NULL = ideal 400 kHz bus)
+ */
+void io_expander_sim_init(io_expander_sim_t *sim, const io_expander_sim_config_t *config);
+
+/**
+ * @brief Bus interface of a simulator
+ *
+ * @param sim Simulator
+ * @return io_expander_bus_t* Bus for io_expander_init()
+ */
+io_expander_bus_t *io_expander_sim_bus(io_expander_sim_t *sim);
+
+/**
+ * @brief Put a chip on the bus in its power-on state
+ *
+ * @param sim Simulator
+ * @param chip Model
+ * @param address 7-bit address
+ * @param int_gpio INT line, shared by chips with the same number (-1 = none)
+ * @return true if added (false if the address is taken or the bus is full)
+ */
+bool io_expander_sim_add(io_expander_sim_t *sim, io_expander_sim_chip_t chip, uint8_t address, int int_gpio);
+
+/**
+ * @brief Drive pins of a chip low from outside (active inputs on the board)
+ *
+ * Asserts INT if input levels change as the chip would, and calls the
+ * handler of the line on a falling edge.
+ *
+ * @param sim Simulator
+ * @param address Chip address
+ * @param low_pins Pins pulled low, all others released
+ */
+void io_expander_sim_set_inputs(io_expander_sim_t *sim, uint8_t address, uint16_t low_pins);
+
+/**
+ * @brief Get the pin levels of a chip, outputs included
+ *
+ * @param sim Simulator
+ * @param address Chip address
+ * @return uint16_t Pin levels (0xFFFF if no chip has the address)
+ */
+uint16_t io_expander_sim_get_pins(io_expander_sim_t *sim, uint8_t address);
+
+/**
+ * @brief Advance the virtual clock (time spent outside bus transactions)
+ *
+ * @param sim Simulator
+ * @param us Microseconds to add
+ */
+void io_expander_sim_advance(io_expander_sim_t *sim, uint32_t us);
+
+/**
+ * @brief Get the virtual time
+ *
+ * @param sim Simulator
+ * @return uint64_t Microseconds since io_expander_sim_init()
+ */
+uint64_t io_expander_sim_now_us(io_expander_sim_t *sim);
+
+/**
+ * @brief Get the bus activity counters
+ *
+ * @param sim Simulator
+ * @param stats Receives a copy of the counters
+ */
+void io_expander_sim_get_stats(io_expander_sim_t *sim, io_expander_sim_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_EXPANDER_SIM_H */
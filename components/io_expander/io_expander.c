@@ -0,0 +1,389 @@
+/* io_expander.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "io_expander.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "io_expander";
+
+/** Guards the shadow/written fields of all device descriptors */
+static portMUX_TYPE shadow_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** Rewrites allowed when other tasks keep changing a shadow during a write */
+#define SHADOW_SYNC_MAX_WRITES  4
+
+/* ============================================================================
+ * BUS
+ * ============================================================================ */
+
+void io_expander_bus_init(io_expander_bus_t *bus, const io_expander_bus_ops_t *ops, void *ctx) {
+    bus->ops = ops;
+    bus->ctx = ctx;
+    bus->stats = (io_expander_bus_stats_t){ .min_us = UINT32_MAX };
+    bus->error_count = 0;
+    bus->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+}
+
+esp_err_t io_expander_bus_transfer(io_expander_bus_t *bus, const io_expander_segment_t *segments, size_t count) {
+    if (bus == NULL || bus->ops == NULL || segments == NULL || count == 0 || count > IO_EXPANDER_MAX_SEGMENTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t start_us = bus->ops->now_us(bus);
+    esp_err_t ret = bus->ops->transfer(bus, segments, count);
+    uint32_t dt = (uint32_t)(bus->ops->now_us(bus) - start_us);
+
+    portENTER_CRITICAL(&bus->lock);
+    bus->stats.transactions++;
+    if (ret != ESP_OK) {
+        bus->stats.errors++;
+        bus->error_count++;
+    }
+    bus->stats.total_us += dt;
+    if (dt < bus->stats.min_us) bus->stats.min_us = dt;
+    if (dt > bus->stats.max_us) bus->stats.max_us = dt;
+    portEXIT_CRITICAL(&bus->lock);
+
+    return ret;
+}
+
+void io_expander_bus_get_stats(io_expander_bus_t *bus, io_expander_bus_stats_t *stats) {
+    if (bus == NULL || stats == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&bus->lock);
+    *stats = bus->stats;
+    portEXIT_CRITICAL(&bus->lock);
+
+    if (stats->transactions == 0) {
+        stats->min_us = 0;
+    }
+}
+
+void io_expander_bus_reset_stats(io_expander_bus_t *bus) {
+    if (bus == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&bus->lock);
+    bus->stats = (io_expander_bus_stats_t){ .min_us = UINT32_MAX };
+    portEXIT_CRITICAL(&bus->lock);
+}
+
+uint32_t io_expander_bus_get_error_count(io_expander_bus_t *bus) {
+    if (bus == NULL) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&bus->lock);
+    uint32_t n = bus->error_count;
+    portEXIT_CRITICAL(&bus->lock);
+    return n;
+}
+
+/* ============================================================================
+ * SHADOW REGISTER
+ * ============================================================================ */
+
+/**
+ * @brief Apply set/clear masks to the shadow register.
+ *
+ * @param dev Pointer to the device descriptor.
+ * @param set_mask Pins to set.
+ * @param clear_mask Pins to clear (applied before set_mask).
+ * @param force Write even if the device already holds the new value.
+ * @return int32_t New port value to write, or -1 if no bus write is needed.
+ */
+static int32_t shadow_apply(io_expander_t *dev, uint16_t set_mask, uint16_t clear_mask, bool force) {
+    portENTER_CRITICAL(&shadow_lock);
+    // Input pins stay high: on quasi-bidirectional ports a low latch would short the input
+    uint16_t value = (uint16_t)(((dev->shadow & ~clear_mask) | set_mask) | dev->input_mask);
+    dev->shadow = value;
+    bool needed = force || !dev->written_valid || dev->written != value;
+    portEXIT_CRITICAL(&shadow_lock);
+
+    return needed ? (int32_t)value : -1;
+}
+
+/**
+ * @brief Record the result of writing a shadow value to the device.
+ *
+ * @param dev Pointer to the device descriptor.
+ * @param value Value that was written.
+ * @param ok Result of the write.
+ * @return int32_t Newer shadow value to write if another task changed the
+ *         shadow while the write was in flight, otherwise -1.
+ */
+static int32_t shadow_commit(io_expander_t *dev, uint16_t value, bool ok) {
+    portENTER_CRITICAL(&shadow_lock);
+    dev->written = value;
+    dev->written_valid = ok;  // A failed write is repeated by the next update
+    int32_t next = (ok && dev->shadow != value) ? (int32_t)dev->shadow : -1;
+    portEXIT_CRITICAL(&shadow_lock);
+
+    return next;
+}
+
+/**
+ * @brief Write the output port of one device, logging failures.
+ *
+ * @param dev Pointer to the device descriptor.
+ * @param value Port value.
+ * @return true if the device acknowledged the write.
+ */
+static bool write_device(io_expander_t *dev, uint16_t value) {
+    if (!dev->ops->write(dev, value)) {
+        ESP_LOGE(TAG, "Write failed to %s at 0x%02X", dev->ops->name, dev->address);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Write a shadow value and follow concurrent shadow changes.
+ *
+ * Whoever writes last re-checks the shadow, so the device converges on the
+ * latest shadow value even if writes from several tasks complete out of order.
+ *
+ * @param dev Pointer to the device descriptor.
+ * @param value Value returned by shadow_apply() (-1 = nothing to write).
+ * @return true if the device holds the shadow value.
+ */
+static bool shadow_sync(io_expander_t *dev, int32_t value) {
+    for (int i = 0; value >= 0 && i < SHADOW_SYNC_MAX_WRITES; i++) {
+        bool ok = write_device(dev, (uint16_t)value);
+        value = shadow_commit(dev, (uint16_t)value, ok);
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ============================================================================
+ * SINGLE DEVICE
+ * ============================================================================ */
+
+bool io_expander_init(io_expander_t *dev, const io_expander_ops_t *ops, io_expander_bus_t *bus,
+                      uint8_t address, uint16_t input_mask) {
+    if (dev == NULL || ops == NULL || bus == NULL || bus->ops == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+
+    dev->ops = ops;
+    dev->bus = bus;
+    dev->address = address;
+    dev->input_mask = input_mask;
+    dev->shadow = IO_EXPANDER_ALL_HIGH;     // Power-on state of quasi-bidirectional latches
+    dev->written = IO_EXPANDER_ALL_HIGH;
+    dev->written_valid = false;             // First update always goes to the bus
+
+    if (bus->ops->add_device && !bus->ops->add_device(bus, address)) {
+        ESP_LOGE(TAG, "Cannot add %s at 0x%02X to the bus", ops->name, address);
+        return false;
+    }
+
+    if (ops->init && !ops->init(dev)) {
+        ESP_LOGE(TAG, "%s at 0x%02X did not accept its configuration", ops->name, address);
+        return false;
+    }
+
+    ESP_LOGI(TAG, "%s initialized at address 0x%02X, inputs 0x%04X", ops->name, address, input_mask);
+    return true;
+}
+
+bool io_expander_read(io_expander_t *dev, uint16_t *value) {
+    if (dev == NULL || dev->ops == NULL || value == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+
+    if (!dev->ops->read(dev, value)) {
+        ESP_LOGE(TAG, "Read failed from %s at 0x%02X", dev->ops->name, dev->address);
+        return false;
+    }
+    return true;
+}
+
+bool io_expander_write(io_expander_t *dev, uint16_t value) {
+    if (dev == NULL || dev->ops == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+
+    return shadow_sync(dev, shadow_apply(dev, value, IO_EXPANDER_ALL_HIGH, true));
+}
+
+bool io_expander_update_mask(io_expander_t *dev, uint16_t mask, uint16_t value) {
+    if (dev == NULL || dev->ops == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+
+    return shadow_sync(dev, shadow_apply(dev, value & mask, mask, false));
+}
+
+uint16_t io_expander_get_shadow(const io_expander_t *dev) {
+    if (dev == NULL) {
+        return IO_EXPANDER_ALL_HIGH;
+    }
+
+    portENTER_CRITICAL(&shadow_lock);
+    uint16_t value = dev->shadow;
+    portEXIT_CRITICAL(&shadow_lock);
+    return value;
+}
+
+bool io_expander_irq_attach(io_expander_t *dev, int gpio_num, io_expander_irq_handler_t handler, void *arg) {
+    if (dev == NULL || dev->ops == NULL || gpio_num < 0 || handler == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+    if (dev->ops->irq_attach == NULL) {
+        ESP_LOGE(TAG, "%s has no interrupt output", dev->ops->name);
+        return false;
+    }
+
+    return dev->ops->irq_attach(dev, gpio_num, handler, arg);
+}
+
+/* ============================================================================
+ * SEVERAL DEVICES
+ * ============================================================================ */
+
+/**
+ * @brief Validate the arguments of a multi-device call.
+ *
+ * @param devs Array of device descriptors.
+ * @param count Number of devices.
+ * @return true if all descriptors are initialized.
+ */
+static bool multi_args_valid(io_expander_t *const devs[], size_t count) {
+    if (devs == NULL || count == 0 || count > IO_EXPANDER_MULTI_MAX_DEVICES) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (devs[i] == NULL || devs[i]->ops == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check whether devices can be chained into one transaction.
+ *
+ * @param devs Array of device descriptors.
+ * @param count Number of devices.
+ * @return true if all devices share driver and bus.
+ */
+static bool same_driver_and_bus(io_expander_t *const devs[], size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (devs[i]->ops != devs[0]->ops || devs[i]->bus != devs[0]->bus) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool io_expander_read_multi(io_expander_t *const devs[], size_t count, uint16_t values[], bool ok[]) {
+    if (!multi_args_valid(devs, count) || values == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+
+    if (count > 1 && devs[0]->ops->read_multi && same_driver_and_bus(devs, count) &&
+        devs[0]->ops->read_multi(devs, count, values)) {
+        if (ok) {
+            for (size_t i = 0; i < count; i++) ok[i] = true;
+        }
+        return true;
+    }
+
+    // Single device, mixed devices or chain failed: per-device status
+    bool all_ok = true;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t value = IO_EXPANDER_ALL_HIGH;
+        bool dev_ok = io_expander_read(devs[i], &value);
+        values[i] = dev_ok ? value : IO_EXPANDER_ALL_HIGH;
+        if (ok) ok[i] = dev_ok;
+        all_ok = all_ok && dev_ok;
+    }
+    return all_ok;
+}
+
+/**
+ * @brief Write pending shadow values of several devices in one transaction.
+ *
+ * Devices whose value is -1 are skipped. A single pending device is written
+ * on its own; several are chained if their driver allows it.
+ *
+ * @param devs Array of device descriptors.
+ * @param count Number of devices.
+ * @param values Values from shadow_apply(), one per device.
+ * @param ok Optional per-device success array.
+ * @return true if every device holds its shadow value.
+ */
+static bool shadow_sync_multi(io_expander_t *const devs[], size_t count, const int32_t values[], bool ok[]) {
+    io_expander_t *sel[IO_EXPANDER_MULTI_MAX_DEVICES];
+    uint16_t buf[IO_EXPANDER_MULTI_MAX_DEVICES];
+    size_t idx[IO_EXPANDER_MULTI_MAX_DEVICES];
+    size_t n = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (ok) ok[i] = true;
+        if (values[i] >= 0) {
+            sel[n] = devs[i];
+            buf[n] = (uint16_t)values[i];
+            idx[n++] = i;
+        }
+    }
+
+    bool chained = false;
+    if (n > 1 && sel[0]->ops->write_multi && same_driver_and_bus(sel, n)) {
+        chained = sel[0]->ops->write_multi(sel, n, buf);
+    }
+
+    bool all_ok = true;
+    for (size_t k = 0; k < n; k++) {
+        bool dev_ok;
+        if (chained) {
+            // Chained write done; only follow up if the shadow moved on meanwhile
+            dev_ok = shadow_sync(sel[k], shadow_commit(sel[k], buf[k], true));
+        } else {
+            dev_ok = shadow_sync(sel[k], buf[k]);
+        }
+        if (ok) ok[idx[k]] = dev_ok;
+        all_ok = all_ok && dev_ok;
+    }
+    return all_ok;
+}
+
+bool io_expander_write_multi(io_expander_t *const devs[], size_t count, const uint16_t values[], bool ok[]) {
+    if (!multi_args_valid(devs, count) || values == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+
+    int32_t pending[IO_EXPANDER_MULTI_MAX_DEVICES];
+    for (size_t i = 0; i < count; i++) {
+        pending[i] = shadow_apply(devs[i], values[i], IO_EXPANDER_ALL_HIGH, true);
+    }
+    return shadow_sync_multi(devs, count, pending, ok);
+}
+
+bool io_expander_update_mask_multi(io_expander_t *const devs[], size_t count,
+                                   const uint16_t mask[], const uint16_t value[], bool ok[]) {
+    if (!multi_args_valid(devs, count) || mask == NULL || value == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+
+    int32_t pending[IO_EXPANDER_MULTI_MAX_DEVICES];
+    for (size_t i = 0; i < count; i++) {
+        pending[i] = shadow_apply(devs[i], value[i] & mask[i], mask[i], false);
+    }
+    return shadow_sync_multi(devs, count, pending, ok);
+}
@@ -0,0 +1,363 @@
+/* io_expander_i2c.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "io_expander_i2c.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#ifdef CONFIG_IO_EXPANDER_USE_LEGACY_I2C
+#include "driver/i2c.h"
+#else
+#include "driver/i2c_master.h"
+#endif
+#include <string.h>
+
+static const char *TAG = "io_expander_i2c";
+
+/** Jobs of a chained transaction: START, address, data (split ACK/NACK when reading) per segment, STOP */
+#define MAX_JOBS    (IO_EXPANDER_MAX_SEGMENTS * 4 + 1)
+
+/**
+ * @brief State of one I2C controller
+ */
+typedef struct {
+    bool used;                  /**< Controller opened */
+    i2c_port_t port;            /**< I2C controller */
+#ifndef CONFIG_IO_EXPANDER_USE_LEGACY_I2C
+    i2c_master_bus_handle_t bus_handle;     /**< Bus handle */
+    uint32_t clk_speed;                     /**< SCL frequency used for devices added to the bus */
+    i2c_master_dev_handle_t raw_handle;     /**< Addressless handle for chained transactions */
+    struct {
+        uint8_t address;
+        i2c_master_dev_handle_t handle;
+    } devices[IO_EXPANDER_I2C_MAX_DEVICES]; /**< Handles for single-segment transactions */
+    size_t device_count;
+    SemaphoreHandle_t jobs_lock;            /**< Guards jobs */
+    i2c_operation_job_t jobs[MAX_JOBS];     /**< Job list of the chained transaction in progress */
+#endif
+} i2c_bus_ctx_t;
+
+static i2c_bus_ctx_t contexts[IO_EXPANDER_I2C_MAX_BUSES];
+
+static int64_t i2c_now_us(io_expander_bus_t *bus) {
+    (void)bus;
+    return esp_timer_get_time();
+}
+
+#ifndef CONFIG_IO_EXPANDER_USE_LEGACY_I2C
+
+/**
+ * @brief Find the device handle of an address.
+ *
+ * @param ctx Controller state.
+ * @param address 7-bit device address.
+ * @return i2c_master_dev_handle_t Handle or NULL if the address was not added.
+ */
+static i2c_master_dev_handle_t find_device(const i2c_bus_ctx_t *ctx, uint8_t address) {
+    for (size_t i = 0; i < ctx->device_count; i++) {
+        if (ctx->devices[i].address == address) {
+            return ctx->devices[i].handle;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Register a device on the bus once, so transactions reuse the handle without allocating.
+ */
+static bool i2c_add_device(io_expander_bus_t *bus, uint8_t address) {
+    i2c_bus_ctx_t *ctx = bus->ctx;
+
+    if (find_device(ctx, address) != NULL) {
+        return true;
+    }
+    if (ctx->device_count >= IO_EXPANDER_I2C_MAX_DEVICES) {
+        ESP_LOGE(TAG, "Too many devices on I2C port %d", ctx->port);
+        return false;
+    }
+
+    i2c_device_config_t dev_conf = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = address,
+        .scl_speed_hz = ctx->clk_speed,
+    };
+    i2c_master_dev_handle_t handle;
+    esp_err_t err = i2c_master_bus_add_device(ctx->bus_handle, &dev_conf, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "i2c_master_bus_add_device failed for 0x%02X: %s", address, esp_err_to_name(err));
+        return false;
+    }
+    ctx->devices[ctx->device_count].address = address;
+    ctx->devices[ctx->device_count].handle = handle;
+    ctx->device_count++;
+    return true;
+}
+
+/**
+ * @brief Run a chained transaction through the addressless handle.
+ *
+ * Builds START, address, data for each segment (repeated START between
+ * segments) and one final STOP, and submits the whole sequence at once.
+ */
+static esp_err_t i2c_transfer_chained(i2c_bus_ctx_t *ctx, const io_expander_segment_t *segments, size_t count) {
+    uint8_t addr[IO_EXPANDER_MAX_SEGMENTS];
+
+    if (ctx->raw_handle == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    xSemaphoreTake(ctx->jobs_lock, portMAX_DELAY);
+    i2c_operation_job_t *jobs = ctx->jobs;
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        const io_expander_segment_t *seg = &segments[i];
+        addr[i] = (uint8_t)((seg->address << 1) | (seg->read ? 1 : 0));
+        jobs[n++] = (i2c_operation_job_t){ .command = I2C_MASTER_CMD_START };
+        jobs[n++] = (i2c_operation_job_t){
+            .command = I2C_MASTER_CMD_WRITE,
+            .write = { .ack_check = true, .data = &addr[i], .total_bytes = 1 },
+        };
+        if (seg->read) {
+            // ACK every byte but the last, which is NACKed to end the read
+            if (seg->len > 1) {
+                jobs[n++] = (i2c_operation_job_t){
+                    .command = I2C_MASTER_CMD_READ,
+                    .read = { .ack_value = I2C_ACK_VAL, .data = seg->data, .total_bytes = seg->len - 1u },
+                };
+            }
+            jobs[n++] = (i2c_operation_job_t){
+                .command = I2C_MASTER_CMD_READ,
+                .read = { .ack_value = I2C_NACK_VAL, .data = &seg->data[seg->len - 1], .total_bytes = 1 },
+            };
+        } else {
+            jobs[n++] = (i2c_operation_job_t){
+                .command = I2C_MASTER_CMD_WRITE,
+                .write = { .ack_check = true, .data = seg->data, .total_bytes = seg->len },
+            };
+        }
+    }
+    jobs[n++] = (i2c_operation_job_t){ .command = I2C_MASTER_CMD_STOP };
+
+    esp_err_t ret = i2c_master_execute_defined_operations(ctx->raw_handle, jobs, n,
+                                                          CONFIG_IO_EXPANDER_I2C_TIMEOUT_MS);
+    xSemaphoreGive(ctx->jobs_lock);
+    return ret;
+}
+
+static esp_err_t i2c_transfer(io_expander_bus_t *bus, const io_expander_segment_t *segments, size_t count) {
+    i2c_bus_ctx_t *ctx = bus->ctx;
+    esp_err_t ret;
+
+    for (size_t i = 0; i < count; i++) {
+        if (segments[i].len == 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    if (count == 1) {
+        i2c_master_dev_handle_t handle = find_device(ctx, segments[0].address);
+        if (handle == NULL) {
+            ret = ESP_ERR_INVALID_STATE;
+        } else if (segments[0].read) {
+            ret = i2c_master_receive(handle, segments[0].data, segments[0].len,
+                                     CONFIG_IO_EXPANDER_I2C_TIMEOUT_MS);
+        } else {
+            ret = i2c_master_transmit(handle, segments[0].data, segments[0].len,
+                                      CONFIG_IO_EXPANDER_I2C_TIMEOUT_MS);
+        }
+    } else {
+        ret = i2c_transfer_chained(ctx, segments, count);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Transaction to 0x%02X (%u segments) failed: %s",
+                 segments[0].address, (unsigned)count, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+#else /* CONFIG_IO_EXPANDER_USE_LEGACY_I2C */
+
+static esp_err_t i2c_transfer(io_expander_bus_t *bus, const io_expander_segment_t *segments, size_t count) {
+    i2c_bus_ctx_t *ctx = bus->ctx;
+
+    // Allocated per transaction, as the legacy driver is used for comparison only
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    if (cmd == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const io_expander_segment_t *seg = &segments[i];
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, (uint8_t)((seg->address << 1) | (seg->read ? I2C_MASTER_READ : I2C_MASTER_WRITE)), true);
+        if (seg->read) {
+            i2c_master_read(cmd, seg->data, seg->len, I2C_MASTER_LAST_NACK);
+        } else {
+            i2c_master_write(cmd, seg->data, seg->len, true);
+        }
+    }
+    i2c_master_stop(cmd);
+
+    esp_err_t ret = i2c_master_cmd_begin(ctx->port, cmd, pdMS_TO_TICKS(CONFIG_IO_EXPANDER_I2C_TIMEOUT_MS));
+    i2c_cmd_link_delete(cmd);
+
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Transaction to 0x%02X (%u segments) failed: %s",
+                 segments[0].address, (unsigned)count, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+#endif /* CONFIG_IO_EXPANDER_USE_LEGACY_I2C */
+
+/**
+ * @brief Attach a falling-edge handler to an INT line.
+ *
+ * Configures the GPIO as input with pull-up (INT is open-drain) and
+ * registers the handler through the shared GPIO ISR service.
+ */
+static bool i2c_irq_attach(io_expander_bus_t *bus, int gpio_num, io_expander_irq_handler_t handler, void *arg) {
+    (void)bus;
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << gpio_num,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "gpio_config failed for INT GPIO%d: %s", gpio_num, esp_err_to_name(err));
+        return false;
+    }
+
+    // The ISR service may already be installed by another component
+    err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "gpio_install_isr_service failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    err = gpio_isr_handler_add(gpio_num, handler, arg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "gpio_isr_handler_add failed for GPIO%d: %s", gpio_num, esp_err_to_name(err));
+        return false;
+    }
+
+    ESP_LOGI(TAG, "INT handler attached on GPIO%d", gpio_num);
+    return true;
+}
+
+static const io_expander_bus_ops_t i2c_bus_ops = {
+#ifndef CONFIG_IO_EXPANDER_USE_LEGACY_I2C
+    .add_device = i2c_add_device,
+#else
+    .add_device = NULL,
+#endif
+    .transfer = i2c_transfer,
+    .now_us = i2c_now_us,
+    .irq_attach = i2c_irq_attach,
+};
+
+bool io_expander_i2c_bus_init(io_expander_bus_t *bus, const io_expander_i2c_config_t *config) {
+    if (bus == NULL || config == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return false;
+    }
+
+    i2c_bus_ctx_t *ctx = NULL;
+    for (int i = 0; i < IO_EXPANDER_I2C_MAX_BUSES; i++) {
+        if (contexts[i].used && contexts[i].port == config->port) {
+            // Already open: share the controller
+            io_expander_bus_init(bus, &i2c_bus_ops, &contexts[i]);
+            return true;
+        }
+        if (ctx == NULL && !contexts[i].used) {
+            ctx = &contexts[i];
+        }
+    }
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "No free I2C bus slot for port %d", config->port);
+        return false;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->port = config->port;
+
+#ifndef CONFIG_IO_EXPANDER_USE_LEGACY_I2C
+    i2c_master_bus_config_t bus_conf = {
+        .i2c_port = config->port,
+        .sda_io_num = config->sda_pin,
+        .scl_io_num = config->scl_pin,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+
+    esp_err_t err = i2c_new_master_bus(&bus_conf, &ctx->bus_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "i2c_new_master_bus failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    ctx->clk_speed = config->clk_speed;
+
+    ctx->jobs_lock = xSemaphoreCreateMutex();
+    if (ctx->jobs_lock == NULL) {
+        ESP_LOGE(TAG, "Cannot create the transaction lock");
+        return false;
+    }
+
+    // Device without an address: chained transactions send address bytes themselves
+    i2c_device_config_t raw_conf = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = I2C_DEVICE_ADDRESS_NOT_USED,
+        .scl_speed_hz = ctx->clk_speed,
+    };
+    err = i2c_master_bus_add_device(ctx->bus_handle, &raw_conf, &ctx->raw_handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No raw device handle, multi-device transactions fall back to single: %s",
+                 esp_err_to_name(err));
+        ctx->raw_handle = NULL;
+    }
+#else
+    i2c_config_t i2c_conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = config->sda_pin,
+        .scl_io_num = config->scl_pin,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = config->clk_speed,
+    };
+
+    esp_err_t err = i2c_param_config(config->port, &i2c_conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "i2c_param_config failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    err = i2c_driver_install(config->port, I2C_MODE_MASTER, 0, 0, 0);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "i2c_driver_install failed: %s", esp_err_to_name(err));
+        return false;
+    }
+#endif
+
+    ctx->used = true;
+    io_expander_bus_init(bus, &i2c_bus_ops, ctx);
+    ESP_LOGI(TAG, "I2C (%s) initialized on port %d, SDA=%d, SCL=%d, speed=%lu",
+             io_expander_i2c_driver_name(), config->port, config->sda_pin, config->scl_pin,
+             (unsigned long)config->clk_speed);
+    return true;
+}
+
+const char *io_expander_i2c_driver_name(void) {
+#ifdef CONFIG_IO_EXPANDER_USE_LEGACY_I2C
+    return "legacy";
+#else
+    return "i2c_master";
+#endif
+}
@@ -0,0 +1,158 @@
+/* io_expander_mcp23017.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+/*
+ * MCP23017 16-bit I/O expander, register map with IOCON.BANK = 0 (A/B
+ * registers interleaved, the power-on layout) and sequential addressing,
+ * so a register pair is accessed as one 16-bit value, port A first.
+ * Port value bit 0-7 = GPA0-7, bit 8-15 = GPB0-7.
+ */
+
+#include "io_expander.h"
+
+#define MCP23017_IODIR      0x00    /**< Direction, 1 = input */
+#define MCP23017_IPOL       0x02    /**< Input polarity */
+#define MCP23017_GPINTEN    0x04    /**< Interrupt-on-change enable */
+#define MCP23017_DEFVAL     0x06    /**< Interrupt compare value */
+#define MCP23017_INTCON     0x08    /**< Interrupt control, 0 = compare with previous value */
+#define MCP23017_IOCON      0x0A    /**< Configuration */
+#define MCP23017_GPPU       0x0C    /**< Pull-up enable */
+#define MCP23017_INTF       0x0E    /**< Interrupt flags */
+#define MCP23017_INTCAP     0x10    /**< Port value captured at interrupt */
+#define MCP23017_GPIO       0x12    /**< Port value */
+#define MCP23017_OLAT       0x14    /**< Output latch */
+
+/** INTA/INTB mirrored (one INT line for both ports), open-drain so lines can be shared */
+#define MCP23017_IOCON_MIRROR   0x40
+#define MCP23017_IOCON_ODR      0x04
+
+/**
+ * @brief Write a 16-bit register pair.
+ *
+ * @param dev Device descriptor.
+ * @param reg Register of port A.
+ * @param value Port A in bits 0-7, port B in bits 8-15.
+ * @return true if the device acknowledged.
+ */
+static bool write_reg16(io_expander_t *dev, uint8_t reg, uint16_t value) {
+    uint8_t buf[3] = { reg, (uint8_t)value, (uint8_t)(value >> 8) };
+    io_expander_segment_t seg = { dev->address, false, sizeof(buf), buf };
+
+    return io_expander_bus_transfer(dev->bus, &seg, 1) == ESP_OK;
+}
+
+/**
+ * @brief Configure the chip: outputs from the shadow, inputs with pull-ups.
+ *
+ * The output latch is written before the direction register, so outputs
+ * come up at the shadow value (all high) instead of the power-on latch 0.
+ * Interrupt-on-change stays off until mcp23017_irq_attach().
+ */
+static bool mcp23017_init(io_expander_t *dev) {
+    uint8_t iocon[2] = { MCP23017_IOCON, MCP23017_IOCON_MIRROR | MCP23017_IOCON_ODR };
+    uint8_t olat[3] = { MCP23017_OLAT, (uint8_t)dev->shadow, (uint8_t)(dev->shadow >> 8) };
+    uint8_t gppu[3] = { MCP23017_GPPU, (uint8_t)dev->input_mask, (uint8_t)(dev->input_mask >> 8) };
+    // GPINTEN, DEFVAL and INTCON: interrupts off, compare with previous value
+    uint8_t intr[7] = { MCP23017_GPINTEN, 0, 0, 0, 0, 0, 0 };
+    uint8_t iodir[3] = { MCP23017_IODIR, (uint8_t)dev->input_mask, (uint8_t)(dev->input_mask >> 8) };
+    io_expander_segment_t segs[] = {
+        { dev->address, false, sizeof(iocon), iocon },
+        { dev->address, false, sizeof(olat), olat },
+        { dev->address, false, sizeof(gppu), gppu },
+        { dev->address, false, sizeof(intr), intr },
+        { dev->address, false, sizeof(iodir), iodir },
+    };
+
+    if (io_expander_bus_transfer(dev->bus, segs, sizeof(segs) / sizeof(segs[0])) != ESP_OK) {
+        return false;
+    }
+    dev->written = dev->shadow;
+    dev->written_valid = true;
+    return true;
+}
+
+/**
+ * @brief Read GPIOA/GPIOB (also releases INT).
+ */
+static bool mcp23017_read(io_expander_t *dev, uint16_t *value) {
+    uint8_t reg = MCP23017_GPIO;
+    uint8_t buf[2] = { 0xFF, 0xFF };
+    io_expander_segment_t segs[2] = {
+        { dev->address, false, 1, &reg },
+        { dev->address, true, sizeof(buf), buf },
+    };
+
+    if (io_expander_bus_transfer(dev->bus, segs, 2) != ESP_OK) {
+        return false;
+    }
+    *value = (uint16_t)(buf[0] | (buf[1] << 8));
+    return true;
+}
+
+/**
+ * @brief Write OLATA/OLATB (pins configured as inputs ignore the latch).
+ */
+static bool mcp23017_write(io_expander_t *dev, uint16_t value) {
+    return write_reg16(dev, MCP23017_OLAT, value);
+}
+
+/**
+ * @brief Read several MCP23017 in one transaction (register pointer write + read each).
+ */
+static bool mcp23017_read_multi(io_expander_t *const devs[], size_t count, uint16_t values[]) {
+    static const uint8_t reg = MCP23017_GPIO;
+    uint8_t buf[IO_EXPANDER_MULTI_MAX_DEVICES][2];
+    io_expander_segment_t segs[IO_EXPANDER_MULTI_MAX_DEVICES * 2] = { 0 };
+
+    for (size_t i = 0; i < count; i++) {
+        buf[i][0] = buf[i][1] = 0xFF;
+        segs[2 * i] = (io_expander_segment_t){ devs[i]->address, false, 1, (uint8_t *)&reg };
+        segs[2 * i + 1] = (io_expander_segment_t){ devs[i]->address, true, 2, buf[i] };
+    }
+    if (io_expander_bus_transfer(devs[0]->bus, segs, 2 * count) != ESP_OK) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (uint16_t)(buf[i][0] | (buf[i][1] << 8));
+    }
+    return true;
+}
+
+/**
+ * @brief Write the output latches of several MCP23017 in one transaction.
+ */
+static bool mcp23017_write_multi(io_expander_t *const devs[], size_t count, const uint16_t values[]) {
+    uint8_t buf[IO_EXPANDER_MULTI_MAX_DEVICES][3];
+    io_expander_segment_t segs[IO_EXPANDER_MULTI_MAX_DEVICES];
+
+    for (size_t i = 0; i < count; i++) {
+        buf[i][0] = MCP23017_OLAT;
+        buf[i][1] = (uint8_t)values[i];
+        buf[i][2] = (uint8_t)(values[i] >> 8);
+        segs[i] = (io_expander_segment_t){ devs[i]->address, false, 3, buf[i] };
+    }
+    return io_expander_bus_transfer(devs[0]->bus, segs, count) == ESP_OK;
+}
+
+/**
+ * @brief Enable interrupt-on-change for the input pins and attach the handler.
+ */
+static bool mcp23017_irq_attach(io_expander_t *dev, int gpio_num, io_expander_irq_handler_t handler, void *arg) {
+    if (dev->bus->ops->irq_attach == NULL) {
+        return false;
+    }
+    if (!dev->bus->ops->irq_attach(dev->bus, gpio_num, handler, arg)) {
+        return false;
+    }
+    return write_reg16(dev, MCP23017_GPINTEN, dev->input_mask);
+}
+
+const io_expander_ops_t io_expander_mcp23017_ops = {
+    .name = "MCP23017",
+    .pins = 16,
+    .init = mcp23017_init,
+    .read = mcp23017_read,
+    .write = mcp23017_write,
+    .read_multi = mcp23017_read_multi,
+    .write_multi = mcp23017_write_multi,
+    .irq_attach = mcp23017_irq_attach,
+};
@@ -0,0 +1,120 @@
+/* io_expander_pcf857x.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+/*
+ * PCF8574 and PCF8575 remote I/O expanders. Both have quasi-bidirectional
+ * ports without registers: a write sets the output latch (1 = weak pull-up,
+ * usable as input), a read returns the pin levels. The PCF8574 transfers
+ * one byte, the PCF8575 two (P00-P07 first, then P10-P17). INT is always
+ * enabled and released by the next read.
+ */
+
+#include "io_expander.h"
+
+/**
+ * @brief Read the pin levels of one PCF857x.
+ *
+ * @param dev Device descriptor.
+ * @param value Receives the pin levels (pins 8-15 read high on a PCF8574).
+ * @return true if the device acknowledged.
+ */
+static bool pcf857x_read(io_expander_t *dev, uint16_t *value) {
+    uint8_t buf[2] = { 0xFF, 0xFF };
+    io_expander_segment_t seg = { dev->address, true, dev->ops->pins / 8, buf };
+
+    if (io_expander_bus_transfer(dev->bus, &seg, 1) != ESP_OK) {
+        return false;
+    }
+    *value = (uint16_t)(buf[0] | (buf[1] << 8));
+    return true;
+}
+
+/**
+ * @brief Write the output latch of one PCF857x.
+ *
+ * @param dev Device descriptor.
+ * @param value Port value (pins 8-15 ignored on a PCF8574).
+ * @return true if the device acknowledged.
+ */
+static bool pcf857x_write(io_expander_t *dev, uint16_t value) {
+    uint8_t buf[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+    io_expander_segment_t seg = { dev->address, false, dev->ops->pins / 8, buf };
+
+    return io_expander_bus_transfer(dev->bus, &seg, 1) == ESP_OK;
+}
+
+/**
+ * @brief Read several PCF857x of one type in one transaction.
+ *
+ * @param devs Device descriptors on one bus.
+ * @param count Number of devices.
+ * @param values Receives one port value per device (untouched on failure).
+ * @return true if every device acknowledged.
+ */
+static bool pcf857x_read_multi(io_expander_t *const devs[], size_t count, uint16_t values[]) {
+    uint8_t buf[IO_EXPANDER_MULTI_MAX_DEVICES][2];
+    io_expander_segment_t segs[IO_EXPANDER_MULTI_MAX_DEVICES] = { 0 };
+
+    for (size_t i = 0; i < count; i++) {
+        buf[i][0] = buf[i][1] = 0xFF;
+        segs[i] = (io_expander_segment_t){ devs[i]->address, true, devs[i]->ops->pins / 8, buf[i] };
+    }
+    if (io_expander_bus_transfer(devs[0]->bus, segs, count) != ESP_OK) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (uint16_t)(buf[i][0] | (buf[i][1] << 8));
+    }
+    return true;
+}
+
+/**
+ * @brief Write several PCF857x of one type in one transaction.
+ *
+ * @param devs Device descriptors on one bus.
+ * @param count Number of devices.
+ * @param values One port value per device.
+ * @return true if every device acknowledged.
+ */
+static bool pcf857x_write_multi(io_expander_t *const devs[], size_t count, const uint16_t values[]) {
+    uint8_t buf[IO_EXPANDER_MULTI_MAX_DEVICES][2];
+    io_expander_segment_t segs[IO_EXPANDER_MULTI_MAX_DEVICES];
+
+    for (size_t i = 0; i < count; i++) {
+        buf[i][0] = (uint8_t)values[i];
+        buf[i][1] = (uint8_t)(values[i] >> 8);
+        segs[i] = (io_expander_segment_t){ devs[i]->address, false, devs[i]->ops->pins / 8, buf[i] };
+    }
+    return io_expander_bus_transfer(devs[0]->bus, segs, count) == ESP_OK;
+}
+
+/**
+ * @brief Attach a handler to the INT line (always enabled on the chip).
+ */
+static bool pcf857x_irq_attach(io_expander_t *dev, int gpio_num, io_expander_irq_handler_t handler, void *arg) {
+    if (dev->bus->ops->irq_attach == NULL) {
+        return false;
+    }
+    return dev->bus->ops->irq_attach(dev->bus, gpio_num, handler, arg);
+}
+
+const io_expander_ops_t io_expander_pcf8574_ops = {
+    .name = "PCF8574",
+    .pins = 8,
+    .init = NULL,
+    .read = pcf857x_read,
+    .write = pcf857x_write,
+    .read_multi = pcf857x_read_multi,
+    .write_multi = pcf857x_write_multi,
+    .irq_attach = pcf857x_irq_attach,
+};
+
+const io_expander_ops_t io_expander_pcf8575_ops = {
+    .name = "PCF8575",
+    .pins = 16,
+    .init = NULL,
+    .read = pcf857x_read,
+    .write = pcf857x_write,
+    .read_multi = pcf857x_read_multi,
+    .write_multi = pcf857x_write_multi,
+    .irq_attach = pcf857x_irq_attach,
+};
@@ -0,0 +1,445 @@
+/* io_expander_sim.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "io_expander_sim.h"
+#include <string.h>
+
+/** Default SCL frequency, as on the board */
+#define SIM_DEFAULT_SCL_HZ  400000
+
+/** Bits per byte on the wire: 8 data bits and ACK */
+#define BITS_PER_BYTE       9
+
+/* MCP23017 registers used by the model (IOCON.BANK = 0) */
+#define MCP_IODIR           0x00
+#define MCP_IPOL            0x02
+#define MCP_GPINTEN         0x04
+#define MCP_DEFVAL          0x06
+#define MCP_INTCON          0x08
+#define MCP_IOCON           0x0A
+#define MCP_INTF            0x0E
+#define MCP_INTCAP          0x10
+#define MCP_GPIO            0x12
+#define MCP_OLAT            0x14
+#define MCP_IOCON_SEQOP     0x20
+
+/* ============================================================================
+ * CHIP MODELS
+ * ============================================================================ */
+
+static uint16_t reg16(const io_expander_sim_dev_t *c, uint8_t reg) {
+    return (uint16_t)(c->regs[reg] | (c->regs[reg + 1] << 8));
+}
+
+static uint16_t pin_mask(const io_expander_sim_dev_t *c) {
+    return c->chip == IO_EXPANDER_SIM_PCF8574 ? 0x00FF : 0xFFFF;
+}
+
+/**
+ * @brief Pin levels of a chip.
+ *
+ * PCF857x: a latch 0 drives the pin low, a latch 1 is a weak pull-up that
+ * outside drivers override. MCP23017: outputs follow OLAT, inputs are high
+ * (pull-up) unless pulled low from outside.
+ */
+static uint16_t chip_levels(const io_expander_sim_dev_t *c) {
+    if (c->chip == IO_EXPANDER_SIM_MCP23017) {
+        uint16_t iodir = reg16(c, MCP_IODIR);
+        return (uint16_t)((reg16(c, MCP_OLAT) & ~iodir) | (~c->ext_low & iodir));
+    }
+    return (uint16_t)(c->latch & ~c->ext_low & pin_mask(c));
+}
+
+/**
+ * @brief Update the INT output after the pin levels changed.
+ *
+ * @param c Chip.
+ * @param old_levels Levels before the change.
+ */
+static void chip_levels_changed(io_expander_sim_dev_t *c, uint16_t old_levels) {
+    uint16_t levels = chip_levels(c);
+
+    if (c->chip == IO_EXPANDER_SIM_MCP23017) {
+        // Compare with the previous value, or with DEFVAL where INTCON is set
+        uint16_t intcon = reg16(c, MCP_INTCON);
+        uint16_t flagged = (uint16_t)((((old_levels ^ levels) & ~intcon) | ((levels ^ reg16(c, MCP_DEFVAL)) & intcon)) &
+                                      reg16(c, MCP_GPINTEN) & reg16(c, MCP_IODIR));
+        if (flagged && !c->int_active) {
+            c->regs[MCP_INTF] = (uint8_t)flagged;
+            c->regs[MCP_INTF + 1] = (uint8_t)(flagged >> 8);
+            c->regs[MCP_INTCAP] = (uint8_t)levels;
+            c->regs[MCP_INTCAP + 1] = (uint8_t)(levels >> 8);
+            c->int_active = true;
+        }
+    } else if (levels != old_levels) {
+        // Asserted while the port differs from its state at the last read
+        c->int_active = levels != c->last_read;
+    }
+}
+
+/**
+ * @brief Clock one data byte written by the master into a chip.
+ *
+ * @param c Chip.
+ * @param index Byte index within the segment.
+ * @param byte Data byte.
+ */
+static void chip_write_byte(io_expander_sim_dev_t *c, size_t index, uint8_t byte) {
+    uint16_t old_levels = chip_levels(c);
+
+    switch (c->chip) {
+    case IO_EXPANDER_SIM_PCF8574:
+        c->latch = byte;
+        break;
+    case IO_EXPANDER_SIM_PCF8575:
+        // Bytes alternate between port 0 and port 1
+        if (index % 2 == 0) {
+            c->latch = (uint16_t)((c->latch & 0xFF00) | byte);
+        } else {
+            c->latch = (uint16_t)((c->latch & 0x00FF) | (byte << 8));
+        }
+        break;
+    case IO_EXPANDER_SIM_MCP23017: {
+        if (index == 0) {
+            c->ptr = byte % IO_EXPANDER_SIM_MCP_REGS;
+            return;
+        }
+        uint8_t reg = c->ptr;
+        if (reg == MCP_GPIO || reg == MCP_GPIO + 1) {
+            c->regs[reg - MCP_GPIO + MCP_OLAT] = byte;      // Writing GPIO writes the latch
+        } else if (reg == MCP_IOCON || reg == MCP_IOCON + 1) {
+            c->regs[MCP_IOCON] = c->regs[MCP_IOCON + 1] = byte;
+        } else if (reg < MCP_INTF || reg >= MCP_GPIO) {
+            c->regs[reg] = byte;                            // INTF and INTCAP are read-only
+        }
+        // Sequential mode walks the register file, byte mode toggles within the A/B pair
+        c->ptr = (c->regs[MCP_IOCON] & MCP_IOCON_SEQOP) ? (uint8_t)(reg ^ 1)
+                                                        : (uint8_t)((reg + 1) % IO_EXPANDER_SIM_MCP_REGS);
+        break;
+    }
+    }
+
+    if (c->chip != IO_EXPANDER_SIM_MCP23017) {
+        // A write also releases INT
+        c->last_read = chip_levels(c);
+        c->int_active = false;
+    }
+    chip_levels_changed(c, old_levels);
+}
+
+/**
+ * @brief Clock one data byte read by the master from a chip.
+ *
+ * @param c Chip.
+ * @param index Byte index within the segment.
+ * @return uint8_t Data byte.
+ */
+static uint8_t chip_read_byte(io_expander_sim_dev_t *c, size_t index) {
+    uint16_t levels = chip_levels(c);
+
+    if (c->chip != IO_EXPANDER_SIM_MCP23017) {
+        c->last_read = levels;
+        c->int_active = false;
+        return (c->chip == IO_EXPANDER_SIM_PCF8575 && index % 2) ? (uint8_t)(levels >> 8) : (uint8_t)levels;
+    }
+
+    uint8_t reg = c->ptr;
+    uint8_t byte;
+    if (reg == MCP_GPIO || reg == MCP_GPIO + 1) {
+        uint16_t value = (uint16_t)(levels ^ (reg16(c, MCP_IPOL) & reg16(c, MCP_IODIR)));
+        byte = reg == MCP_GPIO ? (uint8_t)value : (uint8_t)(value >> 8);
+    } else {
+        byte = c->regs[reg];
+    }
+    if (reg >= MCP_INTCAP && reg <= MCP_GPIO + 1) {
+        // Reading GPIO or INTCAP releases INT
+        c->int_active = false;
+        c->regs[MCP_INTF] = c->regs[MCP_INTF + 1] = 0;
+    }
+    c->ptr = (c->regs[MCP_IOCON] & MCP_IOCON_SEQOP) ? (uint8_t)(reg ^ 1)
+                                                    : (uint8_t)((reg + 1) % IO_EXPANDER_SIM_MCP_REGS);
+    return byte;
+}
+
+/* ============================================================================
+ * BUS
+ * ============================================================================ */
+
+/**
+ * @brief Next PRNG value (xorshift64*).
+ */
+static uint32_t rng_next(io_expander_sim_t *sim) {
+    uint64_t x = sim->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    sim->rng = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static io_expander_sim_dev_t *find_chip(io_expander_sim_t *sim, uint8_t address) {
+    for (size_t i = 0; i < sim->chip_count; i++) {
+        if (sim->chips[i].address == address) {
+            return &sim->chips[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Record the level of every INT line with a handler.
+ *
+ * @param sim Simulator.
+ * @param low Receives true per attached line that is asserted (open-drain, wired-AND).
+ */
+static void lines_snapshot(io_expander_sim_t *sim, bool low[]) {
+    for (size_t i = 0; i < sim->irq_count; i++) {
+        low[i] = false;
+        for (size_t k = 0; k < sim->chip_count; k++) {
+            if (sim->chips[k].int_gpio == sim->irqs[i].gpio && sim->chips[k].int_active) {
+                low[i] = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Find INT lines that went low since a snapshot.
+ *
+ * @param sim Simulator.
+ * @param before Snapshot from lines_snapshot().
+ * @param fire Receives the indexes of lines with a falling edge.
+ * @return size_t Number of lines in fire.
+ */
+static size_t falling_edges(io_expander_sim_t *sim, const bool before[], size_t fire[]) {
+    bool after[IO_EXPANDER_SIM_MAX_IRQS];
+    size_t n = 0;
+
+    lines_snapshot(sim, after);
+    for (size_t i = 0; i < sim->irq_count; i++) {
+        if (!before[i] && after[i]) {
+            fire[n++] = i;
+        }
+    }
+    sim->stats.interrupts += (uint32_t)n;
+    return n;
+}
+
+/**
+ * @brief Call the handlers of lines with a falling edge (outside the lock).
+ */
+static void call_handlers(io_expander_sim_t *sim, const size_t fire[], size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        sim->irqs[fire[i]].handler(sim->irqs[fire[i]].arg);
+    }
+}
+
+static esp_err_t sim_transfer(io_expander_bus_t *bus, const io_expander_segment_t *segments, size_t count) {
+    io_expander_sim_t *sim = bus->ctx;
+    const io_expander_sim_config_t *cfg = &sim->config;
+    bool before[IO_EXPANDER_SIM_MAX_IRQS];
+    size_t fire[IO_EXPANDER_SIM_MAX_IRQS];
+
+    size_t total_bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        total_bytes += 1u + segments[i].len;
+    }
+
+    portENTER_CRITICAL(&sim->lock);
+    lines_snapshot(sim, before);
+    sim->stats.transactions++;
+    sim->sequence++;
+
+    // Same number of PRNG draws per transaction, whatever the outcome
+    uint32_t jitter_us = cfg->jitter_us ? rng_next(sim) % (cfg->jitter_us + 1) : 0;
+    bool fault = (uint32_t)(rng_next(sim) % 1000000u) < cfg->fault_rate_ppm;
+    size_t fault_byte = rng_next(sim) % total_bytes;
+    if (cfg->fault_every && sim->sequence % cfg->fault_every == 0) {
+        fault = true;
+    }
+    if (cfg->worst_case) {
+        jitter_us = cfg->jitter_us;
+        fault = true;
+        fault_byte = total_bytes - 1;
+    }
+
+    esp_err_t ret = ESP_OK;
+    uint32_t bits = 1;              // START
+    size_t byte_index = 0;
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        const io_expander_segment_t *seg = &segments[i];
+        io_expander_sim_dev_t *c = find_chip(sim, seg->address);
+
+        if (i > 0) {
+            bits += 1;              // Repeated START
+        }
+        bits += BITS_PER_BYTE;      // Address byte
+        sim->stats.bytes++;
+        if (fault && byte_index == fault_byte) {
+            sim->stats.faults++;
+            ret = ESP_FAIL;
+            break;
+        }
+        byte_index++;
+        if (c == NULL) {
+            sim->stats.nacks++;
+            ret = ESP_FAIL;
+            break;
+        }
+
+        for (size_t b = 0; b < seg->len; b++) {
+            bits += BITS_PER_BYTE;
+            sim->stats.bytes++;
+            if (fault && byte_index == fault_byte) {
+                sim->stats.faults++;
+                ret = ESP_FAIL;
+                break;
+            }
+            byte_index++;
+            if (seg->read) {
+                seg->data[b] = chip_read_byte(c, b);
+            } else {
+                chip_write_byte(c, b, seg->data[b]);
+            }
+        }
+    }
+    bits += 1;                      // STOP
+
+    sim->clock_ns += (uint64_t)(cfg->overhead_us + jitter_us) * 1000u +
+                     (uint64_t)bits * 1000000000u / cfg->scl_hz;
+    size_t n = falling_edges(sim, before, fire);
+    portEXIT_CRITICAL(&sim->lock);
+
+    call_handlers(sim, fire, n);
+    return ret;
+}
+
+static int64_t sim_now_us(io_expander_bus_t *bus) {
+    return (int64_t)io_expander_sim_now_us(bus->ctx);
+}
+
+static bool sim_irq_attach(io_expander_bus_t *bus, int gpio_num, io_expander_irq_handler_t handler, void *arg) {
+    io_expander_sim_t *sim = bus->ctx;
+    bool ok = true;
+
+    portENTER_CRITICAL(&sim->lock);
+    size_t i = 0;
+    while (i < sim->irq_count && sim->irqs[i].gpio != gpio_num) {
+        i++;
+    }
+    if (i == sim->irq_count) {
+        if (sim->irq_count < IO_EXPANDER_SIM_MAX_IRQS) {
+            sim->irq_count++;
+        } else {
+            ok = false;
+        }
+    }
+    if (ok) {
+        // One handler per line, as with gpio_isr_handler_add()
+        sim->irqs[i].gpio = gpio_num;
+        sim->irqs[i].handler = handler;
+        sim->irqs[i].arg = arg;
+    }
+    portEXIT_CRITICAL(&sim->lock);
+
+    return ok;
+}
+
+static const io_expander_bus_ops_t sim_bus_ops = {
+    .add_device = NULL,
+    .transfer = sim_transfer,
+    .now_us = sim_now_us,
+    .irq_attach = sim_irq_attach,
+};
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void io_expander_sim_init(io_expander_sim_t *sim, const io_expander_sim_config_t *config) {
+    memset(sim, 0, sizeof(*sim));
+    if (config) {
+        sim->config = *config;
+    }
+    if (sim->config.scl_hz == 0) {
+        sim->config.scl_hz = SIM_DEFAULT_SCL_HZ;
+    }
+    // xorshift needs a non-zero state
+    sim->rng = 0x9E3779B97F4A7C15ull ^ sim->config.seed;
+    sim->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    io_expander_bus_init(&sim->bus, &sim_bus_ops, sim);
+}
+
+io_expander_bus_t *io_expander_sim_bus(io_expander_sim_t *sim) {
+    return &sim->bus;
+}
+
+bool io_expander_sim_add(io_expander_sim_t *sim, io_expander_sim_chip_t chip, uint8_t address, int int_gpio) {
+    bool ok = false;
+
+    portENTER_CRITICAL(&sim->lock);
+    if (sim->chip_count < IO_EXPANDER_SIM_MAX_CHIPS && find_chip(sim, address) == NULL) {
+        io_expander_sim_dev_t *c = &sim->chips[sim->chip_count++];
+        memset(c, 0, sizeof(*c));
+        c->chip = chip;
+        c->address = address;
+        c->int_gpio = int_gpio;
+        c->latch = pin_mask(c);
+        c->regs[MCP_IODIR] = c->regs[MCP_IODIR + 1] = 0xFF;    // All inputs after reset
+        c->last_read = chip_levels(c);
+        ok = true;
+    }
+    portEXIT_CRITICAL(&sim->lock);
+
+    return ok;
+}
+
+void io_expander_sim_set_inputs(io_expander_sim_t *sim, uint8_t address, uint16_t low_pins) {
+    bool before[IO_EXPANDER_SIM_MAX_IRQS];
+    size_t fire[IO_EXPANDER_SIM_MAX_IRQS];
+    size_t n = 0;
+
+    portENTER_CRITICAL(&sim->lock);
+    io_expander_sim_dev_t *c = find_chip(sim, address);
+    if (c != NULL) {
+        lines_snapshot(sim, before);
+        uint16_t old_levels = chip_levels(c);
+        c->ext_low = low_pins;
+        chip_levels_changed(c, old_levels);
+        n = falling_edges(sim, before, fire);
+    }
+    portEXIT_CRITICAL(&sim->lock);
+
+    call_handlers(sim, fire, n);
+}
+
+uint16_t io_expander_sim_get_pins(io_expander_sim_t *sim, uint8_t address) {
+    uint16_t levels = 0xFFFF;
+
+    portENTER_CRITICAL(&sim->lock);
+    io_expander_sim_dev_t *c = find_chip(sim, address);
+    if (c != NULL) {
+        levels = chip_levels(c);
+    }
+    portEXIT_CRITICAL(&sim->lock);
+
+    return levels;
+}
+
+void io_expander_sim_advance(io_expander_sim_t *sim, uint32_t us) {
+    portENTER_CRITICAL(&sim->lock);
+    sim->clock_ns += (uint64_t)us * 1000u;
+    portEXIT_CRITICAL(&sim->lock);
+}
+
+uint64_t io_expander_sim_now_us(io_expander_sim_t *sim) {
+    portENTER_CRITICAL(&sim->lock);
+    uint64_t now = sim->clock_ns / 1000u;
+    portEXIT_CRITICAL(&sim->lock);
+    return now;
+}
+
+void io_expander_sim_get_stats(io_expander_sim_t *sim, io_expander_sim_stats_t *stats) {
+    portENTER_CRITICAL(&sim->lock);
+    *stats = sim->stats;
+    portEXIT_CRITICAL(&sim->lock);
+}
@@ -6,7 +6,7 @@
 #include "open62541.h"
 
 /* ============================================================================
- * PCF8574 Addresses for KC868-A16v3
+ * I/O Expander Addresses for KC868-A16v3
  * ============================================================================ */
 
 /** @brief I2C address for input module 1 */
@@ -18,6 +18,14 @@
 /** @brief I2C address for relay/output module 2 */
 #define DIO_OUT2_ADDR 0x25
 
+/** @brief Number of 8-bit discrete input banks (one per input expander) */
+#define DISCRETE_INPUT_BANKS  2
+
+/** @brief GPIO wired to INT of input module 1 (-1 = not used) */
+#define DIO_IN1_INT_GPIO  CONFIG_A16_DIO_IN1_INT_GPIO
+/** @brief GPIO wired to INT of input module 2 (-1 = not used) */
+#define DIO_IN2_INT_GPIO  CONFIG_A16_DIO_IN2_INT_GPIO
+
 /* ============================================================================
  * Discrete I/O Functions
  * ============================================================================ */
@@ -25,7 +33,7 @@
 /**
  * @brief Initialize discrete I/O hardware
  * 
- * Initializes PCF8574 I/O expanders and configures GPIO pins
+ * Initializes the I/O expanders and configures GPIO pins
  * for the KC868-A16v3 controller.
  */
 void discrete_io_init(void);
@@ -131,6 +139,44 @@ writeDiscreteOutputs(UA_Server *server,
  */
 void addDiscreteIOVariables(UA_Server *server);
 
+/**
+ * @brief Add the discrete input edge counters to OPC UA server
+ * 
+ * Creates a Counters object with one child per input (DI1-DI16) holding
+ * RisingEdges and FallingEdges (UInt64, source timestamp = last edge),
+ * PeriodUs and FrequencyHz (Double).
+ * 
+ * @param server OPC UA server instance
+ */
+void addCounterVariables(UA_Server *server);
+
+/**
+ * @brief Start a new server iteration for the read snapshot
+ * 
+ * Read callbacks of one UA_Server_run_iterate() call share a single
+ * io_cache snapshot. Call this before every iteration so the next
+ * Read request gets fresh, mutually consistent values.
+ * 
+ * The snapshot is scoped to the iteration, not to one Read service call:
+ * all requests the server handles in the same iteration, and the monitored
+ * item samples taken in it, share it. Values are therefore at most one
+ * iteration old.
+ */
+void model_invalidate_read_snapshot(void);
+
+/**
+ * @brief Write pending I/O changes into the server (push mode)
+ * 
+ * With CONFIG_A16_OPCUA_PUSH_MODE the I/O nodes are value-backed and this
+ * function writes queued cache changes into them with their hardware
+ * source timestamps, so monitored items report exactly the changes. Call
+ * it from the OPC UA task before every UA_Server_run_iterate(). Does
+ * nothing in the default (data source) mode.
+ * 
+ * @param server OPC UA server instance
+ */
+void model_push_changes(UA_Server *server);
+
 /**
  * @brief Model initialization task
  * 
@@ -169,9 +215,50 @@ uint16_t read_discrete_outputs_fast(void);
  * 
  * Direct hardware access to discrete inputs. Used by polling task.
  * 
+ * @param failed_banks Optional pointer receiving a bit mask of the banks
+ *        that could not be read (their bits are 0 in the result)
  * @return uint16_t Current discrete input value from hardware
  */
-uint16_t read_discrete_inputs_slow(void);
+uint16_t read_discrete_inputs_slow(uint8_t *failed_banks);
+
+/**
+ * @brief Read one discrete input bank from hardware (slow)
+ * 
+ * Reads a single input expander. Used by the polling task when the
+ * expander interrupt reports a change on that bank only.
+ * 
+ * @param bank Input bank (0 = inputs 1-8, 1 = inputs 9-16)
+ * @param ok Optional pointer receiving whether the read succeeded
+ * @return uint8_t Current bank value (1 = signal present, 0 on failure)
+ */
+uint8_t read_discrete_input_bank_slow(uint8_t bank, bool *ok);
+
+/**
+ * @brief Log I2C transaction timing of the I/O expanders
+ * 
+ * Prints count, errors and average/min/max time per transaction since
+ * the previous call, then resets the statistics.
+ */
+void discrete_io_log_bus_stats(void);
+
+/**
+ * @brief Get the number of failed I/O expander transactions since start
+ * 
+ * @return uint32_t Failed I2C transactions (not reset by discrete_io_log_bus_stats())
+ */
+uint32_t discrete_io_get_bus_errors(void);
+
+/**
+ * @brief Attach an ISR to the input expander INT lines
+ * 
+ * Installs the handler on every configured INT GPIO. The handler argument
+ * is a bit mask of the banks wired to that GPIO (bit 0 = bank 0), so a
+ * shared line reports both banks.
+ * 
+ * @param handler ISR handler (must be IRAM_ATTR)
+ * @return uint32_t Mask of banks served by an interrupt (0 = none configured)
+ */
+uint32_t discrete_inputs_attach_interrupt(void (*handler)(void *arg));
 
 /**
  * @brief Write discrete outputs to hardware (slow)
@@ -179,8 +266,23 @@ uint16_t read_discrete_inputs_slow(void);
  * Direct hardware access to discrete outputs. Used by polling task.
  * 
  * @param outputs Value to write to outputs
+ * @return true if both output expanders were written successfully
+ */
+bool write_discrete_outputs_slow(uint16_t outputs);
+
+/**
+ * @brief Change selected discrete outputs on hardware (slow)
+ * 
+ * Updates only the outputs selected by mask through the expander shadow
+ * registers. Expanders whose state does not change are not written, and
+ * no bus read is needed. Used by polling task.
+ * 
+ * @param mask Outputs to change
+ * @param values New values for the outputs selected by mask
+ * @param applied Receives the resulting state of all 16 outputs (may be NULL)
+ * @return true if every written expander acknowledged the write
  */
-void write_discrete_outputs_slow(uint16_t outputs);
+bool write_discrete_outputs_masked_slow(uint16_t mask, uint16_t values, uint16_t *applied);
 
 /* ============================================================================
  * Diagnostic Tags for Performance Measurement
@@ -306,6 +408,8 @@ UA_StatusCode readLoopbackOutput(UA_Server *server,
  * ADC Functions
  * ============================================================================ */
 
+#include "adc_filter.h"
+
 /** @brief ADC channel 1 configuration (GPIO4 - ANALOG_A1) */
 #define OUR_ADC_CHANNEL_1     ADC_CHANNEL_3
 /** @brief ADC channel 2 configuration (GPIO6 - ANALOG_A2) */
@@ -321,7 +425,9 @@ UA_StatusCode readLoopbackOutput(UA_Server *server,
 /**
  * @brief Initialize ADC hardware
  * 
- * Configures ADC channels and calibration for analog inputs.
+ * Configures ADC channels and calibration for analog inputs. With
+ * CONFIG_A16_ADC_BACKEND_CONTINUOUS, starts DMA sampling of all channels
+ * and a consumer task that publishes averaged values to the I/O cache.
  */
 void adc_init(void);
 
@@ -331,17 +437,31 @@ void adc_init(void);
  * Direct hardware read of ADC channel. Used by polling task.
  * 
  * @param channel ADC channel number (0-3)
- * @return uint16_t Raw ADC value (0-4095)
+ * @return uint16_t Raw ADC value (0-4095, 0 if the conversion failed)
  */
 uint16_t read_adc_channel_slow(uint8_t channel);
 
 /**
  * @brief Update all ADC channels from hardware (slow)
  * 
- * Reads all ADC channels and updates the cache.
+ * Reads all ADC channels and updates the cache. Channels whose
+ * conversion fails keep their cached value with reduced quality.
  */
 void update_all_adc_channels_slow(void);
 
+/**
+ * @brief Change the filter of one ADC channel
+ * 
+ * Overrides the CONFIG_A16_ADC_FILTER default for one channel. The filter
+ * runs between acquisition and the I/O cache; its history is cleared.
+ * 
+ * @param channel ADC channel number (0-3)
+ * @param type Filter type
+ * @param param Window length (moving average, median) or IIR shift
+ * @return true if the channel number is valid
+ */
+bool adc_set_filter(uint8_t channel, adc_filter_type_t type, uint8_t param);
+
 /**
  * @brief Read ADC channel from cache (fast)
  * 
@@ -361,6 +481,29 @@ uint16_t read_adc_channel_fast(uint8_t channel);
  */
 uint16_t* get_all_adc_channels_fast(void);
 
+/**
+ * @brief Convert an ADC code to calibrated pin voltage
+ * 
+ * Table lookup in the curve-fitting calibration built by adc_init();
+ * fractional (filtered) codes are interpolated.
+ * 
+ * @param code ADC code (0-4095, may be fractional)
+ * @return float Pin voltage in mV
+ */
+float adc_code_to_mv(float code);
+
+/**
+ * @brief Convert an ADC code to the engineering value of a channel
+ * 
+ * Calibrated pin voltage scaled linearly to the channel range
+ * (e.g. 0-5 V or 4-20 mA).
+ * 
+ * @param channel ADC channel number (0-3)
+ * @param code ADC code (0-4095, may be fractional)
+ * @return float Engineering value
+ */
+float adc_code_to_eu(uint8_t channel, float code);
+
 /**
  * @brief OPC UA read callback for ADC channel
  * 
@@ -382,11 +525,69 @@ UA_StatusCode readAdcChannel(UA_Server *server,
                            UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
                            UA_DataValue *dataValue);
 
+/**
+ * @brief OPC UA read callback for calibrated analog value
+ * 
+ * Called by OPC UA server when an engineering-unit ADC variable is read.
+ * 
+ * @param server OPC UA server instance
+ * @param sessionId Client session ID
+ * @param sessionContext Session context (not used)
+ * @param nodeId Node ID being read
+ * @param nodeContext Channel number stored as pointer
+ * @param sourceTimeStamp Whether to include source timestamp
+ * @param range Data range (not used)
+ * @param dataValue Pointer to store read data
+ * @return UA_StatusCode Status of read operation
+ */
+UA_StatusCode readAdcValue(UA_Server *server,
+                           const UA_NodeId *sessionId, void *sessionContext,
+                           const UA_NodeId *nodeId, void *nodeContext,
+                           UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+                           UA_DataValue *dataValue);
+
 /**
  * @brief Add ADC variables to OPC UA server
  * 
- * Creates OPC UA nodes for ADC channels in the server address space.
+ * Creates OPC UA nodes for ADC channels in the server address space:
+ * raw codes (UInt16) and calibrated values (Float, AnalogItemType with
+ * EURange and EngineeringUnits).
+ * 
+ * @param server OPC UA server instance
+ */
+void addAdcVariables(UA_Server *server);
+
+/**
+ * @brief Let the I/O poll periods follow the OPC UA subscriptions
+ * 
+ * Registers a server callback that derives the input and ADC poll periods
+ * from the fastest sampling interval monitored on their nodes (clamped to
+ * the configured limits) and drops to the housekeeping period while no
+ * session is open. Call after the I/O variables have been added.
+ * 
+ * @param server OPC UA server instance
+ */
+void addPollRateTracking(UA_Server *server);
+
+/**
+ * @brief Add the acquisition Diagnostics object
+ * 
+ * Publishes the polling task histograms (input/ADC acquisition time, input
+ * cache update time, poll start lateness) as Count, Mean, Min, Max, P50,
+ * P99 and P99.9 in microseconds, the I2C error count, and a Reset method
+ * clearing all of them.
+ * 
+ * @param server OPC UA server instance
+ */
+void addDiagnosticsObject(UA_Server *server);
+
+/**
+ * @brief Add the History object
+ * 
+ * Its ReadRaw method returns the samples kept in the I/O cache history
+ * ring buffers for discrete_inputs, discrete_outputs, adc_channel_N and
+ * adc_eu_N, so clients can backfill after a disconnection.
  * 
  * @param server OPC UA server instance
  */
-void addAdcVariables(UA_Server *server);
\ No newline at end of file
+void addHistoryObject(UA_Server *server);
\ No newline at end of file
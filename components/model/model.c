@@ -4,9 +4,20 @@
 #include "model.h"
 #include "driver/gpio.h"
 #include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#ifdef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+#include "esp_adc/adc_continuous.h"
+#include "soc/soc_caps.h"
+#endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "io_cache.h"
-#include "pcf8574.h"
+#include "adc_filter.h"
+#include "io_expander.h"
+#include "io_expander_i2c.h"
 #include "esp_log.h"
+#include "timebase.h"
 
 static const char *TAG = "model";
 
@@ -14,14 +25,36 @@ static const char *TAG = "model";
  * DISCRETE I/O FUNCTIONS
  * ============================================================================ */
 
-/** PCF8574 device descriptors */
-static pcf8574_dev_t dio_in1, dio_in2, dio_out1, dio_out2;
+/** Expander driver selected with A16_DIO_EXPANDER */
+#if defined(CONFIG_A16_DIO_EXPANDER_MCP23017)
+#define DIO_EXPANDER_OPS    io_expander_mcp23017_ops
+#elif defined(CONFIG_A16_DIO_EXPANDER_PCF8575)
+#define DIO_EXPANDER_OPS    io_expander_pcf8575_ops
+#else
+#define DIO_EXPANDER_OPS    io_expander_pcf8574_ops
+#endif
+
+/** Number of 8-bit discrete output banks (one per output expander) */
+#define DISCRETE_OUTPUT_BANKS   2
+
+/** Expander pins not wired on 16-pin chips; kept as inputs (high) */
+#define DIO_UNUSED_PINS     0xFF00
+
+/** Expander device descriptors, bank 0 first */
+static io_expander_t dio_in[DISCRETE_INPUT_BANKS];
+static io_expander_t dio_out[DISCRETE_OUTPUT_BANKS];
+static io_expander_t *const dio_in_devs[DISCRETE_INPUT_BANKS] = { &dio_in[0], &dio_in[1] };
+static io_expander_t *const dio_out_devs[DISCRETE_OUTPUT_BANKS] = { &dio_out[0], &dio_out[1] };
+
+static io_expander_bus_t i2c_bus;
+static io_expander_bus_t *dio_bus = NULL;   /**< The I2C bus once initialized */
+static const io_expander_ops_t *const dio_ops = &DIO_EXPANDER_OPS;
 static bool dio_initialized = false;
 
 /**
  * @brief Initialize discrete I/O hardware
  * 
- * This function initializes the PCF8574 I/O expanders for the KC868-A16v3
+ * This function initializes the I/O expanders for the KC868-A16v3
  * controller. It configures I2C communication and sets all outputs to a
  * safe state (off).
  */
@@ -31,30 +64,35 @@ void discrete_io_init(void) {
     }
     
     // I2C configuration
-    pcf8574_config_t i2c_config = {
-        .i2c_port = I2C_NUM_0,
+    io_expander_i2c_config_t i2c_config = {
+        .port = I2C_NUM_0,
         .sda_pin = 9,
         .scl_pin = 10,
         .clk_speed = 400000
     };
     
-    if (!pcf8574_i2c_init(&i2c_config)) {
+    if (!io_expander_i2c_bus_init(&i2c_bus, &i2c_config)) {
         ESP_LOGE(TAG, "Failed to initialize I2C for discrete I/O");
         return;
     }
+    dio_bus = &i2c_bus;
     
-    // Initialize devices
-    pcf8574_init(&dio_in1, DIO_IN1_ADDR, I2C_NUM_0);
-    pcf8574_init(&dio_in2, DIO_IN2_ADDR, I2C_NUM_0);
-    pcf8574_init(&dio_out1, DIO_OUT1_ADDR, I2C_NUM_0);
-    pcf8574_init(&dio_out2, DIO_OUT2_ADDR, I2C_NUM_0);
+    // Initialize devices; a device that does not answer now is reported by every access
+    const uint8_t in_addr[DISCRETE_INPUT_BANKS] = { DIO_IN1_ADDR, DIO_IN2_ADDR };
+    const uint8_t out_addr[DISCRETE_OUTPUT_BANKS] = { DIO_OUT1_ADDR, DIO_OUT2_ADDR };
+    for (int bank = 0; bank < DISCRETE_INPUT_BANKS; bank++) {
+        io_expander_init(&dio_in[bank], dio_ops, dio_bus, in_addr[bank], IO_EXPANDER_ALL_HIGH);
+    }
+    for (int bank = 0; bank < DISCRETE_OUTPUT_BANKS; bank++) {
+        io_expander_init(&dio_out[bank], dio_ops, dio_bus, out_addr[bank], DIO_UNUSED_PINS);
+    }
     
     // Initialize outputs to safe state (all off)
-    pcf8574_write(&dio_out1, 0xFF); // All bits = 1 (off)
-    pcf8574_write(&dio_out2, 0xFF);
+    const uint16_t off[DISCRETE_OUTPUT_BANKS] = { IO_EXPANDER_ALL_HIGH, IO_EXPANDER_ALL_HIGH };
+    io_expander_write_multi(dio_out_devs, DISCRETE_OUTPUT_BANKS, off, NULL);
     
     dio_initialized = true;
-    ESP_LOGI(TAG, "Discrete I/O initialized");
+    ESP_LOGI(TAG, "Discrete I/O initialized (%s)", dio_ops->name);
 }
 
 /**
@@ -62,32 +100,164 @@ void discrete_io_init(void) {
  * 
  * This function performs direct hardware read of all 16 discrete input channels.
  * It uses lazy initialization - hardware is initialized on first call.
+ * A failed expander reads as 0xFF (inverted to all inputs off), so the
+ * failure is reported separately and must not be taken as a value.
  * 
- * @return uint16_t Current state of discrete inputs (16 bits)
+ * @param failed_banks Optional pointer receiving the banks that failed
+ * @return uint16_t Current state of discrete inputs (16 bits, failed banks 0)
  */
-uint16_t read_discrete_inputs_slow(void) {
+uint16_t read_discrete_inputs_slow(uint8_t *failed_banks) {
+    if (failed_banks) {
+        *failed_banks = 0;
+    }
+    
     // Lazy initialization on first call
     if (!dio_initialized) {
         ESP_LOGI(TAG, "First call to discrete I/O - initializing...");
         discrete_io_init();
         if (!dio_initialized) {
             ESP_LOGE(TAG, "Failed to initialize discrete I/O");
-            return 0xFFFF;
+            if (failed_banks) {
+                *failed_banks = (1u << DISCRETE_INPUT_BANKS) - 1;
+            }
+            return 0;
         }
     }
     
-    uint8_t in1 = pcf8574_read(&dio_in1);
-    uint8_t in2 = pcf8574_read(&dio_in2);
+    // Both expanders in one transaction (repeated START): one bus/driver round trip
+    uint16_t raw[DISCRETE_INPUT_BANKS];
+    bool ok[DISCRETE_INPUT_BANKS];
+    io_expander_read_multi(dio_in_devs, DISCRETE_INPUT_BANKS, raw, ok);
     
-    // Invert: PCF8574: 0=signal present, 1=no signal -> make 1=signal present
-    in1 = ~in1;
-    in2 = ~in2;
+    for (int bank = 0; bank < DISCRETE_INPUT_BANKS; bank++) {
+        if (!ok[bank]) {
+            raw[bank] = IO_EXPANDER_ALL_HIGH;
+            if (failed_banks) {
+                *failed_banks |= 1u << bank;
+            }
+        }
+    }
+    
+    // Invert: expander pin 0=signal present, 1=no signal -> make 1=signal present
+    uint8_t in1 = (uint8_t)~raw[0];
+    uint8_t in2 = (uint8_t)~raw[1];
     
     uint16_t inputs = ((uint16_t)in2 << 8) | in1;
     ESP_LOGD(TAG, "Direct read inputs: 0x%04X", inputs);
     return inputs;
 }
 
+/**
+ * @brief Read one 8-bit discrete input bank from hardware
+ * 
+ * Reads only the expander of the given bank. Reading the port also
+ * releases the expander INT line.
+ * 
+ * @param bank Input bank (0 = inputs 1-8, 1 = inputs 9-16)
+ * @param ok Optional pointer receiving whether the read succeeded
+ * @return uint8_t Current bank value (1 = signal present, 0 on failure)
+ */
+uint8_t read_discrete_input_bank_slow(uint8_t bank, bool *ok) {
+    if (ok) {
+        *ok = false;
+    }
+    
+    if (!dio_initialized) {
+        discrete_io_init();
+        if (!dio_initialized) {
+            ESP_LOGE(TAG, "Failed to initialize discrete I/O");
+            return 0;
+        }
+    }
+    
+    if (bank >= DISCRETE_INPUT_BANKS) {
+        return 0;
+    }
+    
+    // Invert: expander pin 0=signal present, 1=no signal -> make 1=signal present
+    uint16_t in = IO_EXPANDER_ALL_HIGH;
+    bool read_ok = io_expander_read(&dio_in[bank], &in);
+    if (ok) {
+        *ok = read_ok;
+    }
+    return read_ok ? (uint8_t)~in : 0;
+}
+
+/**
+ * @brief Log I2C transaction timing of the I/O expanders
+ * 
+ * Prints the statistics collected on the expander bus since the previous
+ * call and starts a new measurement window. Comparing the output with
+ * CONFIG_IO_EXPANDER_USE_LEGACY_I2C on and off shows the driver overhead.
+ */
+void discrete_io_log_bus_stats(void) {
+    if (dio_bus == NULL) {
+        return;
+    }
+    
+    io_expander_bus_stats_t st;
+    io_expander_bus_get_stats(dio_bus, &st);
+    io_expander_bus_reset_stats(dio_bus);
+    
+    ESP_LOGI(TAG, "I2C (%s): %lu transactions, %lu errors, avg %lu us, min %lu us, max %lu us",
+             io_expander_i2c_driver_name(), (unsigned long)st.transactions, (unsigned long)st.errors,
+             (unsigned long)(st.transactions ? st.total_us / st.transactions : 0),
+             (unsigned long)st.min_us, (unsigned long)st.max_us);
+}
+
+/**
+ * @brief Get the number of failed I/O expander transactions since start
+ * 
+ * @return uint32_t Failed I2C transactions
+ */
+uint32_t discrete_io_get_bus_errors(void) {
+    return dio_bus ? io_expander_bus_get_error_count(dio_bus) : 0;
+}
+
+/**
+ * @brief Attach an ISR to the input expander INT lines
+ * 
+ * Each configured INT GPIO gets the handler with a bank mask as argument.
+ * If both expanders share one GPIO, the handler is installed once with
+ * both bank bits set.
+ * 
+ * @param handler ISR handler (must be IRAM_ATTR)
+ * @return uint32_t Mask of banks served by an interrupt
+ */
+uint32_t discrete_inputs_attach_interrupt(void (*handler)(void *arg)) {
+    // The MCP23017 enables interrupt-on-change when attached: configure the chips first
+    if (!dio_initialized) {
+        discrete_io_init();
+        if (!dio_initialized) {
+            ESP_LOGE(TAG, "Failed to initialize discrete I/O");
+            return 0;
+        }
+    }
+    
+    const int int_gpio[DISCRETE_INPUT_BANKS] = { DIO_IN1_INT_GPIO, DIO_IN2_INT_GPIO };
+    uint32_t attached = 0;
+    
+    for (int bank = 0; bank < DISCRETE_INPUT_BANKS; bank++) {
+        if (int_gpio[bank] < 0 || (attached & (1u << bank))) {
+            continue;
+        }
+        
+        // Collect every bank wired to the same INT line
+        uint32_t banks = 0;
+        for (int other = bank; other < DISCRETE_INPUT_BANKS; other++) {
+            if (int_gpio[other] == int_gpio[bank]) {
+                banks |= 1u << other;
+            }
+        }
+        
+        if (io_expander_irq_attach(&dio_in[bank], int_gpio[bank], handler, (void *)(uintptr_t)banks)) {
+            attached |= banks;
+        }
+    }
+    
+    return attached;
+}
+
 /**
  * @brief Write 16 discrete outputs to hardware
  * 
@@ -95,40 +265,265 @@ uint16_t read_discrete_inputs_slow(void) {
  * It uses lazy initialization - hardware is initialized on first call.
  * 
  * @param outputs Value to write to outputs (16 bits)
+ * @return true if both output expanders acknowledged the write
  */
-void write_discrete_outputs_slow(uint16_t outputs) {
+bool write_discrete_outputs_slow(uint16_t outputs) {
     // Lazy initialization on first call
     if (!dio_initialized) {
         ESP_LOGI(TAG, "First call to discrete I/O - initializing...");
         discrete_io_init();
         if (!dio_initialized) {
             ESP_LOGE(TAG, "Failed to initialize discrete I/O");
-            return;
+            return false;
         }
     }
     
-    uint8_t out1 = outputs & 0xFF;
-    uint8_t out2 = (outputs >> 8) & 0xFF;
+    // Invert: 1 in bit = turn output on -> expander pin 0=turn on
+    const uint16_t raw[DISCRETE_OUTPUT_BANKS] = { (uint8_t)~(outputs & 0xFF), (uint8_t)~((outputs >> 8) & 0xFF) };
     
-    // Invert: 1 in bit = turn output on -> PCF8574: 0=turn on
-    out1 = ~out1;
-    out2 = ~out2;
-    
-    pcf8574_write(&dio_out1, out1);
-    pcf8574_write(&dio_out2, out2);
+    // Both expanders in one transaction so all 16 relays switch together
+    bool ok[DISCRETE_OUTPUT_BANKS];
+    bool all_ok = io_expander_write_multi(dio_out_devs, DISCRETE_OUTPUT_BANKS, raw, ok);
+    if (!all_ok) {
+        ESP_LOGW(TAG, "Output write failed (out1 %s, out2 %s)",
+                 ok[0] ? "ok" : "FAIL", ok[1] ? "ok" : "FAIL");
+    }
     
     ESP_LOGD(TAG, "Direct write outputs: 0x%04X", outputs);
+    return all_ok;
+}
+
+/**
+ * @brief Change selected discrete outputs on hardware
+ * 
+ * Per-relay writes go through the expander shadow registers: an expander
+ * is written only if one of its masked outputs changes, and both are
+ * chained into one transaction when both change.
+ * 
+ * @param mask Outputs to change
+ * @param values New values for the outputs selected by mask
+ * @param applied Receives the resulting state of all 16 outputs (may be NULL)
+ * @return true if every written expander acknowledged the write
+ */
+bool write_discrete_outputs_masked_slow(uint16_t mask, uint16_t values, uint16_t *applied) {
+    if (!dio_initialized) {
+        ESP_LOGI(TAG, "First call to discrete I/O - initializing...");
+        discrete_io_init();
+        if (!dio_initialized) {
+            ESP_LOGE(TAG, "Failed to initialize discrete I/O");
+            return false;
+        }
+    }
+    
+    // Invert: 1 in bit = turn output on -> expander pin 0=turn on
+    const uint16_t dev_mask[DISCRETE_OUTPUT_BANKS] = { (uint16_t)(mask & 0xFF), (uint16_t)(mask >> 8) };
+    const uint16_t raw[DISCRETE_OUTPUT_BANKS] = { (uint8_t)~(values & 0xFF), (uint8_t)~(values >> 8) };
+    
+    bool ok[DISCRETE_OUTPUT_BANKS];
+    bool all_ok = io_expander_update_mask_multi(dio_out_devs, DISCRETE_OUTPUT_BANKS, dev_mask, raw, ok);
+    if (!all_ok) {
+        ESP_LOGW(TAG, "Output write failed (out1 %s, out2 %s)",
+                 ok[0] ? "ok" : "FAIL", ok[1] ? "ok" : "FAIL");
+    }
+    
+    if (applied) {
+        *applied = (uint16_t)~(((io_expander_get_shadow(&dio_out[1]) & 0xFF) << 8) |
+                               (io_expander_get_shadow(&dio_out[0]) & 0xFF));
+    }
+    
+    ESP_LOGD(TAG, "Masked write outputs: mask 0x%04X, values 0x%04X", mask, values);
+    return all_ok;
 }
 
 /* ============================================================================
  * OPC UA FUNCTIONS FOR DISCRETE I/O
  * ============================================================================ */
 
+/** Longest wait for an on-demand hardware read requested through maxAge */
+#define READ_THROUGH_TIMEOUT_MS     50
+
+/**
+ * Snapshot shared by all read callbacks of one server iteration.
+ * 
+ * A Read request for several I/O nodes is processed inside a single
+ * UA_Server_run_iterate() call. The first callback takes one cache snapshot
+ * and the following ones reuse it, so all values in the response come from
+ * the same poll cycle and the cache is copied once per request instead of
+ * once per node. Only the OPC UA task touches these variables.
+ * 
+ * The scope is the iteration, not the Read service call: open62541 has no
+ * hook around a single service, so every request handled in the same
+ * iteration (pipelined or from other sessions) and the monitored item
+ * samples taken in it see the same snapshot. It is never older than one
+ * iteration (at most the run_iterate timeout plus the task delay).
+ */
+static io_cache_snapshot_t read_snapshot;
+static bool read_snapshot_valid = false;
+static uint32_t read_refreshed_groups = 0;  /**< Groups read on demand in this iteration */
+static uint32_t diag_copy_valid = 0;        /**< Diagnostics histograms copied in this iteration (bit per io_diag_id_t) */
+static bool counter_copy_valid = false;     /**< Edge counters copied in this iteration */
+
+/**
+ * @brief Start a new server iteration for the read snapshot
+ * 
+ * Must be called by the OPC UA task before each UA_Server_run_iterate().
+ * The next read callback takes a fresh snapshot.
+ */
+void model_invalidate_read_snapshot(void) {
+    read_snapshot_valid = false;
+    read_refreshed_groups = 0;
+    diag_copy_valid = 0;
+    counter_copy_valid = false;
+}
+
+/**
+ * @brief Get the snapshot of the current server iteration
+ * 
+ * @return const io_cache_snapshot_t* Snapshot taken on first use in this iteration
+ */
+static const io_cache_snapshot_t *get_read_snapshot(void) {
+    if (!read_snapshot_valid) {
+        io_cache_get_snapshot(&read_snapshot);
+        read_snapshot_valid = true;
+    }
+    return &read_snapshot;
+}
+
+/**
+ * @brief Get the iteration snapshot, honouring the maxAge of a Read request
+ * 
+ * Outside of a Read service call (subscription sampling, local reads) and
+ * when the cached value is younger than maxAge this is a plain cache hit.
+ * Otherwise the group is read from hardware through the polling task once
+ * per server iteration and a new snapshot is taken. On timeout the cached
+ * value is returned.
+ * 
+ * @param server OPC UA server instance
+ * @param group IO_REFRESH_INPUTS or IO_REFRESH_ADC
+ * @param channel ADC channel whose age is checked (IO_REFRESH_ADC only)
+ * @return const io_cache_snapshot_t* Snapshot satisfying maxAge if possible
+ */
+static const io_cache_snapshot_t *get_read_snapshot_max_age(UA_Server *server,
+                                                            uint32_t group, uint8_t channel) {
+    const io_cache_snapshot_t *snap = get_read_snapshot();
+    UA_Double max_age = UA_Server_getReadMaxAge(server);
+    
+    if (max_age < 0 || (read_refreshed_groups & group)) {
+        return snap;
+    }
+    
+    uint64_t updated_us = (group == IO_REFRESH_INPUTS) ? snap->inputs_server_timestamp_us
+                                                       : snap->adc_server_timestamps_us[channel];
+    uint64_t now_us = timebase_now_us();
+    
+    // maxAge 0 always asks for a device read
+    if (max_age > 0 && (UA_Double)(now_us - updated_us) / 1000.0 <= max_age) {
+        return snap;
+    }
+    
+    read_refreshed_groups |= group;
+    if (!io_polling_refresh(group, READ_THROUGH_TIMEOUT_MS)) {
+        ESP_LOGD(TAG, "Read-through of group 0x%02lX not done, serving cache", (unsigned long)group);
+        return snap;
+    }
+    
+    read_snapshot_valid = false;
+    return get_read_snapshot();
+}
+
+/**
+ * @brief OPC UA StatusCode of a cached value quality
+ * 
+ * open62541 has no Bad_CommunicationFailure; a failed acquisition without
+ * any older value is reported as Bad_NoCommunication.
+ * 
+ * @param quality Effective quality (see io_quality_effective())
+ * @return UA_StatusCode Status for the DataValue
+ */
+static UA_StatusCode quality_status(io_quality_t quality) {
+    switch (quality) {
+    case IO_QUALITY_GOOD:
+        return UA_STATUSCODE_GOOD;
+    case IO_QUALITY_LAST_USABLE:
+        return UA_STATUSCODE_UNCERTAINLASTUSABLEVALUE;
+    case IO_QUALITY_COMM_FAILURE:
+        return UA_STATUSCODE_BADNOCOMMUNICATION;
+    case IO_QUALITY_WAITING:
+    default:
+        return UA_STATUSCODE_BADWAITINGFORINITIALDATA;
+    }
+}
+
+/**
+ * @brief Set the status of a DataValue from a cached value quality
+ * 
+ * Good values carry no status field (Good is implied).
+ * 
+ * @param dataValue DataValue being filled by a read callback
+ * @param quality Effective quality
+ */
+static void set_quality_status(UA_DataValue *dataValue, io_quality_t quality) {
+    UA_StatusCode status = quality_status(quality);
+    if (status != UA_STATUSCODE_GOOD) {
+        dataValue->hasStatus = true;
+        dataValue->status = status;
+    }
+}
+
+/**
+ * @brief Effective quality of the inputs in a snapshot
+ */
+static io_quality_t inputs_quality(const io_cache_snapshot_t *snap, uint64_t now_us) {
+    return io_quality_effective((io_quality_t)snap->inputs_quality,
+                                snap->inputs_server_timestamp_us, now_us, snap->inputs_stale_ms);
+}
+
+/**
+ * @brief Effective quality of one ADC channel in a snapshot
+ */
+static io_quality_t adc_quality(const io_cache_snapshot_t *snap, uint8_t channel, uint64_t now_us) {
+    return io_quality_effective((io_quality_t)snap->adc_quality[channel],
+                                snap->adc_server_timestamps_us[channel], now_us, snap->adc_stale_ms);
+}
+
+/**
+ * @brief OPC UA DateTime of a cache timestamp
+ * 
+ * @param mono_us Monotonic time from timebase_now_us()
+ * @return UA_DateTime UTC with microsecond resolution
+ */
+static UA_DateTime ua_datetime_from_mono_us(uint64_t mono_us) {
+    return UA_DATETIME_UNIX_EPOCH + (UA_DateTime)timebase_to_utc_us(mono_us) * UA_DATETIME_USEC;
+}
+
+/**
+ * @brief Set the timestamps of a DataValue from cache timestamps
+ * 
+ * Both are flagged as present, otherwise the server replaces them with
+ * the time of the read. The server timestamp is the cache update time.
+ * 
+ * @param dataValue DataValue being filled by a read callback
+ * @param sourceTimeStamp Whether the source timestamp was requested
+ * @param source_us Source timestamp (0 = unknown)
+ * @param server_us Server timestamp (0 = unknown)
+ */
+static void set_timestamps(UA_DataValue *dataValue, UA_Boolean sourceTimeStamp,
+                           uint64_t source_us, uint64_t server_us) {
+    if (sourceTimeStamp && source_us > 0) {
+        dataValue->sourceTimestamp = ua_datetime_from_mono_us(source_us);
+        dataValue->hasSourceTimestamp = true;
+    }
+    if (server_us > 0) {
+        dataValue->serverTimestamp = ua_datetime_from_mono_us(server_us);
+        dataValue->hasServerTimestamp = true;
+    }
+}
+
 /**
  * @brief OPC UA read callback for discrete inputs (uses cache)
  * 
  * This function is called when OPC UA clients read the discrete inputs variable.
- * It retrieves values from the I/O cache instead of accessing hardware directly.
+ * It retrieves values from the shared cache snapshot instead of accessing hardware directly.
  * 
  * @param server OPC UA server instance
  * @param sessionId Client session ID
@@ -146,20 +541,22 @@ readDiscreteInputs(UA_Server *server,
                   const UA_NodeId *nodeId, void *nodeContext,
                   UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
                   UA_DataValue *dataValue) {
-    // Use cache instead of direct reading
-    uint64_t source_ts = 0, server_ts = 0;
-    UA_UInt16 inputs = io_cache_get_discrete_inputs(&source_ts, &server_ts);
+    // Use cache snapshot instead of direct reading (hardware read if older than maxAge)
+    const io_cache_snapshot_t *snap = get_read_snapshot_max_age(server, IO_REFRESH_INPUTS, 0);
+    uint64_t source_ts = snap->inputs_timestamp_us;
+    UA_UInt16 inputs = snap->discrete_inputs;
     
     UA_Variant_setScalarCopy(&dataValue->value, &inputs,
                            &UA_TYPES[UA_TYPES_UINT16]);
     
     // Set timestamps if requested
-    if (sourceTimeStamp && source_ts > 0) {
-        dataValue->sourceTimestamp = UA_DateTime_fromUnixTime((UA_Int64)(source_ts / 1000));
-    }
+    set_timestamps(dataValue, sourceTimeStamp, source_ts, snap->inputs_server_timestamp_us);
+    
+    set_quality_status(dataValue, inputs_quality(snap, timebase_now_us()));
     
     dataValue->hasValue = true;
-    ESP_LOGD(TAG, "Inputs from cache: 0x%04X (source ts: %llu)", inputs, source_ts);
+    ESP_LOGD(TAG, "Inputs from cache: 0x%04X (source ts: %llu)", inputs,
+             (unsigned long long)source_ts);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -167,7 +564,7 @@ readDiscreteInputs(UA_Server *server,
  * @brief OPC UA read callback for discrete outputs (uses cache)
  * 
  * This function is called when OPC UA clients read the discrete outputs variable.
- * It retrieves values from the I/O cache instead of accessing hardware directly.
+ * It retrieves values from the shared cache snapshot instead of accessing hardware directly.
  * 
  * @param server OPC UA server instance
  * @param sessionId Client session ID
@@ -185,20 +582,23 @@ readDiscreteOutputs(UA_Server *server,
                    const UA_NodeId *nodeId, void *nodeContext,
                    UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
                    UA_DataValue *dataValue) {
-    // Use cache instead of direct reading
-    uint64_t source_ts = 0, server_ts = 0;
-    UA_UInt16 outputs = io_cache_get_discrete_outputs(&source_ts, &server_ts);
+    // Use cache snapshot instead of direct reading
+    const io_cache_snapshot_t *snap = get_read_snapshot();
+    uint64_t source_ts = snap->outputs_timestamp_us;
+    UA_UInt16 outputs = snap->discrete_outputs;
     
     UA_Variant_setScalarCopy(&dataValue->value, &outputs,
                            &UA_TYPES[UA_TYPES_UINT16]);
     
     // Set timestamps if requested
-    if (sourceTimeStamp && source_ts > 0) {
-        dataValue->sourceTimestamp = UA_DateTime_fromUnixTime((UA_Int64)(source_ts / 1000));
-    }
+    set_timestamps(dataValue, sourceTimeStamp, source_ts, snap->outputs_server_timestamp_us);
+    
+    // Last queued write could not be applied: value is the last known state
+    set_quality_status(dataValue, (io_quality_t)snap->outputs_quality);
     
     dataValue->hasValue = true;
-    ESP_LOGD(TAG, "Outputs from cache: 0x%04X (source ts: %llu)", outputs, source_ts);
+    ESP_LOGD(TAG, "Outputs from cache: 0x%04X (source ts: %llu)", outputs,
+             (unsigned long long)source_ts);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -206,7 +606,9 @@ readDiscreteOutputs(UA_Server *server,
  * @brief OPC UA write callback for discrete outputs
  * 
  * This function is called when OPC UA clients write to the discrete outputs variable.
- * It updates both the hardware and the cache.
+ * The value is queued for the polling task, which writes the hardware at its
+ * next I/O slot and then updates the cache. The OPC UA task never waits for
+ * the I2C bus.
  * 
  * @param server OPC UA server instance
  * @param sessionId Client session ID
@@ -226,19 +628,75 @@ writeDiscreteOutputs(UA_Server *server,
         data->value.type == &UA_TYPES[UA_TYPES_UINT16]) {
         UA_UInt16 outputs = *(UA_UInt16*)data->value.data;
         
-        // 1. Update physical device (slow)
-        write_discrete_outputs_slow((uint16_t)outputs);
-        
-        // 2. Update cache with current timestamp
-        uint64_t timestamp_ms = (uint64_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
-        io_cache_update_discrete_outputs((uint16_t)outputs, timestamp_ms);
+        // Hand over to the polling task (coalesced, written at next I/O slot)
+        io_polling_request_outputs(0xFFFF, (uint16_t)outputs);
         
-        ESP_LOGD(TAG, "Outputs written: 0x%04X (ts: %llu)", (uint16_t)outputs, timestamp_ms);
+        ESP_LOGD(TAG, "Outputs queued: 0x%04X", (uint16_t)outputs);
         return UA_STATUSCODE_GOOD;
     }
     return UA_STATUSCODE_BADTYPEMISMATCH;
 }
 
+#ifdef CONFIG_A16_OPCUA_PUSH_MODE
+/** Set while the OPC UA task writes pushed values into its own nodes */
+static bool push_writing = false;
+
+/**
+ * @brief Value callback forwarding client writes of the outputs node (push mode)
+ * 
+ * The server has already stored the written value in the node; the request
+ * is queued like writeDiscreteOutputs(). The applied value (or the failure
+ * status) is pushed back once the polling task has written the hardware.
+ */
+static void
+pushWriteDiscreteOutputs(UA_Server *server,
+                         const UA_NodeId *sessionId, void *sessionContext,
+                         const UA_NodeId *nodeId, void *nodeContext,
+                         const UA_NumericRange *range, const UA_DataValue *data) {
+    if (push_writing) {
+        return;
+    }
+    writeDiscreteOutputs(server, sessionId, sessionContext, nodeId, nodeContext, range, data);
+}
+#endif
+
+/**
+ * @brief Add an I/O variable below the Objects folder
+ * 
+ * Creates a data source variable. In push mode the node is value-backed
+ * instead (initial value zero), model_push_changes() keeps it current and
+ * the data source is not used; a write callback must then be installed by
+ * the caller as value callback.
+ * 
+ * @param server OPC UA server instance
+ * @param nodeId Node ID of the new variable
+ * @param browseName Browse name of the new variable
+ * @param typeDefinition Variable type
+ * @param attr Variable attributes (dataType must be set)
+ * @param dataSource Data source callbacks
+ * @param nodeContext Context passed to the callbacks
+ * @return UA_StatusCode Status of the node creation
+ */
+static UA_StatusCode
+add_io_variable(UA_Server *server, const UA_NodeId nodeId,
+                const UA_QualifiedName browseName, const UA_NodeId typeDefinition,
+                UA_VariableAttributes attr, UA_DataSource dataSource, void *nodeContext) {
+    UA_NodeId parentNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId parentReferenceNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+#ifdef CONFIG_A16_OPCUA_PUSH_MODE
+    static const uint64_t zero = 0;
+    (void)dataSource;
+    UA_Variant_setScalar(&attr.value, (void *)&zero, UA_findDataType(&attr.dataType));
+    return UA_Server_addVariableNode(server, nodeId, parentNodeId, parentReferenceNodeId,
+                                     browseName, typeDefinition, attr, nodeContext, NULL);
+#else
+    return UA_Server_addDataSourceVariableNode(server, nodeId, parentNodeId,
+                                               parentReferenceNodeId, browseName,
+                                               typeDefinition, attr, dataSource,
+                                               nodeContext, NULL);
+#endif
+}
+
 /**
  * @brief Add discrete I/O variables to OPC UA server
  * 
@@ -263,14 +721,10 @@ addDiscreteIOVariables(UA_Server *server) {
     
     UA_NodeId inputNodeId = UA_NODEID_STRING(1, "discrete_inputs");
     UA_QualifiedName inputName = UA_QUALIFIEDNAME(1, "Discrete Inputs");
-    UA_NodeId parentNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
-    UA_NodeId parentReferenceNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
     UA_NodeId variableTypeNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
     
-    UA_Server_addDataSourceVariableNode(server, inputNodeId, parentNodeId,
-                                        parentReferenceNodeId, inputName,
-                                        variableTypeNodeId, inputAttr,
-                                        inputDataSource, NULL, NULL);
+    add_io_variable(server, inputNodeId, inputName, variableTypeNodeId,
+                    inputAttr, inputDataSource, NULL);
     
     // 2. Variable for outputs (read/write)
     UA_VariableAttributes outputAttr = UA_VariableAttributes_default;
@@ -286,14 +740,151 @@ addDiscreteIOVariables(UA_Server *server) {
     UA_NodeId outputNodeId = UA_NODEID_STRING(1, "discrete_outputs");
     UA_QualifiedName outputName = UA_QUALIFIEDNAME(1, "Discrete Outputs");
     
-    UA_Server_addDataSourceVariableNode(server, outputNodeId, parentNodeId,
-                                        parentReferenceNodeId, outputName,
-                                        variableTypeNodeId, outputAttr,
-                                        outputDataSource, NULL, NULL);
+    add_io_variable(server, outputNodeId, outputName, variableTypeNodeId,
+                    outputAttr, outputDataSource, NULL);
+#ifdef CONFIG_A16_OPCUA_PUSH_MODE
+    UA_ValueCallback outputCallback = { .onRead = NULL, .onWrite = pushWriteDiscreteOutputs };
+    UA_Server_setVariableNode_valueCallback(server, outputNodeId, outputCallback);
+#endif
     
     ESP_LOGI(TAG, "Discrete I/O variables added to OPC UA server (with caching)");
 }
 
+/* ============================================================================
+ * DISCRETE INPUT EDGE COUNTERS
+ * ============================================================================ */
+
+/** Variable published per input counter */
+typedef enum {
+    COUNTER_FIELD_RISING = 0,
+    COUNTER_FIELD_FALLING,
+    COUNTER_FIELD_PERIOD,
+    COUNTER_FIELD_FREQUENCY,
+    COUNTER_FIELD_NUM
+} counter_field_t;
+
+static const char *const counter_field_names[COUNTER_FIELD_NUM] = {
+    "RisingEdges", "FallingEdges", "PeriodUs", "FrequencyHz"
+};
+
+static const char *const counter_field_ids[COUNTER_FIELD_NUM] = {
+    "rising", "falling", "period", "frequency"
+};
+
+/** Counter copy shared by the reads of one server iteration */
+static io_counter_t counter_copy[IO_NUM_COUNTERS];
+
+/**
+ * @brief OPC UA read callback for one edge counter variable
+ * 
+ * @param nodeContext Input index * COUNTER_FIELD_NUM + field
+ */
+static UA_StatusCode
+readCounterValue(UA_Server *server,
+                 const UA_NodeId *sessionId, void *sessionContext,
+                 const UA_NodeId *nodeId, void *nodeContext,
+                 UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+                 UA_DataValue *dataValue) {
+    uint32_t ctx = (uint32_t)(uintptr_t)nodeContext;
+    uint32_t input = ctx / COUNTER_FIELD_NUM;
+    counter_field_t field = (counter_field_t)(ctx % COUNTER_FIELD_NUM);
+    
+    if (input >= IO_NUM_COUNTERS) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    if (!counter_copy_valid) {
+        io_cache_get_counters(counter_copy);
+        counter_copy_valid = true;
+    }
+    const io_counter_t *c = &counter_copy[input];
+    
+    UA_UInt64 count;
+    UA_Double value;
+    switch (field) {
+    case COUNTER_FIELD_RISING:
+    case COUNTER_FIELD_FALLING:
+        count = (field == COUNTER_FIELD_RISING) ? c->rising : c->falling;
+        UA_Variant_setScalarCopy(&dataValue->value, &count, &UA_TYPES[UA_TYPES_UINT64]);
+        break;
+    case COUNTER_FIELD_PERIOD:
+        value = c->period_us;
+        UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+        break;
+    default:
+        value = io_counter_frequency_hz(c, timebase_now_us());
+        UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+        break;
+    }
+    
+    // Full resolution edge time, so clients can rate counts by source timestamps
+    if (sourceTimeStamp && c->last_edge_us > 0) {
+        dataValue->sourceTimestamp = ua_datetime_from_mono_us(c->last_edge_us);
+        dataValue->hasSourceTimestamp = true;
+    }
+    
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+/**
+ * @brief Add the discrete input edge counters to OPC UA server
+ * 
+ * @param server OPC UA server instance
+ */
+void addCounterVariables(UA_Server *server) {
+    UA_NodeId countersId = UA_NODEID_STRING(1, "counters");
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    oattr.displayName = UA_LOCALIZEDTEXT("en-US", "Counters");
+    oattr.description = UA_LOCALIZEDTEXT("en-US", "Edge counters and pulse frequency of the discrete inputs");
+    UA_StatusCode ret = UA_Server_addObjectNode(server, countersId,
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                                UA_QUALIFIEDNAME(1, "Counters"),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                                oattr, NULL, NULL);
+    if (ret != UA_STATUSCODE_GOOD) {
+        ESP_LOGE(TAG, "Failed to add Counters object: %s", UA_StatusCode_name(ret));
+        return;
+    }
+    
+    UA_DataSource counterSource = { .read = readCounterValue, .write = NULL };
+    for (int input = 0; input < IO_NUM_COUNTERS; input++) {
+        char name[8];
+        char inputIdStr[24];
+        snprintf(name, sizeof(name), "DI%d", input + 1);
+        snprintf(inputIdStr, sizeof(inputIdStr), "counter_di%d", input + 1);
+        
+        UA_NodeId inputId = UA_NODEID_STRING(1, inputIdStr);
+        oattr.displayName = UA_LOCALIZEDTEXT("en-US", name);
+        oattr.description = UA_LOCALIZEDTEXT("en-US", "");
+        UA_Server_addObjectNode(server, inputId, countersId,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                UA_QUALIFIEDNAME(1, name),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oattr, NULL, NULL);
+        
+        for (int field = 0; field < COUNTER_FIELD_NUM; field++) {
+            char nodeIdStr[40];
+            snprintf(nodeIdStr, sizeof(nodeIdStr), "%s_%s", inputIdStr, counter_field_ids[field]);
+            
+            UA_VariableAttributes attr = UA_VariableAttributes_default;
+            attr.displayName = UA_LOCALIZEDTEXT("en-US", (char *)counter_field_names[field]);
+            attr.dataType = (field <= COUNTER_FIELD_FALLING) ? UA_TYPES[UA_TYPES_UINT64].typeId
+                                                             : UA_TYPES[UA_TYPES_DOUBLE].typeId;
+            attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+            
+            UA_Server_addDataSourceVariableNode(server, UA_NODEID_STRING(1, nodeIdStr), inputId,
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                                UA_QUALIFIEDNAME(1, (char *)counter_field_names[field]),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                                attr, counterSource,
+                                                (void *)(uintptr_t)(input * COUNTER_FIELD_NUM + field), NULL);
+        }
+    }
+    
+    ESP_LOGI(TAG, "Edge counters added for %d discrete inputs", IO_NUM_COUNTERS);
+}
+
 /* ============================================================================
  * MAIN INIT FUNCTION
  * ============================================================================ */
@@ -499,78 +1090,460 @@ readLoopbackOutput(UA_Server *server,
 static uint16_t adc_cache[NUM_ADC_CHANNELS] = {0};
 static adc_oneshot_unit_handle_t adc1_handle = NULL;
 static bool adc_initialized = false;
-static uint64_t adc_timestamps_ms[NUM_ADC_CHANNELS] = {0};
-static uint64_t adc_server_timestamps_ms[NUM_ADC_CHANNELS] = {0};
 
 /**
- * @brief Initialize ADC hardware
+ * Filter stage between acquisition and the I/O cache, one per channel.
+ * The lock only guards copying a filter in or out; adc_filter_gen counts
+ * adc_set_filter() calls, so a filter replaced while a copy was being
+ * processed is not overwritten with the old state.
+ */
+static adc_filter_t adc_filters[NUM_ADC_CHANNELS];
+static uint32_t adc_filter_gen[NUM_ADC_CHANNELS];
+static portMUX_TYPE adc_filter_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if defined(CONFIG_A16_ADC_FILTER_MOVING_AVERAGE)
+#define ADC_FILTER_DEFAULT_TYPE   ADC_FILTER_MOVING_AVERAGE
+#define ADC_FILTER_DEFAULT_PARAM  CONFIG_A16_ADC_FILTER_WINDOW
+#elif defined(CONFIG_A16_ADC_FILTER_MEDIAN)
+#define ADC_FILTER_DEFAULT_TYPE   ADC_FILTER_MEDIAN
+#define ADC_FILTER_DEFAULT_PARAM  CONFIG_A16_ADC_FILTER_WINDOW
+#elif defined(CONFIG_A16_ADC_FILTER_IIR)
+#define ADC_FILTER_DEFAULT_TYPE   ADC_FILTER_IIR
+#define ADC_FILTER_DEFAULT_PARAM  CONFIG_A16_ADC_FILTER_IIR_SHIFT
+#else
+#define ADC_FILTER_DEFAULT_TYPE   ADC_FILTER_NONE
+#define ADC_FILTER_DEFAULT_PARAM  0
+#endif
+
+/** Hardware channel of each logical ADC channel */
+static const adc_channel_t adc_channel_ids[NUM_ADC_CHANNELS] = {
+    OUR_ADC_CHANNEL_1,  // GPIO4
+    OUR_ADC_CHANNEL_2,  // GPIO6
+    OUR_ADC_CHANNEL_3,  // GPIO7
+    OUR_ADC_CHANNEL_4,  // GPIO5
+};
+
+#define ADC_LUT_SIZE              4096  /**< One entry per 12-bit code */
+#define ADC_IDEAL_FULL_SCALE_MV   3100  /**< Approximate 12 dB full scale when eFuse calibration is missing */
+
+/** UNECE CEFACT unit codes (OPC UA EUInformation.unitId) */
+#define UNIT_ID_VOLT         0x564C54   /* "VLT" */
+#define UNIT_ID_MILLIAMPERE  0x00344B   /* "4K" */
+
+/**
+ * @brief Linear scaling of one analog input
  * 
- * Configures the ESP32 ADC unit and 4 analog input channels for
- * the KC868-A16v3 controller.
+ * Maps the calibrated pin voltage to the value at the terminal. The pin
+ * voltages at the range ends depend on the input divider / shunt of the
+ * board and can be adjusted here.
  */
-void adc_init(void) {
-    if (adc1_handle != NULL) {
-        return;
-    }
+typedef struct {
+    const char *unit;      /**< Engineering unit display name */
+    const char *unit_desc; /**< Engineering unit description */
+    int32_t unit_id;       /**< UNECE CEFACT unit code */
+    float mv_low;          /**< Pin voltage at eu_low (mV) */
+    float mv_high;         /**< Pin voltage at eu_high (mV) */
+    float eu_low;          /**< Engineering value at the low range end */
+    float eu_high;         /**< Engineering value at the high range end */
+} adc_scaling_t;
+
+static const adc_scaling_t adc_scaling[NUM_ADC_CHANNELS] = {
+    { "V",  "volt",        UNIT_ID_VOLT,        0.0f,   3000.0f, 0.0f, 5.0f  },  // ANALOG_A1: 0-5 V
+    { "V",  "volt",        UNIT_ID_VOLT,        0.0f,   3000.0f, 0.0f, 5.0f  },  // ANALOG_A2: 0-5 V
+    { "mA", "milliampere", UNIT_ID_MILLIAMPERE, 600.0f, 3000.0f, 4.0f, 20.0f },  // ANALOG_A3: 4-20 mA
+    { "mA", "milliampere", UNIT_ID_MILLIAMPERE, 600.0f, 3000.0f, 4.0f, 20.0f },  // ANALOG_A4: 4-20 mA
+};
+
+/** Calibrated pin voltage (mV) per raw code, shared by all channels (same unit and attenuation) */
+static uint16_t adc_mv_lut[ADC_LUT_SIZE];
+/** Per-channel engineering value = mV * gain + offset */
+static float adc_eu_gain[NUM_ADC_CHANNELS];
+static float adc_eu_offset[NUM_ADC_CHANNELS];
+static bool adc_calibrated = false;
+
+/**
+ * @brief Build the raw code to engineering unit tables
+ * 
+ * Runs the adc_cali curve fitting scheme (eFuse coefficients, corrects
+ * the ESP32-S3 nonlinearity) once for every code, so later conversions
+ * are a table lookup plus one multiply-add. Falls back to an ideal
+ * linear curve if the chip has no calibration data.
+ */
+static void adc_calibration_init(void) {
+    adc_cali_handle_t cali = NULL;
     
-    // ADC unit configuration
-    adc_oneshot_unit_init_cfg_t init_config = {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cali_config = {
         .unit_id = ADC_UNIT_1,
-    };
-    ESP_ERROR_CHECK(adc_oneshot_new_unit(&init_config, &adc1_handle));
-    
-    // Channel configuration
-    adc_oneshot_chan_cfg_t config = {
+        .chan = adc_channel_ids[0],
         .atten = ADC_ATTEN_DB_12,
         .bitwidth = ADC_BITWIDTH_12,
     };
+    if (adc_cali_create_scheme_curve_fitting(&cali_config, &cali) != ESP_OK) {
+        cali = NULL;
+    }
+#endif
     
-    // Configure 4 channels
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, OUR_ADC_CHANNEL_1, &config)); // GPIO4
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, OUR_ADC_CHANNEL_2, &config)); // GPIO6  
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, OUR_ADC_CHANNEL_3, &config)); // GPIO7
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, OUR_ADC_CHANNEL_4, &config)); // GPIO5
+    for (int code = 0; code < ADC_LUT_SIZE; code++) {
+        int mv = 0;
+        if (cali == NULL || adc_cali_raw_to_voltage(cali, code, &mv) != ESP_OK) {
+            mv = code * ADC_IDEAL_FULL_SCALE_MV / (ADC_LUT_SIZE - 1);
+        }
+        adc_mv_lut[code] = (uint16_t)mv;
+    }
     
-    adc_initialized = true;
-    ESP_LOGI(TAG, "ADC initialized with oneshot driver (4 channels)");
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    if (cali != NULL) {
+        adc_cali_delete_scheme_curve_fitting(cali);
+    }
+#endif
+    
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        const adc_scaling_t *s = &adc_scaling[i];
+        adc_eu_gain[i] = (s->eu_high - s->eu_low) / (s->mv_high - s->mv_low);
+        adc_eu_offset[i] = s->eu_low - adc_eu_gain[i] * s->mv_low;
+    }
+    
+    adc_calibrated = true;
+    if (cali != NULL) {
+        ESP_LOGI(TAG, "ADC calibration: curve fitting, full scale %u mV", adc_mv_lut[ADC_LUT_SIZE - 1]);
+    } else {
+        ESP_LOGW(TAG, "ADC calibration data not available, using ideal %d mV full scale",
+                 ADC_IDEAL_FULL_SCALE_MV);
+    }
 }
 
 /**
- * @brief Read ADC channel from hardware (slow)
+ * @brief Convert an ADC code to calibrated pin voltage
  * 
- * Performs direct hardware read of a specific ADC channel.
+ * Filtered codes are fractional; they are interpolated between the two
+ * neighbouring table entries.
  * 
- * @param channel ADC channel number (0-3)
- * @return uint16_t Raw ADC value (0-4095)
+ * @param code ADC code (0-4095, may be fractional)
+ * @return float Pin voltage in mV
  */
-uint16_t read_adc_channel_slow(uint8_t channel) {
-    if (adc1_handle == NULL || channel >= NUM_ADC_CHANNELS) {
-        return 0;
+float adc_code_to_mv(float code) {
+    if (!(code > 0.0f)) {
+        return adc_mv_lut[0];
+    }
+    if (code >= (float)(ADC_LUT_SIZE - 1)) {
+        return adc_mv_lut[ADC_LUT_SIZE - 1];
     }
     
-    adc_channel_t channel_id;
-    switch(channel) {
-        case 0: channel_id = OUR_ADC_CHANNEL_1; break;  // GPIO4
-        case 1: channel_id = OUR_ADC_CHANNEL_2; break;  // GPIO6
-        case 2: channel_id = OUR_ADC_CHANNEL_3; break;  // GPIO7
-        case 3: channel_id = OUR_ADC_CHANNEL_4; break;  // GPIO5
-        default: return 0;
+    int i = (int)code;
+    float frac = code - (float)i;
+    return (float)adc_mv_lut[i] + ((float)adc_mv_lut[i + 1] - (float)adc_mv_lut[i]) * frac;
+}
+
+/**
+ * @brief Convert an ADC code to the engineering value of a channel
+ * 
+ * @param channel ADC channel number (0-3)
+ * @param code ADC code (0-4095, may be fractional)
+ * @return float Engineering value (e.g. V or mA), 0 for an invalid channel
+ */
+float adc_code_to_eu(uint8_t channel, float code) {
+    if (channel >= NUM_ADC_CHANNELS) {
+        return 0.0f;
+    }
+    return adc_code_to_mv(code) * adc_eu_gain[channel] + adc_eu_offset[channel];
+}
+
+/**
+ * @brief Run acquired values of all channels through their filters
+ * 
+ * Channels without a new value are not filtered: feeding their old value
+ * again would count it twice in the filter history. Their out[] entry is
+ * the unfiltered input, which the I/O cache discards.
+ * 
+ * Each filter is processed on a local copy outside the critical section,
+ * which keeps interrupts masked only for the copies. Called by one task
+ * (the polling task or the ADC consumer task).
+ * 
+ * @param in Acquired values, one per channel (ADC codes times 1/scale)
+ * @param ok Channels with a new value in in[]
+ * @param scale Factor converting in[] (and the filter output) to ADC codes
+ * @param out Filtered values in ADC codes, one per channel
+ */
+static void adc_apply_filters(const uint16_t in[NUM_ADC_CHANNELS], const bool ok[NUM_ADC_CHANNELS],
+                              float scale, float out[NUM_ADC_CHANNELS]) {
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        if (!ok[i]) {
+            out[i] = in[i] * scale;
+            continue;
+        }
+        
+        adc_filter_t f;
+        portENTER_CRITICAL(&adc_filter_lock);
+        f = adc_filters[i];
+        uint32_t gen = adc_filter_gen[i];
+        portEXIT_CRITICAL(&adc_filter_lock);
+        
+        out[i] = adc_filter_process(&f, in[i]) * scale;
+        
+        // A filter set meanwhile wins; it starts with the next value
+        portENTER_CRITICAL(&adc_filter_lock);
+        if (adc_filter_gen[i] == gen) {
+            adc_filters[i] = f;
+        }
+        portEXIT_CRITICAL(&adc_filter_lock);
+    }
+}
+
+/**
+ * @brief Change the filter of one ADC channel
+ * 
+ * The filter history is cleared; the next acquired value starts the new
+ * filter.
+ * 
+ * @param channel ADC channel number (0-3)
+ * @param type Filter type
+ * @param param Window length (moving average, median) or IIR shift
+ * @return true if the channel number is valid
+ */
+bool adc_set_filter(uint8_t channel, adc_filter_type_t type, uint8_t param) {
+    if (channel >= NUM_ADC_CHANNELS) {
+        return false;
     }
     
-    int raw = 0;
-    ESP_ERROR_CHECK(adc_oneshot_read(adc1_handle, channel_id, &raw));
+    adc_filter_t f;
+    adc_filter_init(&f, type, param);
     
-    // Return raw value (0-4095)
-    return (uint16_t)raw;
+    portENTER_CRITICAL(&adc_filter_lock);
+    adc_filters[channel] = f;
+    adc_filter_gen[channel]++;
+    portEXIT_CRITICAL(&adc_filter_lock);
+    
+    ESP_LOGI(TAG, "ADC%d filter: %s (%u)", channel + 1, adc_filter_type_name(type), param);
+    return true;
+}
+
+#ifdef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+
+#define ADC_CONV_FRAME_SIZE     256   /**< Bytes per DMA conversion frame (64 results) */
+#define ADC_STORE_BUF_SIZE      1024  /**< Driver pool between DMA and the consumer task */
+#define ADC_AVG_FRAC_BITS       4     /**< Fraction bits kept from averaging (4095 << 4 fits in 16 bits) */
+
+static adc_continuous_handle_t adc_cont_handle = NULL;
+
+/**
+ * @brief Map a hardware ADC channel to its logical channel
+ * 
+ * @param hw_channel Channel number from a DMA conversion result
+ * @return int Logical channel (0-3), or -1 if not one of ours
+ */
+static int adc_channel_index(uint32_t hw_channel) {
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        if ((uint32_t)adc_channel_ids[i] == hw_channel) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief ADC consumer task (continuous backend)
+ * 
+ * Drains DMA conversion frames, accumulates per-channel sums and publishes
+ * the averages to the I/O cache once per CONFIG_A16_ADC_PUBLISH_INTERVAL_MS.
+ * Averaging N conversions lowers the noise by about sqrt(N) and the values
+ * keep their fractional part in the float cache.
+ * 
+ * @param pvParameters Task parameters (not used)
+ */
+static void adc_consumer_task(void *pvParameters) {
+    static uint8_t frame[ADC_CONV_FRAME_SIZE];
+    uint32_t sum[NUM_ADC_CHANNELS] = {0};
+    uint32_t count[NUM_ADC_CHANNELS] = {0};
+    uint16_t averages[NUM_ADC_CHANNELS] = {0};
+    float values[NUM_ADC_CHANNELS];
+    bool ok[NUM_ADC_CHANNELS];
+    const TickType_t window = pdMS_TO_TICKS(CONFIG_A16_ADC_PUBLISH_INTERVAL_MS);
+    TickType_t window_start = xTaskGetTickCount();
+    uint64_t window_start_us = timebase_now_us();
+    
+    while (1) {
+        uint32_t len = 0;
+        esp_err_t err = adc_continuous_read(adc_cont_handle, frame, sizeof(frame), &len,
+                                            CONFIG_A16_ADC_PUBLISH_INTERVAL_MS);
+        if (err == ESP_OK) {
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&frame[i];
+                int idx = adc_channel_index(p->type2.channel);
+                if (idx >= 0) {
+                    sum[idx] += p->type2.data;
+                    count[idx]++;
+                }
+            }
+        } else if (err != ESP_ERR_TIMEOUT) {
+            ESP_LOGW(TAG, "adc_continuous_read failed: %s", esp_err_to_name(err));
+        }
+        
+        TickType_t now = xTaskGetTickCount();
+        if (now - window_start < window) {
+            continue;
+        }
+        window_start = now;
+        // The averages belong to the middle of the window
+        uint64_t now_us = timebase_now_us();
+        uint64_t sample_us = window_start_us + (now_us - window_start_us) / 2;
+        window_start_us = now_us;
+        
+        for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+            ok[i] = count[i] > 0;
+            if (count[i] > 0) {
+                // Channels without samples in this window keep the last average (quality drops)
+                averages[i] = (uint16_t)((((uint64_t)sum[i] << ADC_AVG_FRAC_BITS) + count[i] / 2) / count[i]);
+                adc_cache[i] = (uint16_t)((averages[i] + (1u << (ADC_AVG_FRAC_BITS - 1))) >> ADC_AVG_FRAC_BITS);
+            }
+            ESP_LOGV(TAG, "ADC%d: %lu samples averaged", i + 1, (unsigned long)count[i]);
+            sum[i] = 0;
+            count[i] = 0;
+        }
+        
+        adc_apply_filters(averages, ok, 1.0f / (1 << ADC_AVG_FRAC_BITS), values);
+        io_cache_update_all_adc_channels(values, ok, sample_us);
+    }
+}
+
+/**
+ * @brief Start continuous DMA acquisition of all ADC channels
+ */
+static void adc_continuous_start_all(void) {
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = ADC_STORE_BUF_SIZE,
+        .conv_frame_size = ADC_CONV_FRAME_SIZE,
+    };
+    ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_config, &adc_cont_handle));
+    
+    adc_digi_pattern_config_t pattern[NUM_ADC_CHANNELS];
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        pattern[i] = (adc_digi_pattern_config_t){
+            .atten = ADC_ATTEN_DB_12,
+            .channel = adc_channel_ids[i],
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+    }
+    
+    adc_continuous_config_t config = {
+        .pattern_num = NUM_ADC_CHANNELS,
+        .adc_pattern = pattern,
+        .sample_freq_hz = CONFIG_A16_ADC_SAMPLE_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    ESP_ERROR_CHECK(adc_continuous_config(adc_cont_handle, &config));
+    ESP_ERROR_CHECK(adc_continuous_start(adc_cont_handle));
+    
+    xTaskCreatePinnedToCore(adc_consumer_task, "adc_consumer", 3072, NULL, 7, NULL, 1);
+}
+
+#endif /* CONFIG_A16_ADC_BACKEND_CONTINUOUS */
+
+/**
+ * @brief Initialize ADC hardware
+ * 
+ * Configures the ESP32 ADC unit and 4 analog input channels for
+ * the KC868-A16v3 controller. With the continuous backend this starts
+ * DMA sampling and the averaging consumer task instead.
+ */
+void adc_init(void) {
+    if (adc_initialized) {
+        return;
+    }
+    
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        adc_filter_init(&adc_filters[i], ADC_FILTER_DEFAULT_TYPE, ADC_FILTER_DEFAULT_PARAM);
+    }
+    adc_calibration_init();
+    
+#ifdef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+    adc_continuous_start_all();
+    adc_initialized = true;
+    ESP_LOGI(TAG, "ADC initialized with continuous driver (4 channels, %d Hz total, %d ms average, filter: %s)",
+             CONFIG_A16_ADC_SAMPLE_FREQ_HZ, CONFIG_A16_ADC_PUBLISH_INTERVAL_MS,
+             adc_filter_type_name(ADC_FILTER_DEFAULT_TYPE));
+#else
+    // ADC unit configuration
+    adc_oneshot_unit_init_cfg_t init_config = {
+        .unit_id = ADC_UNIT_1,
+    };
+    ESP_ERROR_CHECK(adc_oneshot_new_unit(&init_config, &adc1_handle));
+    
+    // Channel configuration
+    adc_oneshot_chan_cfg_t config = {
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    
+    // Configure 4 channels
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, adc_channel_ids[i], &config));
+    }
+    
+    adc_initialized = true;
+    ESP_LOGI(TAG, "ADC initialized with oneshot driver (4 channels, filter: %s)",
+             adc_filter_type_name(ADC_FILTER_DEFAULT_TYPE));
+#endif
+}
+
+#ifndef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+/**
+ * @brief One oneshot conversion, reporting failures
+ * 
+ * @param channel ADC channel number (0-3)
+ * @param raw Receives the raw value (0-4095, untouched on failure)
+ * @return true if the conversion succeeded
+ */
+static bool adc_read_oneshot(uint8_t channel, uint16_t *raw) {
+    if (adc1_handle == NULL || channel >= NUM_ADC_CHANNELS) {
+        return false;
+    }
+    
+    int value = 0;
+    esp_err_t ret = adc_oneshot_read(adc1_handle, adc_channel_ids[channel], &value);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "ADC%d read failed: %s", channel + 1, esp_err_to_name(ret));
+        return false;
+    }
+    
+    *raw = (uint16_t)value;
+    return true;
+}
+#endif
+
+/**
+ * @brief Read ADC channel from hardware (slow)
+ * 
+ * Performs direct hardware read of a specific ADC channel.
+ * 
+ * @param channel ADC channel number (0-3)
+ * @return uint16_t Raw ADC value (0-4095)
+ */
+uint16_t read_adc_channel_slow(uint8_t channel) {
+#ifdef CONFIG_A16_ADC_BACKEND_CONTINUOUS
+    // Latest average from the consumer task; the DMA owns the ADC unit
+    return channel < NUM_ADC_CHANNELS ? adc_cache[channel] : 0;
+#else
+    uint16_t raw = 0;
+    adc_read_oneshot(channel, &raw);
+    return raw;
+#endif
 }
 
 /**
  * @brief Update all ADC channels from hardware
  * 
  * Reads all ADC channels, updates the local cache and the global I/O cache.
- * Used by the polling task to refresh ADC values.
+ * Used by the polling task to refresh ADC values. All channels are published
+ * to the I/O cache in one update so snapshots never mix two ADC cycles.
+ * 
+ * Does nothing with the continuous backend, whose consumer task publishes
+ * the averaged values itself.
  */
 void update_all_adc_channels_slow(void) {
+#ifndef CONFIG_A16_ADC_BACKEND_CONTINUOUS
     if (adc1_handle == NULL) {
         adc_init();
         if (adc1_handle == NULL) {
@@ -578,17 +1551,21 @@ void update_all_adc_channels_slow(void) {
         }
     }
     
-    uint64_t timestamp = (uint64_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    float values[NUM_ADC_CHANNELS];
+    bool ok[NUM_ADC_CHANNELS];
     
+    // A failed channel keeps its last raw value; it is not filtered and the cache discards it
+    uint64_t start_us = timebase_now_us();
     for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
-        uint16_t value = read_adc_channel_slow(i);
-        adc_cache[i] = value;
-        adc_timestamps_ms[i] = timestamp;
-        adc_server_timestamps_ms[i] = timestamp;
-        
-        // Also update global cache
-        io_cache_update_adc_channel(i, (float)value, timestamp);
+        ok[i] = adc_read_oneshot(i, &adc_cache[i]);
     }
+    // Channels are converted back to back: stamp the middle of the sweep
+    uint64_t timestamp = start_us + (timebase_now_us() - start_us) / 2;
+    adc_apply_filters(adc_cache, ok, 1.0f, values);
+    
+    // Also update global cache
+    io_cache_update_all_adc_channels(values, ok, timestamp);
+#endif
 }
 
 /**
@@ -621,7 +1598,7 @@ uint16_t* get_all_adc_channels_fast(void) {
  * @brief OPC UA read callback for ADC channel
  * 
  * Called when OPC UA clients read an ADC channel variable.
- * Returns cached ADC values with timestamp information.
+ * Returns the value from the shared cache snapshot with timestamp information.
  * 
  * @param server OPC UA server instance
  * @param sessionId Client session ID
@@ -644,21 +1621,148 @@ UA_StatusCode readAdcChannel(UA_Server *server,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
     
-    uint16_t value = adc_cache[channel];
+    const io_cache_snapshot_t *snap = get_read_snapshot_max_age(server, IO_REFRESH_ADC, channel);
+    uint16_t value = (uint16_t)snap->adc[channel];
     UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_UINT16]);
     
-    if (sourceTimeStamp && adc_timestamps_ms[channel] > 0) {
-        dataValue->sourceTimestamp = UA_DateTime_fromUnixTime((UA_Int64)(adc_timestamps_ms[channel] / 1000));
+    set_timestamps(dataValue, sourceTimeStamp, snap->adc_timestamps_us[channel],
+                   snap->adc_server_timestamps_us[channel]);
+    
+    set_quality_status(dataValue, adc_quality(snap, channel, timebase_now_us()));
+    
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+/**
+ * @brief OPC UA read callback for calibrated analog value
+ * 
+ * Converts the cached (filtered) ADC code of the channel to engineering
+ * units through the calibration table.
+ * 
+ * @param server OPC UA server instance
+ * @param sessionId Client session ID
+ * @param sessionContext Session context (not used)
+ * @param nodeId Node ID being read
+ * @param nodeContext Channel number stored as pointer
+ * @param sourceTimeStamp Whether to include source timestamp
+ * @param range Data range (not used)
+ * @param dataValue Pointer to store read data
+ * @return UA_StatusCode Status of read operation
+ */
+UA_StatusCode readAdcValue(UA_Server *server,
+                           const UA_NodeId *sessionId, void *sessionContext,
+                           const UA_NodeId *nodeId, void *nodeContext,
+                           UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+                           UA_DataValue *dataValue) {
+    uint8_t channel = (uintptr_t)nodeContext;
+    
+    if (channel >= NUM_ADC_CHANNELS || !adc_calibrated) {
+        return UA_STATUSCODE_BADINTERNALERROR;
     }
     
+    const io_cache_snapshot_t *snap = get_read_snapshot_max_age(server, IO_REFRESH_ADC, channel);
+    UA_Float value = adc_code_to_eu(channel, snap->adc[channel]);
+    UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_FLOAT]);
+    
+    set_timestamps(dataValue, sourceTimeStamp, snap->adc_timestamps_us[channel],
+                   snap->adc_server_timestamps_us[channel]);
+    
+    set_quality_status(dataValue, adc_quality(snap, channel, timebase_now_us()));
+    
     dataValue->hasValue = true;
     return UA_STATUSCODE_GOOD;
 }
 
+/**
+ * @brief Set a property of a variable, creating it if the type did not
+ * 
+ * @param server OPC UA server instance
+ * @param nodeId Variable owning the property
+ * @param name Browse name of the property (namespace 0)
+ * @param value Property value
+ */
+static void set_variable_property(UA_Server *server, const UA_NodeId nodeId,
+                                  const char *name, const UA_Variant *value) {
+    UA_QualifiedName qn = UA_QUALIFIEDNAME(0, (char *)name);
+    UA_BrowsePathResult bpr = UA_Server_browseSimplifiedBrowsePath(server, nodeId, 1, &qn);
+    
+    if (bpr.statusCode == UA_STATUSCODE_GOOD && bpr.targetsSize > 0) {
+        UA_Server_writeValue(server, bpr.targets[0].targetId.nodeId, *value);
+    } else {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        attr.displayName = UA_LOCALIZEDTEXT("", (char *)name);
+        attr.dataType = value->type->typeId;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        attr.value = *value;
+        UA_Server_addVariableNode(server, UA_NODEID_NULL, nodeId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY), qn,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                  attr, NULL, NULL);
+    }
+    UA_BrowsePathResult_clear(&bpr);
+}
+
+/**
+ * @brief Add calibrated analog variables (AnalogItemType)
+ * 
+ * One Float node per channel with EURange and EngineeringUnits, next to
+ * the raw code nodes. EURange also enables percent deadband monitoring.
+ * 
+ * @param server OPC UA server instance
+ */
+static void addAdcEngineeringVariables(UA_Server *server) {
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        const adc_scaling_t *s = &adc_scaling[i];
+        char browseName[16];
+        char nodeIdStr[32];
+        char description[64];
+        snprintf(browseName, sizeof(browseName), "ADC%d_EU", i + 1);
+        snprintf(nodeIdStr, sizeof(nodeIdStr), "adc_eu_%d", i + 1);
+        snprintf(description, sizeof(description), "Analog Input %d - Calibrated value (%s)", i + 1, s->unit);
+        
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        attr.displayName = UA_LOCALIZEDTEXT("en-US", browseName);
+        attr.description = UA_LOCALIZEDTEXT("en-US", description);
+        attr.dataType = UA_TYPES[UA_TYPES_FLOAT].typeId;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        
+        UA_DataSource dataSource;
+        dataSource.read = readAdcValue;
+        dataSource.write = NULL;
+        
+        UA_NodeId nodeId = UA_NODEID_STRING(1, nodeIdStr);
+        UA_StatusCode ret = add_io_variable(server, nodeId, UA_QUALIFIEDNAME(1, browseName),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_ANALOGITEMTYPE),
+                                            attr, dataSource, (void*)(uintptr_t)i);
+        if (ret != UA_STATUSCODE_GOOD) {
+            ESP_LOGE(TAG, "Failed to add %s: %s", browseName, UA_StatusCode_name(ret));
+            continue;
+        }
+        
+        UA_Range euRange;
+        euRange.low = s->eu_low;
+        euRange.high = s->eu_high;
+        UA_Variant v;
+        UA_Variant_setScalar(&v, &euRange, &UA_TYPES[UA_TYPES_RANGE]);
+        set_variable_property(server, nodeId, "EURange", &v);
+        
+        UA_EUInformation eu;
+        UA_EUInformation_init(&eu);
+        eu.namespaceUri = UA_STRING("http://www.opcfoundation.org/UA/units/un/cefact");
+        eu.unitId = s->unit_id;
+        eu.displayName = UA_LOCALIZEDTEXT("en-US", (char *)s->unit);
+        eu.description = UA_LOCALIZEDTEXT("en-US", (char *)s->unit_desc);
+        UA_Variant_setScalar(&v, &eu, &UA_TYPES[UA_TYPES_EUINFORMATION]);
+        set_variable_property(server, nodeId, "EngineeringUnits", &v);
+    }
+}
+
 /**
  * @brief Add ADC variables to OPC UA server
  * 
- * Creates OPC UA nodes for all 4 ADC channels in the server address space.
+ * Creates OPC UA nodes for all 4 ADC channels in the server address space:
+ * raw UInt16 codes and calibrated Float AnalogItemType values.
  * Each channel is represented as a separate read-only variable.
  * 
  * @param server OPC UA server instance
@@ -688,15 +1792,752 @@ void addAdcVariables(UA_Server *server) {
         
         UA_NodeId nodeId = UA_NODEID_STRING(1, nodeIdStr);
         UA_QualifiedName name = UA_QUALIFIEDNAME(1, channel_names[i]);
-        UA_NodeId parentNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
-        UA_NodeId parentReferenceNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
         UA_NodeId variableTypeNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
         
-        UA_Server_addDataSourceVariableNode(server, nodeId, parentNodeId,
-                                          parentReferenceNodeId, name,
-                                          variableTypeNodeId, attr,
-                                          dataSource, (void*)(uintptr_t)i, NULL);
+        add_io_variable(server, nodeId, name, variableTypeNodeId,
+                        attr, dataSource, (void*)(uintptr_t)i);
+    }
+    
+    addAdcEngineeringVariables(server);
+    
+    ESP_LOGI(TAG, "ADC variables added to OPC UA server (%d channels, raw codes and engineering units)", NUM_ADC_CHANNELS);
+}
+
+/* ============================================================================
+ * PUSH MODE (value-backed nodes fed from the I/O cache change queue)
+ * ============================================================================ */
+
+#ifdef CONFIG_A16_OPCUA_PUSH_MODE
+/** Events written per call, bounds the time spent before UA_Server_run_iterate() */
+#define PUSH_MAX_EVENTS_PER_ITERATION  32
+
+/** How often pushed inputs and ADC values are checked for staleness */
+#define PUSH_STALE_CHECK_MS  100
+
+static bool push_synced = false;
+static uint8_t push_inputs_quality;                     /**< Quality last pushed to the inputs node */
+static uint8_t push_adc_quality[NUM_ADC_CHANNELS];      /**< Quality last pushed per ADC channel */
+static uint64_t push_stale_check_us;
+
+/**
+ * @brief Write a value with its source timestamp into a value-backed node
+ * 
+ * @param server OPC UA server instance
+ * @param nodeIdStr String node ID (namespace 1)
+ * @param value Pointer to the scalar value
+ * @param type Data type of @p value
+ * @param source_ts_us Hardware timestamp, timebase_now_us() clock (0 = unknown)
+ * @param status Status code of the value
+ */
+static void push_value(UA_Server *server, const char *nodeIdStr, const void *value,
+                       const UA_DataType *type, uint64_t source_ts_us, UA_StatusCode status) {
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setScalar(&dv.value, (void *)value, type);
+    dv.hasValue = true;
+    if (source_ts_us > 0) {
+        dv.sourceTimestamp = ua_datetime_from_mono_us(source_ts_us);
+        dv.hasSourceTimestamp = true;
     }
+    if (status != UA_STATUSCODE_GOOD) {
+        dv.status = status;
+        dv.hasStatus = true;
+    }
+    
+    push_writing = true;
+    UA_StatusCode ret = UA_Server_writeDataValue(server, UA_NODEID_STRING(1, (char *)nodeIdStr), dv);
+    push_writing = false;
     
-    ESP_LOGI(TAG, "ADC variables added to OPC UA server (%d channels, raw codes)", NUM_ADC_CHANNELS);
-}
\ No newline at end of file
+    if (ret != UA_STATUSCODE_GOOD) {
+        ESP_LOGW(TAG, "Push to %s failed: %s", nodeIdStr, UA_StatusCode_name(ret));
+    }
+}
+
+/**
+ * @brief Write one ADC channel (raw code and calibrated value)
+ */
+static void push_adc_channel(UA_Server *server, uint8_t channel, float code, uint64_t source_ts_us,
+                             io_quality_t quality) {
+    char nodeIdStr[32];
+    UA_UInt16 raw = (UA_UInt16)code;
+    UA_StatusCode status = quality_status(quality);
+    snprintf(nodeIdStr, sizeof(nodeIdStr), "adc_channel_%d", channel + 1);
+    push_value(server, nodeIdStr, &raw, &UA_TYPES[UA_TYPES_UINT16], source_ts_us, status);
+    
+    if (adc_calibrated) {
+        UA_Float eu = adc_code_to_eu(channel, code);
+        snprintf(nodeIdStr, sizeof(nodeIdStr), "adc_eu_%d", channel + 1);
+        push_value(server, nodeIdStr, &eu, &UA_TYPES[UA_TYPES_FLOAT], source_ts_us, status);
+    }
+    push_adc_quality[channel] = (uint8_t)quality;
+}
+
+/**
+ * @brief Write one change event into its node(s)
+ */
+static void push_event(UA_Server *server, const io_event_t *ev) {
+    UA_UInt16 word = ev->discrete;
+    
+    switch (ev->kind) {
+    case IO_EVENT_DISCRETE_INPUTS:
+        push_value(server, "discrete_inputs", &word, &UA_TYPES[UA_TYPES_UINT16],
+                   ev->source_timestamp_us, quality_status((io_quality_t)ev->quality));
+        push_inputs_quality = ev->quality;
+        break;
+    case IO_EVENT_DISCRETE_OUTPUTS:
+        push_value(server, "discrete_outputs", &word, &UA_TYPES[UA_TYPES_UINT16],
+                   ev->source_timestamp_us, quality_status((io_quality_t)ev->quality));
+        break;
+    case IO_EVENT_ADC:
+        if (ev->channel < NUM_ADC_CHANNELS) {
+            push_adc_channel(server, ev->channel, ev->adc, ev->source_timestamp_us,
+                             (io_quality_t)ev->quality);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Write every I/O node from one cache snapshot
+ */
+static void push_snapshot(UA_Server *server) {
+    io_cache_snapshot_t snap;
+    io_cache_get_snapshot(&snap);
+    uint64_t now_us = timebase_now_us();
+    
+    io_event_t ev = { .kind = IO_EVENT_DISCRETE_INPUTS, .discrete = snap.discrete_inputs,
+                      .quality = (uint8_t)inputs_quality(&snap, now_us),
+                      .source_timestamp_us = snap.inputs_timestamp_us };
+    push_event(server, &ev);
+    
+    ev.kind = IO_EVENT_DISCRETE_OUTPUTS;
+    ev.discrete = snap.discrete_outputs;
+    ev.quality = snap.outputs_quality;
+    ev.source_timestamp_us = snap.outputs_timestamp_us;
+    push_event(server, &ev);
+    
+    // Channels not acquired yet are written too, with Bad_WaitingForInitialData
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        push_adc_channel(server, (uint8_t)i, snap.adc[i], snap.adc_timestamps_us[i],
+                         adc_quality(&snap, (uint8_t)i, now_us));
+    }
+}
+
+/**
+ * @brief Re-write inputs and ADC nodes whose staleness changed
+ * 
+ * A value that stops updating produces no change event, so the quality
+ * downgrade of io_quality_effective() (and the upgrade once updates
+ * resume with an unchanged value) is detected here from a snapshot taken
+ * every PUSH_STALE_CHECK_MS.
+ */
+static void push_check_staleness(UA_Server *server) {
+    uint64_t now_us = timebase_now_us();
+    if (now_us - push_stale_check_us < PUSH_STALE_CHECK_MS * 1000ULL) {
+        return;
+    }
+    push_stale_check_us = now_us;
+    
+    io_cache_snapshot_t snap;
+    io_cache_get_snapshot(&snap);
+    
+    io_quality_t q = inputs_quality(&snap, now_us);
+    if (q != push_inputs_quality) {
+        io_event_t ev = { .kind = IO_EVENT_DISCRETE_INPUTS, .discrete = snap.discrete_inputs,
+                          .quality = (uint8_t)q, .source_timestamp_us = snap.inputs_timestamp_us };
+        push_event(server, &ev);
+    }
+    
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        q = adc_quality(&snap, (uint8_t)i, now_us);
+        if (q != push_adc_quality[i]) {
+            push_adc_channel(server, (uint8_t)i, snap.adc[i], snap.adc_timestamps_us[i], q);
+        }
+    }
+}
+#endif /* CONFIG_A16_OPCUA_PUSH_MODE */
+
+/**
+ * @brief Write pending I/O changes into the server (push mode)
+ * 
+ * Called by the OPC UA task before each UA_Server_run_iterate(). The first
+ * call enables the I/O cache change queue and writes all nodes from a
+ * snapshot; later calls write at most PUSH_MAX_EVENTS_PER_ITERATION queued
+ * changes. After a queue overflow all nodes are written again from a
+ * snapshot. Does nothing unless CONFIG_A16_OPCUA_PUSH_MODE is set.
+ * 
+ * @param server OPC UA server instance
+ */
+void model_push_changes(UA_Server *server) {
+#ifdef CONFIG_A16_OPCUA_PUSH_MODE
+    io_event_t ev;
+    
+    if (!push_synced || io_cache_take_event_overflow()) {
+        io_cache_enable_events(true);
+        io_cache_take_event_overflow();
+        // Everything queued so far is covered by the snapshot
+        while (io_cache_pop_event(&ev)) {
+        }
+        push_snapshot(server);
+        if (push_synced) {
+            ESP_LOGW(TAG, "I/O change queue overflow, all nodes resynchronised");
+        }
+        push_synced = true;
+        return;
+    }
+    
+    for (int i = 0; i < PUSH_MAX_EVENTS_PER_ITERATION && io_cache_pop_event(&ev); i++) {
+        push_event(server, &ev);
+    }
+    push_check_staleness(server);
+#else
+    (void)server;
+#endif
+}
+
+/* ============================================================================
+ * SUBSCRIPTION-AWARE POLL RATES
+ * ============================================================================ */
+
+/** How often the monitored sampling intervals are re-evaluated */
+#define POLL_RATE_UPDATE_INTERVAL_MS  1000
+
+/**
+ * @brief Fastest sampling interval monitored on a set of nodes
+ * 
+ * @param server OPC UA server instance
+ * @param nodeIds String node IDs (namespace 1)
+ * @param count Number of node IDs
+ * @return UA_Double Interval in ms, negative if none of the nodes is monitored
+ */
+static UA_Double fastest_sampling_interval(UA_Server *server, const char *const nodeIds[], size_t count) {
+    UA_Double fastest = -1.0;
+    for (size_t i = 0; i < count; i++) {
+        UA_NodeId nodeId = UA_NODEID_STRING(1, (char *)nodeIds[i]);
+        UA_Double interval = UA_Server_getMinSamplingInterval(server, &nodeId);
+        if (interval >= 0 && (fastest < 0 || interval < fastest)) {
+            fastest = interval;
+        }
+    }
+    return fastest;
+}
+
+/**
+ * @brief Clamp a sampling interval to a poll period
+ * 
+ * @param interval Fastest monitored interval in ms (negative = not monitored)
+ * @param min_ms Fastest allowed period
+ * @param max_ms Period used when not monitored or monitored slower
+ * @return uint32_t Poll period in ms
+ */
+static uint32_t poll_period_ms(UA_Double interval, uint32_t min_ms, uint32_t max_ms) {
+    if (interval < 0 || interval >= max_ms) {
+        return max_ms;
+    }
+    if (interval <= min_ms) {
+        return min_ms;
+    }
+    return (uint32_t)interval;
+}
+
+/**
+ * @brief Server callback: derive the poll periods from the subscriptions
+ * 
+ * @param server OPC UA server instance
+ * @param data Not used
+ */
+static void updatePollRates(UA_Server *server, void *data) {
+    static const char *const input_nodes[] = { "discrete_inputs" };
+    static const char *const adc_nodes[] = {
+        "adc_channel_1", "adc_channel_2", "adc_channel_3", "adc_channel_4",
+        "adc_eu_1", "adc_eu_2", "adc_eu_3", "adc_eu_4",
+    };
+    
+#if CONFIG_A16_POLL_IDLE_MS > 0
+    UA_ServerStatistics stats = UA_Server_getStatistics(server);
+    if (stats.ss.currentSessionCount == 0) {
+        io_polling_set_intervals(CONFIG_A16_POLL_IDLE_MS, CONFIG_A16_POLL_IDLE_MS);
+        return;
+    }
+#endif
+    
+    UA_Double inputs = fastest_sampling_interval(server, input_nodes,
+                                                 sizeof(input_nodes) / sizeof(input_nodes[0]));
+    UA_Double adc = fastest_sampling_interval(server, adc_nodes,
+                                              sizeof(adc_nodes) / sizeof(adc_nodes[0]));
+    io_polling_set_intervals(
+        poll_period_ms(inputs, CONFIG_A16_POLL_INPUTS_MIN_MS, CONFIG_A16_POLL_INPUTS_MAX_MS),
+        poll_period_ms(adc, CONFIG_A16_POLL_ADC_MIN_MS, CONFIG_A16_POLL_ADC_MAX_MS));
+}
+
+/**
+ * @brief Let the I/O poll periods follow the OPC UA subscriptions
+ * 
+ * @param server OPC UA server instance
+ */
+void addPollRateTracking(UA_Server *server) {
+    UA_StatusCode ret = UA_Server_addRepeatedCallback(server, updatePollRates, NULL,
+                                                      POLL_RATE_UPDATE_INTERVAL_MS, NULL);
+    if (ret != UA_STATUSCODE_GOOD) {
+        ESP_LOGE(TAG, "Failed to register poll rate callback: %s", UA_StatusCode_name(ret));
+        return;
+    }
+    updatePollRates(server, NULL);
+}
+
+/* ============================================================================
+ * ACQUISITION DIAGNOSTICS
+ * ============================================================================ */
+
+/** Statistic published per histogram */
+typedef enum {
+    DIAG_FIELD_COUNT = 0,
+    DIAG_FIELD_MEAN,
+    DIAG_FIELD_MIN,
+    DIAG_FIELD_MAX,
+    DIAG_FIELD_P50,
+    DIAG_FIELD_P99,
+    DIAG_FIELD_P999,
+    DIAG_FIELD_NUM
+} diag_field_t;
+
+static const char *const diag_field_names[DIAG_FIELD_NUM] = {
+    "Count", "MeanUs", "MinUs", "MaxUs", "P50Us", "P99Us", "P999Us"
+};
+
+/** Browse name, node ID prefix and unit of each io_diag_id_t histogram */
+static const struct {
+    const char *name;
+    const char *id;
+    bool cycles;        /**< Values are CPU cycles (converted to microseconds) */
+} diag_hists[IO_DIAG_COUNT] = {
+    [IO_DIAG_INPUTS_READ]  = { "InputsReadTime",  "diag_inputs_read",  true  },
+    [IO_DIAG_ADC_READ]     = { "AdcReadTime",     "diag_adc_read",     true  },
+    [IO_DIAG_CACHE_UPDATE] = { "CacheUpdateTime", "diag_cache_update", true  },
+    [IO_DIAG_LATENESS]     = { "CycleLateness",   "diag_lateness",     false },
+};
+
+/** Histogram copies shared by the reads of one server iteration */
+static io_hist_t diag_copy[IO_DIAG_COUNT];
+
+/**
+ * @brief OPC UA read callback for one histogram statistic
+ * 
+ * @param nodeContext Histogram index * DIAG_FIELD_NUM + field
+ */
+static UA_StatusCode
+readDiagValue(UA_Server *server,
+              const UA_NodeId *sessionId, void *sessionContext,
+              const UA_NodeId *nodeId, void *nodeContext,
+              UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+              UA_DataValue *dataValue) {
+    uint32_t ctx = (uint32_t)(uintptr_t)nodeContext;
+    io_diag_id_t id = (io_diag_id_t)(ctx / DIAG_FIELD_NUM);
+    diag_field_t field = (diag_field_t)(ctx % DIAG_FIELD_NUM);
+    
+    if (id >= IO_DIAG_COUNT) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    if (!(diag_copy_valid & (1u << id))) {
+        io_polling_get_diag_histogram(id, &diag_copy[id]);
+        diag_copy_valid |= 1u << id;
+    }
+    const io_hist_t *h = &diag_copy[id];
+    
+    if (field == DIAG_FIELD_COUNT) {
+        UA_UInt32 count = h->count;
+        UA_Variant_setScalarCopy(&dataValue->value, &count, &UA_TYPES[UA_TYPES_UINT32]);
+        dataValue->hasValue = true;
+        return UA_STATUSCODE_GOOD;
+    }
+    
+    double v = 0.0;
+    if (h->count > 0) {
+        switch (field) {
+        case DIAG_FIELD_MEAN: v = (double)h->sum / h->count; break;
+        case DIAG_FIELD_MIN:  v = h->min; break;
+        case DIAG_FIELD_MAX:  v = h->max; break;
+        case DIAG_FIELD_P50:  v = io_hist_percentile(h, 0.50); break;
+        case DIAG_FIELD_P99:  v = io_hist_percentile(h, 0.99); break;
+        case DIAG_FIELD_P999: v = io_hist_percentile(h, 0.999); break;
+        default: break;
+        }
+    }
+    UA_Double us = diag_hists[id].cycles ? v / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ : v;
+    UA_Variant_setScalarCopy(&dataValue->value, &us, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+/**
+ * @brief OPC UA read callback for the I2C error count
+ */
+static UA_StatusCode
+readDiagBusErrors(UA_Server *server,
+                  const UA_NodeId *sessionId, void *sessionContext,
+                  const UA_NodeId *nodeId, void *nodeContext,
+                  UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+                  UA_DataValue *dataValue) {
+    UA_UInt32 errors = io_polling_get_bus_errors();
+    UA_Variant_setScalarCopy(&dataValue->value, &errors, &UA_TYPES[UA_TYPES_UINT32]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+/**
+ * @brief OPC UA method: reset all acquisition diagnostics
+ */
+static UA_StatusCode
+resetDiagnosticsMethod(UA_Server *server,
+                       const UA_NodeId *sessionId, void *sessionContext,
+                       const UA_NodeId *methodId, void *methodContext,
+                       const UA_NodeId *objectId, void *objectContext,
+                       size_t inputSize, const UA_Variant *input,
+                       size_t outputSize, UA_Variant *output) {
+    io_polling_reset_diagnostics();
+    ESP_LOGI(TAG, "Acquisition diagnostics reset requested");
+    return UA_STATUSCODE_GOOD;
+}
+
+/**
+ * @brief Add a read-only diagnostics variable
+ */
+static void add_diag_variable(UA_Server *server, const UA_NodeId parent, const char *nodeIdStr,
+                              const char *name, const UA_DataType *type,
+                              UA_DataSource dataSource, void *nodeContext) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", (char *)name);
+    attr.dataType = type->typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    
+    UA_Server_addDataSourceVariableNode(server, UA_NODEID_STRING(1, (char *)nodeIdStr), parent,
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                        UA_QUALIFIEDNAME(1, (char *)name),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        attr, dataSource, nodeContext, NULL);
+}
+
+/**
+ * @brief Add the acquisition Diagnostics object
+ * 
+ * @param server OPC UA server instance
+ */
+void addDiagnosticsObject(UA_Server *server) {
+    UA_NodeId diagId = UA_NODEID_STRING(1, "diagnostics");
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    oattr.displayName = UA_LOCALIZEDTEXT("en-US", "Diagnostics");
+    oattr.description = UA_LOCALIZEDTEXT("en-US", "I/O acquisition timing (microseconds) and bus errors");
+    UA_StatusCode ret = UA_Server_addObjectNode(server, diagId,
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                                UA_QUALIFIEDNAME(1, "Diagnostics"),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                                oattr, NULL, NULL);
+    if (ret != UA_STATUSCODE_GOOD) {
+        ESP_LOGE(TAG, "Failed to add Diagnostics object: %s", UA_StatusCode_name(ret));
+        return;
+    }
+    
+    UA_DataSource histSource = { .read = readDiagValue, .write = NULL };
+    for (int id = 0; id < IO_DIAG_COUNT; id++) {
+        char nodeIdStr[48];
+        UA_NodeId histId = UA_NODEID_STRING(1, (char *)diag_hists[id].id);
+        oattr.displayName = UA_LOCALIZEDTEXT("en-US", (char *)diag_hists[id].name);
+        oattr.description = UA_LOCALIZEDTEXT("en-US", "");
+        UA_Server_addObjectNode(server, histId, diagId,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                UA_QUALIFIEDNAME(1, (char *)diag_hists[id].name),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oattr, NULL, NULL);
+        
+        for (int field = 0; field < DIAG_FIELD_NUM; field++) {
+            snprintf(nodeIdStr, sizeof(nodeIdStr), "%s_%s", diag_hists[id].id, diag_field_names[field]);
+            add_diag_variable(server, histId, nodeIdStr, diag_field_names[field],
+                              field == DIAG_FIELD_COUNT ? &UA_TYPES[UA_TYPES_UINT32]
+                                                        : &UA_TYPES[UA_TYPES_DOUBLE],
+                              histSource, (void *)(uintptr_t)(id * DIAG_FIELD_NUM + field));
+        }
+    }
+    
+    UA_DataSource errorSource = { .read = readDiagBusErrors, .write = NULL };
+    add_diag_variable(server, diagId, "diag_i2c_errors", "I2CErrors",
+                      &UA_TYPES[UA_TYPES_UINT32], errorSource, NULL);
+    
+    UA_MethodAttributes mattr = UA_MethodAttributes_default;
+    mattr.displayName = UA_LOCALIZEDTEXT("en-US", "Reset");
+    mattr.description = UA_LOCALIZEDTEXT("en-US", "Clear all diagnostics histograms and counters");
+    mattr.executable = true;
+    mattr.userExecutable = true;
+    UA_Server_addMethodNode(server, UA_NODEID_STRING(1, "diag_reset"), diagId,
+                            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                            UA_QUALIFIEDNAME(1, "Reset"), mattr, resetDiagnosticsMethod,
+                            0, NULL, 0, NULL, NULL, NULL);
+    
+    ESP_LOGI(TAG, "Diagnostics object added (%d histograms)", IO_DIAG_COUNT);
+}
+/* ============================================================================
+ * HISTORY (ring buffers read back through a method)
+ * ============================================================================ */
+
+/** Largest number of samples returned by one ReadRaw call */
+#define HISTORY_READ_MAX_VALUES  500
+
+/** Size of a ReadRaw continuation point: record sequence number, little endian */
+#define HISTORY_CONTINUATION_BYTES  4
+
+/** History copy decoded by ReadRaw, only used by the OPC UA task */
+static io_history_t history_copy;
+
+/**
+ * @brief History tag of a node
+ * 
+ * @param nodeId Node given by the client
+ * @param tag Receives the history tag
+ * @param eu_channel Receives the ADC channel for adc_eu_N nodes, -1 otherwise
+ * @return true if the node has a history
+ */
+static bool history_tag_of_node(const UA_NodeId *nodeId, io_history_tag_t *tag, int *eu_channel) {
+    *eu_channel = -1;
+    if (nodeId->namespaceIndex != 1 || nodeId->identifierType != UA_NODEIDTYPE_STRING) {
+        return false;
+    }
+    
+    char id[32];
+    size_t len = nodeId->identifier.string.length;
+    if (len >= sizeof(id)) {
+        return false;
+    }
+    memcpy(id, nodeId->identifier.string.data, len);
+    id[len] = '\0';
+    
+    if (strcmp(id, "discrete_inputs") == 0) {
+        *tag = IO_HISTORY_TAG_INPUTS;
+        return true;
+    }
+    if (strcmp(id, "discrete_outputs") == 0) {
+        *tag = IO_HISTORY_TAG_OUTPUTS;
+        return true;
+    }
+    
+    // Compare with the node IDs as created, so e.g. "adc_channel_1foo" does not match
+    char expected[32];
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        snprintf(expected, sizeof(expected), "adc_channel_%d", i + 1);
+        if (strcmp(id, expected) == 0) {
+            *tag = (io_history_tag_t)(IO_HISTORY_TAG_ADC + i);
+            return true;
+        }
+        snprintf(expected, sizeof(expected), "adc_eu_%d", i + 1);
+        if (adc_calibrated && strcmp(id, expected) == 0) {
+            *tag = (io_history_tag_t)(IO_HISTORY_TAG_ADC + i);
+            *eu_channel = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief OPC UA method: read buffered samples of an I/O node
+ * 
+ * Inputs: NodeId, StartTime, EndTime (MinDateTime = no limit), MaxValues
+ * (0 = HISTORY_READ_MAX_VALUES) and ContinuationPoint (empty on the first
+ * call). Outputs the samples with StartTime <= SourceTimestamp <= EndTime,
+ * oldest first, as Values (Double), SourceTimestamps and StatusCodes, plus
+ * a ContinuationPoint to pass to the next call with the same times if
+ * MaxValues cut the result short, empty otherwise.
+ * 
+ * The continuation point is the sequence number of the first sample not
+ * returned, not its timestamp: samples can share a timestamp (out of order
+ * samples are clamped to the newest time), so resuming by time would
+ * return some of them twice. If that sample has meanwhile been dropped from
+ * the ring, the next call resumes at the oldest sample still kept.
+ */
+static UA_StatusCode
+historyReadRawMethod(UA_Server *server,
+                     const UA_NodeId *sessionId, void *sessionContext,
+                     const UA_NodeId *methodId, void *methodContext,
+                     const UA_NodeId *objectId, void *objectContext,
+                     size_t inputSize, const UA_Variant *input,
+                     size_t outputSize, UA_Variant *output) {
+    if (inputSize != 5 || outputSize != 4 ||
+        !UA_Variant_hasScalarType(&input[0], &UA_TYPES[UA_TYPES_NODEID]) ||
+        !UA_Variant_hasScalarType(&input[1], &UA_TYPES[UA_TYPES_DATETIME]) ||
+        !UA_Variant_hasScalarType(&input[2], &UA_TYPES[UA_TYPES_DATETIME]) ||
+        !UA_Variant_hasScalarType(&input[3], &UA_TYPES[UA_TYPES_UINT32]) ||
+        !UA_Variant_hasScalarType(&input[4], &UA_TYPES[UA_TYPES_BYTESTRING])) {
+        return UA_STATUSCODE_BADARGUMENTSMISSING;
+    }
+    
+    io_history_tag_t tag;
+    int eu_channel;
+    if (!history_tag_of_node((const UA_NodeId *)input[0].data, &tag, &eu_channel)) {
+        return UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+    }
+    UA_DateTime start = *(UA_DateTime *)input[1].data;
+    UA_DateTime end = *(UA_DateTime *)input[2].data;
+    UA_UInt32 max_values = *(UA_UInt32 *)input[3].data;
+    if (end == 0) {
+        end = INT64_MAX;
+    }
+    if (start > end) {
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+    if (max_values == 0 || max_values > HISTORY_READ_MAX_VALUES) {
+        max_values = HISTORY_READ_MAX_VALUES;
+    }
+    
+    const UA_ByteString *resume_point = (const UA_ByteString *)input[4].data;
+    bool resuming = resume_point->length > 0;
+    uint32_t resume_seq = 0;
+    if (resuming) {
+        if (resume_point->length != HISTORY_CONTINUATION_BYTES) {
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        }
+        for (int i = HISTORY_CONTINUATION_BYTES - 1; i >= 0; i--) {
+            resume_seq = (resume_seq << 8) | resume_point->data[i];
+        }
+    }
+    
+    io_cache_copy_history(tag, &history_copy);
+    size_t capacity = history_copy.count < max_values ? history_copy.count : max_values;
+    UA_Double *values = (UA_Double *)UA_Array_new(capacity, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_DateTime *times = (UA_DateTime *)UA_Array_new(capacity, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_StatusCode *codes = (UA_StatusCode *)UA_Array_new(capacity, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    if (!values || !times || !codes) {
+        UA_Array_delete(values, capacity, &UA_TYPES[UA_TYPES_DOUBLE]);
+        UA_Array_delete(times, capacity, &UA_TYPES[UA_TYPES_DATETIME]);
+        UA_Array_delete(codes, capacity, &UA_TYPES[UA_TYPES_STATUSCODE]);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    
+    io_history_iter_t it;
+    io_history_sample_t sample;
+    size_t n = 0;
+    bool more = false;
+    uint32_t next_seq = 0;
+    io_history_iter_init(&it, &history_copy);
+    while (io_history_next(&it, &sample)) {
+        // Sequence numbers wrap, so compare their distance
+        if (resuming && (int32_t)(sample.seq - resume_seq) < 0) continue;
+        UA_DateTime t = ua_datetime_from_mono_us(sample.time_us);
+        if (t < start) continue;
+        if (t > end) break;
+        if (n == capacity) {
+            more = true;
+            next_seq = sample.seq;
+            break;
+        }
+        
+        if (history_copy.kind == IO_HISTORY_DISCRETE) {
+            values[n] = (UA_Double)(uint16_t)sample.value;
+        } else if (eu_channel >= 0) {
+            values[n] = adc_code_to_eu((uint8_t)eu_channel, io_history_adc_code(sample.value));
+        } else {
+            values[n] = io_history_adc_code(sample.value);
+        }
+        times[n] = t;
+        codes[n] = quality_status((io_quality_t)sample.quality);
+        n++;
+    }
+    
+    // An empty continuation point means complete, so a truncated result must not go out without one
+    UA_ByteString continuation = UA_BYTESTRING_NULL;
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    if (more) {
+        ret = UA_ByteString_allocBuffer(&continuation, HISTORY_CONTINUATION_BYTES);
+        for (int i = 0; ret == UA_STATUSCODE_GOOD && i < HISTORY_CONTINUATION_BYTES; i++) {
+            continuation.data[i] = (UA_Byte)(next_seq >> (8 * i));
+        }
+    }
+    if (ret == UA_STATUSCODE_GOOD) {
+        ret = UA_Variant_setScalarCopy(&output[3], &continuation, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    }
+    UA_ByteString_clear(&continuation);
+    if (ret != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(values, capacity, &UA_TYPES[UA_TYPES_DOUBLE]);
+        UA_Array_delete(times, capacity, &UA_TYPES[UA_TYPES_DATETIME]);
+        UA_Array_delete(codes, capacity, &UA_TYPES[UA_TYPES_STATUSCODE]);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    
+    UA_Variant_setArray(&output[0], values, n, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Variant_setArray(&output[1], times, n, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_Variant_setArray(&output[2], codes, n, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    
+    ESP_LOGD(TAG, "History of tag %d: %u of %lu samples returned (%lu dropped so far)", tag,
+             (unsigned)n, (unsigned long)history_copy.count, (unsigned long)history_copy.dropped);
+    return UA_STATUSCODE_GOOD;
+}
+
+/**
+ * @brief Describe one method argument
+ */
+static UA_Argument history_argument(const char *name, const char *description,
+                                    const UA_DataType *type, UA_Int32 valueRank) {
+    UA_Argument arg;
+    UA_Argument_init(&arg);
+    arg.name = UA_STRING((char *)name);
+    arg.description = UA_LOCALIZEDTEXT("en-US", (char *)description);
+    arg.dataType = type->typeId;
+    arg.valueRank = valueRank;
+    return arg;
+}
+
+/**
+ * @brief Add the History object with its ReadRaw method
+ * 
+ * @param server OPC UA server instance
+ */
+void addHistoryObject(UA_Server *server) {
+    UA_NodeId historyId = UA_NODEID_STRING(1, "history");
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    oattr.displayName = UA_LOCALIZEDTEXT("en-US", "History");
+    oattr.description = UA_LOCALIZEDTEXT("en-US", "Buffered changes of the discrete I/O words and ADC channels");
+    UA_StatusCode ret = UA_Server_addObjectNode(server, historyId,
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                                UA_QUALIFIEDNAME(1, "History"),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                                oattr, NULL, NULL);
+    if (ret != UA_STATUSCODE_GOOD) {
+        ESP_LOGE(TAG, "Failed to add History object: %s", UA_StatusCode_name(ret));
+        return;
+    }
+    
+    UA_Argument inputs[5] = {
+        history_argument("NodeId", "discrete_inputs, discrete_outputs, adc_channel_N or adc_eu_N",
+                         &UA_TYPES[UA_TYPES_NODEID], UA_VALUERANK_SCALAR),
+        history_argument("StartTime", "Oldest source timestamp to return",
+                         &UA_TYPES[UA_TYPES_DATETIME], UA_VALUERANK_SCALAR),
+        history_argument("EndTime", "Newest source timestamp to return (MinDateTime = no limit)",
+                         &UA_TYPES[UA_TYPES_DATETIME], UA_VALUERANK_SCALAR),
+        history_argument("MaxValues", "Largest number of samples (0 = server limit)",
+                         &UA_TYPES[UA_TYPES_UINT32], UA_VALUERANK_SCALAR),
+        history_argument("ContinuationPoint", "ContinuationPoint of the previous call, empty to start",
+                         &UA_TYPES[UA_TYPES_BYTESTRING], UA_VALUERANK_SCALAR),
+    };
+    UA_Argument outputs[4] = {
+        history_argument("Values", "Sample values", &UA_TYPES[UA_TYPES_DOUBLE], UA_VALUERANK_ONE_DIMENSION),
+        history_argument("SourceTimestamps", "Sample source timestamps",
+                         &UA_TYPES[UA_TYPES_DATETIME], UA_VALUERANK_ONE_DIMENSION),
+        history_argument("StatusCodes", "Sample quality",
+                         &UA_TYPES[UA_TYPES_STATUSCODE], UA_VALUERANK_ONE_DIMENSION),
+        history_argument("ContinuationPoint", "Pass to the next call if not empty (more samples)",
+                         &UA_TYPES[UA_TYPES_BYTESTRING], UA_VALUERANK_SCALAR),
+    };
+    
+    UA_MethodAttributes mattr = UA_MethodAttributes_default;
+    mattr.displayName = UA_LOCALIZEDTEXT("en-US", "ReadRaw");
+    mattr.description = UA_LOCALIZEDTEXT("en-US", "Read the buffered samples of an I/O node");
+    mattr.executable = true;
+    mattr.userExecutable = true;
+    UA_Server_addMethodNode(server, UA_NODEID_STRING(1, "history_read_raw"), historyId,
+                            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                            UA_QUALIFIEDNAME(1, "ReadRaw"), mattr, historyReadRawMethod,
+                            5, inputs, 4, outputs, NULL, NULL);
+    
+    ESP_LOGI(TAG, "History object added (%d tags, %d bytes each)", IO_HISTORY_TAG_COUNT, IO_HISTORY_BYTES);
+}
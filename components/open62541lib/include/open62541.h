@@ -25243,6 +25243,13 @@ void UA_EXPORT UA_Server_delete(UA_Server *server);
 UA_ServerConfig UA_EXPORT *
 UA_Server_getConfig(UA_Server *server);
 
+/* Local patch: maxAge (ms) of the Read request currently being processed, or
+ * -1 when no Read service call is in progress (e.g. monitored item sampling,
+ * local reads). Lets data source callbacks decide whether a cached value is
+ * fresh enough for the client. */
+UA_Double UA_EXPORT
+UA_Server_getReadMaxAge(const UA_Server *server);
+
 /* Runs the main loop of the server. In each iteration, this calls into the
  * networklayers to see if messages have arrived.
  *
@@ -25936,6 +25943,12 @@ UA_Server_createDataChangeMonitoredItem(UA_Server *server,
 UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_deleteMonitoredItem(UA_Server *server, UA_UInt32 monitoredItemId);
 
+/* Local patch: fastest revised samplingInterval (ms) of the enabled client
+ * MonitoredItems on the value attribute of a node, or -1 if the node is not
+ * monitored. Iterates all MonitoredItems; call it at a low rate. */
+UA_Double UA_EXPORT
+UA_Server_getMinSamplingInterval(UA_Server *server, const UA_NodeId *nodeId);
+
 #endif
 
 /**
@@ -7176,6 +7176,10 @@ struct UA_Server {
      * the parent and member instantiation */
     UA_Boolean bootstrapNS0;
 
+    /* maxAge of the Read request being processed, -1 outside of Service_Read
+     * (local patch, see UA_Server_getReadMaxAge) */
+    UA_Double readMaxAge;
+
     /* Discovery */
 #ifdef UA_ENABLE_DISCOVERY
     UA_DiscoveryManager discoveryManager;
@@ -26674,6 +26678,13 @@ UA_Server_getConfig(UA_Server *server) {
   return &server->config;
 }
 
+UA_Double
+UA_Server_getReadMaxAge(const UA_Server *server) {
+    if(!server)
+        return -1.0;
+    return server->readMaxAge;
+}
+
 UA_StatusCode
 getNamespaceByName(UA_Server *server, const UA_String namespaceUri,
                    size_t *foundIndex) {
@@ -26850,6 +26861,8 @@ UA_Server_init(UA_Server *server) {
      * UA_Server_run_startup() */
     server->startTime = 0;
 
+    server->readMaxAge = -1.0;
+
     /* Set a seed for non-cyptographic randomness */
 #ifndef UA_ENABLE_DETERMINISTIC_RNG
     UA_random_seed((UA_UInt64)UA_DateTime_now());
@@ -40794,6 +40807,7 @@ Service_Read(UA_Server *server, UA_Session *session,
 
     
 
+    server->readMaxAge = request->maxAge;
     response->responseHeader.serviceResult =
         UA_Server_processServiceOperations(server, session,
                                            (UA_ServiceOperation)Operation_Read,
@@ -40801,6 +40815,7 @@ Service_Read(UA_Server *server, UA_Session *session,
                                            &UA_TYPES[UA_TYPES_READVALUEID],
                                            &response->resultsSize,
                                            &UA_TYPES[UA_TYPES_DATAVALUE]);
+    server->readMaxAge = -1.0;
 }
 
 UA_DataValue
@@ -44079,6 +44094,24 @@ UA_Server_deleteMonitoredItem(UA_Server *server, UA_UInt32 monitoredItemId) {
     return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
 }
 
+UA_Double
+UA_Server_getMinSamplingInterval(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_Double min = -1.0;
+    UA_Subscription *sub;
+    LIST_FOREACH(sub, &server->subscriptions, serverListEntry) {
+        UA_MonitoredItem *mon;
+        LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
+            if(mon->monitoringMode == UA_MONITORINGMODE_DISABLED ||
+               mon->attributeId != UA_ATTRIBUTEID_VALUE ||
+               !UA_NodeId_equal(&mon->monitoredNodeId, nodeId))
+                continue;
+            if(min < 0.0 || mon->samplingInterval < min)
+                min = mon->samplingInterval;
+        }
+    }
+    return min;
+}
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
 
 /*********************************** amalgamated original file "/home/cmb/Workspace/open62541/src/server/ua_services_securechannel.c" ***********************************/
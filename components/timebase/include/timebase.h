@@ -0,0 +1,133 @@
+/* timebase.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Largest offset correction applied by slewing; larger errors step the clock */
+#define TIMEBASE_STEP_THRESHOLD_US  500000
+/** @brief Slew rate of offset corrections (500 ppm, the adjtime() rate) */
+#define TIMEBASE_SLEW_PPM           500
+
+/**
+ * @brief Monotonic-to-UTC mapping
+ *
+ * UTC is the monotonic time plus an offset. A new reference (SNTP sync)
+ * does not move the offset at once: the offset drifts from base_offset_us
+ * towards target_offset_us at TIMEBASE_SLEW_PPM from base_mono_us on, so
+ * mapped timestamps stay monotonic and sequence-of-events order is kept
+ * across syncs. Only errors above TIMEBASE_STEP_THRESHOLD_US (first sync,
+ * manual clock change) step the offset.
+ *
+ * The mapping itself only depends on C, so the same code runs in the
+ * firmware and in host tools.
+ */
+typedef struct {
+    uint64_t base_mono_us;      /**< Monotonic time of the last reference */
+    int64_t base_offset_us;     /**< Offset in effect at base_mono_us */
+    int64_t target_offset_us;   /**< Offset measured at base_mono_us */
+    bool synced;                /**< Offset comes from a time reference (not only the boot clock) */
+} timebase_map_t;
+
+/**
+ * @brief Offset of the mapping at a monotonic time
+ *
+ * @param map Pointer to mapping
+ * @param mono_us Monotonic time in microseconds
+ * @return int64_t UTC minus monotonic time in microseconds
+ */
+static inline int64_t timebase_map_offset_us(const timebase_map_t *map, uint64_t mono_us) {
+    int64_t error = map->target_offset_us - map->base_offset_us;
+    if (error == 0 || mono_us <= map->base_mono_us) {
+        return map->base_offset_us;
+    }
+    uint64_t elapsed = mono_us - map->base_mono_us;
+    int64_t max_step = (int64_t)(elapsed / (1000000 / TIMEBASE_SLEW_PPM));
+    if (error > max_step) error = max_step;
+    if (error < -max_step) error = -max_step;
+    return map->base_offset_us + error;
+}
+
+/**
+ * @brief Map a monotonic time to UTC
+ *
+ * @param map Pointer to mapping
+ * @param mono_us Monotonic time in microseconds
+ * @return int64_t Microseconds since 1970-01-01 UTC
+ */
+static inline int64_t timebase_map_utc_us(const timebase_map_t *map, uint64_t mono_us) {
+    return (int64_t)mono_us + timebase_map_offset_us(map, mono_us);
+}
+
+/**
+ * @brief Feed a time reference into the mapping
+ *
+ * @param map Pointer to mapping
+ * @param mono_us Monotonic time of the reference
+ * @param utc_us UTC of the reference in microseconds since 1970
+ * @param synced true if the reference is a real time source
+ * @return int64_t Error of the mapping before the update (reference minus mapped time)
+ */
+int64_t timebase_map_update(timebase_map_t *map, uint64_t mono_us, int64_t utc_us, bool synced);
+
+/**
+ * @brief Initialize the timebase
+ *
+ * Takes the first mapping from the system clock, which is unset (1970)
+ * until SNTP or an RTC sets it. Safe to call more than once.
+ */
+void timebase_init(void);
+
+/**
+ * @brief Monotonic time
+ *
+ * The one clock for acquisition, scheduling and cache timestamps:
+ * esp_timer, 64-bit microseconds since boot, never wraps and never jumps.
+ *
+ * @return uint64_t Microseconds since boot
+ */
+uint64_t timebase_now_us(void);
+
+/**
+ * @brief Monotonic time in milliseconds
+ *
+ * @return uint64_t Milliseconds since boot
+ */
+static inline uint64_t timebase_now_ms(void) {
+    return timebase_now_us() / 1000;
+}
+
+/**
+ * @brief Re-discipline the mapping from the system clock
+ *
+ * Call after the system clock was set, normally from the SNTP time sync
+ * notification.
+ */
+void timebase_sync(void);
+
+/**
+ * @brief Map a monotonic timestamp to UTC
+ *
+ * @param mono_us Monotonic time from timebase_now_us()
+ * @return int64_t Microseconds since 1970-01-01 UTC
+ */
+int64_t timebase_to_utc_us(uint64_t mono_us);
+
+/**
+ * @brief Check whether UTC comes from a time reference
+ *
+ * @return true after the first successful timebase_sync() with a valid date
+ */
+bool timebase_is_synced(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMEBASE_H */
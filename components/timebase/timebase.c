@@ -0,0 +1,117 @@
+/* timebase.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "timebase.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <sys/time.h>
+
+static const char *TAG = "timebase";
+
+/** System clock values before this are taken as "not set" (2020-01-01) */
+#define TIMEBASE_MIN_VALID_UTC_US  (1577836800LL * 1000000LL)
+
+/**
+ * The mapping is written by the SNTP callback and read by the polling and
+ * OPC UA tasks on both cores. Copying it under a spinlock costs a few
+ * loads, far less than a conversion is worth.
+ */
+static timebase_map_t timebase_map;
+static portMUX_TYPE timebase_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool timebase_initialized = false;
+
+int64_t timebase_map_update(timebase_map_t *map, uint64_t mono_us, int64_t utc_us, bool synced) {
+    int64_t measured = utc_us - (int64_t)mono_us;
+    int64_t current = timebase_map_offset_us(map, mono_us);
+    int64_t error = measured - current;
+    
+    if (!map->synced || error > TIMEBASE_STEP_THRESHOLD_US || error < -TIMEBASE_STEP_THRESHOLD_US) {
+        // First reference or large error: step
+        map->base_offset_us = measured;
+    } else {
+        // Small error: slew from the offset in effect now
+        map->base_offset_us = current;
+    }
+    map->base_mono_us = mono_us;
+    map->target_offset_us = measured;
+    map->synced = map->synced || synced;
+    return error;
+}
+
+/**
+ * @brief Read the system clock together with the monotonic clock
+ *
+ * The system clock read is bracketed by two monotonic reads and paired
+ * with their midpoint.
+ */
+static void read_reference(uint64_t *mono_us, int64_t *utc_us) {
+    struct timeval tv;
+    uint64_t t0 = (uint64_t)esp_timer_get_time();
+    gettimeofday(&tv, NULL);
+    uint64_t t1 = (uint64_t)esp_timer_get_time();
+    
+    *mono_us = t0 + (t1 - t0) / 2;
+    *utc_us = (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+void timebase_init(void) {
+    if (timebase_initialized) {
+        return;
+    }
+    
+    uint64_t mono_us;
+    int64_t utc_us;
+    read_reference(&mono_us, &utc_us);
+    
+    portENTER_CRITICAL(&timebase_lock);
+    timebase_map.base_mono_us = mono_us;
+    timebase_map.base_offset_us = utc_us - (int64_t)mono_us;
+    timebase_map.target_offset_us = timebase_map.base_offset_us;
+    timebase_map.synced = false;
+    timebase_initialized = true;
+    portEXIT_CRITICAL(&timebase_lock);
+    
+    ESP_LOGI(TAG, "Timebase initialized (system clock %s)",
+             utc_us >= TIMEBASE_MIN_VALID_UTC_US ? "set" : "not set");
+}
+
+uint64_t timebase_now_us(void) {
+    return (uint64_t)esp_timer_get_time();
+}
+
+void timebase_sync(void) {
+    uint64_t mono_us;
+    int64_t utc_us;
+    read_reference(&mono_us, &utc_us);
+    
+    if (utc_us < TIMEBASE_MIN_VALID_UTC_US) {
+        ESP_LOGW(TAG, "System clock not set, sync ignored");
+        return;
+    }
+    
+    portENTER_CRITICAL(&timebase_lock);
+    bool was_synced = timebase_map.synced;
+    int64_t error = timebase_map_update(&timebase_map, mono_us, utc_us, true);
+    timebase_initialized = true;
+    portEXIT_CRITICAL(&timebase_lock);
+    
+    if (!was_synced || error > TIMEBASE_STEP_THRESHOLD_US || error < -TIMEBASE_STEP_THRESHOLD_US) {
+        ESP_LOGI(TAG, "UTC stepped by %lld us", (long long)error);
+    } else {
+        ESP_LOGI(TAG, "UTC slewing %lld us", (long long)error);
+    }
+}
+
+int64_t timebase_to_utc_us(uint64_t mono_us) {
+    portENTER_CRITICAL(&timebase_lock);
+    int64_t offset = timebase_map_offset_us(&timebase_map, mono_us);
+    portEXIT_CRITICAL(&timebase_lock);
+    return (int64_t)mono_us + offset;
+}
+
+bool timebase_is_synced(void) {
+    portENTER_CRITICAL(&timebase_lock);
+    bool synced = timebase_map.synced;
+    portEXIT_CRITICAL(&timebase_lock);
+    return synced;
+}
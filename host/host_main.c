@@ -0,0 +1,242 @@
+/* host_main.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+/*
+ * Linux entry point of the host build. Runs the unchanged firmware
+ * (app_main() and everything below it) on the FreeRTOS/ESP-IDF shim,
+ * with the PCF8574 expanders and the ADC replaced by simulations whose
+ * signals are set on the command line. The network is the host's own:
+ * the server listens on port 4840 of all interfaces.
+ *
+ * Usage: opcua_host [OPTIONS], see print_help().
+ */
+
+#include "opcua_esp32.h"
+#include "model.h"
+#include "esp_adc/adc_oneshot.h"
+#include "host_shim.h"
+#include "sim_source.h"
+#include "sim_expander.h"
+#include "sim_adc.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *TAG = "host";
+
+/** @brief Longest wait for the OPC UA task to shut down */
+#define SHUTDOWN_TIMEOUT_MS     5000
+
+/** Default ADC signals: slow noisy sines, a quarter period apart */
+#define ADC_DEFAULT_SPEC        "sine:low=500,high=3500,period_ms=20000,noise=2"
+
+void app_main(void);
+
+static const adc_channel_t adc_channels[NUM_ADC_CHANNELS] = {
+    OUR_ADC_CHANNEL_1, OUR_ADC_CHANNEL_2, OUR_ADC_CHANNEL_3, OUR_ADC_CHANNEL_4,
+};
+
+/* ============================================================================
+ * NETWORK STUBS
+ * ============================================================================ */
+
+/*
+ * Replace the ethernet component: the host is already connected, so
+ * connecting only announces the address to the event handlers.
+ */
+esp_err_t example_connect(void) {
+    ESP_LOGI(TAG, "Using the host network");
+    return esp_event_post(IP_EVENT, GOT_IP_EVENT, NULL, 0, portMAX_DELAY);
+}
+
+esp_err_t example_disconnect(void) {
+    return esp_event_post(BASE_IP_EVENT, DISCONNECT_EVENT, NULL, 0, portMAX_DELAY);
+}
+
+esp_netif_t *get_example_netif(void) {
+    return NULL;
+}
+
+/* ============================================================================
+ * COMMAND LINE
+ * ============================================================================ */
+
+static void print_help(const char *program_name) {
+    printf("OPC UA server host build with simulated I/O\n");
+    printf("Usage: %s [OPTIONS]\n\n", program_name);
+    printf("Options:\n");
+    printf("  -h, --help              Show this help message\n");
+    printf("  -d, --duration SEC      Stop after SEC seconds (default: run until Ctrl+C)\n");
+    printf("  --di SPEC               Discrete input word, bit set = input active\n");
+    printf("                          (default: count:period_ms=100)\n");
+    printf("  --ai N=SPEC             Signal of ADC channel N (1-4) in codes 0-4095\n");
+    printf("                          (default: %s, phase N/4)\n", ADC_DEFAULT_SPEC);
+    printf("  --loopback              Outputs drive the inputs (DI = DO), --di is ignored\n");
+    printf("  --i2c-ideal             I2C transactions take no time\n");
+    printf("  --i2c-extra-us US       Added to every I2C transaction (default: 0)\n");
+    printf("  --i2c-fault-rate P      Fraction of I2C transactions not acknowledged (default: 0)\n");
+    printf("  --int-poll-us US        INT line update period (default: 1000)\n");
+    printf("  --adc-conv-us US        Time of one ADC conversion (default: 0)\n");
+    printf("  --adc-fault-rate P      Fraction of ADC conversions timing out (default: 0)\n");
+    printf("  -v, --verbose           Debug log level\n");
+    printf("  -q, --quiet             Warnings and errors only\n\n");
+    printf("Signal SPEC: kind[:key=value,...], kinds const, sine, square, ramp, count,\n");
+    printf("random and file; keys value, low, high, period_ms, phase, duty, noise, seed,\n");
+    printf("path and loop (see host/sim/sim_source.h). Examples:\n");
+    printf("  --di square:low=0,high=0x0001,period_ms=10\n");
+    printf("  --ai 2=file:path=trace.csv,loop=1\n");
+}
+
+static bool parse_double(const char *s, double *out) {
+    char *end;
+    errno = 0;
+    double v = strtod(s, &end);
+    if (errno || end == s || *end != '\0') {
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(int argc, char *argv[]) {
+    static sim_source_t di_source;
+    static sim_source_t ai_sources[NUM_ADC_CHANNELS];
+    sim_expander_config_t bus = { .timing = true, .int_poll_us = 1000 };
+    sim_adc_config_t adc = { 0 };
+    double duration_s = 0.0;
+    double v;
+
+    sim_source_init(&di_source, 0, 0xFFFF);
+    sim_source_parse(&di_source, "count:period_ms=100");
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        char spec[128];
+        snprintf(spec, sizeof(spec), "%s,phase=%.2f,seed=%d", ADC_DEFAULT_SPEC, i / 4.0, i + 1);
+        sim_source_init(&ai_sources[i], 0, SIM_ADC_MAX_CODE);
+        sim_source_parse(&ai_sources[i], spec);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_help(argv[0]);
+            return 0;
+        } else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--verbose") == 0) {
+            esp_log_level_set("*", ESP_LOG_DEBUG);
+        } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0) {
+            esp_log_level_set("*", ESP_LOG_WARN);
+        } else if (strcmp(arg, "--loopback") == 0) {
+            bus.loopback = true;
+        } else if (strcmp(arg, "--i2c-ideal") == 0) {
+            bus.timing = false;
+        } else if (val == NULL) {
+            printf("Unknown option or missing value: %s\n", arg);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        } else if (strcmp(arg, "-d") == 0 || strcmp(arg, "--duration") == 0) {
+            if (!parse_double(val, &duration_s) || duration_s < 0) {
+                printf("Error: invalid duration: %s\n", val);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(arg, "--di") == 0) {
+            sim_source_init(&di_source, 0, 0xFFFF);
+            if (!sim_source_parse(&di_source, val)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(arg, "--ai") == 0) {
+            int ch = atoi(val);
+            const char *spec = strchr(val, '=');
+            if (ch < 1 || ch > NUM_ADC_CHANNELS || spec == NULL) {
+                printf("Error: expected --ai N=SPEC with N 1-%d: %s\n", NUM_ADC_CHANNELS, val);
+                return 1;
+            }
+            sim_source_free(&ai_sources[ch - 1]);
+            sim_source_init(&ai_sources[ch - 1], 0, SIM_ADC_MAX_CODE);
+            if (!sim_source_parse(&ai_sources[ch - 1], spec + 1)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(arg, "--i2c-extra-us") == 0 && parse_double(val, &v) && v >= 0) {
+            bus.overhead_us = (uint32_t)v;
+            i++;
+        } else if (strcmp(arg, "--i2c-fault-rate") == 0 && parse_double(val, &v) && v >= 0 && v <= 1) {
+            bus.fault_rate = v;
+            i++;
+        } else if (strcmp(arg, "--int-poll-us") == 0 && parse_double(val, &v) && v >= 1) {
+            bus.int_poll_us = (uint32_t)v;
+            i++;
+        } else if (strcmp(arg, "--adc-conv-us") == 0 && parse_double(val, &v) && v >= 0) {
+            adc.conversion_us = (uint32_t)v;
+            i++;
+        } else if (strcmp(arg, "--adc-fault-rate") == 0 && parse_double(val, &v) && v >= 0 && v <= 1) {
+            adc.fault_rate = v;
+            i++;
+        } else {
+            printf("Unknown option or invalid value: %s %s\n", arg, val);
+            printf("Use %s -h for help\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // The board: two input and two output expanders, four ADC channels
+    sim_expander_configure(&bus, &di_source);
+    sim_expander_add_input(DIO_IN1_ADDR, 0, DIO_IN1_INT_GPIO);
+    sim_expander_add_input(DIO_IN2_ADDR, 1, DIO_IN2_INT_GPIO);
+    sim_expander_add_output(DIO_OUT1_ADDR, 0);
+    sim_expander_add_output(DIO_OUT2_ADDR, 1);
+    sim_adc_configure(&adc);
+    for (int i = 0; i < NUM_ADC_CHANNELS; i++) {
+        sim_adc_set_source(adc_channels[i], &ai_sources[i]);
+    }
+
+    // Signals are taken synchronously below; tasks inherit the mask
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Default 50 us timer slack would dominate the polling jitter
+    prctl(PR_SET_TIMERSLACK, 1UL);
+
+    app_main();
+
+    if (duration_s > 0) {
+        struct timespec ts = { (time_t)duration_s, (long)((duration_s - (time_t)duration_s) * 1e9) };
+        sigtimedwait(&stop_signals, NULL, &ts);
+    } else {
+        int sig;
+        sigwait(&stop_signals, &sig);
+    }
+
+    ESP_LOGI(TAG, "Stopping");
+    example_disconnect();
+    if (!host_task_wait_exit("opcua_task", SHUTDOWN_TIMEOUT_MS)) {
+        ESP_LOGE(TAG, "OPC UA task did not stop within %d ms", SHUTDOWN_TIMEOUT_MS);
+    }
+
+    sim_expander_stats_t bs;
+    sim_adc_stats_t as;
+    sim_expander_get_stats(&bs);
+    sim_adc_get_stats(&as);
+    printf("\nI2C: %u transactions, %u bytes, %u NACKs, %u injected faults, %u interrupts\n",
+           bs.transactions, bs.bytes, bs.nacks, bs.injected_faults, bs.interrupts);
+    printf("ADC: %u conversions, %u injected faults\n", as.conversions, as.injected_faults);
+    printf("Outputs at exit: 0x%04X\n", sim_expander_outputs());
+
+    fflush(stdout);
+    // Polling and timer threads run forever, as on the target
+    _exit(0);
+}
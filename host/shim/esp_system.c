@@ -0,0 +1,160 @@
+/* esp_system.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+/*
+ * Host versions of the ESP-IDF services the firmware uses besides the
+ * RTOS and timers: error names, logging, the default event loop and SNTP.
+ */
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "esp_eth.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(ETH_EVENT);
+
+/* ============================================================================
+ * ERRORS AND LOGGING
+ * ============================================================================ */
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK:                    return "ESP_OK";
+    case ESP_FAIL:                  return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NO_FREE_PAGES: return "ESP_ERR_NVS_NO_FREE_PAGES";
+    default:                        return "UNKNOWN ERROR";
+    }
+}
+
+static esp_log_level_t log_level = ESP_LOG_INFO;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    (void)tag;
+    log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    static const char letters[] = "-EWIDV";
+    if (level > log_level) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    flockfile(stdout);
+    printf("%c (%lu) %s: ", letters[level], (unsigned long)(esp_timer_get_time() / 1000), tag);
+    vprintf(format, args);
+    putchar('\n');
+    funlockfile(stdout);
+    fflush(stdout);
+    va_end(args);
+}
+
+/* ============================================================================
+ * DEFAULT EVENT LOOP
+ * ============================================================================ */
+
+#define MAX_EVENT_HANDLERS  16
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} event_handler_entry_t;
+
+static event_handler_entry_t event_handlers[MAX_EVENT_HANDLERS];
+static int event_handler_count;
+static pthread_mutex_t event_lock = PTHREAD_MUTEX_INITIALIZER;
+
+esp_err_t esp_event_loop_create_default(void) {
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t handler, void *arg) {
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&event_lock);
+    if (event_handler_count >= MAX_EVENT_HANDLERS) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        event_handlers[event_handler_count++] = (event_handler_entry_t){
+            event_base, event_id, handler, arg
+        };
+    }
+    pthread_mutex_unlock(&event_lock);
+    return ret;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+                         const void *event_data, size_t event_data_size, TickType_t ticks) {
+    (void)event_data_size;
+    (void)ticks;
+
+    // Copy the matching handlers so they may register or post themselves
+    event_handler_entry_t matched[MAX_EVENT_HANDLERS];
+    int n = 0;
+    pthread_mutex_lock(&event_lock);
+    for (int i = 0; i < event_handler_count; i++) {
+        const event_handler_entry_t *e = &event_handlers[i];
+        if (strcmp(e->base, event_base) == 0 && (e->id == event_id || e->id == ESP_EVENT_ANY_ID)) {
+            matched[n++] = *e;
+        }
+    }
+    pthread_mutex_unlock(&event_lock);
+
+    for (int i = 0; i < n; i++) {
+        matched[i].handler(matched[i].arg, event_base, event_id, (void *)event_data);
+    }
+    return ESP_OK;
+}
+
+/* ============================================================================
+ * SNTP
+ * ============================================================================ */
+
+static sntp_sync_time_cb_t sntp_callback;
+static sntp_sync_status_t sntp_status = SNTP_SYNC_STATUS_RESET;
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t mode) {
+    (void)mode;
+}
+
+void esp_sntp_setservername(uint8_t idx, const char *server) {
+    (void)idx;
+    (void)server;
+}
+
+void esp_sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+    sntp_callback = callback;
+}
+
+void esp_sntp_init(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    sntp_status = SNTP_SYNC_STATUS_COMPLETED;
+    if (sntp_callback) {
+        sntp_callback(&tv);
+    }
+}
+
+sntp_sync_status_t esp_sntp_get_sync_status(void) {
+    return sntp_status;
+}
@@ -0,0 +1,150 @@
+/* esp_timer.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "esp_timer.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief One timer and its dispatch thread
+ */
+struct host_timer {
+    esp_timer_create_args_t args;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool armed;
+    bool deleted;
+    uint64_t expiry_us;         /**< Next expiry, esp_timer_get_time() clock */
+    uint64_t period_us;         /**< 0 = one-shot */
+};
+
+static uint64_t start_ns;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Time starts with the process, like esp_timer starts at boot */
+__attribute__((constructor))
+static void timer_clock_init(void) {
+    start_ns = monotonic_ns();
+}
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)((monotonic_ns() - start_ns) / 1000u);
+}
+
+static struct timespec to_abs(uint64_t us) {
+    uint64_t ns = start_ns + us * 1000u;
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    return ts;
+}
+
+static void *timer_thread(void *arg) {
+    struct host_timer *t = arg;
+
+    pthread_setname_np(pthread_self(), t->args.name ? t->args.name : "esp_timer");
+    pthread_mutex_lock(&t->lock);
+    while (!t->deleted) {
+        if (!t->armed) {
+            pthread_cond_wait(&t->cond, &t->lock);
+            continue;
+        }
+        if ((uint64_t)esp_timer_get_time() < t->expiry_us) {
+            struct timespec ts = to_abs(t->expiry_us);
+            pthread_cond_timedwait(&t->cond, &t->lock, &ts);
+            continue;
+        }
+
+        if (t->period_us) {
+            t->expiry_us += t->period_us;
+        } else {
+            t->armed = false;
+        }
+        pthread_mutex_unlock(&t->lock);
+        t->args.callback(t->args.arg);
+        pthread_mutex_lock(&t->lock);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle) {
+    if (args == NULL || args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct host_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    t->args = *args;
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&t->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&t->thread, NULL, timer_thread, t) != 0) {
+        free(t);
+        return ESP_ERR_NO_MEM;
+    }
+    *out_handle = t;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t t, uint64_t timeout_us, uint64_t period_us) {
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&t->lock);
+    if (t->armed) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        t->expiry_us = (uint64_t)esp_timer_get_time() + timeout_us;
+        t->period_us = period_us;
+        t->armed = true;
+        pthread_cond_signal(&t->cond);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return ret;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    return period_us ? timer_start(timer, period_us, period_us) : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&t->lock);
+    if (!t->armed) {
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    t->armed = false;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return ret;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t t) {
+    pthread_mutex_lock(&t->lock);
+    t->deleted = true;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+
+    pthread_join(t->thread, NULL);
+    pthread_cond_destroy(&t->cond);
+    pthread_mutex_destroy(&t->lock);
+    free(t);
+    return ESP_OK;
+}
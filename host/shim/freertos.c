@@ -0,0 +1,327 @@
+/* freertos.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "host_shim.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "host_rtos";
+
+#define TASK_NAME_LEN  16
+
+/**
+ * @brief One task: a thread with its notification word
+ */
+struct host_task {
+    pthread_t thread;
+    char name[TASK_NAME_LEN];
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify_value;
+    bool notify_pending;
+    bool running;                   /**< Created by xTaskCreate and not deleted */
+    struct host_task *next;
+};
+
+struct host_semaphore {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    UBaseType_t count;
+    UBaseType_t max_count;
+};
+
+static __thread struct host_task *current_task;
+
+/** All tasks ever created, for host_task_wait_exit() */
+static struct host_task *task_list;
+static pthread_mutex_t task_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t task_list_cond;
+
+/**
+ * @brief Condition variable waiting on CLOCK_MONOTONIC
+ */
+static void cond_init_monotonic(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * @brief Absolute CLOCK_MONOTONIC time a number of ticks from now
+ */
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ticks * (1000000000ull / configTICK_RATE_HZ);
+    ts.tv_sec += (time_t)(ns / 1000000000ull);
+    ts.tv_nsec += (long)(ns % 1000000000ull);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+/**
+ * @brief Wait on a condition; false on timeout
+ */
+static bool cond_wait_ticks(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks,
+                            const struct timespec *deadline) {
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+__attribute__((constructor))
+static void task_list_init(void) {
+    cond_init_monotonic(&task_list_cond);
+}
+
+static struct host_task *task_alloc(const char *name) {
+    struct host_task *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return NULL;
+    }
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "");
+    pthread_mutex_init(&t->lock, NULL);
+    cond_init_monotonic(&t->cond);
+    return t;
+}
+
+static void *task_entry(void *arg) {
+    struct host_task *t = arg;
+    current_task = t;
+    pthread_setname_np(pthread_self(), t->name);
+    t->fn(t->arg);
+    // Returning from a FreeRTOS task is an error; end it like vTaskDelete(NULL)
+    ESP_LOGW(TAG, "Task %s returned without vTaskDelete()", t->name);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id) {
+    (void)stack_depth;
+    (void)priority;
+    (void)core_id;
+
+    struct host_task *t = task_alloc(name);
+    if (t == NULL) {
+        return pdFAIL;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    t->running = true;
+
+    pthread_mutex_lock(&task_list_lock);
+    t->next = task_list;
+    task_list = t;
+    pthread_mutex_unlock(&task_list_lock);
+
+    // Set before the thread runs: the new task may be notified at once
+    if (handle) {
+        *handle = t;
+    }
+
+    if (pthread_create(&t->thread, NULL, task_entry, t) != 0) {
+        pthread_mutex_lock(&task_list_lock);
+        t->running = false;
+        pthread_mutex_unlock(&task_list_lock);
+        return pdFAIL;
+    }
+    pthread_detach(t->thread);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != NULL && task != current_task) {
+        ESP_LOGE(TAG, "vTaskDelete of another task is not supported");
+        return;
+    }
+
+    struct host_task *t = current_task;
+    if (t != NULL) {
+        pthread_mutex_lock(&task_list_lock);
+        t->running = false;
+        pthread_cond_broadcast(&task_list_cond);
+        pthread_mutex_unlock(&task_list_lock);
+    }
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    uint64_t ns = (uint64_t)ticks * (1000000000ull / configTICK_RATE_HZ);
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)((uint64_t)esp_timer_get_time() * configTICK_RATE_HZ / 1000000u);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    // Threads not created by xTaskCreate (the process main thread) get a handle on first use
+    if (current_task == NULL) {
+        char name[TASK_NAME_LEN] = "main";
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        current_task = task_alloc(name);
+    }
+    return current_task;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    BaseType_t ret = pdPASS;
+    if (task == NULL) {
+        return pdFAIL;
+    }
+
+    pthread_mutex_lock(&task->lock);
+    switch (action) {
+    case eSetBits:
+        task->notify_value |= value;
+        break;
+    case eIncrement:
+        task->notify_value++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notify_value = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (task->notify_pending) {
+            ret = pdFAIL;
+        } else {
+            task->notify_value = value;
+        }
+        break;
+    case eNoAction:
+        break;
+    }
+    task->notify_pending = true;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return ret;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks) {
+    struct host_task *t = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = deadline_after(ticks);
+    BaseType_t ret = pdTRUE;
+
+    pthread_mutex_lock(&t->lock);
+    if (!t->notify_pending) {
+        t->notify_value &= ~clear_on_entry;
+        while (!t->notify_pending && ticks != 0) {
+            if (!cond_wait_ticks(&t->cond, &t->lock, ticks, &deadline)) {
+                break;
+            }
+        }
+    }
+    if (value) {
+        *value = t->notify_value;
+    }
+    if (t->notify_pending) {
+        t->notify_value &= ~clear_on_exit;
+        t->notify_pending = false;
+    } else {
+        ret = pdFALSE;
+    }
+    pthread_mutex_unlock(&t->lock);
+    return ret;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    struct host_semaphore *s = calloc(1, sizeof(*s));
+    if (s == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    cond_init_monotonic(&s->cond);
+    s->count = initial_count;
+    s->max_count = max_count;
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+    BaseType_t ret = pdFALSE;
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && ticks != 0) {
+        if (!cond_wait_ticks(&sem->cond, &sem->lock, ticks, &deadline)) {
+            break;
+        }
+    }
+    if (sem->count > 0) {
+        sem->count--;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    BaseType_t ret = pdFALSE;
+
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count < sem->max_count) {
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    if (sem == NULL) {
+        return;
+    }
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+}
+
+bool host_task_wait_exit(const char *name, uint32_t timeout_ms) {
+    struct timespec deadline = deadline_after(pdMS_TO_TICKS(timeout_ms));
+    bool done;
+
+    pthread_mutex_lock(&task_list_lock);
+    for (;;) {
+        done = true;
+        for (struct host_task *t = task_list; t; t = t->next) {
+            if (t->running && strcmp(t->name, name) == 0) {
+                done = false;
+            }
+        }
+        if (done || pthread_cond_timedwait(&task_list_cond, &task_list_lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&task_list_lock);
+    return done;
+}
+
+int host_task_count(void) {
+    int n = 0;
+    pthread_mutex_lock(&task_list_lock);
+    for (struct host_task *t = task_list; t; t = t->next) {
+        n += t->running;
+    }
+    pthread_mutex_unlock(&task_list_lock);
+    return n;
+}
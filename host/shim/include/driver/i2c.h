@@ -0,0 +1,8 @@
+/* i2c.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_DRIVER_I2C_H
+#define HOST_DRIVER_I2C_H
+
+#error "The host build simulates the i2c_master driver only: disable CONFIG_IO_EXPANDER_USE_LEGACY_I2C"
+
+#endif /* HOST_DRIVER_I2C_H */
@@ -0,0 +1,101 @@
+/* i2c_master.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_DRIVER_I2C_MASTER_H
+#define HOST_DRIVER_I2C_MASTER_H
+
+/*
+ * ESP-IDF i2c_master driver API, implemented by the simulated bus in
+ * host/sim/sim_expander.c. Only what the I/O expander I2C backend uses
+ * is provided.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "hal/i2c_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_i2c_bus *i2c_master_bus_handle_t;
+typedef struct host_i2c_device *i2c_master_dev_handle_t;
+
+#define I2C_DEVICE_ADDRESS_NOT_USED  0xFFFF
+
+typedef enum {
+    I2C_ADDR_BIT_LEN_7 = 0,
+    I2C_ADDR_BIT_LEN_10,
+} i2c_addr_bit_len_t;
+
+typedef enum {
+    I2C_CLK_SRC_DEFAULT = 0,
+} i2c_clock_source_t;
+
+typedef enum {
+    I2C_ACK_VAL = 0,
+    I2C_NACK_VAL = 1,
+} i2c_ack_value_t;
+
+typedef struct {
+    i2c_port_t i2c_port;
+    int sda_io_num;
+    int scl_io_num;
+    i2c_clock_source_t clk_source;
+    uint8_t glitch_ignore_cnt;
+    int intr_priority;
+    size_t trans_queue_depth;
+    struct {
+        uint32_t enable_internal_pullup : 1;
+    } flags;
+} i2c_master_bus_config_t;
+
+typedef struct {
+    i2c_addr_bit_len_t dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+    uint32_t scl_wait_us;
+} i2c_device_config_t;
+
+typedef enum {
+    I2C_MASTER_CMD_START,
+    I2C_MASTER_CMD_WRITE,
+    I2C_MASTER_CMD_READ,
+    I2C_MASTER_CMD_STOP,
+} i2c_master_command_t;
+
+typedef struct {
+    i2c_master_command_t command;
+    union {
+        struct {
+            bool ack_check;
+            uint8_t *data;
+            size_t total_bytes;
+        } write;
+        struct {
+            i2c_ack_value_t ack_value;
+            uint8_t *data;
+            size_t total_bytes;
+        } read;
+    };
+} i2c_operation_job_t;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config,
+                             i2c_master_bus_handle_t *ret_bus_handle);
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle,
+                                    const i2c_device_config_t *dev_config,
+                                    i2c_master_dev_handle_t *ret_handle);
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer,
+                              size_t write_size, int xfer_timeout_ms);
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer,
+                             size_t read_size, int xfer_timeout_ms);
+esp_err_t i2c_master_execute_defined_operations(i2c_master_dev_handle_t i2c_dev,
+                                                i2c_operation_job_t *i2c_operation,
+                                                size_t operation_list_num, int xfer_timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_DRIVER_I2C_MASTER_H */
@@ -0,0 +1,16 @@
+/* adc_cali.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_ADC_CALI_H
+#define HOST_ESP_ADC_CALI_H
+
+#include "esp_err.h"
+
+typedef struct host_adc_cali *adc_cali_handle_t;
+
+/* A simulated ADC has no eFuse calibration; the firmware falls back to its ideal curve */
+static inline esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage) {
+    (void)handle; (void)raw; (void)voltage;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* HOST_ESP_ADC_CALI_H */
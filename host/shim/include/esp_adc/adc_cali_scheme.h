@@ -0,0 +1,10 @@
+/* adc_cali_scheme.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_ADC_CALI_SCHEME_H
+#define HOST_ESP_ADC_CALI_SCHEME_H
+
+#include "esp_adc/adc_cali.h"
+
+#define ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED  0
+
+#endif /* HOST_ESP_ADC_CALI_SCHEME_H */
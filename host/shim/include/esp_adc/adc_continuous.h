@@ -0,0 +1,8 @@
+/* adc_continuous.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_ADC_CONTINUOUS_H
+#define HOST_ESP_ADC_CONTINUOUS_H
+
+#error "The host build simulates the oneshot ADC backend only: disable CONFIG_A16_ADC_BACKEND_CONTINUOUS"
+
+#endif /* HOST_ESP_ADC_CONTINUOUS_H */
@@ -0,0 +1,23 @@
+/* esp_cpu.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+#include <stdint.h>
+#include <time.h>
+#include "sdkconfig.h"
+
+/**
+ * @brief CPU cycle counter of the configured ESP32 clock
+ *
+ * Derived from CLOCK_MONOTONIC at CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, so code
+ * that converts cycles with that frequency gets host wall-clock time.
+ */
+static inline uint32_t esp_cpu_get_cycle_count(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    return (uint32_t)(ns * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ / 1000u);
+}
+
+#endif /* HOST_ESP_CPU_H */
@@ -0,0 +1,17 @@
+/* esp_eth.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_ETH_H
+#define HOST_ESP_ETH_H
+
+#include "esp_event.h"
+
+ESP_EVENT_DECLARE_BASE(ETH_EVENT);
+
+typedef enum {
+    ETHERNET_EVENT_START,
+    ETHERNET_EVENT_STOP,
+    ETHERNET_EVENT_CONNECTED,
+    ETHERNET_EVENT_DISCONNECTED,
+} eth_event_t;
+
+#endif /* HOST_ESP_ETH_H */
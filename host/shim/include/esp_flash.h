@@ -0,0 +1,6 @@
+/* esp_flash.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_FLASH_H
+#define HOST_ESP_FLASH_H
+
+#endif /* HOST_ESP_FLASH_H */
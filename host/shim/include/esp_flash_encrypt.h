@@ -0,0 +1,11 @@
+/* esp_flash_encrypt.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_FLASH_ENCRYPT_H
+#define HOST_ESP_FLASH_ENCRYPT_H
+
+#include <stdbool.h>
+
+static inline bool esp_flash_encryption_enabled(void) { return false; }
+static inline void esp_flash_write_protect_crypt_cnt(void) { }
+
+#endif /* HOST_ESP_FLASH_ENCRYPT_H */
@@ -0,0 +1,44 @@
+/* esp_sntp.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_SNTP_H
+#define HOST_ESP_SNTP_H
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SNTP_OPMODE_POLL,
+    SNTP_OPMODE_LISTENONLY,
+} esp_sntp_operatingmode_t;
+
+typedef enum {
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS,
+} sntp_sync_status_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t mode);
+void esp_sntp_setservername(uint8_t idx, const char *server);
+void esp_sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+
+/**
+ * @brief Start time synchronization
+ *
+ * The host clock is already kept by the operating system, so the
+ * notification callback runs at once with the current time.
+ */
+void esp_sntp_init(void);
+sntp_sync_status_t esp_sntp_get_sync_status(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_SNTP_H */
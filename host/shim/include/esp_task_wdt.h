@@ -0,0 +1,14 @@
+/* esp_task_wdt.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_TASK_WDT_H
+#define HOST_ESP_TASK_WDT_H
+
+#include "esp_err.h"
+#include "freertos/task.h"
+
+/* No task watchdog on the host: a stuck task shows up in a debugger instead */
+static inline esp_err_t esp_task_wdt_add(TaskHandle_t task) { (void)task; return ESP_OK; }
+static inline esp_err_t esp_task_wdt_reset(void) { return ESP_OK; }
+static inline esp_err_t esp_task_wdt_delete(TaskHandle_t task) { (void)task; return ESP_OK; }
+
+#endif /* HOST_ESP_TASK_WDT_H */
@@ -0,0 +1,8 @@
+/* esp_wifi_default.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_ESP_WIFI_DEFAULT_H
+#define HOST_ESP_WIFI_DEFAULT_H
+
+#include "esp_wifi.h"
+
+#endif /* HOST_ESP_WIFI_DEFAULT_H */
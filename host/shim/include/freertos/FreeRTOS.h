@@ -0,0 +1,65 @@
+/* FreeRTOS.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+/*
+ * Host shim of the FreeRTOS kernel API used by the firmware.
+ *
+ * Tasks are POSIX threads, critical sections are recursive mutexes and
+ * ticks follow CLOCK_MONOTONIC. Priorities and core affinity are ignored:
+ * the Linux scheduler decides, which is what a load test on a workstation
+ * wants anyway.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE         ((BaseType_t)0)
+#define pdTRUE          ((BaseType_t)1)
+#define pdFAIL          pdFALSE
+#define pdPASS          pdTRUE
+#define portMAX_DELAY   ((TickType_t)0xFFFFFFFFu)
+
+#define configTICK_RATE_HZ      CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000u))
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+
+/**
+ * @brief Critical section lock
+ *
+ * On the ESP32 a portMUX is a spinlock that also masks interrupts, and it
+ * may be taken again by the owner. A recursive mutex gives the same
+ * nesting and mutual exclusion between threads.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED  { PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP }
+
+#define portENTER_CRITICAL(mux)       pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux)        pthread_mutex_unlock(&(mux)->mutex)
+#define portENTER_CRITICAL_ISR(mux)   portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)    portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(woken)     ((void)(woken))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FREERTOS_H */
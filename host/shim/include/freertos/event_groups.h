@@ -0,0 +1,12 @@
+/* event_groups.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_FREERTOS_EVENT_GROUPS_H
+#define HOST_FREERTOS_EVENT_GROUPS_H
+
+#include "freertos/FreeRTOS.h"
+
+/* Event groups are only used by the network connection code, which the host build replaces */
+typedef struct host_event_group *EventGroupHandle_t;
+typedef TickType_t EventBits_t;
+
+#endif /* HOST_FREERTOS_EVENT_GROUPS_H */
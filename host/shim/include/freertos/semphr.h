@@ -0,0 +1,27 @@
+/* semphr.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Binary or counting semaphore, or mutex (no priority inheritance) */
+typedef struct host_semaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#define xSemaphoreCreateBinary()  xSemaphoreCreateCounting(1, 0)
+#define xSemaphoreCreateMutex()   xSemaphoreCreateCounting(1, 1)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FREERTOS_SEMPHR_H */
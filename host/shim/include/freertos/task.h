@@ -0,0 +1,59 @@
+/* task.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Task handle (one POSIX thread) */
+typedef struct host_task *TaskHandle_t;
+
+typedef void (*TaskFunction_t)(void *arg);
+
+/** @brief Task notification actions */
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id);
+
+static inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                     void *arg, UBaseType_t priority, TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, handle, -1);
+}
+
+/**
+ * @brief Delete a task
+ *
+ * Only the calling task can be deleted (task == NULL); the thread exits.
+ */
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+BaseType_t xTaskGenericNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks);
+
+#define xTaskNotify(task, value, action)  xTaskGenericNotify((task), (value), (action))
+#define xTaskNotifyGive(task)             xTaskGenericNotify((task), 0, eIncrement)
+#define xTaskNotifyFromISR(task, value, action, woken) \
+    (*(woken) = pdFALSE, xTaskGenericNotify((task), (value), (action)))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FREERTOS_TASK_H */
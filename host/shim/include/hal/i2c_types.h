@@ -0,0 +1,13 @@
+/* i2c_types.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_HAL_I2C_TYPES_H
+#define HOST_HAL_I2C_TYPES_H
+
+/* I2C controller numbers, shared by the i2c_master and legacy driver APIs */
+
+typedef int i2c_port_t;
+
+#define I2C_NUM_0  0
+#define I2C_NUM_1  1
+
+#endif /* HOST_HAL_I2C_TYPES_H */
@@ -0,0 +1,36 @@
+/* host_shim.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_SHIM_H
+#define HOST_SHIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Host-only extensions of the FreeRTOS/ESP-IDF shim, used by the host
+ * entry point (host/host_main.c). Firmware sources never include this.
+ */
+
+/**
+ * @brief Wait until a task has deleted itself
+ *
+ * @param name Task name given to xTaskCreatePinnedToCore()
+ * @param timeout_ms Longest wait
+ * @return true if no task of that name is running (any more)
+ */
+bool host_task_wait_exit(const char *name, uint32_t timeout_ms);
+
+/**
+ * @brief Number of tasks created and not deleted yet
+ */
+int host_task_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_SHIM_H */
@@ -0,0 +1,8 @@
+/* err.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_LWIP_ERR_H
+#define HOST_LWIP_ERR_H
+
+typedef signed char err_t;
+
+#endif /* HOST_LWIP_ERR_H */
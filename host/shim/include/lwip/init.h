@@ -0,0 +1,8 @@
+/* init.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_LWIP_INIT_H
+#define HOST_LWIP_INIT_H
+
+/* Nothing to set up: the host network stack belongs to the operating system */
+
+#endif /* HOST_LWIP_INIT_H */
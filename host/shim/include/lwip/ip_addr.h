@@ -0,0 +1,17 @@
+/* ip_addr.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_LWIP_IP_ADDR_H
+#define HOST_LWIP_IP_ADDR_H
+
+#include <stdint.h>
+#include <arpa/inet.h>
+
+typedef struct {
+    uint32_t addr;      /**< Network byte order, same layout as struct in_addr */
+} ip4_addr_t;
+
+static inline int ip4addr_aton(const char *cp, ip4_addr_t *addr) {
+    return inet_aton(cp, (struct in_addr *)addr);
+}
+
+#endif /* HOST_LWIP_IP_ADDR_H */
@@ -0,0 +1,25 @@
+/* netdb.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_LWIP_NETDB_H
+#define HOST_LWIP_NETDB_H
+
+#include <netdb.h>
+#include <sys/socket.h>
+
+/*
+ * lwIP returns at most one address and prefers IPv4 for AF_UNSPEC. glibc
+ * would also return the IPv6 wildcard for a passive lookup, whose bind
+ * collides with the IPv4 one in an architecture without IPV6_V6ONLY.
+ */
+static inline int lwip_getaddrinfo(const char *nodename, const char *servname,
+                                   const struct addrinfo *hints, struct addrinfo **res) {
+    struct addrinfo h = *hints;
+    if (h.ai_family == AF_UNSPEC) {
+        h.ai_family = AF_INET;
+    }
+    return getaddrinfo(nodename, servname, &h, res);
+}
+
+#define lwip_freeaddrinfo   freeaddrinfo
+
+#endif /* HOST_LWIP_NETDB_H */
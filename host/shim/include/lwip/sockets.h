@@ -0,0 +1,44 @@
+/* sockets.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+/*
+ * lwIP socket API on top of the POSIX sockets of the host.
+ *
+ * open62541 is built for its freertosLWIP architecture in the firmware;
+ * mapping the lwip_* calls lets the host build compile the same
+ * amalgamation with the same options.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "lwip/ip_addr.h"
+
+#define lwip_send           send
+#define lwip_recv           recv
+#define lwip_sendto         sendto
+#define lwip_recvfrom       recvfrom
+#define lwip_htonl          htonl
+#define lwip_ntohl          ntohl
+#define lwip_close          close
+#define lwip_select         select
+#define lwip_shutdown       shutdown
+#define lwip_socket         socket
+#define lwip_bind           bind
+#define lwip_listen         listen
+#define lwip_accept         accept
+#define lwip_connect        connect
+#define lwip_getsockopt     getsockopt
+#define lwip_setsockopt     setsockopt
+#define lwip_getsockname    getsockname
+#define lwip_ioctl          ioctl
+
+#endif /* HOST_LWIP_SOCKETS_H */
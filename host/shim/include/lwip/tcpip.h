@@ -0,0 +1,8 @@
+/* tcpip.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_LWIP_TCPIP_H
+#define HOST_LWIP_TCPIP_H
+
+/* Nothing to set up: the host network stack belongs to the operating system */
+
+#endif /* HOST_LWIP_TCPIP_H */
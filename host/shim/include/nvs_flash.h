@@ -0,0 +1,12 @@
+/* nvs_flash.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef HOST_NVS_FLASH_H
+#define HOST_NVS_FLASH_H
+
+#include "esp_err.h"
+
+/* The firmware keeps nothing in NVS; the host has no partition to initialize */
+static inline esp_err_t nvs_flash_init(void) { return ESP_OK; }
+static inline esp_err_t nvs_flash_erase(void) { return ESP_OK; }
+
+#endif /* HOST_NVS_FLASH_H */
@@ -0,0 +1,116 @@
+/* sim_adc.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+/*
+ * Simulated ADC behind the ESP-IDF adc_oneshot API. Every hardware
+ * channel samples a sim_source_t at the time of the conversion.
+ */
+
+#include "sim_adc.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const char *TAG = "sim_adc";
+
+struct host_adc_unit {
+    adc_unit_t unit;
+    uint32_t configured;    /**< Bit mask of configured channels */
+};
+
+static sim_adc_config_t config;
+static const sim_source_t *sources[HOST_ADC_CHANNEL_COUNT];
+static atomic_uint conversions;
+static atomic_uint injected_faults;
+static pthread_mutex_t rng_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+void sim_adc_configure(const sim_adc_config_t *cfg) {
+    config = *cfg;
+}
+
+void sim_adc_set_source(int channel, const sim_source_t *src) {
+    if (channel >= 0 && channel < HOST_ADC_CHANNEL_COUNT) {
+        sources[channel] = src;
+    }
+}
+
+void sim_adc_get_stats(sim_adc_stats_t *stats) {
+    stats->conversions = atomic_load(&conversions);
+    stats->injected_faults = atomic_load(&injected_faults);
+}
+
+static bool inject_fault(void) {
+    if (config.fault_rate <= 0.0) {
+        return false;
+    }
+    pthread_mutex_lock(&rng_lock);
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    double u = (double)((rng_state * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+    pthread_mutex_unlock(&rng_lock);
+    return u < config.fault_rate;
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config,
+                               adc_oneshot_unit_handle_t *ret_unit) {
+    if (init_config == NULL || ret_unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct host_adc_unit *unit = calloc(1, sizeof(*unit));
+    if (unit == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    unit->unit = init_config->unit_id;
+    *ret_unit = unit;
+    ESP_LOGI(TAG, "Simulated ADC unit %d: %u us per conversion, %.4f fault rate",
+             unit->unit + 1, (unsigned)config.conversion_us, config.fault_rate);
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel,
+                                     const adc_oneshot_chan_cfg_t *chan_config) {
+    if (handle == NULL || chan_config == NULL ||
+        (int)channel < 0 || (int)channel >= HOST_ADC_CHANNEL_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->configured |= 1u << channel;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw) {
+    if (handle == NULL || out_raw == NULL ||
+        (int)chan < 0 || (int)chan >= HOST_ADC_CHANNEL_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!(handle->configured & (1u << chan))) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint64_t start_us = (uint64_t)esp_timer_get_time();
+    if (config.conversion_us) {
+        struct timespec ts = { (time_t)(config.conversion_us / 1000000),
+                               (long)(config.conversion_us % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+    if (inject_fault()) {
+        atomic_fetch_add(&injected_faults, 1);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    double v = sources[chan] ? sim_source_value(sources[chan], start_us) : 0.0;
+    v = round(v);
+    *out_raw = v <= 0.0 ? 0 : v >= SIM_ADC_MAX_CODE ? SIM_ADC_MAX_CODE : (int)v;
+    atomic_fetch_add(&conversions, 1);
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_del_unit(adc_oneshot_unit_handle_t handle) {
+    free(handle);
+    return ESP_OK;
+}
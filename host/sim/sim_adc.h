@@ -0,0 +1,59 @@
+/* sim_adc.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef SIM_ADC_H
+#define SIM_ADC_H
+
+#include <stdint.h>
+#include "sim_source.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Largest 12-bit code */
+#define SIM_ADC_MAX_CODE  4095
+
+/**
+ * @brief Behaviour of the simulated ADC
+ */
+typedef struct {
+    uint32_t conversion_us;     /**< Time a oneshot conversion blocks the caller */
+    double fault_rate;          /**< Probability that a conversion times out */
+} sim_adc_config_t;
+
+/**
+ * @brief Counters of the simulated ADC
+ */
+typedef struct {
+    uint32_t conversions;       /**< Completed conversions */
+    uint32_t injected_faults;   /**< Conversions failed by fault_rate */
+} sim_adc_stats_t;
+
+/**
+ * @brief Configure the simulated ADC
+ *
+ * Call before the firmware creates the ADC unit.
+ */
+void sim_adc_configure(const sim_adc_config_t *config);
+
+/**
+ * @brief Signal of one hardware channel, in ADC codes
+ *
+ * Values are rounded and clamped to 0..SIM_ADC_MAX_CODE. A channel
+ * without a source reads 0.
+ *
+ * @param channel Hardware channel (adc_channel_t)
+ * @param src Source, must stay valid while the firmware runs
+ */
+void sim_adc_set_source(int channel, const sim_source_t *src);
+
+/**
+ * @brief Copy the ADC counters
+ */
+void sim_adc_get_stats(sim_adc_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_ADC_H */
@@ -0,0 +1,415 @@
+/* sim_expander.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+/*
+ * Simulated I2C bus with PCF8574 expanders behind the ESP-IDF i2c_master
+ * and GPIO interrupt APIs, so the unchanged I/O expander drivers run on the
+ * host. Transactions take the time of the transfer at the device SCL
+ * clock, can fail at a configured rate, and input expanders assert their
+ * INT line when a pin changes after the last read.
+ */
+
+#include "sim_expander.h"
+#include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "sim_i2c";
+
+#define BITS_PER_BYTE       9   /**< 8 data bits and ACK */
+#define MAX_GPIO            64
+
+typedef enum {
+    ROLE_INPUT,
+    ROLE_OUTPUT,
+} device_role_t;
+
+/**
+ * @brief One simulated PCF8574
+ */
+typedef struct {
+    uint8_t address;
+    device_role_t role;
+    uint8_t bank;
+    int int_gpio;
+    uint8_t latch;          /**< Port latch, 0xFF after power-on */
+    uint8_t last_read;      /**< Pin state at the last read, reference of INT */
+} sim_device_t;
+
+struct host_i2c_bus {
+    i2c_port_t port;
+};
+
+struct host_i2c_device {
+    struct host_i2c_bus *bus;
+    uint16_t address;       /**< I2C_DEVICE_ADDRESS_NOT_USED for raw sequences */
+    uint32_t scl_hz;
+};
+
+static sim_expander_config_t config = {
+    .timing = true,
+    .int_poll_us = 1000,
+};
+static const sim_source_t *input_source;
+
+static sim_device_t devices[SIM_EXPANDER_MAX_DEVICES];
+static int device_count;
+static sim_expander_stats_t stats;
+static uint64_t rng_state = 0x853C49E6748FEA9Bull;
+
+/** Serialises transactions like the real bus and guards all state above */
+static pthread_mutex_t bus_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static gpio_isr_t isr_handlers[MAX_GPIO];
+static void *isr_args[MAX_GPIO];
+static bool int_line_low[MAX_GPIO];
+static pthread_t int_thread;
+static bool int_thread_started;
+
+void sim_expander_configure(const sim_expander_config_t *cfg, const sim_source_t *inputs) {
+    pthread_mutex_lock(&bus_lock);
+    config = *cfg;
+    if (config.int_poll_us == 0) {
+        config.int_poll_us = 1000;
+    }
+    input_source = inputs;
+    pthread_mutex_unlock(&bus_lock);
+}
+
+static void add_device(uint8_t address, device_role_t role, uint8_t bank, int int_gpio) {
+    pthread_mutex_lock(&bus_lock);
+    if (device_count < SIM_EXPANDER_MAX_DEVICES) {
+        devices[device_count++] = (sim_device_t){
+            .address = address, .role = role, .bank = bank, .int_gpio = int_gpio,
+            .latch = 0xFF, .last_read = 0xFF,
+        };
+    }
+    pthread_mutex_unlock(&bus_lock);
+}
+
+void sim_expander_add_input(uint8_t address, uint8_t bank, int int_gpio) {
+    add_device(address, ROLE_INPUT, bank, int_gpio < MAX_GPIO ? int_gpio : -1);
+}
+
+void sim_expander_add_output(uint8_t address, uint8_t bank) {
+    add_device(address, ROLE_OUTPUT, bank, -1);
+}
+
+/** @brief Logical output word; bus_lock held */
+static uint16_t outputs_locked(void) {
+    uint16_t word = 0;
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i].role == ROLE_OUTPUT) {
+            word |= (uint16_t)((uint8_t)~devices[i].latch) << (8 * devices[i].bank);
+        }
+    }
+    return word;
+}
+
+uint16_t sim_expander_outputs(void) {
+    pthread_mutex_lock(&bus_lock);
+    uint16_t word = outputs_locked();
+    pthread_mutex_unlock(&bus_lock);
+    return word;
+}
+
+void sim_expander_get_stats(sim_expander_stats_t *out) {
+    pthread_mutex_lock(&bus_lock);
+    *out = stats;
+    pthread_mutex_unlock(&bus_lock);
+}
+
+/**
+ * @brief Pin levels of a device; bus_lock held
+ *
+ * Quasi-bidirectional port: a pin reads low if the latch drives it low
+ * or the outside pulls it low.
+ */
+static uint8_t device_pins(const sim_device_t *d, uint64_t now_us) {
+    if (d->role == ROLE_OUTPUT) {
+        return d->latch;
+    }
+
+    uint16_t active;
+    if (config.loopback) {
+        active = outputs_locked();
+    } else if (input_source) {
+        double v = sim_source_value(input_source, now_us);
+        active = v <= 0.0 ? 0 : v >= 65535.0 ? 0xFFFF : (uint16_t)(v + 0.5);
+    } else {
+        active = 0;
+    }
+    return d->latch & (uint8_t)~(active >> (8 * d->bank));
+}
+
+static sim_device_t *find_device(uint8_t address) {
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i].address == address) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+/** @brief xorshift64* step; bus_lock held */
+static double random_unit(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (double)((rng_state * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Wait until a transfer of the given size would be finished
+ *
+ * @param start_us Start of the transaction
+ * @param bits Bits on the wire including START/STOP
+ * @param scl_hz SCL clock
+ */
+static void bus_wait(uint64_t start_us, uint32_t bits, uint32_t scl_hz) {
+    uint64_t dt = config.overhead_us;
+    if (config.timing && scl_hz) {
+        dt += (uint64_t)bits * 1000000u / scl_hz;
+    }
+    if (dt == 0) {
+        return;
+    }
+
+    uint64_t end_us = start_us + dt;
+    int64_t left;
+    while ((left = (int64_t)(end_us - (uint64_t)esp_timer_get_time())) > 0) {
+        struct timespec ts = { (time_t)(left / 1000000), (long)(left % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+/**
+ * @brief Decide whether a transaction fails; bus_lock held
+ */
+static bool inject_fault(void) {
+    if (config.fault_rate > 0.0 && random_unit() < config.fault_rate) {
+        stats.injected_faults++;
+        return true;
+    }
+    return false;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config,
+                             i2c_master_bus_handle_t *ret_bus_handle) {
+    struct host_i2c_bus *bus = calloc(1, sizeof(*bus));
+    if (bus == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    bus->port = bus_config->i2c_port;
+    *ret_bus_handle = bus;
+    ESP_LOGI(TAG, "Simulated bus on port %d: %d expanders, %s timing, %.4f fault rate",
+             bus->port, device_count, config.timing ? "SCL" : "no",
+             config.fault_rate);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle,
+                                    const i2c_device_config_t *dev_config,
+                                    i2c_master_dev_handle_t *ret_handle) {
+    struct host_i2c_device *dev = calloc(1, sizeof(*dev));
+    if (dev == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    dev->bus = bus_handle;
+    dev->address = dev_config->device_address;
+    dev->scl_hz = dev_config->scl_speed_hz;
+    *ret_handle = dev;
+    return ESP_OK;
+}
+
+/**
+ * @brief Run one addressed transfer: write (latch the last byte) or read (pins)
+ */
+static esp_err_t device_transfer(i2c_master_dev_handle_t dev, uint8_t *buf, size_t size, bool read) {
+    uint64_t start_us = (uint64_t)esp_timer_get_time();
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&bus_lock);
+    stats.transactions++;
+    stats.bytes += (uint32_t)(1 + size);
+    sim_device_t *d = dev->address == I2C_DEVICE_ADDRESS_NOT_USED ? NULL : find_device((uint8_t)dev->address);
+    if (d == NULL) {
+        stats.nacks++;
+        ret = ESP_FAIL;
+    } else if (inject_fault()) {
+        ret = ESP_FAIL;
+    } else if (read) {
+        uint8_t pins = device_pins(d, start_us);
+        memset(buf, pins, size);
+        d->last_read = pins;
+    } else if (size > 0) {
+        d->latch = buf[size - 1];
+    }
+    pthread_mutex_unlock(&bus_lock);
+
+    bus_wait(start_us, 2 + (uint32_t)(1 + size) * BITS_PER_BYTE, dev->scl_hz);
+    return ret;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer,
+                              size_t write_size, int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    return device_transfer(i2c_dev, (uint8_t *)write_buffer, write_size, false);
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer,
+                             size_t read_size, int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    return device_transfer(i2c_dev, read_buffer, read_size, true);
+}
+
+esp_err_t i2c_master_execute_defined_operations(i2c_master_dev_handle_t i2c_dev,
+                                                i2c_operation_job_t *ops,
+                                                size_t count, int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    uint64_t start_us = (uint64_t)esp_timer_get_time();
+    uint32_t bits = 0;
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&bus_lock);
+    stats.transactions++;
+    bool failed = inject_fault();
+    sim_device_t *d = NULL;
+    bool expect_address = false;
+
+    // Effects of the chain up to a missing ACK stay applied, as on the wire
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        i2c_operation_job_t *op = &ops[i];
+        switch (op->command) {
+        case I2C_MASTER_CMD_START:
+            bits += 1;
+            expect_address = true;
+            break;
+        case I2C_MASTER_CMD_STOP:
+            bits += 1;
+            break;
+        case I2C_MASTER_CMD_WRITE:
+            for (size_t b = 0; b < op->write.total_bytes; b++) {
+                uint8_t byte = op->write.data[b];
+                bits += BITS_PER_BYTE;
+                stats.bytes++;
+                if (expect_address) {
+                    expect_address = false;
+                    d = find_device(byte >> 1);
+                    if (d == NULL) {
+                        stats.nacks++;
+                        ret = ESP_FAIL;
+                        break;
+                    }
+                } else if (d) {
+                    d->latch = byte;
+                }
+            }
+            break;
+        case I2C_MASTER_CMD_READ:
+            if (d) {
+                uint8_t pins = device_pins(d, start_us);
+                memset(op->read.data, pins, op->read.total_bytes);
+                d->last_read = pins;
+            }
+            bits += (uint32_t)op->read.total_bytes * BITS_PER_BYTE;
+            stats.bytes += (uint32_t)op->read.total_bytes;
+            break;
+        }
+        if (failed && i + 1 == count / 2) {
+            // An injected fault hits the middle of the chain
+            ret = ESP_FAIL;
+        }
+    }
+    pthread_mutex_unlock(&bus_lock);
+
+    bus_wait(start_us, bits, i2c_dev->scl_hz);
+    return ret;
+}
+
+/* ============================================================================
+ * INT LINES
+ * ============================================================================ */
+
+/**
+ * @brief Follow the input signals and deliver falling INT edges
+ *
+ * PCF8574 INT is open drain and active low: it is asserted while the pins
+ * differ from their state at the last read. Devices sharing a GPIO form a
+ * wired-AND, so the handler runs when the first of them asserts.
+ */
+static void *int_thread_fn(void *arg) {
+    (void)arg;
+    pthread_setname_np(pthread_self(), "sim_int");
+
+    for (;;) {
+        gpio_isr_t fire[MAX_GPIO];
+        void *fire_arg[MAX_GPIO];
+        int nfire = 0;
+        uint64_t now_us = (uint64_t)esp_timer_get_time();
+
+        pthread_mutex_lock(&bus_lock);
+        bool low[MAX_GPIO] = { false };
+        for (int i = 0; i < device_count; i++) {
+            sim_device_t *d = &devices[i];
+            if (d->role == ROLE_INPUT && d->int_gpio >= 0 && device_pins(d, now_us) != d->last_read) {
+                low[d->int_gpio] = true;
+            }
+        }
+        for (int g = 0; g < MAX_GPIO; g++) {
+            if (low[g] && !int_line_low[g] && isr_handlers[g]) {
+                fire[nfire] = isr_handlers[g];
+                fire_arg[nfire++] = isr_args[g];
+                stats.interrupts++;
+            }
+            int_line_low[g] = low[g];
+        }
+        uint32_t poll_us = config.int_poll_us;
+        pthread_mutex_unlock(&bus_lock);
+
+        for (int i = 0; i < nfire; i++) {
+            fire[i](fire_arg[i]);
+        }
+
+        struct timespec ts = { (time_t)(poll_us / 1000000), (long)(poll_us % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg) {
+    return cfg->pin_bit_mask ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&bus_lock);
+    if (int_thread_started) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (pthread_create(&int_thread, NULL, int_thread_fn, NULL) == 0) {
+        pthread_detach(int_thread);
+        int_thread_started = true;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    pthread_mutex_unlock(&bus_lock);
+    return ret;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args) {
+    if (gpio_num < 0 || gpio_num >= MAX_GPIO) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&bus_lock);
+    isr_handlers[gpio_num] = isr_handler;
+    isr_args[gpio_num] = args;
+    pthread_mutex_unlock(&bus_lock);
+    return ESP_OK;
+}
@@ -0,0 +1,84 @@
+/* sim_expander.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef SIM_EXPANDER_H
+#define SIM_EXPANDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim_source.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Maximum number of simulated expanders on the bus */
+#define SIM_EXPANDER_MAX_DEVICES  8
+
+/**
+ * @brief Behaviour of the simulated I2C bus
+ */
+typedef struct {
+    bool timing;                /**< Take as long as the transfer at the SCL clock (false = instant) */
+    uint32_t overhead_us;       /**< Added to every transaction (driver and ISR latency) */
+    double fault_rate;          /**< Probability that a transaction is not acknowledged */
+    uint32_t int_poll_us;       /**< How often INT lines follow the input signals */
+    bool loopback;              /**< Outputs drive the inputs instead of the input source */
+} sim_expander_config_t;
+
+/**
+ * @brief Counters of the simulated bus
+ */
+typedef struct {
+    uint32_t transactions;      /**< Completed or failed transactions */
+    uint32_t bytes;             /**< Bytes including address bytes */
+    uint32_t injected_faults;   /**< Transactions failed by fault_rate */
+    uint32_t nacks;             /**< Transactions to an address with no device */
+    uint32_t interrupts;        /**< Falling INT edges delivered to handlers */
+} sim_expander_stats_t;
+
+/**
+ * @brief Configure the simulated bus
+ *
+ * Call before the firmware opens the bus.
+ *
+ * @param config Bus behaviour
+ * @param inputs Logical input word (bit set = input active), read by the input expanders
+ */
+void sim_expander_configure(const sim_expander_config_t *config, const sim_source_t *inputs);
+
+/**
+ * @brief Place a PCF8574 driving one input bank
+ *
+ * An active input pulls its pin low, as on the opto-isolated inputs.
+ *
+ * @param address 7-bit I2C address
+ * @param bank Bank of the input word (0 = bits 0-7, 1 = bits 8-15)
+ * @param int_gpio GPIO of its INT line (-1 = not wired)
+ */
+void sim_expander_add_input(uint8_t address, uint8_t bank, int int_gpio);
+
+/**
+ * @brief Place a PCF8574 holding one output bank
+ *
+ * A pin written low switches its output on (bit set in the output word).
+ *
+ * @param address 7-bit I2C address
+ * @param bank Bank of the output word
+ */
+void sim_expander_add_output(uint8_t address, uint8_t bank);
+
+/**
+ * @brief Current logical output word (bit set = output on)
+ */
+uint16_t sim_expander_outputs(void);
+
+/**
+ * @brief Copy the bus counters
+ */
+void sim_expander_get_stats(sim_expander_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_EXPANDER_H */
@@ -0,0 +1,287 @@
+/* sim_source.c - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#include "sim_source.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SPEC_MAX_LEN  512
+
+static const char *const kind_names[] = {
+    [SIM_SOURCE_CONST] = "const",
+    [SIM_SOURCE_SINE] = "sine",
+    [SIM_SOURCE_SQUARE] = "square",
+    [SIM_SOURCE_RAMP] = "ramp",
+    [SIM_SOURCE_COUNT] = "count",
+    [SIM_SOURCE_RANDOM] = "random",
+    [SIM_SOURCE_FILE] = "file",
+};
+
+/**
+ * @brief splitmix64 finalizer: well mixed 64 bits from any input
+ */
+static inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Uniform value in (0, 1) for a seed and a sequence number
+ */
+static inline double uniform(uint64_t seed, uint64_t n) {
+    return ((double)(mix64(seed ^ mix64(n)) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+void sim_source_init(sim_source_t *src, double value, double high) {
+    memset(src, 0, sizeof(*src));
+    src->kind = SIM_SOURCE_CONST;
+    src->low = value;
+    src->high = high;
+    src->period_us = 1000000;
+    src->duty = 0.5;
+    src->seed = 1;
+    src->loop = true;
+}
+
+/**
+ * @brief Load a "time_ms,value" CSV trace
+ */
+static bool load_trace(sim_source_t *src, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "sim: cannot open trace %s\n", path);
+        return false;
+    }
+
+    size_t cap = 0;
+    char line[256];
+    unsigned lineno = 0;
+    sim_source_free(src);
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') {
+            continue;
+        }
+
+        char *end;
+        double t_ms = strtod(p, &end);
+        if (end == p || (*end != ',' && *end != ';' && *end != ' ' && *end != '\t')) {
+            // A header line such as "time_ms,value" is skipped
+            if (src->count == 0) continue;
+            fprintf(stderr, "sim: %s:%u: expected \"time_ms,value\"\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+        p = end + 1;
+        double v = strtod(p, &end);
+        if (end == p || t_ms < 0) {
+            fprintf(stderr, "sim: %s:%u: expected \"time_ms,value\"\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+
+        uint64_t t_us = (uint64_t)llround(t_ms * 1000.0);
+        if (src->count > 0 && t_us < src->times_us[src->count - 1]) {
+            fprintf(stderr, "sim: %s:%u: time goes backwards\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+        if (src->count == cap) {
+            cap = cap ? cap * 2 : 256;
+            uint64_t *t = realloc(src->times_us, cap * sizeof(*t));
+            double *vv = realloc(src->values, cap * sizeof(*vv));
+            if (t == NULL || vv == NULL) {
+                free(t ? t : src->times_us);
+                free(vv ? vv : src->values);
+                src->times_us = NULL;
+                src->values = NULL;
+                src->count = 0;
+                fclose(f);
+                fprintf(stderr, "sim: out of memory loading %s\n", path);
+                return false;
+            }
+            src->times_us = t;
+            src->values = vv;
+        }
+        src->times_us[src->count] = t_us;
+        src->values[src->count] = v;
+        src->count++;
+    }
+    fclose(f);
+
+    if (src->count == 0) {
+        fprintf(stderr, "sim: trace %s has no samples\n", path);
+        return false;
+    }
+
+    // Trace starts at time 0; one pass ends one mean sample interval after the last sample
+    uint64_t t0 = src->times_us[0];
+    for (size_t i = 0; i < src->count; i++) {
+        src->times_us[i] -= t0;
+    }
+    uint64_t last = src->times_us[src->count - 1];
+    src->length_us = src->count > 1 ? last + last / (src->count - 1) : 1000;
+    return true;
+}
+
+bool sim_source_parse(sim_source_t *src, const char *spec) {
+    char buf[SPEC_MAX_LEN];
+    if (strlen(spec) >= sizeof(buf)) {
+        fprintf(stderr, "sim: source spec too long\n");
+        return false;
+    }
+    strcpy(buf, spec);
+
+    char *params = strchr(buf, ':');
+    if (params) {
+        *params++ = '\0';
+    }
+
+    int kind = -1;
+    for (size_t i = 0; i < sizeof(kind_names) / sizeof(kind_names[0]); i++) {
+        if (strcmp(buf, kind_names[i]) == 0) {
+            kind = (int)i;
+        }
+    }
+    if (kind < 0) {
+        fprintf(stderr, "sim: unknown source kind \"%s\"\n", buf);
+        return false;
+    }
+    src->kind = (sim_source_kind_t)kind;
+
+    const char *path = NULL;
+    for (char *kv = params ? strtok(params, ",") : NULL; kv; kv = strtok(NULL, ",")) {
+        char *eq = strchr(kv, '=');
+        if (eq == NULL) {
+            fprintf(stderr, "sim: expected key=value, got \"%s\"\n", kv);
+            return false;
+        }
+        *eq = '\0';
+        const char *key = kv;
+        const char *val = eq + 1;
+
+        if (strcmp(key, "path") == 0) {
+            path = val;
+            continue;
+        }
+
+        char *end;
+        double num = strtod(val, &end);
+        if (end == val || *end != '\0') {
+            fprintf(stderr, "sim: bad number \"%s\" for %s\n", val, key);
+            return false;
+        }
+
+        if (strcmp(key, "value") == 0) {
+            src->low = src->high = num;
+        } else if (strcmp(key, "low") == 0) {
+            src->low = num;
+        } else if (strcmp(key, "high") == 0) {
+            src->high = num;
+        } else if (strcmp(key, "period_ms") == 0 && num > 0) {
+            src->period_us = (uint64_t)llround(num * 1000.0);
+        } else if (strcmp(key, "phase") == 0) {
+            src->phase = num;
+        } else if (strcmp(key, "duty") == 0 && num >= 0 && num <= 1) {
+            src->duty = num;
+        } else if (strcmp(key, "noise") == 0 && num >= 0) {
+            src->noise = num;
+        } else if (strcmp(key, "seed") == 0) {
+            src->seed = (uint64_t)num;
+        } else if (strcmp(key, "loop") == 0) {
+            src->loop = num != 0;
+        } else {
+            fprintf(stderr, "sim: unknown or invalid key \"%s\" for %s\n", key, kind_names[kind]);
+            return false;
+        }
+    }
+
+    if (src->kind == SIM_SOURCE_FILE) {
+        if (path == NULL) {
+            fprintf(stderr, "sim: file source needs path=\n");
+            return false;
+        }
+        return load_trace(src, path);
+    }
+    return true;
+}
+
+/**
+ * @brief Replayed value at a time (last sample at or before it)
+ */
+static double trace_value(const sim_source_t *src, uint64_t time_us) {
+    if (src->loop) {
+        time_us %= src->length_us;
+    }
+    size_t lo = 0;
+    size_t hi = src->count;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (src->times_us[mid] <= time_us) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return src->values[lo];
+}
+
+double sim_source_value(const sim_source_t *src, uint64_t time_us) {
+    double span = src->high - src->low;
+    double cycles = (double)time_us / (double)src->period_us + src->phase;
+    double frac = cycles - floor(cycles);
+    uint64_t n = time_us / src->period_us;
+    double v;
+
+    switch (src->kind) {
+    case SIM_SOURCE_SINE:
+        v = src->low + span * 0.5 * (1.0 + sin(2.0 * M_PI * frac));
+        break;
+    case SIM_SOURCE_SQUARE:
+        v = frac < 1.0 - src->duty ? src->low : src->high;
+        break;
+    case SIM_SOURCE_RAMP:
+        v = src->low + span * frac;
+        break;
+    case SIM_SOURCE_COUNT:
+        v = src->low + (double)(n % ((uint64_t)span + 1));
+        break;
+    case SIM_SOURCE_RANDOM:
+        v = src->low + floor(uniform(src->seed, n) * (span + 1.0));
+        if (v > src->high) v = src->high;
+        break;
+    case SIM_SOURCE_FILE:
+        v = src->count ? trace_value(src, time_us) : 0.0;
+        break;
+    case SIM_SOURCE_CONST:
+    default:
+        v = src->low;
+        break;
+    }
+
+    if (src->noise > 0.0) {
+        // Box-Muller from two uniforms keyed by the time
+        double u1 = uniform(src->seed + 1, time_us);
+        double u2 = uniform(src->seed + 2, time_us);
+        v += src->noise * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+    }
+    return v;
+}
+
+void sim_source_free(sim_source_t *src) {
+    free(src->times_us);
+    free(src->values);
+    src->times_us = NULL;
+    src->values = NULL;
+    src->count = 0;
+}
@@ -0,0 +1,106 @@
+/* sim_source.h - See the project LICENSE file and main/opcua_esp32.c for licensing and attribution. */
+
+#ifndef SIM_SOURCE_H
+#define SIM_SOURCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Waveform kinds of a simulated signal
+ */
+typedef enum {
+    SIM_SOURCE_CONST = 0,   /**< Constant value */
+    SIM_SOURCE_SINE,        /**< Sine between low and high */
+    SIM_SOURCE_SQUARE,      /**< low for (1 - duty) of the period, then high */
+    SIM_SOURCE_RAMP,        /**< Sawtooth from low to high */
+    SIM_SOURCE_COUNT,       /**< Counts up from low by one every period, wraps after high */
+    SIM_SOURCE_RANDOM,      /**< New uniform random value every period */
+    SIM_SOURCE_FILE,        /**< Replay of a recorded trace, held between samples */
+} sim_source_kind_t;
+
+/**
+ * @brief A simulated signal
+ *
+ * The value is a pure function of time (noise included, it is derived
+ * from a hash of seed and time), so any thread may sample a source
+ * without locking and runs with the same seed are reproducible.
+ *
+ * Specification strings have the form "kind[:key=value,...]":
+ *
+ * | kind   | keys                                       |
+ * |--------|--------------------------------------------|
+ * | const  | value                                      |
+ * | sine   | low, high, period_ms, phase                |
+ * | square | low, high, period_ms, phase, duty          |
+ * | ramp   | low, high, period_ms, phase                |
+ * | count  | low, high, period_ms                       |
+ * | random | low, high, period_ms                       |
+ * | file   | path, loop (CSV lines "time_ms,value")     |
+ *
+ * Every kind also takes noise (standard deviation of added Gaussian
+ * noise) and seed. Numbers may be decimal or 0x hexadecimal.
+ */
+typedef struct {
+    sim_source_kind_t kind;
+    double low;             /**< Lower value (const: the value) */
+    double high;            /**< Upper value */
+    uint64_t period_us;     /**< Period of periodic kinds */
+    double phase;           /**< Phase offset as a fraction of the period */
+    double duty;            /**< Fraction of the period at high (square) */
+    double noise;           /**< Standard deviation of Gaussian noise, 0 = none */
+    uint64_t seed;          /**< Seed of noise and random values */
+    bool loop;              /**< Replay: start over at the end of the trace */
+    uint64_t *times_us;     /**< Replay: sample times from the start of the trace */
+    double *values;         /**< Replay: sample values */
+    size_t count;           /**< Replay: number of samples */
+    uint64_t length_us;     /**< Replay: length of one pass */
+} sim_source_t;
+
+/**
+ * @brief Initialize a source to a constant
+ *
+ * @param src Pointer to source
+ * @param value Constant value, also the default low of a later spec
+ * @param high Default high of a later spec
+ */
+void sim_source_init(sim_source_t *src, double value, double high);
+
+/**
+ * @brief Configure a source from a specification string
+ *
+ * Keys not given keep the values set by sim_source_init(). Errors are
+ * printed to stderr.
+ *
+ * @param src Pointer to initialized source
+ * @param spec Specification, e.g. "sine:low=500,high=3500,period_ms=2000,noise=3"
+ * @return true on success
+ */
+bool sim_source_parse(sim_source_t *src, const char *spec);
+
+/**
+ * @brief Value of a source
+ *
+ * @param src Pointer to source
+ * @param time_us Time since start of the simulation in microseconds
+ * @return double Value (not rounded or clamped)
+ */
+double sim_source_value(const sim_source_t *src, uint64_t time_us);
+
+/**
+ * @brief Free the replay data of a source
+ *
+ * @param src Pointer to source
+ */
+void sim_source_free(sim_source_t *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_SOURCE_H */
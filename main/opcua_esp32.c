@@ -48,7 +48,7 @@
  *    - Original License: Apache License, Version 2.0
  *    - Modifications: Integrated into project structure, documentation.
  *
- * 3. PCF8574 I2C Expander Driver
+ * 3. I/O Expander HAL and Drivers (PCF8574/PCF8575, MCP23017)
  *    - Status: Original work created for this project.
  *    - Author: Alexander Dikunov
  *    - License: MIT License (covered by the project-wide license above)
@@ -141,6 +141,7 @@
 #include "opcua_esp32.h"
 #include "model.h"
 #include "io_cache.h"
+#include "timebase.h"
 #include "esp_task_wdt.h"          /* Watchdog timer functions */
 #include "esp_sntp.h"              /* SNTP time synchronization */
 #include "nvs_flash.h"             /* Non-volatile storage */
@@ -299,7 +300,11 @@ static void opcua_task(void *arg)
     /* Add Information Model Objects Here */
     // REMOVED: addDSTemperatureDataSourceVariable(server);
     addDiscreteIOVariables(server);
+    addCounterVariables(server);
     addAdcVariables(server);
+    addPollRateTracking(server);
+    addDiagnosticsObject(server);
+    addHistoryObject(server);
     
     ESP_LOGI(TAG, "OPC UA server initialized");
     
@@ -320,6 +325,12 @@ static void opcua_task(void *arg)
     
     while (running)
     {
+        // All read callbacks of this iteration share one cache snapshot
+        model_invalidate_read_snapshot();
+        
+        // Push mode: write I/O changes into their nodes before sampling
+        model_push_changes(server);
+        
         // CRITICAL FIX: use 10ms timeout instead of blocking call
         UA_Server_run_iterate(server, 10); // 10ms timeout
         
@@ -359,6 +370,8 @@ static void opcua_task(void *arg)
 void time_sync_notification_cb(struct timeval *tv)
 {
     ESP_LOGI(SNTP_TAG, "Time synchronized");
+    // Source and server timestamps follow the new UTC reference
+    timebase_sync();
 }
 
 static void initialize_sntp(void)
@@ -496,6 +509,7 @@ void app_main(void)
     
     /* INITIALIZE CACHE AND POLLING TASK */
     ESP_LOGI(TAG, "Initializing IO cache system...");
+    timebase_init();
     io_cache_init();
     adc_init();
     io_polling_task_start();